@@ -0,0 +1,156 @@
+#include "internal/bloom.h"
+#include "utils/io.h"
+
+#define BLOOM_SEED 14695981039346656037ULL
+#define BLOOM_PRIME 1099511628211ULL
+
+static uint32_t bloom_counters_for(uint32_t expected_items) {
+  uint64_t wanted = (uint64_t)expected_items * BLOOM_COUNTERS_PER_ITEM;
+  uint32_t size = BLOOM_MIN_COUNTERS;
+
+  while (size < wanted && size < (1u << 30)) {
+    size <<= 1;
+  }
+
+  return size;
+}
+
+BloomFilter* bloom_create(uint32_t expected_items) {
+  BloomFilter* filter = calloc(1, sizeof(BloomFilter));
+  if (!filter) return NULL;
+
+  filter->num_counters = bloom_counters_for(expected_items);
+  filter->num_hashes = BLOOM_NUM_HASHES;
+  filter->counters = calloc(filter->num_counters, sizeof(uint8_t));
+
+  if (!filter->counters) {
+    free(filter);
+    return NULL;
+  }
+
+  return filter;
+}
+
+void bloom_destroy(BloomFilter* filter) {
+  if (!filter) return;
+
+  free(filter->counters);
+  free(filter);
+}
+
+uint64_t bloom_hash(const void* data, size_t len, uint64_t seed) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  uint64_t hash = seed ? seed : BLOOM_SEED;
+
+  for (size_t i = 0; i < len; i++) {
+    hash ^= bytes[i];
+    hash *= BLOOM_PRIME;
+  }
+
+  return hash;
+}
+
+static inline uint32_t bloom_slot(BloomFilter* filter, uint64_t hash, uint8_t i) {
+  /* Kirsch-Mitzenmacher: derive k probes from two halves of one hash */
+  uint32_t h1 = (uint32_t)hash;
+  uint32_t h2 = (uint32_t)(hash >> 32) | 1;
+
+  return (h1 + i * h2) & (filter->num_counters - 1);
+}
+
+void bloom_add(BloomFilter* filter, uint64_t hash) {
+  for (uint8_t i = 0; i < filter->num_hashes; i++) {
+    uint8_t* counter = &filter->counters[bloom_slot(filter, hash, i)];
+    if (*counter < UINT8_MAX) (*counter)++;
+  }
+
+  filter->item_count++;
+}
+
+void bloom_remove(BloomFilter* filter, uint64_t hash) {
+  for (uint8_t i = 0; i < filter->num_hashes; i++) {
+    if (filter->counters[bloom_slot(filter, hash, i)] == 0) return;
+  }
+
+  for (uint8_t i = 0; i < filter->num_hashes; i++) {
+    uint8_t* counter = &filter->counters[bloom_slot(filter, hash, i)];
+    // saturated counters have lost their true count, leave them pinned
+    if (*counter < UINT8_MAX) (*counter)--;
+  }
+
+  if (filter->item_count > 0) filter->item_count--;
+}
+
+bool bloom_might_contain(BloomFilter* filter, uint64_t hash) {
+  for (uint8_t i = 0; i < filter->num_hashes; i++) {
+    if (filter->counters[bloom_slot(filter, hash, i)] == 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool bloom_is_saturated(BloomFilter* filter) {
+  return filter->item_count > filter->num_counters / BLOOM_COUNTERS_PER_ITEM;
+}
+
+BloomFilter* load_bloom(FILE* file) {
+  /*
+  [4B] - Filter Identifier (constraint id)
+  [1B] - Key Column Count
+  [<count>B] - Key Column Indexes
+  [4B] - Counter Count
+  [1B] - Hash Count
+  [4B] - Item Count
+  [<counters>B] - Counters
+  */
+  bool is_invalid = false;
+  BloomFilter* filter = calloc(1, sizeof(BloomFilter));
+  if (!filter) return NULL;
+
+  eof_fread(&filter->id, sizeof(uint32_t), 1, file, &is_invalid);
+  eof_fread(&filter->column_count, sizeof(uint8_t), 1, file, &is_invalid);
+
+  if (is_invalid || filter->column_count > BLOOM_MAX_KEY_COLUMNS) {
+    free(filter);
+    return NULL;
+  }
+
+  eof_fread(filter->columns, sizeof(uint8_t), filter->column_count, file, &is_invalid);
+  eof_fread(&filter->num_counters, sizeof(uint32_t), 1, file, &is_invalid);
+  eof_fread(&filter->num_hashes, sizeof(uint8_t), 1, file, &is_invalid);
+  eof_fread(&filter->item_count, sizeof(uint32_t), 1, file, &is_invalid);
+
+  bool is_pow2 = filter->num_counters && !(filter->num_counters & (filter->num_counters - 1));
+  if (is_invalid || !is_pow2) {
+    free(filter);
+    return NULL;
+  }
+
+  filter->counters = malloc(filter->num_counters);
+  if (!filter->counters) {
+    free(filter);
+    return NULL;
+  }
+
+  eof_fread(filter->counters, sizeof(uint8_t), filter->num_counters, file, &is_invalid);
+  if (is_invalid) {
+    bloom_destroy(filter);
+    return NULL;
+  }
+
+  return filter;
+}
+
+void save_bloom(BloomFilter* filter, FILE* file) {
+  if (!filter || !file) return;
+
+  fwrite(&filter->id, sizeof(uint32_t), 1, file);
+  fwrite(&filter->column_count, sizeof(uint8_t), 1, file);
+  fwrite(filter->columns, sizeof(uint8_t), filter->column_count, file);
+  fwrite(&filter->num_counters, sizeof(uint32_t), 1, file);
+  fwrite(&filter->num_hashes, sizeof(uint8_t), 1, file);
+  fwrite(&filter->item_count, sizeof(uint32_t), 1, file);
+  fwrite(filter->counters, sizeof(uint8_t), filter->num_counters, file);
+}
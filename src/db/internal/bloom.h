@@ -0,0 +1,45 @@
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define BLOOM_MIN_COUNTERS 1024
+#define BLOOM_COUNTERS_PER_ITEM 8
+#define BLOOM_NUM_HASHES 4
+#define BLOOM_MAX_KEY_COLUMNS 16
+#define BLOOM_MAX_FILTERS 16
+#define BLOOM_FILE_MAGIC 0x4A424C4D  // "JBLM"
+
+/*
+  Counting Bloom filter, one per UNIQUE / PRIMARY KEY constraint.
+  Counters (instead of bits) allow keys to be removed on DELETE.
+  A negative answer from bloom_might_contain is definite.
+*/
+typedef struct BloomFilter {
+  uint32_t id;
+  uint8_t column_count;
+  uint8_t columns[BLOOM_MAX_KEY_COLUMNS];
+
+  uint32_t num_counters;
+  uint8_t num_hashes;
+  uint32_t item_count;
+  uint8_t* counters;
+} BloomFilter;
+
+BloomFilter* bloom_create(uint32_t expected_items);
+void bloom_destroy(BloomFilter* filter);
+
+uint64_t bloom_hash(const void* data, size_t len, uint64_t seed);
+void bloom_add(BloomFilter* filter, uint64_t hash);
+void bloom_remove(BloomFilter* filter, uint64_t hash);
+bool bloom_might_contain(BloomFilter* filter, uint64_t hash);
+bool bloom_is_saturated(BloomFilter* filter);
+
+BloomFilter* load_bloom(FILE* file);
+void save_bloom(BloomFilter* filter, FILE* file);
+
+#endif // BLOOM_H
@@ -0,0 +1,396 @@
+#include "internal/hashset.h"
+
+#include "kernel/kernel.h"
+
+#define TUPLE_SET_NULL_MARKER 0x9E3779B97F4A7C15ULL
+
+static uint32_t tuple_set_slots_for(uint32_t expected) {
+  uint64_t wanted = (uint64_t)expected * 2;
+  uint32_t size = TUPLE_SET_MIN_SLOTS;
+
+  while (size < wanted && size < (1u << 30)) {
+    size <<= 1;
+  }
+
+  return size;
+}
+
+static bool is_string_type(uint8_t type) {
+  switch (type) {
+    case TOK_T_STRING:
+    case TOK_T_VARCHAR:
+    case TOK_T_CHAR:
+    case TOK_T_TEXT:
+    case TOK_T_JSON:
+    case TOK_T_BLOB:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// sign, integer digits and fraction digits of a decimal with the padding zeros dropped, so 1.50 and 01.5 agree
+static size_t decimal_canonical(const char* digits, char* out, size_t size) {
+  const char* p = digits;
+  bool negative = *p == '-';
+  if (*p == '-' || *p == '+') p++;
+  while (*p == '0') p++;
+
+  const char* dot = strchr(p, '.');
+  size_t int_len = dot ? (size_t)(dot - p) : strlen(p);
+  size_t frac_len = dot ? strlen(dot + 1) : 0;
+  while (frac_len > 0 && dot[frac_len] == '0') frac_len--;
+
+  size_t len = 0;
+  if (negative && (int_len > 0 || frac_len > 0) && len < size) out[len++] = '-';
+  for (size_t i = 0; i < int_len && len < size; i++) out[len++] = p[i];
+  if (frac_len > 0 && len < size) out[len++] = '.';
+  for (size_t i = 0; i < frac_len && len < size; i++) out[len++] = dot[1 + i];
+
+  return len;
+}
+
+bool hash_column_value(ColumnValue* value, uint8_t type, uint64_t* hash) {
+  if (value->is_null) {
+    uint64_t marker = TUPLE_SET_NULL_MARKER;
+    *hash = bloom_hash(&marker, sizeof(uint64_t), *hash);
+    return true;
+  }
+
+  // arrays have no canonical key form
+  if (value->is_array) return false;
+
+  // untyped keys take the type of each value, so strings of any flavour still share a form
+  if (type == TOK_T_TBEV) type = is_string_type(value->type) ? TOK_T_STRING : value->type;
+
+  // out-of-line values are keyed by the object they point at
+  if (value->is_toast) {
+    *hash = bloom_hash(&value->toast_object, sizeof(uint32_t), *hash);
+    return true;
+  }
+
+  switch (type) {
+    case TOK_T_INT:
+    case TOK_T_UINT:
+    case TOK_T_SERIAL:
+      *hash = bloom_hash(&value->int_value, sizeof(int64_t), *hash);
+      return true;
+
+    case TOK_T_FLOAT:
+    case TOK_T_DOUBLE: {
+      double d = value->type == TOK_T_FLOAT ? (double)value->float_value : value->double_value;
+      if (d == 0.0) d = 0.0;
+      *hash = bloom_hash(&d, sizeof(double), *hash);
+      return true;
+    }
+
+    case TOK_T_BOOL: {
+      uint8_t b = value->bool_value ? 1 : 0;
+      *hash = bloom_hash(&b, 1, *hash);
+      return true;
+    }
+
+    case TOK_T_STRING:
+    case TOK_T_VARCHAR:
+    case TOK_T_CHAR:
+    case TOK_T_TEXT:
+    case TOK_T_JSON:
+    case TOK_T_BLOB:
+      if (!value->str_value) return false;
+      *hash = bloom_hash(value->str_value, strlen(value->str_value), *hash);
+      return true;
+
+    case TOK_T_UUID:
+      if (!value->str_value) return false;
+      *hash = bloom_hash(value->str_value, 16, *hash);
+      return true;
+
+    case TOK_T_DECIMAL: {
+      char canonical[MAX_DECIMAL_LEN];
+      size_t len = decimal_canonical(value->decimal.decimal_value, canonical, sizeof(canonical));
+      *hash = bloom_hash(canonical, len, *hash);
+      return true;
+    }
+
+    case TOK_T_DATE:
+      *hash = bloom_hash(&value->date_value, sizeof(Date), *hash);
+      return true;
+
+    case TOK_T_TIME:
+      *hash = bloom_hash(&value->time_value, sizeof(TimeStored), *hash);
+      return true;
+
+    case TOK_T_TIME_TZ: {
+      int64_t fields[2] = { value->time_tz_value.time, value->time_tz_value.time_zone_offset };
+      *hash = bloom_hash(fields, sizeof(fields), *hash);
+      return true;
+    }
+
+    case TOK_T_DATETIME:
+    case TOK_T_DATETIME_TZ: {
+      // field by field, the structs carry padding
+      DateTime_TZ* dt = &value->datetime_tz_value;
+      int32_t fields[7] = { dt->year, dt->month, dt->day, dt->hour, dt->minute, dt->second,
+        type == TOK_T_DATETIME_TZ ? dt->time_zone_offset : 0 };
+      *hash = bloom_hash(fields, sizeof(fields), *hash);
+      return true;
+    }
+
+    case TOK_T_TIMESTAMP:
+      *hash = bloom_hash(&value->timestamp_value.timestamp, sizeof(int64_t), *hash);
+      return true;
+
+    case TOK_T_TIMESTAMP_TZ: {
+      int64_t fields[2] = { value->timestamp_tz_value.timestamp, value->timestamp_tz_value.time_zone_offset };
+      *hash = bloom_hash(fields, sizeof(fields), *hash);
+      return true;
+    }
+
+    case TOK_T_INTERVAL: {
+      int64_t fields[3] = { value->interval_value.months, value->interval_value.days, value->interval_value.micros };
+      *hash = bloom_hash(fields, sizeof(fields), *hash);
+      return true;
+    }
+
+    default: {
+      char value_str[256];
+      format_column_value(value_str, sizeof(value_str), value);
+      *hash = bloom_hash(value_str, strlen(value_str), *hash);
+      return true;
+    }
+  }
+}
+
+bool hash_tuple(ColumnValue* tuple, uint8_t width, uint8_t* types, uint64_t* out_hash) {
+  uint64_t hash = 0;
+
+  for (uint8_t i = 0; i < width; i++) {
+    if (!hash_column_value(&tuple[i], types[i], &hash)) return false;
+  }
+
+  *out_hash = hash;
+  return true;
+}
+
+bool column_values_equal(ColumnValue* a, ColumnValue* b, uint8_t type) {
+  if (a->is_null || b->is_null) return a->is_null && b->is_null;
+  if (a->is_array || b->is_array) return a->is_array && b->is_array && compare_values(a, b) == 0;
+  if (a->is_toast || b->is_toast) return a->is_toast && b->is_toast && a->toast_object == b->toast_object;
+
+  if (type == TOK_T_TBEV) {
+    if (is_string_type(a->type) && is_string_type(b->type)) {
+      type = TOK_T_STRING;
+    } else if (a->type != b->type) {
+      return false;
+    } else {
+      type = a->type;
+    }
+  }
+
+  switch (type) {
+    case TOK_T_INT:
+    case TOK_T_UINT:
+    case TOK_T_SERIAL:
+      return a->int_value == b->int_value;
+
+    case TOK_T_FLOAT:
+    case TOK_T_DOUBLE: {
+      double x = a->type == TOK_T_FLOAT ? (double)a->float_value : a->double_value;
+      double y = b->type == TOK_T_FLOAT ? (double)b->float_value : b->double_value;
+      return x == y;
+    }
+
+    case TOK_T_BOOL:
+      return a->bool_value == b->bool_value;
+
+    case TOK_T_STRING:
+    case TOK_T_VARCHAR:
+    case TOK_T_CHAR:
+    case TOK_T_TEXT:
+    case TOK_T_JSON:
+    case TOK_T_BLOB:
+      if (!a->str_value || !b->str_value) return a->str_value == b->str_value;
+      return strcmp(a->str_value, b->str_value) == 0;
+
+    case TOK_T_UUID:
+      if (!a->str_value || !b->str_value) return a->str_value == b->str_value;
+      return memcmp(a->str_value, b->str_value, 16) == 0;
+
+    case TOK_T_DECIMAL: {
+      char x[MAX_DECIMAL_LEN], y[MAX_DECIMAL_LEN];
+      size_t x_len = decimal_canonical(a->decimal.decimal_value, x, sizeof(x));
+      size_t y_len = decimal_canonical(b->decimal.decimal_value, y, sizeof(y));
+      return x_len == y_len && memcmp(x, y, x_len) == 0;
+    }
+
+    case TOK_T_DATE:
+      return a->date_value == b->date_value;
+
+    case TOK_T_TIME:
+      return a->time_value == b->time_value;
+
+    case TOK_T_TIME_TZ:
+      return a->time_tz_value.time == b->time_tz_value.time &&
+        a->time_tz_value.time_zone_offset == b->time_tz_value.time_zone_offset;
+
+    case TOK_T_DATETIME:
+    case TOK_T_DATETIME_TZ: {
+      DateTime_TZ* x = &a->datetime_tz_value;
+      DateTime_TZ* y = &b->datetime_tz_value;
+      return x->year == y->year && x->month == y->month && x->day == y->day &&
+        x->hour == y->hour && x->minute == y->minute && x->second == y->second &&
+        (type == TOK_T_DATETIME || x->time_zone_offset == y->time_zone_offset);
+    }
+
+    case TOK_T_TIMESTAMP:
+      return a->timestamp_value.timestamp == b->timestamp_value.timestamp;
+
+    case TOK_T_TIMESTAMP_TZ:
+      return a->timestamp_tz_value.timestamp == b->timestamp_tz_value.timestamp &&
+        a->timestamp_tz_value.time_zone_offset == b->timestamp_tz_value.time_zone_offset;
+
+    case TOK_T_INTERVAL:
+      return a->interval_value.months == b->interval_value.months &&
+        a->interval_value.days == b->interval_value.days &&
+        a->interval_value.micros == b->interval_value.micros;
+
+    default:
+      return key_compare(get_column_value_as_pointer(a), get_column_value_as_pointer(b), type) == 0;
+  }
+}
+
+bool tuple_set_init(TupleSet* set, uint8_t width, uint8_t* types, uint32_t expected) {
+  if (width == 0) return false;
+
+  memset(set, 0, sizeof(TupleSet));
+  set->width = width;
+  memcpy(set->types, types, width);
+
+  set->capacity = expected > 16 ? expected : 16;
+  set->num_slots = tuple_set_slots_for(set->capacity);
+
+  set->values = malloc(sizeof(ColumnValue) * set->capacity * width);
+  set->hashes = malloc(sizeof(uint64_t) * set->capacity);
+  set->slots = malloc(sizeof(uint32_t) * set->num_slots);
+
+  if (!set->values || !set->hashes || !set->slots) {
+    tuple_set_free(set);
+    return false;
+  }
+
+  memset(set->slots, 0xFF, sizeof(uint32_t) * set->num_slots);
+  return true;
+}
+
+void tuple_set_free(TupleSet* set) {
+  if (!set) return;
+
+  free(set->values);
+  free(set->hashes);
+  free(set->slots);
+
+  set->values = NULL;
+  set->hashes = NULL;
+  set->slots = NULL;
+  set->count = set->capacity = set->num_slots = 0;
+}
+
+// forgets every entry but keeps the allocations for the next round of inserts
+void tuple_set_clear(TupleSet* set) {
+  set->count = 0;
+  if (set->slots) memset(set->slots, 0xFF, sizeof(uint32_t) * set->num_slots);
+}
+
+static bool tuple_matches(TupleSet* set, uint32_t idx, ColumnValue* tuple) {
+  ColumnValue* existing = &set->values[(size_t)idx * set->width];
+
+  for (uint8_t i = 0; i < set->width; i++) {
+    if (!column_values_equal(&existing[i], &tuple[i], set->types[i])) return false;
+  }
+
+  return true;
+}
+
+static uint32_t* tuple_set_probe(TupleSet* set, ColumnValue* tuple, uint64_t hash) {
+  uint32_t mask = set->num_slots - 1;
+  uint32_t slot = (uint32_t)hash & mask;
+
+  while (set->slots[slot] != TUPLE_SET_EMPTY) {
+    uint32_t idx = set->slots[slot];
+    if (set->hashes[idx] == hash && tuple_matches(set, idx, tuple)) break;
+    slot = (slot + 1) & mask;
+  }
+
+  return &set->slots[slot];
+}
+
+static bool tuple_set_grow(TupleSet* set) {
+  uint32_t capacity = set->capacity << 1;
+
+  ColumnValue* values = realloc(set->values, sizeof(ColumnValue) * capacity * set->width);
+  if (!values) return false;
+  set->values = values;
+
+  uint64_t* hashes = realloc(set->hashes, sizeof(uint64_t) * capacity);
+  if (!hashes) return false;
+  set->hashes = hashes;
+
+  set->capacity = capacity;
+
+  uint32_t num_slots = tuple_set_slots_for(capacity);
+  if (num_slots == set->num_slots) return true;
+
+  uint32_t* slots = malloc(sizeof(uint32_t) * num_slots);
+  if (!slots) return false;
+
+  memset(slots, 0xFF, sizeof(uint32_t) * num_slots);
+  for (uint32_t idx = 0; idx < set->count; idx++) {
+    uint32_t slot = (uint32_t)set->hashes[idx] & (num_slots - 1);
+    while (slots[slot] != TUPLE_SET_EMPTY) {
+      slot = (slot + 1) & (num_slots - 1);
+    }
+    slots[slot] = idx;
+  }
+
+  free(set->slots);
+  set->slots = slots;
+  set->num_slots = num_slots;
+
+  return true;
+}
+
+int64_t tuple_set_find(TupleSet* set, ColumnValue* tuple) {
+  uint64_t hash;
+  if (set->count == 0 || !hash_tuple(tuple, set->width, set->types, &hash)) return -1;
+
+  uint32_t idx = *tuple_set_probe(set, tuple, hash);
+  return idx == TUPLE_SET_EMPTY ? -1 : (int64_t)idx;
+}
+
+int64_t tuple_set_insert(TupleSet* set, ColumnValue* tuple, bool* inserted) {
+  if (inserted) *inserted = false;
+
+  uint64_t hash;
+  if (!hash_tuple(tuple, set->width, set->types, &hash)) return -1;
+
+  uint32_t* slot = tuple_set_probe(set, tuple, hash);
+  if (*slot != TUPLE_SET_EMPTY) return *slot;
+
+  if (set->count == set->capacity) {
+    if (!tuple_set_grow(set)) return -1;
+    slot = tuple_set_probe(set, tuple, hash);
+  }
+
+  uint32_t idx = set->count++;
+  memcpy(&set->values[(size_t)idx * set->width], tuple, sizeof(ColumnValue) * set->width);
+  set->hashes[idx] = hash;
+  *slot = idx;
+
+  if (inserted) *inserted = true;
+  return idx;
+}
+
+ColumnValue* tuple_set_get(TupleSet* set, uint32_t idx) {
+  if (idx >= set->count) return NULL;
+  return &set->values[(size_t)idx * set->width];
+}
@@ -0,0 +1,47 @@
+#ifndef HASHSET_H
+#define HASHSET_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "parser/parser.h"
+
+#define TUPLE_SET_MIN_SLOTS 64
+#define TUPLE_SET_EMPTY UINT32_MAX
+#define TUPLE_SET_MAX_WIDTH 16 // composite keys of constraints and indexes
+
+/*
+  Open-addressing hash set over fixed-width ColumnValue tuples.
+  Tuples are copied shallowly (strings stay owned by their rows) and entries
+  keep their insertion index, so callers can hang parallel payloads off them.
+  A column typed TOK_T_TBEV is keyed on the type each value carries, for
+  keys computed from expressions whose type is only known per row.
+*/
+typedef struct TupleSet {
+  uint8_t width;
+  uint8_t types[UINT8_MAX];
+
+  ColumnValue* values;
+  uint64_t* hashes;
+  uint32_t count;
+  uint32_t capacity;
+
+  uint32_t* slots;
+  uint32_t num_slots;
+} TupleSet;
+
+bool hash_column_value(ColumnValue* value, uint8_t type, uint64_t* hash);
+bool hash_tuple(ColumnValue* tuple, uint8_t width, uint8_t* types, uint64_t* out_hash);
+bool column_values_equal(ColumnValue* a, ColumnValue* b, uint8_t type);
+
+bool tuple_set_init(TupleSet* set, uint8_t width, uint8_t* types, uint32_t expected);
+void tuple_set_free(TupleSet* set);
+void tuple_set_clear(TupleSet* set);
+
+int64_t tuple_set_find(TupleSet* set, ColumnValue* tuple);
+int64_t tuple_set_insert(TupleSet* set, ColumnValue* tuple, bool* inserted);
+ColumnValue* tuple_set_get(TupleSet* set, uint32_t idx);
+
+#endif // HASHSET_H
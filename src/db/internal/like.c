@@ -0,0 +1,295 @@
+#include "like.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define LIKE_SET_WORDS 4
+
+typedef struct LikeElement {
+  bool is_literal;
+  uint8_t byte;
+  uint64_t set[LIKE_SET_WORDS];
+} LikeElement;
+
+static inline uint8_t ascii_lower(uint8_t c) {
+  return (c >= 'A' && c <= 'Z') ? (uint8_t)(c | 0x20) : c;
+}
+
+static inline void set_add(uint64_t* set, uint8_t c) {
+  set[c >> 6] |= 1ULL << (c & 63);
+}
+
+static inline bool set_has(const uint64_t* set, uint8_t c) {
+  return (set[c >> 6] >> (c & 63)) & 1;
+}
+
+// under (?i) a byte belongs to the set when its lowercase form does
+static void set_fold(uint64_t* set) {
+  uint64_t folded[LIKE_SET_WORDS] = {0};
+  for (int c = 0; c < 256; c++) {
+    if (set_has(set, ascii_lower((uint8_t)c))) set_add(folded, (uint8_t)c);
+  }
+  memcpy(set, folded, sizeof(folded));
+}
+
+// same grammar the interpreter had: optional '^', single bytes and a-z ranges up to ']'
+static const char* parse_class(const char* p, uint64_t* set, bool case_insensitive) {
+  bool negated = false;
+  if (*p == '^') {
+    negated = true;
+    p++;
+  }
+
+  while (*p && *p != ']') {
+    if (p[1] == '-' && p[2] && p[2] != ']') {
+      uint8_t start = case_insensitive ? ascii_lower((uint8_t)p[0]) : (uint8_t)p[0];
+      uint8_t end = case_insensitive ? ascii_lower((uint8_t)p[2]) : (uint8_t)p[2];
+      for (int c = start; c <= end; c++) set_add(set, (uint8_t)c);
+      p += 3;
+    } else {
+      set_add(set, case_insensitive ? ascii_lower((uint8_t)*p) : (uint8_t)*p);
+      p++;
+    }
+  }
+
+  if (*p == ']') p++;
+
+  if (negated) {
+    for (int w = 0; w < LIKE_SET_WORDS; w++) set[w] = ~set[w];
+  }
+  if (case_insensitive) set_fold(set);
+
+  return p;
+}
+
+static bool push_segment(LikeMatcher* matcher, LikeElement* elements, uint32_t count) {
+  if (count == 0) return true;
+
+  LikeSegment* segments = realloc(matcher->segments, sizeof(LikeSegment) * (matcher->segment_count + 1));
+  if (!segments) return false;
+  matcher->segments = segments;
+
+  LikeSegment* seg = &segments[matcher->segment_count++];
+  memset(seg, 0, sizeof(LikeSegment));
+  seg->length = count;
+  seg->is_literal = true;
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (!elements[i].is_literal) seg->is_literal = false;
+  }
+
+  if (seg->is_literal) {
+    seg->bytes = malloc(count);
+    if (!seg->bytes) return false;
+
+    if (matcher->case_insensitive) {
+      seg->fold = calloc(count, 1);
+      if (!seg->fold) return false;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+      seg->bytes[i] = elements[i].byte;
+      if (seg->fold && seg->bytes[i] >= 'a' && seg->bytes[i] <= 'z') seg->fold[i] = 0x20;
+    }
+  } else {
+    seg->sets = calloc((size_t)count * LIKE_SET_WORDS, sizeof(uint64_t));
+    if (!seg->sets) return false;
+
+    for (uint32_t i = 0; i < count; i++) {
+      uint64_t* set = &seg->sets[i * LIKE_SET_WORDS];
+      if (elements[i].is_literal) {
+        set_add(set, elements[i].byte);
+        if (matcher->case_insensitive) set_fold(set);
+      } else {
+        memcpy(set, elements[i].set, sizeof(elements[i].set));
+      }
+    }
+  }
+
+  matcher->min_length += count;
+  return true;
+}
+
+LikeMatcher* like_compile(const char* pattern) {
+  if (!pattern) return NULL;
+
+  LikeMatcher* matcher = calloc(1, sizeof(LikeMatcher));
+  if (!matcher) return NULL;
+
+  if (strncmp(pattern, "(?i)", 4) == 0) {
+    matcher->case_insensitive = true;
+    pattern += 4;
+  }
+
+  LikeElement* elements = malloc(sizeof(LikeElement) * (strlen(pattern) + 1));
+  bool success = elements != NULL;
+  uint32_t count = 0;
+
+  const char* p = pattern;
+  while (success && *p) {
+    if (*p == '%' || *p == '*') {
+      if (p == pattern) matcher->leading_any = true;
+      success = push_segment(matcher, elements, count);
+      count = 0;
+
+      p++;
+      if (!*p) matcher->trailing_any = true;
+      continue;
+    }
+
+    LikeElement* element = &elements[count++];
+    memset(element, 0, sizeof(LikeElement));
+    element->is_literal = true;
+
+    if (*p == '\\') {
+      p++;
+      if (!*p) {
+        matcher->never_matches = true;
+        count--;
+        break;
+      }
+      element->byte = matcher->case_insensitive ? ascii_lower((uint8_t)*p) : (uint8_t)*p;
+      p++;
+    } else if (*p == '_') {
+      element->is_literal = false;
+      memset(element->set, 0xff, sizeof(element->set));
+      p++;
+    } else if (*p == '[') {
+      element->is_literal = false;
+      p = parse_class(p + 1, element->set, matcher->case_insensitive);
+    } else {
+      element->byte = matcher->case_insensitive ? ascii_lower((uint8_t)*p) : (uint8_t)*p;
+      p++;
+    }
+  }
+
+  success = success && push_segment(matcher, elements, count);
+  free(elements);
+
+  if (!success) {
+    like_free(matcher);
+    return NULL;
+  }
+
+  return matcher;
+}
+
+static inline bool literal_at(const LikeSegment* seg, const uint8_t* s) {
+  if (!seg->fold) return memcmp(s, seg->bytes, seg->length) == 0;
+
+  for (uint32_t i = 0; i < seg->length; i++) {
+    if ((s[i] | seg->fold[i]) != seg->bytes[i]) return false;
+  }
+  return true;
+}
+
+static inline bool segment_at(const LikeSegment* seg, const uint8_t* s) {
+  if (seg->is_literal) return literal_at(seg, s);
+
+  for (uint32_t i = 0; i < seg->length; i++) {
+    if (!set_has(&seg->sets[i * LIKE_SET_WORDS], s[i])) return false;
+  }
+  return true;
+}
+
+// leftmost start of seg that fits inside s[from, end), -1 when there is none
+static int64_t segment_find(const LikeSegment* seg, const uint8_t* s, size_t from, size_t end) {
+  size_t length = seg->length;
+  if (end < from || end - from < length) return -1;
+
+  size_t last_start = end - length;
+  size_t i = from;
+
+  if (seg->is_literal) {
+#if defined(__SSE2__)
+    // 16 candidate starts at once, kept only where both the first and the last byte agree
+    const __m128i first = _mm_set1_epi8((char)seg->bytes[0]);
+    const __m128i last = _mm_set1_epi8((char)seg->bytes[length - 1]);
+    const __m128i first_fold = _mm_set1_epi8(seg->fold ? (char)seg->fold[0] : 0);
+    const __m128i last_fold = _mm_set1_epi8(seg->fold ? (char)seg->fold[length - 1] : 0);
+
+    for (; i + 15 <= last_start; i += 16) {
+      __m128i head = _mm_or_si128(_mm_loadu_si128((const __m128i*)(s + i)), first_fold);
+      __m128i tail = _mm_or_si128(_mm_loadu_si128((const __m128i*)(s + i + length - 1)), last_fold);
+      uint32_t mask = (uint32_t)_mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+
+      while (mask) {
+        size_t at = i + (size_t)__builtin_ctz(mask);
+        if (literal_at(seg, s + at)) return (int64_t)at;
+        mask &= mask - 1;
+      }
+    }
+#endif
+
+    if (!seg->fold) {
+      while (i <= last_start) {
+        const uint8_t* hit = memchr(s + i, seg->bytes[0], last_start - i + 1);
+        if (!hit) return -1;
+
+        i = (size_t)(hit - s);
+        if (literal_at(seg, hit)) return (int64_t)i;
+        i++;
+      }
+      return -1;
+    }
+  }
+
+  for (; i <= last_start; i++) {
+    if (segment_at(seg, s + i)) return (int64_t)i;
+  }
+  return -1;
+}
+
+bool like_matches(LikeMatcher* matcher, const char* str, size_t len) {
+  if (!matcher || !str || matcher->never_matches) return false;
+  if (len < matcher->min_length) return false;
+
+  const uint8_t* s = (const uint8_t*)str;
+  LikeSegment* segments = matcher->segments;
+  uint32_t n = matcher->segment_count;
+
+  if (n == 0) return matcher->leading_any || matcher->trailing_any || len == 0;
+
+  if (!matcher->leading_any && !matcher->trailing_any && n == 1) {
+    return len == segments[0].length && segment_at(&segments[0], s);
+  }
+
+  size_t pos = 0, end = len;
+  uint32_t first = 0, last = n;
+
+  if (!matcher->leading_any) {
+    if (!segment_at(&segments[0], s)) return false;
+    pos = segments[0].length;
+    first = 1;
+  }
+
+  if (!matcher->trailing_any) {
+    LikeSegment* tail = &segments[n - 1];
+    end = len - tail->length;
+    if (end < pos || !segment_at(tail, s + end)) return false;
+    last = n - 1;
+  }
+
+  for (uint32_t i = first; i < last; i++) {
+    int64_t at = segment_find(&segments[i], s, pos, end);
+    if (at < 0) return false;
+    pos = (size_t)at + segments[i].length;
+  }
+
+  return true;
+}
+
+void like_free(LikeMatcher* matcher) {
+  if (!matcher) return;
+
+  for (uint32_t i = 0; i < matcher->segment_count; i++) {
+    free(matcher->segments[i].bytes);
+    free(matcher->segments[i].fold);
+    free(matcher->segments[i].sets);
+  }
+
+  free(matcher->segments);
+  free(matcher);
+}
@@ -0,0 +1,44 @@
+#ifndef LIKE_H
+#define LIKE_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/*
+  LIKE patterns compiled once, when the statement is parsed. The pattern is
+  split on '%' into segments; every element of a segment matches exactly one
+  byte, so segments have a fixed width and placing each one at its leftmost
+  match is enough, no backtracking. Segments made only of literal bytes are
+  compared with memcmp when anchored and found with a two-byte SIMD filter
+  when floating. "(?i)" matching folds case through per-byte masks instead of
+  lowercased copies.
+*/
+
+typedef struct LikeSegment {
+  uint32_t length;
+  bool is_literal;
+
+  uint8_t* bytes;   // literal bytes, lowercased under (?i)
+  uint8_t* fold;    // 0x20 where (?i) lets a letter match either case, else 0
+  uint64_t* sets;   // 4 words (256 bits) per position, for segments with '_' or '[...]'
+} LikeSegment;
+
+typedef struct LikeMatcher {
+  bool case_insensitive;
+  bool never_matches;  // a trailing escape, as the interpreter rejected those
+
+  bool leading_any;
+  bool trailing_any;
+
+  uint32_t min_length;
+  uint32_t segment_count;
+  LikeSegment* segments;
+} LikeMatcher;
+
+LikeMatcher* like_compile(const char* pattern);
+bool like_matches(LikeMatcher* matcher, const char* str, size_t len);
+void like_free(LikeMatcher* matcher);
+
+#endif
@@ -0,0 +1,181 @@
+#include "internal/sketch.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// callers hash with FNV, whose high bits are weak for short keys
+static uint64_t sketch_mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+void hll_init(HyperLogLog* hll) {
+  memset(hll->registers, 0, sizeof(hll->registers));
+}
+
+void hll_add(HyperLogLog* hll, uint64_t hash) {
+  uint64_t h = sketch_mix(hash);
+  uint32_t idx = (uint32_t)(h >> (64 - HLL_PRECISION));
+
+  // a guard bit below the register index bounds the run when the rest is all zeros
+  uint64_t rest = (h << HLL_PRECISION) | (1ULL << (HLL_PRECISION - 1));
+  uint8_t rank = (uint8_t)__builtin_clzll(rest) + 1;
+
+  if (rank > hll->registers[idx]) hll->registers[idx] = rank;
+}
+
+void hll_merge(HyperLogLog* hll, HyperLogLog* other) {
+  for (uint32_t i = 0; i < HLL_REGISTERS; i++) {
+    if (other->registers[i] > hll->registers[i]) hll->registers[i] = other->registers[i];
+  }
+}
+
+uint64_t hll_estimate(HyperLogLog* hll) {
+  double m = (double)HLL_REGISTERS;
+  double sum = 0.0;
+  uint32_t zeros = 0;
+
+  for (uint32_t i = 0; i < HLL_REGISTERS; i++) {
+    sum += ldexp(1.0, -hll->registers[i]);
+    zeros += hll->registers[i] == 0;
+  }
+
+  double estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+
+  // small cardinalities leave registers empty, where linear counting is more accurate
+  if (estimate <= 2.5 * m && zeros > 0) estimate = m * log(m / (double)zeros);
+
+  return (uint64_t)(estimate + 0.5);
+}
+
+void tdigest_init(TDigest* digest) {
+  digest->merged = 0;
+  digest->buffered = 0;
+  digest->min = INFINITY;
+  digest->max = -INFINITY;
+}
+
+void tdigest_add(TDigest* digest, double value, double weight) {
+  if (isnan(value) || weight <= 0.0) return;
+
+  if (digest->merged + digest->buffered >= TDIGEST_MAX_CENTROIDS) tdigest_compress(digest);
+
+  digest->centroids[digest->merged + digest->buffered++] = (TDigestCentroid){ value, weight };
+  if (value < digest->min) digest->min = value;
+  if (value > digest->max) digest->max = value;
+}
+
+void tdigest_merge(TDigest* digest, TDigest* other) {
+  uint32_t count = other->merged + other->buffered;
+  for (uint32_t i = 0; i < count; i++) {
+    tdigest_add(digest, other->centroids[i].mean, other->centroids[i].weight);
+  }
+
+  if (other->min < digest->min) digest->min = other->min;
+  if (other->max > digest->max) digest->max = other->max;
+}
+
+static int centroid_order(const void* a, const void* b) {
+  double x = ((TDigestCentroid*)a)->mean;
+  double y = ((TDigestCentroid*)b)->mean;
+  return (x > y) - (x < y);
+}
+
+// k1 scale: one unit of k is the most weight a centroid may hold at quantile q
+static double tdigest_k(double q) {
+  return TDIGEST_COMPRESSION / (2.0 * M_PI) * asin(2.0 * q - 1.0);
+}
+
+static double tdigest_q(double k) {
+  if (k >= TDIGEST_COMPRESSION / 4.0) return 1.0;
+  return (sin(k * 2.0 * M_PI / TDIGEST_COMPRESSION) + 1.0) / 2.0;
+}
+
+void tdigest_compress(TDigest* digest) {
+  if (digest->buffered == 0) return;
+
+  TDigestCentroid* c = digest->centroids;
+  uint32_t count = digest->merged + digest->buffered;
+  qsort(c, count, sizeof(TDigestCentroid), centroid_order);
+
+  double total = 0.0;
+  for (uint32_t i = 0; i < count; i++) {
+    total += c[i].weight;
+  }
+
+  double before = 0.0;
+  double limit = total * tdigest_q(tdigest_k(0.0) + 1.0);
+  TDigestCentroid current = c[0];
+  uint32_t out = 0;
+
+  for (uint32_t i = 1; i < count; i++) {
+    TDigestCentroid next = c[i];
+
+    if (before + current.weight + next.weight <= limit) {
+      current.weight += next.weight;
+      current.mean += (next.mean - current.mean) * next.weight / current.weight;
+      continue;
+    }
+
+    c[out++] = current;
+    before += current.weight;
+    limit = total * tdigest_q(tdigest_k(before / total) + 1.0);
+    current = next;
+  }
+
+  c[out++] = current;
+  digest->merged = out;
+  digest->buffered = 0;
+}
+
+double tdigest_total(TDigest* digest) {
+  double total = 0.0;
+  uint32_t count = digest->merged + digest->buffered;
+  for (uint32_t i = 0; i < count; i++) {
+    total += digest->centroids[i].weight;
+  }
+  return total;
+}
+
+bool tdigest_quantile(TDigest* digest, double q, double* out) {
+  tdigest_compress(digest);
+  if (digest->merged == 0) return false;
+
+  if (q < 0.0) q = 0.0;
+  if (q > 1.0) q = 1.0;
+
+  TDigestCentroid* c = digest->centroids;
+  uint32_t last = digest->merged - 1;
+  double total = tdigest_total(digest);
+  double target = q * total;
+
+  // each centroid sits at the middle of its weight; the tails run out to the extremes
+  double first_center = c[0].weight / 2.0;
+  if (target <= first_center) {
+    *out = digest->min + (c[0].mean - digest->min) * (first_center > 0.0 ? target / first_center : 0.0);
+    return true;
+  }
+
+  double cumulative = 0.0;
+  for (uint32_t i = 0; i < last; i++) {
+    double center = cumulative + c[i].weight / 2.0;
+    double next_center = cumulative + c[i].weight + c[i + 1].weight / 2.0;
+
+    if (target <= next_center) {
+      *out = c[i].mean + (c[i + 1].mean - c[i].mean) * (target - center) / (next_center - center);
+      return true;
+    }
+
+    cumulative += c[i].weight;
+  }
+
+  double last_center = total - c[last].weight / 2.0;
+  double span = total - last_center;
+  *out = c[last].mean + (digest->max - c[last].mean) * (span > 0.0 ? (target - last_center) / span : 1.0);
+  return true;
+}
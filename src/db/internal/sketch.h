@@ -0,0 +1,59 @@
+#ifndef SKETCH_H
+#define SKETCH_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#define HLL_PRECISION 12
+#define HLL_REGISTERS (1 << HLL_PRECISION)
+
+#define TDIGEST_COMPRESSION 100
+#define TDIGEST_BUFFER (4 * TDIGEST_COMPRESSION)
+#define TDIGEST_MAX_CENTROIDS (2 * TDIGEST_COMPRESSION + TDIGEST_BUFFER)
+
+/*
+  HyperLogLog distinct counter. Each register keeps the longest run of
+  leading zeros seen among the hashes routed to it; 4096 registers give a
+  standard error of about 1.6% whatever the input size. Two sketches merge
+  by taking the larger register, so per-worker or per-database sketches
+  combine into the sketch of the union.
+*/
+typedef struct HyperLogLog {
+  uint8_t registers[HLL_REGISTERS];
+} HyperLogLog;
+
+void hll_init(HyperLogLog* hll);
+void hll_add(HyperLogLog* hll, uint64_t hash);
+void hll_merge(HyperLogLog* hll, HyperLogLog* other);
+uint64_t hll_estimate(HyperLogLog* hll);
+
+/*
+  Merging t-digest for quantiles. Values collect in a buffer that is
+  periodically sorted into the centroids, which stay small near both tails
+  (arcsine scale) so extreme percentiles keep their precision. Another
+  digest merges by feeding its centroids through the same buffer.
+*/
+typedef struct TDigestCentroid {
+  double mean;
+  double weight;
+} TDigestCentroid;
+
+typedef struct TDigest {
+  TDigestCentroid centroids[TDIGEST_MAX_CENTROIDS]; // merged ones first, then the buffer
+  uint32_t merged;
+  uint32_t buffered;
+  double min;
+  double max;
+} TDigest;
+
+void tdigest_init(TDigest* digest);
+void tdigest_add(TDigest* digest, double value, double weight);
+void tdigest_merge(TDigest* digest, TDigest* other);
+void tdigest_compress(TDigest* digest);
+double tdigest_total(TDigest* digest);
+bool tdigest_quantile(TDigest* digest, double q, double* out);
+
+#endif // SKETCH_H
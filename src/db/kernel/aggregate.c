@@ -0,0 +1,1232 @@
+#include "kernel/kernel.h"
+
+/*
+  Aggregates are streaming accumulators: each AggregateState takes values one
+  at a time (or another state, when morsels are aggregated in parallel) and
+  is finalized once its input ends. STDDEV and VARIANCE keep Welford running
+  moments; MEDIAN and MODE keep their inputs until the end, and COUNT_DISTINCT
+  keeps each distinct input once in a hash set. APPROX_COUNT_DISTINCT and
+  APPROX_PERCENTILE trade that exactness for a fixed few KB per state, a
+  HyperLogLog and a t-digest, which merge as cheaply as a SUM.
+  Over a materialized set of rows, aggregate_rows advances every aggregate of
+  the query together vector by vector, so the input is walked once; plain
+  numeric column arguments are first gathered into typed arrays with a
+  validity mask and reduced by branch-free loops the compiler can vectorize.
+
+  Hash aggregation for GROUP BY. Input rows are looked up in an open
+  addressing table (linear probing) keyed on the group columns; each group
+  keeps a representative row and one accumulator per aggregate in the query.
+  Once the table holds as many groups as the memory budget allows, rows for
+  groups it has not seen yet are hashed into one of a few partition files
+  under the tmp directory instead. When the in-memory groups have been
+  emitted each partition is aggregated on its own with a reseeded hash, and
+  may split again up to a fixed depth.
+
+  Emitted group rows carry the table's columns followed by one finalized
+  value per aggregate; aggregate nodes are tagged with their slot so HAVING
+  and the projection can read them back through evaluate_expression. Rows
+  that own their strings, such as those read back from a partition, are
+  released right after they are added, so a group built from them copies
+  the strings it keeps: its columns and whatever MIN, MAX, FIRST, LAST, MODE
+  and COUNT(DISTINCT) hold on to. Rows of one pass either all own their
+  strings or none do.
+*/
+
+// numeric aggregates reduce every input to a double; integers also keep an exact sum
+static bool numeric_value(ColumnValue* value, double* out, bool* is_int) {
+  *is_int = false;
+
+  switch (value->type) {
+    case TOK_T_INT:
+    case TOK_T_UINT:
+    case TOK_T_SERIAL:
+      *is_int = true;
+      *out = (double)value->int_value;
+      return true;
+    case TOK_T_FLOAT:
+      *out = value->float_value;
+      return true;
+    case TOK_T_DOUBLE:
+      *out = value->double_value;
+      return true;
+    default: {
+      ColumnValue cast = *value;
+      if (!infer_and_cast_value_raw(&cast, TOK_T_DOUBLE)) return false;
+      *out = cast.double_value;
+      return true;
+    }
+  }
+}
+
+static void welford_merge(AggregateState* state, uint64_t count, double mean, double m2) {
+  if (count == 0) return;
+
+  uint64_t total = state->count + count;
+  double delta = mean - state->mean;
+
+  state->m2 += m2 + delta * delta * ((double)state->count * (double)count / (double)total);
+  state->mean += delta * ((double)count / (double)total);
+  state->count = total;
+}
+
+static bool state_push_value(AggregateState* state, ColumnValue value) {
+  if (state->value_count == state->value_capacity) {
+    uint32_t capacity = state->value_capacity ? state->value_capacity * 2 : 16;
+
+    ColumnValue* values = realloc(state->values, capacity * sizeof(ColumnValue));
+    if (!values) return false;
+
+    state->values = values;
+    state->value_capacity = capacity;
+  }
+
+  state->values[state->value_count++] = value;
+  return true;
+}
+
+static bool state_add_distinct(AggregateState* state, ColumnValue* value) {
+  if (!state->distinct) {
+    uint8_t type = TOK_T_TBEV;
+    state->distinct = malloc(sizeof(TupleSet));
+    if (!state->distinct || !tuple_set_init(state->distinct, 1, &type, 0)) {
+      free(state->distinct);
+      state->distinct = NULL;
+      return false;
+    }
+  }
+
+  return tuple_set_insert(state->distinct, value, NULL) >= 0;
+}
+
+// sketches are allocated with the first value, so empty groups stay small
+static HyperLogLog* state_hll(AggregateState* state) {
+  if (!state->hll) {
+    state->hll = malloc(sizeof(HyperLogLog));
+    if (state->hll) hll_init(state->hll);
+  }
+
+  return state->hll;
+}
+
+static TDigest* state_digest(AggregateState* state) {
+  if (!state->digest) {
+    state->digest = malloc(sizeof(TDigest));
+    if (state->digest) tdigest_init(state->digest);
+  }
+
+  return state->digest;
+}
+
+// the fraction of APPROX_PERCENTILE(col, p), a constant between 0 and 1
+static bool approx_percentile_rank(Function* fn, double* p) {
+  if (fn->arg_count < 2 || fn->args[1]->type != EXPR_LITERAL || fn->args[1]->literal.is_null) return false;
+
+  bool is_int;
+  if (!numeric_value(&fn->args[1]->literal, p, &is_int)) return false;
+  return *p >= 0.0 && *p <= 1.0;
+}
+
+static bool state_append_text(AggregateState* state, const char* text, const char* separator) {
+  size_t text_len = strlen(text);
+  size_t sep_len = state->text_length > 0 ? strlen(separator) : 0;
+  size_t needed = state->text_length + sep_len + text_len + 1;
+
+  if (needed > state->text_capacity) {
+    size_t capacity = state->text_capacity ? state->text_capacity : 64;
+    while (capacity < needed) capacity *= 2;
+
+    char* grown = realloc(state->text, capacity);
+    if (!grown) return false;
+
+    state->text = grown;
+    state->text_capacity = capacity;
+  }
+
+  memcpy(state->text + state->text_length, separator, sep_len);
+  memcpy(state->text + state->text_length + sep_len, text, text_len + 1);
+  state->text_length += sep_len + text_len;
+  return true;
+}
+
+static const char* aggregate_separator(Function* fn) {
+  if (fn->arg_count > 1 && fn->args[1]->type == EXPR_LITERAL && !fn->args[1]->literal.is_null &&
+      (fn->args[1]->literal.type == TOK_T_STRING || fn->args[1]->literal.type == TOK_T_VARCHAR)) {
+    return fn->args[1]->literal.str_value;
+  }
+
+  return ",";
+}
+
+void aggregate_state_update(AggregateState* state, Function* fn, ColumnValue* value) {
+  // COUNT(*) has no argument and counts every row
+  if (!value) {
+    state->count++;
+    return;
+  }
+  if (value->is_null) return;
+
+  double number;
+  bool is_int;
+
+  switch (fn->type) {
+    case AGG_COUNT:
+      state->count++;
+      break;
+
+    case AGG_SUM:
+    case AGG_AVG:
+      if (!numeric_value(value, &number, &is_int)) return;
+      if (is_int) state->int_sum += value->int_value;
+      else state->is_double = true;
+      state->sum += number;
+      state->count++;
+      break;
+
+    case AGG_MIN:
+      if (state->count++ == 0 || compare_values(value, &state->value) < 0) state->value = *value;
+      break;
+
+    case AGG_MAX:
+      if (state->count++ == 0 || compare_values(value, &state->value) > 0) state->value = *value;
+      break;
+
+    case AGG_FIRST:
+      if (state->count++ == 0) state->value = *value;
+      break;
+
+    case AGG_LAST:
+      state->count++;
+      state->value = *value;
+      break;
+
+    case AGG_STDDEV:
+    case AGG_VARIANCE: {
+      if (!numeric_value(value, &number, &is_int)) return;
+      state->count++;
+      double delta = number - state->mean;
+      state->mean += delta / (double)state->count;
+      state->m2 += delta * (number - state->mean);
+      break;
+    }
+
+    case AGG_BOOL_AND:
+    case AGG_BOOL_OR: {
+      ColumnValue truth = *value;
+      if (truth.type != TOK_T_BOOL && !infer_and_cast_value_raw(&truth, TOK_T_BOOL)) return;
+
+      if (fn->type == AGG_BOOL_AND) state->truth = state->count == 0 ? truth.bool_value : state->truth && truth.bool_value;
+      else state->truth = state->truth || truth.bool_value;
+      state->count++;
+      break;
+    }
+
+    case AGG_MEDIAN:
+      if (!numeric_value(value, &number, &is_int)) return;
+      if (state_push_value(state, (ColumnValue){ .type = TOK_T_DOUBLE, .double_value = number })) state->count++;
+      break;
+
+    case AGG_MODE:
+      if (state_push_value(state, *value)) state->count++;
+      break;
+
+    case AGG_COUNT_DISTINCT:
+      if (state_add_distinct(state, value)) state->count++;
+      break;
+
+    case AGG_APPROX_COUNT_DISTINCT: {
+      uint64_t hash = 0;
+      if (!hash_column_value(value, TOK_T_TBEV, &hash) || !state_hll(state)) return;
+      hll_add(state->hll, hash);
+      state->count++;
+      break;
+    }
+
+    case AGG_APPROX_PERCENTILE:
+      if (!numeric_value(value, &number, &is_int) || !state_digest(state)) return;
+      tdigest_add(state->digest, number, 1.0);
+      state->count++;
+      break;
+
+    case AGG_STRING_AGG:
+    case AGG_GROUP_CONCAT: {
+      char buffer[256];
+      const char* text = buffer;
+
+      if ((value->type == TOK_T_STRING || value->type == TOK_T_VARCHAR || value->type == TOK_T_CHAR) && !value->is_array) {
+        text = value->str_value;
+      } else {
+        format_column_value(buffer, sizeof(buffer), value);
+      }
+
+      if (state_append_text(state, text, aggregate_separator(fn))) state->count++;
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+// aggregates whose result is one of their input values rather than a value of their own
+bool aggregate_returns_input(AggregateType type) {
+  switch (type) {
+    case AGG_MIN:
+    case AGG_MAX:
+    case AGG_FIRST:
+    case AGG_LAST:
+    case AGG_MODE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool aggregate_is_mergeable(AggregateType type) {
+  switch (type) {
+    case AGG_FIRST:
+    case AGG_LAST:
+    case AGG_STRING_AGG:
+    case AGG_GROUP_CONCAT:
+    case NOT_AGG:
+      return false;
+    default:
+      return true;
+  }
+}
+
+void aggregate_state_merge(AggregateState* state, AggregateState* other, Function* fn) {
+  if (other->count == 0) return;
+
+  switch (fn->type) {
+    case AGG_MIN:
+      if (state->count == 0 || compare_values(&other->value, &state->value) < 0) state->value = other->value;
+      state->count += other->count;
+      break;
+
+    case AGG_MAX:
+      if (state->count == 0 || compare_values(&other->value, &state->value) > 0) state->value = other->value;
+      state->count += other->count;
+      break;
+
+    case AGG_STDDEV:
+    case AGG_VARIANCE:
+      welford_merge(state, other->count, other->mean, other->m2);
+      break;
+
+    case AGG_BOOL_AND:
+      state->truth = state->count == 0 ? other->truth : state->truth && other->truth;
+      state->count += other->count;
+      break;
+
+    case AGG_BOOL_OR:
+      state->truth = state->truth || other->truth;
+      state->count += other->count;
+      break;
+
+    case AGG_MEDIAN:
+    case AGG_MODE:
+      for (uint32_t i = 0; i < other->value_count; i++) {
+        if (state_push_value(state, other->values[i])) state->count++;
+      }
+      break;
+
+    case AGG_COUNT_DISTINCT:
+      for (uint32_t i = 0; other->distinct && i < other->distinct->count; i++) {
+        if (state_add_distinct(state, tuple_set_get(other->distinct, i))) state->count++;
+      }
+      break;
+
+    case AGG_APPROX_COUNT_DISTINCT:
+      if (!other->hll || !state_hll(state)) break;
+      hll_merge(state->hll, other->hll);
+      state->count += other->count;
+      break;
+
+    case AGG_APPROX_PERCENTILE:
+      if (!other->digest || !state_digest(state)) break;
+      tdigest_merge(state->digest, other->digest);
+      state->count += other->count;
+      break;
+
+    default:
+      state->count += other->count;
+      state->int_sum += other->int_sum;
+      state->sum += other->sum;
+      state->is_double = state->is_double || other->is_double;
+      break;
+  }
+}
+
+static int compare_value_entries(const void* a, const void* b) {
+  return compare_values((ColumnValue*)a, (ColumnValue*)b);
+}
+
+ColumnValue aggregate_state_finalize(AggregateState* state, Function* fn) {
+  ColumnValue result = { .is_null = true };
+
+  if (fn->type == AGG_COUNT || fn->type == AGG_COUNT_DISTINCT) {
+    result.type = TOK_T_INT;
+    result.int_value = fn->type == AGG_COUNT ? (int64_t)state->count
+      : (state->distinct ? (int64_t)state->distinct->count : 0);
+    result.is_null = false;
+    return result;
+  }
+
+  if (fn->type == AGG_APPROX_COUNT_DISTINCT) {
+    result.type = TOK_T_INT;
+    result.int_value = state->hll ? (int64_t)hll_estimate(state->hll) : 0;
+    result.is_null = false;
+    return result;
+  }
+
+  if (state->count == 0) return result;
+
+  switch (fn->type) {
+    case AGG_SUM:
+      if (state->is_double) {
+        result.type = TOK_T_DOUBLE;
+        result.double_value = state->sum;
+      } else {
+        result.type = TOK_T_INT;
+        result.int_value = state->int_sum;
+      }
+      break;
+
+    case AGG_AVG:
+      result.type = TOK_T_DOUBLE;
+      result.double_value = (state->is_double ? state->sum : (double)state->int_sum) / (double)state->count;
+      break;
+
+    case AGG_MIN:
+    case AGG_MAX:
+    case AGG_FIRST:
+    case AGG_LAST:
+      return state->value;
+
+    case AGG_STDDEV:
+    case AGG_VARIANCE:
+      // sample statistics, undefined for a single value
+      if (state->count < 2) return result;
+      result.type = TOK_T_DOUBLE;
+      result.double_value = state->m2 / (double)(state->count - 1);
+      if (fn->type == AGG_STDDEV) result.double_value = sqrt(result.double_value);
+      break;
+
+    case AGG_BOOL_AND:
+    case AGG_BOOL_OR:
+      result.type = TOK_T_BOOL;
+      result.bool_value = state->truth;
+      break;
+
+    case AGG_MEDIAN: {
+      qsort(state->values, state->value_count, sizeof(ColumnValue), compare_value_entries);
+      uint32_t mid = state->value_count / 2;
+
+      result.type = TOK_T_DOUBLE;
+      result.double_value = state->value_count % 2 ? state->values[mid].double_value
+        : (state->values[mid - 1].double_value + state->values[mid].double_value) / 2.0;
+      break;
+    }
+
+    case AGG_MODE: {
+      qsort(state->values, state->value_count, sizeof(ColumnValue), compare_value_entries);
+
+      // ties resolve to the smallest value
+      uint32_t best = 0, best_run = 0;
+      for (uint32_t i = 0; i < state->value_count;) {
+        uint32_t j = i + 1;
+        while (j < state->value_count && compare_values(&state->values[i], &state->values[j]) == 0) j++;
+        if (j - i > best_run) {
+          best = i;
+          best_run = j - i;
+        }
+        i = j;
+      }
+      return state->values[best];
+    }
+
+    case AGG_APPROX_PERCENTILE: {
+      double p;
+      if (!approx_percentile_rank(fn, &p) || !state->digest) return result;
+      if (!tdigest_quantile(state->digest, p, &result.double_value)) return result;
+      result.type = TOK_T_DOUBLE;
+      break;
+    }
+
+    case AGG_STRING_AGG:
+    case AGG_GROUP_CONCAT:
+      // the finished string belongs to the result row
+      result.type = TOK_T_STRING;
+      result.str_value = state->text;
+      state->text = NULL;
+      state->text_length = 0;
+      state->text_capacity = 0;
+      break;
+
+    default:
+      return result;
+  }
+
+  result.is_null = false;
+  return result;
+}
+
+void aggregate_state_free(AggregateState* state) {
+  if (!state) return;
+
+  free(state->values);
+  free(state->text);
+  if (state->distinct) {
+    tuple_set_free(state->distinct);
+    free(state->distinct);
+  }
+  free(state->hll);
+  free(state->digest);
+  memset(state, 0, sizeof(AggregateState));
+}
+
+typedef struct AggregateColumn {
+  uint16_t column;
+  bool is_int;
+  uint8_t type;
+  int64_t ints[VECTOR_SIZE];
+  double doubles[VECTOR_SIZE];
+  uint8_t valid[VECTOR_SIZE];
+} AggregateColumn;
+
+static bool aggregate_has_kernel(AggregateType type) {
+  switch (type) {
+    case AGG_COUNT:
+    case AGG_SUM:
+    case AGG_AVG:
+    case AGG_MIN:
+    case AGG_MAX:
+    case AGG_STDDEV:
+    case AGG_VARIANCE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static void gather_column(AggregateColumn* col, Row* rows, uint32_t n) {
+  if (col->is_int) {
+    for (uint32_t i = 0; i < n; i++) {
+      ColumnValue* value = &rows[i].values[col->column];
+      col->valid[i] = !value->is_null;
+      col->ints[i] = value->is_null ? 0 : value->int_value;
+    }
+  } else {
+    for (uint32_t i = 0; i < n; i++) {
+      ColumnValue* value = &rows[i].values[col->column];
+      col->valid[i] = !value->is_null;
+      col->doubles[i] = value->is_null ? 0.0 : value->double_value;
+    }
+  }
+
+  // integer columns still feed the floating point moments
+  if (col->is_int) {
+    for (uint32_t i = 0; i < n; i++) {
+      col->doubles[i] = (double)col->ints[i];
+    }
+  }
+}
+
+static void kernel_extremum(AggregateState* state, AggregateColumn* col, uint32_t n, uint64_t valid, bool is_min) {
+  ColumnValue best = { .type = col->type };
+
+  if (col->is_int) {
+    int64_t acc = is_min ? INT64_MAX : INT64_MIN;
+    for (uint32_t i = 0; i < n; i++) {
+      int64_t v = col->valid[i] ? col->ints[i] : acc;
+      acc = is_min ? (v < acc ? v : acc) : (v > acc ? v : acc);
+    }
+    best.int_value = acc;
+  } else {
+    double acc = is_min ? INFINITY : -INFINITY;
+    for (uint32_t i = 0; i < n; i++) {
+      double v = col->valid[i] ? col->doubles[i] : acc;
+      acc = is_min ? (v < acc ? v : acc) : (v > acc ? v : acc);
+    }
+    best.double_value = acc;
+  }
+
+  int cmp = state->count == 0 ? 0 : compare_values(&best, &state->value);
+  if (state->count == 0 || (is_min ? cmp < 0 : cmp > 0)) state->value = best;
+  state->count += valid;
+}
+
+static void aggregate_kernel(AggregateState* state, AggregateType type, AggregateColumn* col, uint32_t n) {
+  uint64_t valid = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    valid += col->valid[i];
+  }
+  if (valid == 0) return;
+
+  switch (type) {
+    case AGG_COUNT:
+      state->count += valid;
+      break;
+
+    case AGG_SUM:
+    case AGG_AVG: {
+      double sum = 0.0;
+      for (uint32_t i = 0; i < n; i++) {
+        sum += col->doubles[i];
+      }
+
+      if (col->is_int) {
+        int64_t int_sum = 0;
+        for (uint32_t i = 0; i < n; i++) {
+          int_sum += col->ints[i];
+        }
+        state->int_sum += int_sum;
+      } else {
+        state->is_double = true;
+      }
+
+      state->sum += sum;
+      state->count += valid;
+      break;
+    }
+
+    case AGG_MIN:
+    case AGG_MAX:
+      kernel_extremum(state, col, n, valid, type == AGG_MIN);
+      break;
+
+    case AGG_STDDEV:
+    case AGG_VARIANCE: {
+      // two passes over the cached vector, then Chan's merge into the running moments
+      double sum = 0.0;
+      for (uint32_t i = 0; i < n; i++) {
+        sum += col->doubles[i];
+      }
+      double mean = sum / (double)valid;
+
+      double m2 = 0.0;
+      for (uint32_t i = 0; i < n; i++) {
+        double d = col->valid[i] ? col->doubles[i] - mean : 0.0;
+        m2 += d * d;
+      }
+
+      welford_merge(state, valid, mean, m2);
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+bool aggregate_rows(AggregateState* states, ExprNode** aggregates, uint8_t count, Row* rows, uint32_t row_count,
+                    TableSchema* schema, Database* db, uint8_t schema_idx) {
+  if (count == 0 || row_count == 0) return true;
+
+  AggregateColumn* columns = malloc(count * sizeof(AggregateColumn));
+  int16_t* column_of = malloc(count * sizeof(int16_t));
+  if (!columns || !column_of) {
+    free(columns);
+    free(column_of);
+    return false;
+  }
+
+  uint8_t column_count = 0;
+  for (uint8_t k = 0; k < count; k++) {
+    Function* fn = &aggregates[k]->fn;
+    column_of[k] = -1;
+
+    if (fn->arg_count == 0 || !aggregate_has_kernel(fn->type)) continue;
+
+    ExprNode* arg = fn->args[0];
+    if (arg->type != EXPR_COLUMN || arg->column.index >= schema->column_count) continue;
+
+    ColumnDefinition* def = &schema->columns[arg->column.index];
+    if (def->is_array) continue;
+
+    bool is_int = def->type == TOK_T_INT || def->type == TOK_T_UINT || def->type == TOK_T_SERIAL;
+    if (!is_int && def->type != TOK_T_DOUBLE) continue;
+
+    uint8_t c = 0;
+    while (c < column_count && columns[c].column != arg->column.index) c++;
+    if (c == column_count) {
+      columns[c].column = arg->column.index;
+      columns[c].is_int = is_int;
+      columns[c].type = def->type;
+      column_count++;
+    }
+    column_of[k] = c;
+  }
+
+  for (uint32_t start = 0; start < row_count; start += VECTOR_SIZE) {
+    uint32_t n = row_count - start < VECTOR_SIZE ? row_count - start : VECTOR_SIZE;
+    Row* batch = rows + start;
+
+    for (uint8_t c = 0; c < column_count; c++) {
+      gather_column(&columns[c], batch, n);
+    }
+
+    for (uint8_t k = 0; k < count; k++) {
+      Function* fn = &aggregates[k]->fn;
+
+      if (column_of[k] >= 0) {
+        aggregate_kernel(&states[k], fn->type, &columns[column_of[k]], n);
+      } else if (fn->arg_count == 0) {
+        if (fn->type == AGG_COUNT) states[k].count += n;
+      } else {
+        for (uint32_t i = 0; i < n; i++) {
+          ColumnValue value = evaluate_expression(fn->args[0], &batch[i], schema, db, schema_idx);
+          aggregate_state_update(&states[k], fn, &value);
+        }
+      }
+    }
+  }
+
+  free(columns);
+  free(column_of);
+  return true;
+}
+
+ColumnValue evaluate_aggregate(ExprNode* expr, Row* rows, uint32_t row_count, TableSchema* schema, Database* db, uint8_t schema_idx) {
+  ColumnValue result;
+  memset(&result, 0, sizeof(ColumnValue));
+
+  if (expr->type != EXPR_FUNCTION || expr->fn.type == NOT_AGG) {
+    LOG_ERROR("Invalid aggregate expression");
+    return result;
+  }
+
+  AggregateState state;
+  memset(&state, 0, sizeof(AggregateState));
+
+  if (!aggregate_rows(&state, &expr, 1, rows, row_count, schema, db, schema_idx)) {
+    LOG_ERROR("Memory allocation failed for aggregate");
+    return result;
+  }
+
+  result = aggregate_state_finalize(&state, &expr->fn);
+  aggregate_state_free(&state);
+  return result;
+}
+
+// partial states of a select list made only of mergeable aggregates, so the same query run
+// against several databases can be combined before anything is finalized
+ExecutionResult aggregate_select_states(Database* db, JQLCommand* cmd, AggregateState* states) {
+  if (cmd->type != CMD_SELECT || !cmd->schema) {
+    return (ExecutionResult){1, "Only SELECT statements can be aggregated across databases"};
+  }
+  if (cmd->has_join || cmd->has_group_by || cmd->has_having) {
+    return (ExecutionResult){1, "Aggregates combined across databases cannot be grouped or joined"};
+  }
+
+  ExprNode* aggregates[MAX_COLUMNS];
+  uint8_t columns[PAGE_COLUMN_BYTES] = {0};
+  uint8_t count = 0;
+
+  for (int j = 0; j < cmd->value_counts[0] && j < MAX_COLUMNS; j++) {
+    ExprNode* expr = cmd->sel_columns[j].expr;
+    if (!expr || expr->type != EXPR_FUNCTION || !aggregate_is_mergeable(expr->fn.type)) {
+      return (ExecutionResult){1, "Only mergeable aggregates can be combined across databases"};
+    }
+
+    aggregates[count++] = expr;
+    expr_column_set(expr, columns);
+  }
+
+  TableSchema* schema = get_table_schema(db, cmd->schema->table_name);
+  if (!schema) {
+    return (ExecutionResult){1, "Error: Invalid schema"};
+  }
+
+  load_btree_cluster(db, schema->table_name);
+  cmd->schema = schema;
+
+  uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+  BufferPool* pool = &db->lake[schema_idx];
+
+  ScanSelection* selection = scan_select_rows(db, cmd, schema, schema_idx);
+  Row* batch = malloc(VECTOR_SIZE * sizeof(Row));
+  bool ok = selection && batch;
+
+  for (uint16_t p = 0; ok && p < selection->page_count; p++) {
+    Page* page = pool->pages[p];
+    uint16_t n = selection->counts[p];
+    if (!page || n == 0) continue;
+
+    for (uint16_t i = 0; i < n; i++) {
+      uint16_t row_idx = selection->sel[p][i];
+      page_materialize_row(page, row_idx, schema, columns);
+      batch[i] = page->rows[row_idx];
+    }
+
+    ok = aggregate_rows(states, aggregates, count, batch, n, schema, db, schema_idx);
+  }
+
+  free(selection);
+  free(batch);
+
+  if (!ok) return (ExecutionResult){1, "Memory allocation failed for aggregate"};
+  return (ExecutionResult){0, "Aggregates computed"};
+}
+
+static bool collect_aggregates(GroupTable* table, ExprNode* node) {
+  if (!node) return true;
+
+  switch (node->type) {
+    case EXPR_FUNCTION:
+      if (node->fn.type == NOT_AGG) {
+        for (uint8_t i = 0; i < node->fn.arg_count; i++) {
+          if (!collect_aggregates(table, node->fn.args[i])) return false;
+        }
+        return true;
+      }
+
+      if (table->aggregate_count >= MAX_COLUMNS) {
+        table->error = "Too many aggregates in grouped query";
+        return false;
+      }
+
+      node->fn.grouped = true;
+      node->fn.group_slot = table->aggregate_count;
+      table->aggregates[table->aggregate_count++] = node;
+      return true;
+
+    case EXPR_BINARY_OP:
+    case EXPR_COMPARISON:
+    case EXPR_LOGICAL_AND:
+    case EXPR_LOGICAL_OR:
+      return collect_aggregates(table, node->binary.left) && collect_aggregates(table, node->binary.right);
+
+    case EXPR_LOGICAL_NOT:
+      return collect_aggregates(table, node->unary);
+
+    case EXPR_UNARY_OP:
+      return collect_aggregates(table, node->arth_unary.expr);
+
+    case EXPR_LIKE:
+      return collect_aggregates(table, node->like.left);
+
+    case EXPR_BETWEEN:
+      return collect_aggregates(table, node->between.value) &&
+        collect_aggregates(table, node->between.lower) &&
+        collect_aggregates(table, node->between.upper);
+
+    case EXPR_IN:
+      if (!collect_aggregates(table, node->in.value)) return false;
+      for (size_t i = 0; i < node->in.count; i++) {
+        if (!collect_aggregates(table, node->in.list[i])) return false;
+      }
+      return true;
+
+    default:
+      return true;
+  }
+}
+
+static uint64_t hash_group_key(GroupTable* table, Row* row) {
+  JQLCommand* cmd = table->cmd;
+  uint64_t h = 14695981039346656037ULL ^ ((uint64_t)table->depth * 0x9E3779B97F4A7C15ULL);
+
+  for (uint8_t i = 0; i < cmd->group_by_count; i++) {
+    ColumnValue* value = &row->values[cmd->group_by[i]];
+
+    // arrays only share a bucket; equality is decided by column_values_equal
+    if (!hash_column_value(value, TOK_T_TBEV, &h)) h = bloom_hash(&value->type, 1, h);
+  }
+
+  // finalize so the top bits used for partitioning are well mixed
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+static bool group_keys_equal(GroupTable* table, Row* a, Row* b) {
+  JQLCommand* cmd = table->cmd;
+
+  for (uint8_t i = 0; i < cmd->group_by_count; i++) {
+    uint8_t col = cmd->group_by[i];
+    if (!column_values_equal(&a->values[col], &b->values[col], TOK_T_TBEV)) return false;
+  }
+
+  return true;
+}
+
+// feeds a value of a row that is released after the update, copying whatever the state keeps of it
+static bool group_state_update(AggregateState* state, Function* fn, ColumnValue* value, bool copy) {
+  if (!copy || !value) {
+    aggregate_state_update(state, fn, value);
+    return true;
+  }
+
+  ColumnValue kept = state->value;
+  uint32_t pushed = state->value_count;
+  uint32_t distinct = state->distinct ? state->distinct->count : 0;
+
+  aggregate_state_update(state, fn, value);
+
+  switch (fn->type) {
+    case AGG_MIN:
+    case AGG_MAX:
+    case AGG_FIRST:
+    case AGG_LAST:
+      if (!spill_value_owned(value) || state->value.str_value != value->str_value) return true;
+      free_spill_value(&kept);
+      return copy_spill_value(&state->value);
+
+    case AGG_MODE:
+      return state->value_count == pushed || copy_spill_value(&state->values[pushed]);
+
+    case AGG_COUNT_DISTINCT:
+      return !state->distinct || state->distinct->count == distinct ||
+        copy_spill_value(tuple_set_get(state->distinct, distinct));
+
+    default:
+      return true;
+  }
+}
+
+static void group_state_free(AggregateState* state, Function* fn, bool owns_strings) {
+  if (owns_strings) {
+    switch (fn->type) {
+      case AGG_MIN:
+      case AGG_MAX:
+      case AGG_FIRST:
+      case AGG_LAST:
+        free_spill_value(&state->value);
+        break;
+
+      case AGG_MODE:
+        for (uint32_t i = 0; i < state->value_count; i++) {
+          free_spill_value(&state->values[i]);
+        }
+        break;
+
+      case AGG_COUNT_DISTINCT:
+        for (uint32_t i = 0; state->distinct && i < state->distinct->count; i++) {
+          free_spill_value(tuple_set_get(state->distinct, i));
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  aggregate_state_free(state);
+}
+
+// releases the groups' accumulators; their rows stay with the table
+static void group_table_free_states(GroupTable* table) {
+  for (uint32_t g = 0; g < table->group_count; g++) {
+    AggregateState* states = &table->states[(size_t)g * table->aggregate_count];
+
+    for (uint8_t k = 0; k < table->aggregate_count; k++) {
+      group_state_free(&states[k], &table->aggregates[k]->fn, table->groups[g].owns_strings);
+    }
+  }
+}
+
+static void group_row_free(Row* group) {
+  if (group->owns_strings) free_spill_row(group);
+  else free(group->values);
+}
+
+static bool group_table_resize(GroupTable* table, uint32_t slot_count) {
+  uint32_t* slots = malloc(slot_count * sizeof(uint32_t));
+  if (!slots) return false;
+  memset(slots, 0xff, slot_count * sizeof(uint32_t));
+
+  uint32_t mask = slot_count - 1;
+  for (uint32_t g = 0; g < table->group_count; g++) {
+    uint32_t s = (uint32_t)table->hashes[g] & mask;
+    while (slots[s] != UINT32_MAX) s = (s + 1) & mask;
+    slots[s] = g;
+  }
+
+  free(table->slots);
+  table->slots = slots;
+  table->slot_mask = mask;
+  return true;
+}
+
+bool group_table_init(GroupTable* table, Database* db, JQLCommand* cmd, TableSchema* schema, size_t memory_budget) {
+  memset(table, 0, sizeof(GroupTable));
+  table->db = db;
+  table->cmd = cmd;
+  table->schema = schema;
+  table->schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+
+  for (int j = 0; j < cmd->value_counts[0]; j++) {
+    if (!collect_aggregates(table, cmd->sel_columns[j].expr)) return false;
+  }
+  if (cmd->has_having && !collect_aggregates(table, cmd->having)) return false;
+
+  table->width = schema->column_count + table->aggregate_count;
+
+  if (memory_budget > 0) {
+    size_t per_group = sizeof(Row) + sizeof(uint64_t) + 2 * sizeof(uint32_t) +
+      table->width * sizeof(ColumnValue) + table->aggregate_count * sizeof(AggregateState);
+    size_t max_groups = memory_budget / per_group;
+    table->max_groups = max_groups < 16 ? 16 : (max_groups > UINT32_MAX / 2 ? UINT32_MAX / 2 : (uint32_t)max_groups);
+  }
+
+  if (!group_table_resize(table, 64)) {
+    table->error = "Memory allocation failed for group table";
+    return false;
+  }
+
+  return true;
+}
+
+static bool group_spill(GroupTable* table, Row* row, uint64_t hash) {
+  GroupPartition* part = &table->spill[hash >> (64 - 3)];
+
+  if (!part->file) {
+    snprintf(part->path, MAX_PATH_LENGTH, "%s" SEP "group_%p_%u.part",
+      table->db->fs->tmp_dir, (void*)table, table->spill_files++);
+    part->depth = table->depth + 1;
+
+    part->file = fopen(part->path, "w+b");
+    if (!part->file) {
+      LOG_ERROR("Failed to open group partition file: %s", part->path);
+      table->error = "Failed to spill group partition";
+      return false;
+    }
+  }
+
+  if (!write_spill_row(part->file, row, table->schema)) {
+    LOG_ERROR("Failed to write group partition file: %s", part->path);
+    table->error = "Failed to spill group partition";
+    return false;
+  }
+
+  return true;
+}
+
+static uint32_t group_insert(GroupTable* table, Row* row, uint64_t hash) {
+  if (table->group_count == table->group_capacity) {
+    uint32_t capacity = table->group_capacity ? table->group_capacity * 2 : 64;
+
+    Row* groups = realloc(table->groups, capacity * sizeof(Row));
+    if (!groups) return UINT32_MAX;
+    table->groups = groups;
+
+    uint64_t* hashes = realloc(table->hashes, capacity * sizeof(uint64_t));
+    if (!hashes) return UINT32_MAX;
+    table->hashes = hashes;
+
+    if (table->aggregate_count > 0) {
+      AggregateState* states = realloc(table->states, (size_t)capacity * table->aggregate_count * sizeof(AggregateState));
+      if (!states) return UINT32_MAX;
+      table->states = states;
+    }
+
+    table->group_capacity = capacity;
+  }
+
+  uint32_t g = table->group_count;
+  Row* group = &table->groups[g];
+  memset(group, 0, sizeof(Row));
+  group->id = row->id;
+  group->n_values = table->width;
+  group->values = calloc(table->width, sizeof(ColumnValue));
+  if (!group->values) return UINT32_MAX;
+
+  memcpy(group->values, row->values, table->schema->column_count * sizeof(ColumnValue));
+  if (row->owns_strings) {
+    group->owns_strings = true;
+
+    for (uint16_t i = 0; i < table->schema->column_count; i++) {
+      if (copy_spill_value(&group->values[i])) continue;
+
+      while (i-- > 0) free_spill_value(&group->values[i]);
+      free(group->values);
+      group->values = NULL;
+      return UINT32_MAX;
+    }
+  }
+
+  if (table->aggregate_count > 0) {
+    memset(&table->states[(size_t)g * table->aggregate_count], 0, table->aggregate_count * sizeof(AggregateState));
+  }
+
+  table->hashes[g] = hash;
+  table->group_count++;
+
+  if ((uint64_t)table->group_count * 2 > table->slot_mask + 1) {
+    if (!group_table_resize(table, (table->slot_mask + 1) * 2)) return UINT32_MAX;
+  } else {
+    uint32_t s = (uint32_t)hash & table->slot_mask;
+    while (table->slots[s] != UINT32_MAX) s = (s + 1) & table->slot_mask;
+    table->slots[s] = g;
+  }
+
+  return g;
+}
+
+bool group_table_add(GroupTable* table, Row* row) {
+  uint64_t hash = hash_group_key(table, row);
+
+  uint32_t s = (uint32_t)hash & table->slot_mask;
+  uint32_t g;
+  while ((g = table->slots[s]) != UINT32_MAX) {
+    if (table->hashes[g] == hash && group_keys_equal(table, &table->groups[g], row)) break;
+    s = (s + 1) & table->slot_mask;
+  }
+
+  if (g == UINT32_MAX) {
+    if (table->max_groups && table->group_count >= table->max_groups && table->depth < GROUP_MAX_SPILL_DEPTH) {
+      return group_spill(table, row, hash);
+    }
+
+    g = group_insert(table, row, hash);
+    if (g == UINT32_MAX) {
+      table->error = "Memory allocation failed for group table";
+      return false;
+    }
+  }
+
+  AggregateState* states = &table->states[(size_t)g * table->aggregate_count];
+  for (uint8_t k = 0; k < table->aggregate_count; k++) {
+    Function* fn = &table->aggregates[k]->fn;
+
+    if (fn->arg_count == 0) {
+      aggregate_state_update(&states[k], fn, NULL);
+      continue;
+    }
+
+    ColumnValue value = evaluate_expression(fn->args[0], row, table->schema, table->db, table->schema_idx);
+    if (!group_state_update(&states[k], fn, &value, row->owns_strings)) {
+      table->error = "Memory allocation failed for group table";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool group_table_finish(GroupTable* table) {
+  table->cursor = 0;
+
+  for (int p = 0; p < GROUP_SPILL_PARTITIONS; p++) {
+    GroupPartition* part = &table->spill[p];
+    if (!part->file) continue;
+
+    GroupPartition* pending = realloc(table->pending, (table->pending_count + 1) * sizeof(GroupPartition));
+    if (!pending) {
+      table->error = "Memory allocation failed for group partitions";
+      return false;
+    }
+    table->pending = pending;
+
+    rewind(part->file);
+    table->pending[table->pending_count++] = *part;
+    memset(part, 0, sizeof(GroupPartition));
+  }
+
+  return true;
+}
+
+// retires the emitted groups (their rows are still referenced downstream) and aggregates the next partition
+static bool group_table_load_partition(GroupTable* table) {
+  if (table->group_count > 0) {
+    Row* retired = realloc(table->retired, (table->retired_count + table->group_count) * sizeof(Row));
+    if (!retired) {
+      table->error = "Memory allocation failed for group table";
+      return false;
+    }
+    table->retired = retired;
+
+    memcpy(&table->retired[table->retired_count], table->groups, table->group_count * sizeof(Row));
+    table->retired_count += table->group_count;
+  }
+
+  group_table_free_states(table);
+
+  table->group_count = 0;
+  memset(table->slots, 0xff, (table->slot_mask + 1) * sizeof(uint32_t));
+
+  GroupPartition part = table->pending[--table->pending_count];
+  table->depth = part.depth;
+
+  LOG_DEBUG("Aggregating spilled group partition %s at depth %u", part.path, part.depth);
+
+  bool ok = true;
+  Row row;
+  while (ok && read_spill_row(part.file, &row, table->schema)) {
+    ok = group_table_add(table, &row);
+    free_spill_row(&row);
+  }
+
+  fclose(part.file);
+  remove(part.path);
+
+  return ok && group_table_finish(table);
+}
+
+bool group_table_next(GroupTable* table, Row* out) {
+  JQLCommand* cmd = table->cmd;
+  uint16_t base = table->schema->column_count;
+
+  while (true) {
+    while (table->cursor < table->group_count) {
+      uint32_t g = table->cursor++;
+      Row* group = &table->groups[g];
+
+      AggregateState* states = &table->states[(size_t)g * table->aggregate_count];
+      for (uint8_t k = 0; k < table->aggregate_count; k++) {
+        Function* fn = &table->aggregates[k]->fn;
+        group->values[base + k] = aggregate_state_finalize(&states[k], fn);
+
+        // the state's own copy goes with the state, the group row keeps another
+        if (group->owns_strings && aggregate_returns_input(fn->type) && !copy_spill_value(&group->values[base + k])) {
+          table->error = "Memory allocation failed for group table";
+          return false;
+        }
+      }
+
+      if (cmd->has_having && !evaluate_condition(cmd->having, group, table->schema, table->db, table->schema_idx)) {
+        continue;
+      }
+
+      *out = *group;
+      return true;
+    }
+
+    if (table->pending_count == 0) return false;
+    if (!group_table_load_partition(table)) return false;
+  }
+}
+
+void group_table_free(GroupTable* table) {
+  if (!table) return;
+
+  group_table_free_states(table);
+  for (uint32_t g = 0; g < table->group_count; g++) {
+    group_row_free(&table->groups[g]);
+  }
+  for (uint32_t i = 0; i < table->retired_count; i++) {
+    group_row_free(&table->retired[i]);
+  }
+
+  for (int p = 0; p < GROUP_SPILL_PARTITIONS; p++) {
+    if (!table->spill[p].file) continue;
+    fclose(table->spill[p].file);
+    remove(table->spill[p].path);
+  }
+  for (uint32_t i = 0; i < table->pending_count; i++) {
+    fclose(table->pending[i].file);
+    remove(table->pending[i].path);
+  }
+
+  free(table->pending);
+  free(table->retired);
+  free(table->slots);
+  free(table->groups);
+  free(table->hashes);
+  free(table->states);
+  memset(table, 0, sizeof(GroupTable));
+}
@@ -0,0 +1,307 @@
+#include "kernel/kernel.h"
+
+/*
+  Catalog cache. Resolving a table or one of its columns used to run a full
+  SELECT against jb_tables, jb_attribute or jb_attrdef for every lookup, and
+  loading a schema does one per column. The cache reads each catalog table in
+  a single pass and answers lookups by name or id from hash sets afterwards.
+*/
+
+static CatalogCache* catalog_of(Database* db) {
+  if (!db) return NULL;
+  if (!db->core) db->core = db;
+
+  Database* core = db->core;
+  if (!core->catalog) {
+    core->catalog = calloc(1, sizeof(CatalogCache));
+    if (!core->catalog) {
+      LOG_ERROR("Failed to allocate the catalog cache");
+      return NULL;
+    }
+  }
+
+  return core->catalog;
+}
+
+static void catalog_clear(CatalogCache* cache) {
+  for (uint32_t i = 0; i < cache->tables_by_name.count; i++) {
+    free(tuple_set_get(&cache->tables_by_name, i)[0].str_value);
+  }
+
+  for (uint32_t i = 0; i < cache->attributes.count; i++) {
+    free(tuple_set_get(&cache->attributes, i)[1].str_value);
+    if (i < cache->attrs_capacity) free(cache->attrs[i].default_expr);
+  }
+
+  tuple_set_free(&cache->tables_by_name);
+  tuple_set_free(&cache->tables_by_id);
+  tuple_set_free(&cache->attributes);
+
+  free(cache->table_ids);
+  free(cache->attrs);
+  cache->table_ids = NULL;
+  cache->attrs = NULL;
+  cache->table_ids_capacity = cache->attrs_capacity = 0;
+
+  cache->is_loaded = false;
+}
+
+static bool catalog_init_sets(CatalogCache* cache) {
+  uint8_t name_type = TOK_T_TEXT;
+  uint8_t id_type = TOK_T_INT;
+  uint8_t attr_types[2] = { TOK_T_INT, TOK_T_TEXT };
+
+  return tuple_set_init(&cache->tables_by_name, 1, &name_type, 0) &&
+         tuple_set_init(&cache->tables_by_id, 1, &id_type, 0) &&
+         tuple_set_init(&cache->attributes, 2, attr_types, 0);
+}
+
+// payloads follow their set's capacity, so they only move when the set has grown
+static bool fit_payload(void** payload, uint32_t* capacity, TupleSet* set, size_t size) {
+  if (*capacity >= set->capacity) return true;
+
+  void* grown = realloc(*payload, size * set->capacity);
+  if (!grown) return false;
+
+  *payload = grown;
+  *capacity = set->capacity;
+  return true;
+}
+
+static bool add_table(CatalogCache* cache, int64_t table_id, const char* name) {
+  ColumnValue key = { .type = TOK_T_TEXT, .str_value = (char*)name };
+  ColumnValue id = { .type = TOK_T_INT, .int_value = table_id };
+  if (tuple_set_find(&cache->tables_by_name, &key) != -1 || tuple_set_find(&cache->tables_by_id, &id) != -1) {
+    return true;
+  }
+
+  key.str_value = strdup(name);
+  if (!key.str_value) return false;
+
+  if (tuple_set_insert(&cache->tables_by_name, &key, NULL) < 0) {
+    free(key.str_value);
+    return false;
+  }
+
+  int64_t idx = tuple_set_insert(&cache->tables_by_id, &id, NULL);
+  if (idx < 0 || !fit_payload((void**)&cache->table_ids, &cache->table_ids_capacity, &cache->tables_by_name, sizeof(int64_t))) {
+    return false;
+  }
+
+  cache->table_ids[idx] = table_id;
+  return true;
+}
+
+static CatalogAttribute* add_attribute(CatalogCache* cache, int64_t table_id, const char* column_name) {
+  ColumnValue key[2] = {
+    { .type = TOK_T_INT, .int_value = table_id },
+    { .type = TOK_T_TEXT, .str_value = (char*)column_name },
+  };
+
+  int64_t idx = tuple_set_find(&cache->attributes, key);
+  if (idx != -1) return &cache->attrs[idx];
+
+  key[1].str_value = strdup(column_name);
+  if (!key[1].str_value) return NULL;
+
+  idx = tuple_set_insert(&cache->attributes, key, NULL);
+  if (idx < 0) {
+    free(key[1].str_value);
+    return NULL;
+  }
+
+  if (!fit_payload((void**)&cache->attrs, &cache->attrs_capacity, &cache->attributes, sizeof(CatalogAttribute))) {
+    return NULL;
+  }
+
+  memset(&cache->attrs[idx], 0, sizeof(CatalogAttribute));
+  return &cache->attrs[idx];
+}
+
+static Result catalog_query(Database* core, char* query) {
+  ParserState state = parser_save_state(core->parser);
+  Result res = process_silent(core, query);
+  parser_restore_state(core->parser, state);
+  return res;
+}
+
+static bool catalog_load(Database* db, CatalogCache* cache) {
+  if (cache->is_loaded) return true;
+  if (cache->is_loading) return false;
+
+  Database* core = db->core;
+  cache->is_loading = true;
+
+  bool success = catalog_init_sets(cache);
+
+  Result res = {0};
+  if (success) {
+    res = catalog_query(core, "SELECT id, name FROM jb_tables;");
+    success = res.exec.code == 0;
+  }
+
+  for (uint32_t i = 0; success && i < res.exec.row_count; i++) {
+    Row* row = &res.exec.rows[i];
+    if (!row->values[1].str_value) continue;
+    success = add_table(cache, row->values[0].int_value, row->values[1].str_value);
+  }
+  free_result(&res);
+
+  if (success) {
+    res = catalog_query(core,
+      "SELECT table_id, column_name, data_type, ordinal_position, is_nullable, has_default, has_constraints "
+      "FROM jb_attribute;");
+    success = res.exec.code == 0;
+  }
+
+  for (uint32_t i = 0; success && i < res.exec.row_count; i++) {
+    Row* row = &res.exec.rows[i];
+    if (!row->values[1].str_value) continue;
+
+    CatalogAttribute* entry = add_attribute(cache, row->values[0].int_value, row->values[1].str_value);
+    if (!entry) {
+      success = false;
+      break;
+    }
+
+    entry->attr = (Attribute){
+      .data_type = row->values[2].int_value,
+      .ordinal_position = row->values[3].int_value,
+      .is_nullable = row->values[4].bool_value,
+      .has_default = row->values[5].bool_value,
+      .has_constraints = row->values[6].bool_value,
+    };
+  }
+  free_result(&res);
+
+  if (success) {
+    res = catalog_query(core, "SELECT table_id, column_name, default_expr FROM jb_attrdef;");
+    success = res.exec.code == 0;
+  }
+
+  for (uint32_t i = 0; success && i < res.exec.row_count; i++) {
+    Row* row = &res.exec.rows[i];
+    if (!row->values[1].str_value) continue;
+
+    ColumnValue* expr = &row->values[2];
+    if (expr->is_toast) check_and_concat_toast(core, expr);
+    if (!expr->str_value) continue;
+
+    ColumnValue key[2] = {
+      { .type = TOK_T_INT, .int_value = row->values[0].int_value },
+      { .type = TOK_T_TEXT, .str_value = row->values[1].str_value },
+    };
+
+    // the first definition wins, as the per-column lookup it replaces did
+    int64_t idx = tuple_set_find(&cache->attributes, key);
+    if (idx != -1 && !cache->attrs[idx].default_expr) {
+      cache->attrs[idx].default_expr = strdup(expr->str_value);
+    }
+  }
+  free_result(&res);
+
+  cache->is_loading = false;
+
+  if (!success) {
+    LOG_ERROR("Failed to load the catalog cache");
+    catalog_clear(cache);
+    return false;
+  }
+
+  cache->is_loaded = true;
+  cache->version++;
+  return true;
+}
+
+int64_t catalog_table_id(Database* db, const char* name) {
+  CatalogCache* cache = catalog_of(db);
+  if (!cache || !name || !catalog_load(db, cache)) return -1;
+
+  ColumnValue key = { .type = TOK_T_TEXT, .str_value = (char*)name };
+  int64_t idx = tuple_set_find(&cache->tables_by_name, &key);
+
+  return idx == -1 ? -1 : cache->table_ids[idx];
+}
+
+const char* catalog_table_name(Database* db, int64_t table_id) {
+  CatalogCache* cache = catalog_of(db);
+  if (!cache || !catalog_load(db, cache)) return NULL;
+
+  ColumnValue key = { .type = TOK_T_INT, .int_value = table_id };
+  int64_t idx = tuple_set_find(&cache->tables_by_id, &key);
+
+  return idx == -1 ? NULL : tuple_set_get(&cache->tables_by_name, idx)[0].str_value;
+}
+
+CatalogAttribute* catalog_attribute(Database* db, int64_t table_id, const char* column_name) {
+  CatalogCache* cache = catalog_of(db);
+  if (!cache || !column_name || !catalog_load(db, cache)) return NULL;
+
+  ColumnValue key[2] = {
+    { .type = TOK_T_INT, .int_value = table_id },
+    { .type = TOK_T_TEXT, .str_value = (char*)column_name },
+  };
+  int64_t idx = tuple_set_find(&cache->attributes, key);
+
+  return idx == -1 ? NULL : &cache->attrs[idx];
+}
+
+uint64_t catalog_version(Database* db) {
+  CatalogCache* cache = catalog_of(db);
+  return cache ? cache->version : 0;
+}
+
+// writers keep a loaded cache current; an unloaded one picks their rows up on first use
+void catalog_add_table(Database* db, int64_t table_id, const char* name) {
+  CatalogCache* cache = catalog_of(db);
+  if (!cache || !cache->is_loaded) return;
+
+  // a half-applied entry would leave the sets disagreeing, start over instead
+  if (!add_table(cache, table_id, name)) catalog_clear(cache);
+  cache->version++;
+}
+
+void catalog_add_attribute(Database* db, int64_t table_id, const char* column_name, Attribute* attr) {
+  CatalogCache* cache = catalog_of(db);
+  if (!cache || !cache->is_loaded) return;
+
+  CatalogAttribute* entry = add_attribute(cache, table_id, column_name);
+  if (entry) {
+    entry->attr = *attr;
+  } else {
+    catalog_clear(cache);
+  }
+  cache->version++;
+}
+
+void catalog_set_default(Database* db, int64_t table_id, const char* column_name, const char* default_expr) {
+  CatalogCache* cache = catalog_of(db);
+  if (!cache || !cache->is_loaded) return;
+
+  CatalogAttribute* entry = catalog_attribute(db, table_id, column_name);
+  if (!entry) {
+    // a default for a column the cache never saw, read both back together
+    catalog_invalidate(db);
+    return;
+  }
+
+  free(entry->default_expr);
+  entry->default_expr = strdup(default_expr);
+  cache->version++;
+}
+
+void catalog_invalidate(Database* db) {
+  CatalogCache* cache = catalog_of(db);
+  if (!cache) return;
+
+  if (cache->is_loaded) catalog_clear(cache);
+  cache->version++;
+}
+
+void catalog_free(Database* db) {
+  if (!db || !db->catalog) return;
+
+  catalog_clear(db->catalog);
+  free(db->catalog);
+  db->catalog = NULL;
+}
@@ -49,7 +49,7 @@ ExecutionResult execute_create_table(Database* db, JQLCommand* cmd) {
     if (col->has_sequence) {
       char seq_name[MAX_IDENTIFIER_LEN * 2];
       sprintf(seq_name, "%s%s", schema->table_name, col->name);
-      col->sequence_id = create_default_sequence(db->core, seq_name, cmd->is_unsafe);
+      col->sequence_id = create_default_sequence(db->core, seq_name, col->sequence_cache, cmd->is_unsafe);
 
       if (col->sequence_id == -1) {
         return (ExecutionResult){-1, "Table creation failed"};;
@@ -161,6 +161,11 @@ ExecutionResult execute_alter_table(Database* db, JQLCommand* cmd) {
   TableSchema* schema = db->tc[table_offset].schema;
   int64_t table_id = find_table(db, alter_cmd->table_name);
 
+  // stored rows are only readable through the columns they were written with
+  pool_materialize(&db->lake[table_offset], schema);
+  statistics_invalidate(db, table_offset);
+  result_cache_invalidate(db, table_offset);
+
   if (table_id == -1) {
     result.code = -1;
     result.message = "Table not found in catalog";
@@ -468,6 +473,9 @@ ExecutionResult execute_alter_table(Database* db, JQLCommand* cmd) {
       result.message = "Unknown ALTER operation";
       break;
   }
+
+  // catalog rows may have been rewritten or removed, let the next lookup reread them
+  if (result.code == 0) catalog_invalidate(db);
   
   return result;
 }
@@ -694,6 +702,9 @@ Row* execute_row_insert(ExprNode** src, Database* db, uint8_t schema_idx,
   }
 
   RowID row_id = serialize_insert(pool, *row, db->tc[schema_idx]);
+  track_constraint_blooms(db, schema, row->values, column_count, true);
+  track_statistics(db, schema, row->values, column_count, true);
+  result_cache_invalidate(db, schema_idx);
 
   for (uint8_t i = 0; i < primary_key_count; i++) {
     if (&primary_key_cols[i]) {
@@ -712,143 +723,114 @@ Row* execute_row_insert(ExprNode** src, Database* db, uint8_t schema_idx,
   return (Row*)row;  
 }
 
-ExecutionResult execute_select(Database* db, JQLCommand* cmd) {
-  if (!db || !cmd || !cmd->schema) {
-    return (ExecutionResult){1, "Invalid execution context or command"};
-  }
-
+// the schema a SELECT's rows are read through, once its tables are loaded
+TableSchema* bind_select(Database* db, JQLCommand* cmd, const char** error) {
   TableSchema* schema = get_table_schema(db, cmd->schema->table_name);
   if (!schema) {
-    return (ExecutionResult){1, "Error: Invalid schema"};
+    *error = "Error: Invalid schema";
+    return NULL;
   }
 
   load_btree_cluster(db, schema->table_name);
   cmd->schema = schema;
+  if (!cmd->has_join) return schema;
 
-  uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
-  BufferPool* pool = &db->lake[schema_idx];
-
-  RowID row_start = {0};
-  Row* collected_rows = calloc(100, sizeof(Row));
-  if (!collected_rows) {
-    return (ExecutionResult){1, "Memory allocation failed for result rows"};
+  // joined rows carry both tables' columns and are read through the joined schema
+  if (!get_table_schema(db, cmd->join_table)) {
+    *error = "Error: Invalid schema for joined table";
+    return NULL;
   }
 
-  uint32_t total_found = 0;
-  for (uint16_t i = 0; i < pool->num_pages; i++) {
-    Page* page = pool->pages[i];
-    if (!page || page->num_rows == 0) continue;
-    for (uint16_t j = 0; j < page->num_rows; j++) {
-      Row* row = &page->rows[j];
-      if (!is_struct_zeroed(&row_start, sizeof(RowID))) {
-        if (row->id.page_id != row_start.page_id || row->id.row_id != row_start.row_id)
-          continue;
-      }
-
-      if (is_struct_zeroed(row, sizeof(Row))) continue;
-      if (row->deleted) continue;
-      if (cmd->has_where && !evaluate_condition(cmd->where, row, schema, db, schema_idx))  continue;
-
-      collected_rows[total_found] = *row;
-      total_found++;  
-      
-      if (!is_struct_zeroed(&row_start, sizeof(RowID)) && total_found > 0)
-        break;
-    }
-  }
+  load_btree_cluster(db, cmd->join_table);
+  return cmd->join_schema;
+}
 
-  if (cmd->has_order_by && total_found > 1) {
-    quick_sort_rows(collected_rows, 0, total_found - 1, cmd, schema);
+ExecutionResult execute_select(Database* db, JQLCommand* cmd) {
+  if (!db || !cmd || !cmd->schema) {
+    return (ExecutionResult){1, "Invalid execution context or command"};
   }
 
-  uint32_t start = cmd->has_offset ? cmd->offset : 0;
-  uint32_t max_out = cmd->has_limit  ? cmd->limit  : total_found;
-  uint32_t available = (start < total_found) ? (total_found - start) : 0;
-  uint32_t out_count = (available < max_out) ? available : max_out;
+  QueryProfile* profile = db->profile;
+  db->profile = NULL;
+  ProfileClock clock = profile_start(profile);
 
-  Row* result_rows = calloc(out_count, sizeof(Row));
-  char** aliases = malloc(sizeof(char*) * cmd->value_counts[0]);
-  for (int i = 0; i < cmd->value_counts[0]; i++) {
-    aliases[i] = malloc(256);
-  }
-  
-  if (!result_rows) {
-    free(collected_rows);
-    return (ExecutionResult){1, "Memory allocation failed for limited result rows"};
+  const char* bind_error = NULL;
+  TableSchema* rows_schema = bind_select(db, cmd, &bind_error);
+  if (!rows_schema) {
+    return (ExecutionResult){1, bind_error};
   }
+  profile_phase(profile, PHASE_BIND, &clock);
 
-  bool* is_aggregate_col = calloc(schema->column_count, sizeof(bool));
-  ColumnValue* aggregate_results = calloc(schema->column_count, sizeof(ColumnValue));
+  QueryOperator* pipeline = pipeline_build(db, cmd, rows_schema);
+  if (!pipeline || (profile && !pipeline_instrument(pipeline))) {
+    pipeline_free(pipeline);
+    return (ExecutionResult){1, "Memory allocation failed for select pipeline"};
+  }
+  profile_phase(profile, PHASE_PLAN, &clock);
 
-  for (int j = 0; j < schema->column_count; j++) {
+  char** aliases = malloc(sizeof(char*) * cmd->value_counts[0]);
+  for (int j = 0; j < cmd->value_counts[0]; j++) {
     ExprNode* expr = cmd->sel_columns[j].expr;
-    
-    if (expr && expr->type == EXPR_FUNCTION && expr->fn.type != NOT_AGG) {
-      is_aggregate_col[j] = true;
-      aggregate_results[j] = evaluate_aggregate(expr, collected_rows, total_found, schema, db, schema_idx);
+
+    if (cmd->sel_columns[j].alias) {
+      aliases[j] = strdup(cmd->sel_columns[j].alias);
+    } else if (!expr) {
+      aliases[j] = strdup("?column?");
+    } else if (expr->type == EXPR_ARRAY_ACCESS) {
+      int base_idx = expr->column.index;
+      int array_idx = expr->column.array_idx->literal.int_value;
+      const char* base_name = rows_schema->columns[base_idx].name;
+      char buffer[256];
+      snprintf(buffer, sizeof(buffer), "%s[%d]", base_name, array_idx);
+      aliases[j] = strdup(buffer);
+    } else if (expr->type == EXPR_FUNCTION) {
+      aliases[j] = strdup(expr->fn.name);
+    } else if (expr->type == EXPR_COLUMN) {
+      aliases[j] = strdup(rows_schema->columns[expr->column.index].name);
+    } else {
+      aliases[j] = strdup("?column?");
+    }
+  }
+
+  Row* result_rows = NULL;
+  uint32_t out_count = 0;
+  uint32_t capacity = 0;
+
+  Row row;
+  while (pipeline_next(pipeline, &row)) {
+    if (out_count == capacity) {
+      capacity = capacity ? capacity * 2 : 16;
+      Row* grown = realloc(result_rows, capacity * sizeof(Row));
+      if (!grown) {
+        free(row.values);
+        pipeline->error = "Memory allocation failed for result rows";
+        break;
+      }
+      result_rows = grown;
     }
+
+    result_rows[out_count++] = row;
   }
 
-  for (uint32_t i = 0; i < out_count; i++) {
-    Row* src = &collected_rows[start + i];
-    Row* dst = &result_rows[i];
-    
-    memset(dst, 0, sizeof(Row));
-    dst->id = src->id;
-    dst->values = calloc(schema->column_count, sizeof(ColumnValue));
-    dst->n_values = schema->column_count;
-    if (!dst->values) {
-      free(collected_rows);
-      free(result_rows);
-      free(is_aggregate_col);
-      free(aggregate_results);
-      return (ExecutionResult){1, "Memory allocation failed for projected values"};
-    }
-        
-  
-    for (int k = 0; k < schema->column_count; k++) {
-      dst->values[k].is_null = true;
-    }
+  const char* error = pipeline_error(pipeline);
+  profile_phase(profile, PHASE_EXECUTE, &clock);
 
-    int col_count = cmd->value_counts[0];
-
-    for (int j = 0; j < col_count; j++) {
-      ExprNode* expr = cmd->sel_columns[j].expr;
-      ColumnValue val = {0};
-
-      if (cmd->sel_columns[j].alias) {
-        aliases[j] = strdup(cmd->sel_columns[j].alias);
-      } else if (expr->type == EXPR_ARRAY_ACCESS) {
-        int base_idx = expr->column.index;
-        int array_idx = expr->column.array_idx->literal.int_value;
-        const char* base_name = cmd->schema->columns[base_idx].name;
-        char buffer[256];
-        snprintf(buffer, sizeof(buffer), "%s[%d]", base_name, array_idx);
-        aliases[j] = strdup(buffer);
-      } else if (expr->type == EXPR_FUNCTION) {
-        aliases[j] = strdup(expr->fn.name);
-      } else {
-        aliases[j] = strdup(cmd->schema->columns[expr->column.index].name);
-      }
-      
-      if (!expr) {
-        dst = src;
-        continue;
-      }
-      
-      if (is_aggregate_col[j]) {
-        dst->values[j] = aggregate_results[j];
-      } else {
-        val = evaluate_expression(expr, src, schema, db, schema_idx);
-        dst->values[j] = val;
-      }
+  // EXPLAIN ANALYZE reads the plan off the pipeline once it ran
+  if (profile) profile->pipeline = pipeline;
+  else pipeline_free(pipeline);
+
+  if (error) {
+    for (uint32_t i = 0; i < out_count; i++) {
+      free(result_rows[i].values);
     }
+    for (int j = 0; j < cmd->value_counts[0]; j++) {
+      free(aliases[j]);
+    }
+    free(aliases);
+    free(result_rows);
+    return (ExecutionResult){1, error};
   }
 
-  free(is_aggregate_col);
-  free(aggregate_results);
-  free(collected_rows);
-
   return (ExecutionResult){
     .code = 0,
     .message = "Select executed successfully",
@@ -864,6 +846,10 @@ ExecutionResult execute_update(Database* db, JQLCommand* cmd) {
   if (!db || !cmd || !cmd->schema) {
     return (ExecutionResult){1, "Invalid execution context or command"};
   }
+
+  QueryProfile* profile = db->profile;
+  db->profile = NULL;
+  ProfileClock clock = profile_start(profile);
   
   TableSchema* schema = get_table_schema(db, cmd->schema->table_name);
   if (!schema) {
@@ -879,73 +865,56 @@ ExecutionResult execute_update(Database* db, JQLCommand* cmd) {
 
   int fk_count = 0;
   Constraint* referencing_fks = get_fk_constr_ref_table(db, table_id, &fk_count);
+  ExecutionResult result = {0, "Success"};
 
   for (int i = 0; i < fk_count; i++) {
-    Constraint* fk = &referencing_fks[i];
-    if (fk->ref_column_count != fk->column_count) {
-      return (ExecutionResult){1, "Foreign key constraint validation failed: ref_column_count != column_count"};
-    }
-    if (!fk->on_update) {
-      return (ExecutionResult){1, "UPDATE restricted by foreign key constraint - ON UPDATE not enabled"};
+    if (referencing_fks[i].ref_column_count != referencing_fks[i].column_count) {
+      result = (ExecutionResult){1, "Foreign key constraint validation failed: ref_column_count != column_count"};
     }
   }
 
   RowSet update_set = {malloc(sizeof(RowID) * 4096), 0, 4096};
-  FKConstraintValues* old_fk = malloc(sizeof(FKConstraintValues) * fk_count);
-  FKConstraintValues* new_fk = malloc(sizeof(FKConstraintValues) * fk_count);
+  FKConstraintValues* fk_values = malloc(sizeof(FKConstraintValues) * (fk_count > 0 ? (size_t)fk_count : 1));
+  bool initialized = false;
 
-  if (!update_set.rows || !old_fk || !new_fk) {
-    free(update_set.rows);
-    free(old_fk);
-    free(new_fk);
-    return (ExecutionResult){1, "OOM"};
+  if (result.code == 0 && (!update_set.rows || !fk_values)) {
+    result = (ExecutionResult){1, "OOM"};
+  } else if (result.code == 0 && !(initialized = init_fk_constraints(fk_values, referencing_fks, fk_count, schema))) {
+    result = (ExecutionResult){1, "Foreign key references unknown column"};
   }
 
-  if (!init_fk_constraints(old_fk, referencing_fks, fk_count) ||
-      !init_fk_constraints(new_fk, referencing_fks, fk_count)) {
-    cleanup_fk_constraints(old_fk, fk_count);
-    cleanup_fk_constraints(new_fk, fk_count);
-    free(old_fk);
-    free(new_fk);
-    free(update_set.rows);
-    return (ExecutionResult){1, "OOM"};
-  }
+  profile_phase(profile, PHASE_BIND, &clock);
 
-  ExecutionResult result = collect_fk_tuples_update(db, schema, cmd, referencing_fks, fk_count,
-                                                   &update_set, old_fk, new_fk);
-  if (result.code != 0) {
-    cleanup_fk_constraints(old_fk, fk_count);
-    cleanup_fk_constraints(new_fk, fk_count);
-    free(old_fk);
-    free(new_fk);
-    free(update_set.rows);
-    return result;
+  // the scan also gathers the keys referencing rows follow, as the matching rows would change them
+  if (result.code == 0) {
+    result = collect_fk_tuples_update(db, schema, cmd, referencing_fks, fk_count, &update_set, fk_values);
   }
-  
-  LOG_DEBUG("Collected unique FK key tuples across %d constraints", fk_count);
-  for (int fk_idx = 0; fk_idx < fk_count; fk_idx++) {
+  profile_phase(profile, PHASE_COLLECT, &clock);
+
+  for (int fk_idx = 0; result.code == 0 && fk_idx < fk_count; fk_idx++) {
     Constraint* fk = &referencing_fks[fk_idx];
-    LOG_DEBUG("Constraint %s has %d unique key tuples", fk->name, old_fk[fk_idx].count);
+    LOG_DEBUG("Constraint %s has %d changed key tuples", fk->name, fk_values[fk_idx].keys.count);
     
-    if (!handle_on_update_constraints(db, fk, &(old_fk[fk_idx]), &(new_fk[fk_idx]))) {
-      cleanup_fk_constraints(old_fk, fk_count);
-      cleanup_fk_constraints(new_fk, fk_count);
-      free(old_fk);
-      free(new_fk);
-      free(update_set.rows);
-      return (ExecutionResult){1, "UPDATE restricted by foreign constraint"};
+    if (!handle_on_update_constraints(db, fk, &fk_values[fk_idx])) {
+      result = (ExecutionResult){1, "UPDATE restricted by foreign constraint"};
     }
   }
+  if (fk_count > 0) profile_phase(profile, PHASE_FK_ACTIONS, &clock);
 
+  if (result.code == 0) {
+    result = perform_updates(db, schema, cmd, &update_set);
+  }
+  profile_phase(profile, PHASE_WRITE, &clock);
 
-  result = perform_updates(db, schema, cmd, &update_set);
-
-  cleanup_fk_constraints(old_fk, fk_count);
-  cleanup_fk_constraints(new_fk, fk_count);
-  free(old_fk);
-  free(new_fk);
+  if (initialized) cleanup_fk_constraints(fk_values, fk_count);
+  free(fk_values);
   free(update_set.rows);
 
+  for (int i = 0; i < fk_count; i++) {
+    free_constraint(&referencing_fks[i]);
+  }
+  free(referencing_fks);
+
   return result;
 }
 
@@ -954,6 +923,10 @@ ExecutionResult execute_delete(Database* db, JQLCommand* cmd) {
     return (ExecutionResult){1, "Invalid execution context or command"};
   }
 
+  QueryProfile* profile = db->profile;
+  db->profile = NULL;
+  ProfileClock clock = profile_start(profile);
+
   TableSchema* schema = get_table_schema(db, cmd->schema->table_name);
   if (!schema) {
     return (ExecutionResult){1, "Error: Invalid schema"};
@@ -967,59 +940,20 @@ ExecutionResult execute_delete(Database* db, JQLCommand* cmd) {
     return (ExecutionResult){-1, "Table not found in catalog"};
   }
 
-  int fk_count = 0;
-  Constraint* referencing_fks = get_fk_constr_ref_table(db, table_id, &fk_count);
-
-  for (int i = 0; i < fk_count; i++) {
-    Constraint* fk = &referencing_fks[i];
-    if (fk->ref_column_count != fk->column_count) {
-      return (ExecutionResult){1, "Foreign key constraint validation failed: ref_column_count != column_count"};
-    }
-  }
-
   RowSet delete_set = {malloc(sizeof(RowID) * 4096), 0, 4096};
-  FKConstraintValues* fk_constraints = malloc(sizeof(FKConstraintValues) * fk_count);
-
-  if (!delete_set.rows || !fk_constraints) {
-    free(delete_set.rows); 
-    free(fk_constraints);
+  if (!delete_set.rows) {
     return (ExecutionResult){1, "OOM"};
   }
+  profile_phase(profile, PHASE_BIND, &clock);
 
-  if (!init_fk_constraints(fk_constraints, referencing_fks, fk_count)) {
-    cleanup_fk_constraints(fk_constraints, fk_count);
-    free(fk_constraints);
-    free(delete_set.rows);
-    return (ExecutionResult){1, "OOM"};
-  }
+  ExecutionResult result = collect_delete_set(db, schema, cmd, &delete_set);
+  profile_phase(profile, PHASE_COLLECT, &clock);
 
-  ExecutionResult result = collect_fk_tuples_delete(db, schema, cmd, referencing_fks, fk_count,
-                                                   &delete_set, fk_constraints);
-  if (result.code != 0) {
-    cleanup_fk_constraints(fk_constraints, fk_count);
-    free(fk_constraints);
-    free(delete_set.rows);
-    return result;
+  if (result.code == 0) {
+    result = delete_rows(db, schema, table_id, &delete_set, profile);
   }
 
-  LOG_DEBUG("Collected unique FK key tuples across %d constraints", fk_count);
-  for (int fk_idx = 0; fk_idx < fk_count; fk_idx++) {
-    Constraint* fk = &referencing_fks[fk_idx];
-    LOG_DEBUG("Constraint %s has %d unique key tuples", fk->name, fk_constraints[fk_idx].count);
-    
-    if (!handle_on_delete_constraints(db, fk, &fk_constraints[fk_idx])) {
-      cleanup_fk_constraints(fk_constraints, fk_count);
-      free(fk_constraints);
-      free(delete_set.rows);
-      return (ExecutionResult){1, "DELETE restricted by foreign constraint"};
-    }
-  }
-
-  result = perform_deletes(db, schema, &delete_set);
-
-  cleanup_fk_constraints(fk_constraints, fk_count);
-  free(fk_constraints);
   free(delete_set.rows);
 
   return result;
-}
\ No newline at end of file
+}
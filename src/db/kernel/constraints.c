@@ -1,16 +1,25 @@
 #include "kernel/kernel.h"
 
-bool init_fk_constraints(FKConstraintValues* fk_constraints, Constraint* referencing_fks, int count) {
+bool init_fk_constraints(FKConstraintValues* fk_constraints, Constraint* referencing_fks, int count, TableSchema* schema) {
   for (int i = 0; i < count; i++) {
-    fk_constraints[i].values = malloc(sizeof(ColumnValue) * 256 * referencing_fks[i].ref_column_count);
-    fk_constraints[i].count = 0;
-    fk_constraints[i].capacity = 256;
-    fk_constraints[i].column_idx = 0;
-    
-    if (!fk_constraints[i].values) {
-      for (int j = 0; j < i; j++) {
-        free(fk_constraints[j].values);
+    Constraint* fk = &referencing_fks[i];
+    uint8_t types[TUPLE_SET_MAX_WIDTH];
+    bool resolved = fk->ref_column_count > 0 && fk->ref_column_count <= TUPLE_SET_MAX_WIDTH;
+
+    for (int j = 0; resolved && j < fk->ref_column_count; j++) {
+      int column_idx = find_column_index(schema, fk->ref_columns[j]);
+      if (column_idx < 0) {
+        resolved = false;
+        break;
       }
+      types[j] = schema->columns[column_idx].type;
+    }
+
+    fk_constraints[i].new_values = NULL;
+    fk_constraints[i].capacity = 0;
+
+    if (!resolved || !tuple_set_init(&fk_constraints[i].keys, fk->ref_column_count, types, 256)) {
+      cleanup_fk_constraints(fk_constraints, i);
       return false;
     }
   }
@@ -87,7 +96,12 @@ int64_t insert_constraint(Database* db, int64_t table_id, char* name,
   char* ref_table_str = (ref_table != -1) ? (snprintf(ref_table_buf, sizeof(ref_table_buf), "%d", ref_table), ref_table_buf) : "NULL";
 
   char* check = process_str_arg(check_expr);
-  char** flags = CONSTRAINT_FLAGS[constraint_type];
+  if (constraint_type < CONSTRAINT_PRIMARY_KEY || constraint_type > CONSTRAINT_CHECK) {
+    LOG_ERROR("Unknown constraint type %d for '%s'", constraint_type, name);
+    return -1;
+  }
+
+  char** flags = CONSTRAINT_FLAGS[constraint_type - 1];
 
   ParserState state = parser_save_state(db->core->parser);
 
@@ -398,48 +412,193 @@ bool validate_not_null_constraint(Constraint* constraint, TableSchema* schema, C
   return true;
 }
 
+bool hash_constraint_key(BloomFilter* filter, TableSchema* schema, ColumnValue* values, int value_count, uint64_t* out_hash) {
+  uint64_t hash = 0;
+
+  for (uint8_t i = 0; i < filter->column_count; i++) {
+    uint8_t column_idx = filter->columns[i];
+    if (column_idx >= value_count) return false;
+
+    ColumnValue* value = &values[column_idx];
+
+    // NULLs never collide and TOAST / array keys are left to the query path
+    if (value->is_null) return false;
+    if (!hash_column_value(value, schema->columns[column_idx].type, &hash)) return false;
+  }
+
+  *out_hash = hash;
+  return true;
+}
+
+BloomFilter* build_constraint_bloom(Database* db, TableSchema* schema, Constraint* constraint, uint32_t expected_items) {
+  if (constraint->column_count <= 0 || constraint->column_count > BLOOM_MAX_KEY_COLUMNS) {
+    return NULL;
+  }
+
+  uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+  BufferPool* pool = &db->lake[schema_idx];
+  pool_materialize(pool, schema);
+
+  uint32_t live_rows = 0;
+  for (uint16_t page_idx = 0; page_idx < pool->num_pages; page_idx++) {
+    Page* page = pool->pages[page_idx];
+    if (page) live_rows += page->num_rows;
+  }
+
+  if (expected_items < live_rows * 2) expected_items = live_rows * 2;
+
+  BloomFilter* filter = bloom_create(expected_items);
+  if (!filter) return NULL;
+
+  filter->id = (uint32_t)constraint->id;
+  filter->column_count = constraint->column_count;
+
+  for (int i = 0; i < constraint->column_count; i++) {
+    int column_idx = find_column_index(schema, constraint->columns[i]);
+    if (column_idx < 0) {
+      bloom_destroy(filter);
+      return NULL;
+    }
+    filter->columns[i] = (uint8_t)column_idx;
+  }
+
+  for (uint16_t page_idx = 0; page_idx < pool->num_pages; page_idx++) {
+    Page* page = pool->pages[page_idx];
+    if (!page || page->num_rows == 0) continue;
+
+    for (uint16_t row_idx = 0; row_idx < page->num_rows; row_idx++) {
+      Row* row = &page->rows[row_idx];
+      if (is_struct_zeroed(row, sizeof(Row)) || row->deleted) continue;
+
+      uint64_t key_hash;
+      if (hash_constraint_key(filter, schema, row->values, row->n_values, &key_hash)) {
+        bloom_add(filter, key_hash);
+      }
+    }
+  }
+
+  return filter;
+}
+
+BloomFilter* get_constraint_bloom(Database* db, TableSchema* schema, Constraint* constraint) {
+  uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+  TableCatalogEntry* tc = &db->tc[schema_idx];
+
+  if (!tc->bloom_loaded) {
+    load_table_blooms(db, schema);
+  }
+
+  for (uint8_t i = 0; i < tc->bloom_count; i++) {
+    BloomFilter* filter = tc->bloom[i];
+    if (filter->id != (uint32_t)constraint->id) continue;
+
+    if (bloom_is_saturated(filter)) {
+      BloomFilter* grown = build_constraint_bloom(db, schema, constraint, filter->item_count * 2);
+      if (grown) {
+        bloom_destroy(filter);
+        tc->bloom[i] = grown;
+      }
+    }
+
+    return tc->bloom[i];
+  }
+
+  if (tc->bloom_count >= BLOOM_MAX_FILTERS) {
+    return NULL;
+  }
+
+  BloomFilter* filter = build_constraint_bloom(db, schema, constraint, 0);
+  if (filter) {
+    tc->bloom[tc->bloom_count++] = filter;
+  }
+
+  return filter;
+}
+
+void track_constraint_blooms(Database* db, TableSchema* schema, ColumnValue* values, int value_count, bool is_insert) {
+  uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+  TableCatalogEntry* tc = &db->tc[schema_idx];
+
+  if (!tc->bloom_loaded) {
+    load_table_blooms(db, schema);
+  }
+
+  for (uint8_t i = 0; i < tc->bloom_count; i++) {
+    uint64_t key_hash;
+    if (!hash_constraint_key(tc->bloom[i], schema, values, value_count, &key_hash)) continue;
+
+    if (is_insert) {
+      bloom_add(tc->bloom[i], key_hash);
+    } else {
+      bloom_remove(tc->bloom[i], key_hash);
+    }
+  }
+}
+
 bool validate_unique_constraint(Database* db, Constraint* constraint, TableSchema* schema, ColumnValue* values, int value_count) {
   if (!db->core) db->core = db;
 
-  ParserState state = parser_save_state(db->core->parser);
+  BloomFilter* filter = get_constraint_bloom(db, schema, constraint);
+  uint64_t key_hash;
+
+  if (filter && hash_constraint_key(filter, schema, values, value_count, &key_hash) &&
+      !bloom_might_contain(filter, key_hash)) {
+    return true;
+  }
+
+  // the duplicate probe is parsed once per constraint and re-bound with each row's key
+  char stmt_name[MAX_IDENTIFIER_LEN];
+  snprintf(stmt_name, sizeof(stmt_name), "jb_unique_%.200s_%lld", schema->table_name, (long long)constraint->id);
+
+  PreparedStatement* stmt = find_prepared_statement(db, stmt_name);
 
   char where_clause[1024] = {0};
-  bool first = true;
+  ColumnValue params[MAX_PARAMS];
+  uint16_t param_count = 0;
   
-  for (int i = 0; i < constraint->column_count; i++) {
+  for (int i = 0; i < constraint->column_count && param_count < MAX_PARAMS; i++) {
     int column_idx = find_column_index(schema, constraint->columns[i]);
 
     if (column_idx >= 0 && column_idx < value_count) {
-      if (!first) {
-        strncat(where_clause, " AND ", 5);
-      }
-
-      char value_str[256] = {0};
-      format_column_value(value_str, sizeof(value_str), &values[column_idx]);
+      if (!stmt) {
+        if (param_count > 0) {
+          strncat(where_clause, " AND ", 5);
+        }
 
-      char condition[512] = {0};
-      snprintf(condition, sizeof(condition), "%s = %s", constraint->columns[i], value_str);
+        char condition[512] = {0};
+        snprintf(condition, sizeof(condition), "%s = $%u", constraint->columns[i], param_count + 1);
 
-      strncat(where_clause, condition, strlen(condition));
+        strncat(where_clause, condition, strlen(condition));
+      }
 
-      first = false;
+      params[param_count++] = values[column_idx];
     } else {
       printf("Skipping column: index invalid or out of value range.\n");
     }
   }
 
-  char query[2048];
-  snprintf(query, sizeof(query),
-    "SELECT COUNT() FROM %s WHERE %s;", schema->table_name, where_clause);
+  if (!stmt) {
+    char query[2048];
+    snprintf(query, sizeof(query),
+      "SELECT COUNT() FROM %s WHERE %s;", schema->table_name, where_clause);
+
+    ParserState state = parser_save_state(db->core->parser);
+    stmt = prepare_statement(db, stmt_name, query);
+    parser_restore_state(db->core->parser, state);
+
+    if (!stmt) {
+      LOG_ERROR("Failed to prepare UNIQUE check for constraint '%s'", constraint->name);
+      return false;
+    }
+  }
       
-  Result res = process_silent(db, query);
-  bool is_unique = (res.exec.code == 0 && res.exec.row_count <= 0);
+  Result res = execute_prepared(db, stmt, params, param_count, false);
+  bool is_unique = (res.exec.code == 0 && res.exec.row_count > 0 && res.exec.rows[0].values[0].int_value == 0);
 
   if (!is_unique) {
     LOG_ERROR("UNIQUE constraint '%s' violated", constraint->name);
   }
 
-  parser_restore_state(db->core->parser, state);
   free_result(&res);
 
   return is_unique;
@@ -450,58 +609,89 @@ bool validate_primary_key_constraint(Database* db, Constraint* constraint, Table
          validate_unique_constraint(db, constraint, schema, values, value_count);
 }
 
+bool fk_key_exists(Database* db, TableSchema* ref_schema, char** ref_columns, int ref_column_count, ColumnValue* key) {
+  uint8_t ref_idx = hash_fnv1a(ref_schema->table_name, MAX_TABLES);
+  int columns[TUPLE_SET_MAX_WIDTH];
+
+  for (int i = 0; i < ref_column_count; i++) {
+    columns[i] = find_column_index(ref_schema, ref_columns[i]);
+    if (columns[i] < 0) return false;
+  }
+
+  ColumnDefinition* first = &ref_schema->columns[columns[0]];
+
+  if (ref_column_count == 1 && first->is_primary_key && !key[0].is_toast && !key[0].is_array) {
+    load_btree_cluster(db, ref_schema->table_name);
+    BTree* tree = db->tc[ref_idx].btree[hash_fnv1a(first->name, MAX_COLUMNS)];
+
+    ColumnValue probe = key[0];
+    if (tree && infer_and_cast_value(&probe, first)) {
+      RowID rid = btree_search(tree, get_column_value_as_pointer(&probe));
+      return !is_struct_zeroed(&rid, sizeof(RowID));
+    }
+  }
+
+  BufferPool* pool = &db->lake[ref_idx];
+  pool_materialize(pool, ref_schema);
+
+  for (uint16_t page_idx = 0; page_idx < pool->num_pages; page_idx++) {
+    Page* page = pool->pages[page_idx];
+    if (!page || page->num_rows == 0) continue;
+
+    for (uint16_t row_idx = 0; row_idx < page->num_rows; row_idx++) {
+      Row* row = &page->rows[row_idx];
+      if (is_struct_zeroed(row, sizeof(Row)) || row->deleted) continue;
+
+      bool match = true;
+      for (int i = 0; i < ref_column_count && match; i++) {
+        match = column_values_equal(&row->values[columns[i]], &key[i], ref_schema->columns[columns[i]].type);
+      }
+
+      if (match) return true;
+    }
+  }
+
+  return false;
+}
+
 bool validate_foreign_key_constraint(Database* db, Constraint* constraint, TableSchema* schema, ColumnValue* values, int value_count) {
   if (!db->core) db->core = db;
 
-  ParserState state = parser_save_state(db->core->parser);
-
-  TableSchema* ref_schema = get_table_schema_by_id(db, constraint->ref_table_id);
-  
-  if (!ref_schema) {
-    LOG_ERROR("Referenced table not found for constraint '%s'", constraint->name);
-    parser_restore_state(db->core->parser, state);
+  if (constraint->column_count != constraint->ref_column_count ||
+      constraint->column_count <= 0 || constraint->column_count > TUPLE_SET_MAX_WIDTH) {
+    LOG_ERROR("Malformed FOREIGN KEY constraint '%s'", constraint->name);
     return false;
   }
 
-  char where_clause[1024] = {0};
-  bool first = true;
-  
-  for (int i = 0; i < constraint->column_count && i < constraint->ref_column_count; i++) {
+  ColumnValue key[TUPLE_SET_MAX_WIDTH];
+
+  for (int i = 0; i < constraint->column_count; i++) {
     int column_idx = find_column_index(schema, constraint->columns[i]);
-    if (column_idx >= 0 && column_idx < value_count) {
-      if (!first) {
-        strcat(where_clause, " AND ");
-      }
-      
-      char value_str[256];
-      format_column_value(value_str, sizeof(value_str), &values[column_idx]);
-      
-      char condition[512];
-      snprintf(condition, sizeof(condition), "%s = %s", 
-        constraint->ref_columns[i], value_str);
-      strcat(where_clause, condition);
-      
-      first = false;
+    if (column_idx < 0 || column_idx >= value_count) {
+      LOG_ERROR("Column '%s' of constraint '%s' not found", constraint->columns[i], constraint->name);
+      return false;
     }
+
+    // MATCH SIMPLE: a NULL in any referencing column exempts the row
+    if (values[column_idx].is_null) return true;
+    key[i] = values[column_idx];
   }
 
-  if (!where_clause) return true;
+  ParserState state = parser_save_state(db->core->parser);
+  TableSchema* ref_schema = get_table_schema_by_id(db, constraint->ref_table_id);
+  parser_restore_state(db->core->parser, state);
 
-  char query[2048];
-  snprintf(query, sizeof(query),
-    "SELECT COUNT() FROM %s WHERE %s;", ref_schema->table_name, where_clause);
+  if (!ref_schema) {
+    LOG_ERROR("Referenced table not found for constraint '%s'", constraint->name);
+    return false;
+  }
 
-  Result res = process_silent(db, query);
-  bool fk_valid = (res.exec.code == 0 && res.exec.row_count > 0 && 
-                   res.exec.rows[0].values[0].int_value > 0);
+  bool fk_valid = fk_key_exists(db, ref_schema, constraint->ref_columns, constraint->ref_column_count, key);
 
   if (!fk_valid) {
     LOG_ERROR("FOREIGN KEY constraint '%s' violated", constraint->name);
   }
 
-  parser_restore_state(db->core->parser, state);
-  free_result(&res);
-
   return fk_valid;
 }
 
@@ -559,7 +749,9 @@ bool validate_constraint(Database* db, Constraint* constraint, TableSchema* sche
 
 void cleanup_fk_constraints(FKConstraintValues* fk_constraints, int count) {
   for (int i = 0; i < count; i++) {
-    free(fk_constraints[i].values);
+    tuple_set_free(&fk_constraints[i].keys);
+    free(fk_constraints[i].new_values);
+    fk_constraints[i].new_values = NULL;
   }
 }
 
@@ -575,58 +767,29 @@ bool expand_row_set(RowSet* set) {
 }
 
 bool expand_fk_constraint(FKConstraintValues* fk_constraint, int ref_col_count) {
-  if (fk_constraint->count < fk_constraint->capacity) return true;
-  
-  fk_constraint->capacity <<= 1;
-  ColumnValue* new_vals = realloc(fk_constraint->values, 
-                                 sizeof(ColumnValue) * fk_constraint->capacity * ref_col_count);
+  if (fk_constraint->capacity >= fk_constraint->keys.capacity) return true;
+
+  uint32_t capacity = fk_constraint->keys.capacity;
+  ColumnValue* new_vals = realloc(fk_constraint->new_values, 
+                                 sizeof(ColumnValue) * capacity * ref_col_count);
   if (!new_vals) return false;
   
-  fk_constraint->values = new_vals;
+  fk_constraint->new_values = new_vals;
+  fk_constraint->capacity = capacity;
   return true;
 }
 
-bool tuple_exists(FKConstraintValues* fk_constraint, ColumnValue* key_tuple, 
-                        Constraint* fk, TableSchema* schema) {
-  for (uint32_t i = 0; i < fk_constraint->count; i++) {
-    ColumnValue* existing = &fk_constraint->values[i * fk->ref_column_count];
-    bool match = true;
-    
-    for (uint8_t col_idx = 0; col_idx < fk->ref_column_count; col_idx++) {
-      int schema_col_idx = find_column_index(schema, fk->ref_columns[col_idx]);
-      void* existing_val = get_column_value_as_pointer(&existing[col_idx]);
-      void* new_val = get_column_value_as_pointer(&key_tuple[col_idx]);
-      int type = schema->columns[schema_col_idx].type;
-      
-      if (key_compare(existing_val, new_val, type) != 0) {
-        match = false;
-        break;
-      }
-    }
-    
-    if (match) return true;
-  }
-  return false;
-}
-
-bool store_fk_tuple(FKConstraintValues* fk_constraint, ColumnValue* key_tuple, 
-                          Constraint* fk, TableSchema* schema) {
-  if (tuple_exists(fk_constraint, key_tuple, fk, schema)) return true;
-  
-  if (!expand_fk_constraint(fk_constraint, fk->ref_column_count)) return false;
-  
-  ColumnValue* dest = &fk_constraint->values[fk_constraint->count * fk->ref_column_count];
-  for (uint8_t col_idx = 0; col_idx < fk->ref_column_count; col_idx++) {
-    dest[col_idx] = key_tuple[col_idx];
-  }
-  fk_constraint->count++;
-  return true;
+int64_t store_fk_tuple(FKConstraintValues* fk_constraint, ColumnValue* key_tuple, bool* inserted) {
+  return tuple_set_insert(&fk_constraint->keys, key_tuple, inserted);
 }
 
 bool extract_fk_tuple(Row* row, TableSchema* schema, Constraint* fk, ColumnValue* tuple) {
   for (uint8_t col_idx = 0; col_idx < fk->ref_column_count; col_idx++) {
     int schema_col_idx = find_column_index(schema, fk->ref_columns[col_idx]);
     if (schema_col_idx == -1) return false;
+
+    // a NULL key can never be referenced
+    if (row->values[schema_col_idx].is_null) return false;
     tuple[col_idx] = row->values[schema_col_idx];
   }
   return true;
@@ -634,41 +797,39 @@ bool extract_fk_tuple(Row* row, TableSchema* schema, Constraint* fk, ColumnValue
 
 ExecutionResult collect_fk_tuples_update(Database* db, TableSchema* schema, JQLCommand* cmd,
   Constraint* referencing_fks, int fk_count,
-  RowSet* update_set, FKConstraintValues* old_fk,
-  FKConstraintValues* new_fk) {
+  RowSet* update_set, FKConstraintValues* fk_values) {
   uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
   BufferPool* pool = &db->lake[schema_idx];
+  pool_materialize(pool, schema);
+
+  ScanSelection* selection = scan_select_rows(db, cmd, schema, schema_idx);
+  if (!selection) return (ExecutionResult){1, "OOM"};
 
-  for (uint16_t page_idx = 0; page_idx < pool->num_pages; ++page_idx) {
+  ExecutionResult result = {0, "Success"};
+
+  for (uint16_t page_idx = 0; page_idx < selection->page_count; ++page_idx) {
     Page* page = pool->pages[page_idx];
     if (!page || page->num_rows == 0) continue;
 
-    for (uint16_t row_idx = 0; row_idx < page->num_rows; ++row_idx) {
+    for (uint16_t i = 0; i < selection->counts[page_idx]; i++) {
+      uint16_t row_idx = selection->sel[page_idx][i];
       Row* row = &page->rows[row_idx];
 
-      if (row->deleted || !row) continue;
-      if (cmd->has_where && !evaluate_condition(cmd->where, row, schema, db, schema_idx)) continue;
-
-      if (!expand_row_set(update_set)) return (ExecutionResult){1, "OOM"};
+      if (!expand_row_set(update_set)) {
+        result = (ExecutionResult){1, "OOM"};
+        goto cleanup;
+      }
       update_set->rows[update_set->count++] = (RowID){page_idx, row_idx};
 
       for (int fk_idx = 0; fk_idx < fk_count; fk_idx++) {
         Constraint* fk = &referencing_fks[fk_idx];
 
-        ColumnValue* old_tuple = malloc(sizeof(ColumnValue) * fk->ref_column_count);
-        ColumnValue* new_tuple = malloc(sizeof(ColumnValue) * fk->ref_column_count);
+        ColumnValue old_tuple[TUPLE_SET_MAX_WIDTH];
+        ColumnValue new_tuple[TUPLE_SET_MAX_WIDTH];
 
-        if (!old_tuple || !new_tuple) {
-          free(old_tuple);
-          free(new_tuple);
-          return (ExecutionResult){1, "OOM"};
-        }
+        if (!extract_fk_tuple(row, schema, fk, old_tuple)) continue;
 
-        if (!extract_fk_tuple(row, schema, fk, old_tuple)) {
-          free(old_tuple);
-          free(new_tuple);
-          continue;
-        }
+        bool key_changed = false;
 
         for (uint8_t col_idx = 0; col_idx < fk->ref_column_count; col_idx++) {
           int schema_col_idx = find_column_index(schema, fk->ref_columns[col_idx]);
@@ -682,13 +843,11 @@ ExecutionResult collect_fk_tuples_update(Database* db, TableSchema* schema, JQLC
               ColumnValue array_idx = evaluate_expression(cmd->update_columns->array_idx, row, schema, db, schema_idx);
 
               if (!infer_and_cast_value(&eval, &schema->columns[schema_col_idx])) {
-                free(old_tuple);
-                free(new_tuple);
-                return (ExecutionResult){1, "Invalid type casting in FK update"};
+                result = (ExecutionResult){1, "Invalid type casting in FK update"};
+                goto cleanup;
               }
 
               if (!is_struct_zeroed(&array_idx, sizeof(ColumnValue))) {
-                new_value = new_value;
                 new_value.array.array_value[array_idx.int_value] = eval;
               } else {
                 new_value = eval;
@@ -700,69 +859,110 @@ ExecutionResult collect_fk_tuples_update(Database* db, TableSchema* schema, JQLC
           }
 
           new_tuple[col_idx] = will_update ? new_value : row->values[schema_col_idx];
+
+          if (!column_values_equal(&old_tuple[col_idx], &new_tuple[col_idx], schema->columns[schema_col_idx].type)) {
+            key_changed = true;
+          }
         }
 
-        if (!store_fk_tuple(&old_fk[fk_idx], old_tuple, fk, schema) ||
-          !store_fk_tuple(&new_fk[fk_idx], new_tuple, fk, schema)) {
-          free(old_tuple);
-          free(new_tuple);
-          return (ExecutionResult){1, "OOM"};
+        // rows keeping their key leave referencing rows untouched
+        if (!key_changed) continue;
+
+        bool inserted = false;
+        int64_t key_idx = store_fk_tuple(&fk_values[fk_idx], old_tuple, &inserted);
+
+        if (key_idx < 0 || !expand_fk_constraint(&fk_values[fk_idx], fk->ref_column_count)) {
+          result = (ExecutionResult){1, "OOM"};
+          goto cleanup;
         }
 
-        free(old_tuple);
-        free(new_tuple);
+        if (inserted) {
+          memcpy(&fk_values[fk_idx].new_values[key_idx * fk->ref_column_count], new_tuple,
+                 sizeof(ColumnValue) * fk->ref_column_count);
+        }
       }
     }
   }
 
-  return (ExecutionResult){0, "Success"};
+cleanup:
+  free(selection);
+  return result;
 }
 
-ExecutionResult collect_fk_tuples_delete(Database* db, TableSchema* schema, JQLCommand* cmd,
-                                               Constraint* referencing_fks, int fk_count,
-                                               RowSet* delete_set, FKConstraintValues* fk_constraints) {
+ExecutionResult collect_delete_set(Database* db, TableSchema* schema, JQLCommand* cmd, RowSet* delete_set) {
   uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
   BufferPool* pool = &db->lake[schema_idx];
+  pool_materialize(pool, schema);
 
-  for (uint16_t page_idx = 0; page_idx < pool->num_pages; page_idx++) {
+  ScanSelection* selection = scan_select_rows(db, cmd, schema, schema_idx);
+  if (!selection) return (ExecutionResult){1, "OOM"};
+
+  for (uint16_t page_idx = 0; page_idx < selection->page_count; page_idx++) {
     Page* page = pool->pages[page_idx];
     if (!page || page->num_rows == 0) continue;
 
-    for (uint16_t row_idx = 0; row_idx < page->num_rows; row_idx++) {
-      Row* row = &page->rows[row_idx];
-
-      if (is_struct_zeroed(row, sizeof(Row)) || row->deleted) continue;
-      if (cmd->has_where && !evaluate_condition(cmd->where, row, schema, db, schema_idx)) continue;
+    for (uint16_t i = 0; i < selection->counts[page_idx]; i++) {
+      uint16_t row_idx = selection->sel[page_idx][i];
 
-      if (!expand_row_set(delete_set)) return (ExecutionResult){1, "OOM"};
+      if (!expand_row_set(delete_set)) {
+        free(selection);
+        return (ExecutionResult){1, "OOM"};
+      }
       delete_set->rows[delete_set->count++] = (RowID){page_idx, row_idx};
+    }
+  }
 
-      for (int fk_idx = 0; fk_idx < fk_count; fk_idx++) {
-        Constraint* fk = &referencing_fks[fk_idx];
-        
-        ColumnValue* key_tuple = malloc(sizeof(ColumnValue) * fk->ref_column_count);
-        if (!key_tuple) return (ExecutionResult){1, "OOM"};
-        
-        if (extract_fk_tuple(row, schema, fk, key_tuple)) {
-          if (!store_fk_tuple(&fk_constraints[fk_idx], key_tuple, fk, schema)) {
-            free(key_tuple);
-            return (ExecutionResult){1, "OOM"};
-          }
-        }
-        
-        free(key_tuple);
+  free(selection);
+  return (ExecutionResult){0, "Success"};
+}
+
+ExecutionResult collect_fk_tuples_delete(Database* db, TableSchema* schema,
+                                               Constraint* referencing_fks, int fk_count,
+                                               RowSet* delete_set, FKConstraintValues* fk_values) {
+  uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+  BufferPool* pool = &db->lake[schema_idx];
+
+  for (uint32_t i = 0; i < delete_set->count; i++) {
+    Row* row = &pool->pages[delete_set->rows[i].page_id]->rows[delete_set->rows[i].row_id];
+
+    for (int fk_idx = 0; fk_idx < fk_count; fk_idx++) {
+      ColumnValue key_tuple[TUPLE_SET_MAX_WIDTH];
+
+      if (extract_fk_tuple(row, schema, &referencing_fks[fk_idx], key_tuple) &&
+          store_fk_tuple(&fk_values[fk_idx], key_tuple, NULL) < 0) {
+        return (ExecutionResult){1, "OOM"};
       }
     }
   }
+
   return (ExecutionResult){0, "Success"};
 }
 
+void reindex_primary_keys(Database* db, TableSchema* schema, Row* row, uint16_t* cols, ColumnValue* old_vals, int count) {
+  uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+
+  for (int i = 0; i < count; i++) {
+    ColumnDefinition* def = &schema->columns[cols[i]];
+    if (!def->is_primary_key) continue;
+
+    BTree* tree = db->tc[schema_idx].btree[hash_fnv1a(def->name, MAX_COLUMNS)];
+    if (!tree) continue;
+
+    btree_delete(tree, get_column_value_as_pointer(&old_vals[i]));
+    if (!btree_insert(tree, get_column_value_as_pointer(&row->values[cols[i]]), row->id)) {
+      LOG_WARN("Warning: failed to re-index PK '%s' in B-tree", def->name);
+    }
+  }
+}
+
 ExecutionResult perform_updates(Database* db, TableSchema* schema, JQLCommand* cmd, RowSet* update_set) {
   uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
   BufferPool* pool = &db->lake[schema_idx];
   size_t null_bitmap_size = (schema->column_count + 7) / 8;
   uint32_t rows_updated = 0;
 
+  ExprProgram* program = expr_program_compile(cmd->values[0], cmd->value_counts[0], schema, db);
+
   for (uint32_t i = 0; i < update_set->count; i++) {
     uint16_t page_idx = update_set->rows[i].page_id;
     uint16_t row_idx = update_set->rows[i].row_id;
@@ -779,18 +979,25 @@ ExecutionResult perform_updates(Database* db, TableSchema* schema, JQLCommand* c
     };
 
     if (!upd.cols || !upd.old_vals || !upd.new_vals) {
+      expr_program_free(program);
       free(upd.cols);
       free(upd.old_vals);
       free(upd.new_vals);
       return (ExecutionResult){1, "OOM"};
     }
 
+    if (program) {
+      expr_program_run(program, row, schema, db, schema_idx);
+    }
+
     for (int k = 0; k < max_updates; ++k) {
       int col_index = cmd->update_columns[k].index;
-      ColumnValue eval = evaluate_expression(cmd->values[0][k], row, schema, db, schema_idx);
+      ColumnValue eval = program ? expr_program_result(program, k) :
+        evaluate_expression(cmd->values[0][k], row, schema, db, schema_idx);
       ColumnValue array_idx = evaluate_expression(cmd->update_columns->array_idx, row, schema, db, schema_idx);
       
       if (!infer_and_cast_value(&eval, &schema->columns[col_index])) {
+        expr_program_free(program);
         free(upd.cols);
         free(upd.old_vals);
         free(upd.new_vals);
@@ -811,11 +1018,17 @@ ExecutionResult perform_updates(Database* db, TableSchema* schema, JQLCommand* c
     
     if (upd.count > 0) {
       write_update_wal(db->wal, schema_idx, page_idx, row_idx, upd.cols, upd.old_vals, upd.new_vals, upd.count, schema);
+      track_constraint_blooms(db, schema, row->values, schema->column_count, false);
+      track_statistics(db, schema, row->values, schema->column_count, false);
       
       for (int u = 0; u < upd.count; ++u) {
         row->values[upd.cols[u]] = upd.new_vals[u];
       }
 
+      track_constraint_blooms(db, schema, row->values, schema->column_count, true);
+      track_statistics(db, schema, row->values, schema->column_count, true);
+      reindex_primary_keys(db, schema, row, upd.cols, upd.old_vals, upd.count);
+
       if (cmd->bitmap) {
         row->null_bitmap = (uint8_t*)malloc(null_bitmap_size);
         memcpy(row->null_bitmap, cmd->bitmap, null_bitmap_size);
@@ -823,6 +1036,8 @@ ExecutionResult perform_updates(Database* db, TableSchema* schema, JQLCommand* c
         row->null_bitmap = (uint8_t*)calloc(null_bitmap_size, 1);
       }
 
+      page_zone_add(page, row, schema);
+
       rows_updated++;
       page->is_dirty = true;
     }
@@ -832,6 +1047,8 @@ ExecutionResult perform_updates(Database* db, TableSchema* schema, JQLCommand* c
     free(upd.new_vals);
   }
 
+  expr_program_free(program);
+  if (rows_updated) result_cache_invalidate(db, schema_idx);
   return (ExecutionResult){0, "Update executed successfully", .row_count = rows_updated};
 }
 
@@ -846,6 +1063,7 @@ ExecutionResult perform_deletes(Database* db, TableSchema* schema, RowSet* delet
 
     Page* page = pool->pages[page_idx];
     Row* row = &page->rows[row_idx];
+    if (!row->values) continue;
 
     write_delete_wal(db->wal, schema_idx, page_idx, row_idx, row, schema);
 
@@ -866,6 +1084,9 @@ ExecutionResult perform_deletes(Database* db, TableSchema* schema, RowSet* delet
       }
     }
 
+    track_constraint_blooms(db, schema, row->values, schema->column_count, false);
+    track_statistics(db, schema, row->values, schema->column_count, false);
+
     RowID id = {page_idx, row_idx + 1};
     serialize_delete(pool, id);
 
@@ -873,63 +1094,237 @@ ExecutionResult perform_deletes(Database* db, TableSchema* schema, RowSet* delet
     rows_deleted++;
   }
 
+  if (rows_deleted) result_cache_invalidate(db, schema_idx);
   return (ExecutionResult){0, "Delete executed successfully", .row_count = rows_deleted};
 }
 
-bool cascade_delete(Database* db, int64_t referencing_table_id, char** ref_columns, int ref_column_count, ColumnValue* values, int value_count) {
-  TableSchema* ref_schema = get_table_schema_by_id(db, referencing_table_id);
-  if (!ref_schema) {
-    LOG_WARN("Referenced table schema not found for ID: %ld", referencing_table_id);
-    return false;
+ExecutionResult delete_rows(Database* db, TableSchema* schema, int64_t table_id, RowSet* delete_set, QueryProfile* profile) {
+  uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+  BufferPool* pool = &db->lake[schema_idx];
+  ProfileClock clock = profile_start(profile);
+
+  int fk_count = 0;
+  Constraint* referencing_fks = get_fk_constr_ref_table(db, table_id, &fk_count);
+  ExecutionResult result = {0, "Success"};
+
+  for (int i = 0; i < fk_count; i++) {
+    if (referencing_fks[i].ref_column_count != referencing_fks[i].column_count) {
+      result = (ExecutionResult){1, "Foreign key constraint validation failed: ref_column_count != column_count"};
+    }
   }
 
-  for (int i = 0; i < value_count; i++) {
-    char where_clause[512] = {0};
-    bool first = true;
+  FKConstraintValues* fk_values = malloc(sizeof(FKConstraintValues) * (fk_count > 0 ? (size_t)fk_count : 1));
+  bool initialized = false;
 
-    for (int j = 0; j < ref_column_count; j++) {
-      if (!first) strcat(where_clause, " AND ");
+  if (result.code == 0 && !fk_values) {
+    result = (ExecutionResult){1, "OOM"};
+  } else if (result.code == 0 && !(initialized = init_fk_constraints(fk_values, referencing_fks, fk_count, schema))) {
+    result = (ExecutionResult){1, "Foreign key references unknown column"};
+  }
 
-      int idx = find_column_index(ref_schema, ref_columns[j]);
-      if (idx == -1) {
-        LOG_WARN("Reference column '%s' not found in schema '%s'", ref_columns[j], ref_schema->table_name);
-        return false;
+  if (result.code == 0) {
+    result = collect_fk_tuples_delete(db, schema, referencing_fks, fk_count, delete_set, fk_values);
+  }
+  if (fk_count > 0) profile_phase(profile, PHASE_FK_COLLECT, &clock);
+
+  if (result.code == 0) {
+    // hide the doomed rows so cascades through self references never revisit them
+    for (uint32_t i = 0; i < delete_set->count; i++) {
+      pool->pages[delete_set->rows[i].page_id]->rows[delete_set->rows[i].row_id].deleted = true;
+    }
+
+    for (int fk_idx = 0; fk_idx < fk_count; fk_idx++) {
+      LOG_DEBUG("Constraint %s has %d unique key tuples", referencing_fks[fk_idx].name, fk_values[fk_idx].keys.count);
+
+      if (!handle_on_delete_constraints(db, &referencing_fks[fk_idx], &fk_values[fk_idx])) {
+        result = (ExecutionResult){1, "DELETE restricted by foreign constraint"};
+        break;
       }
+    }
 
-      char value_str[256];
-      format_column_value(value_str, sizeof(value_str), &values[i * ref_column_count + j]);
+    if (result.code != 0) {
+      for (uint32_t i = 0; i < delete_set->count; i++) {
+        pool->pages[delete_set->rows[i].page_id]->rows[delete_set->rows[i].row_id].deleted = false;
+      }
+    }
+  }
+  if (fk_count > 0) profile_phase(profile, PHASE_FK_ACTIONS, &clock);
 
-      char condition[512];
-      snprintf(condition, sizeof(condition), "%s = %s", ref_columns[j], value_str);
-      strcat(where_clause, condition);
+  if (result.code == 0) {
+    result = perform_deletes(db, schema, delete_set);
+  }
+  profile_phase(profile, PHASE_WRITE, &clock);
 
-      first = false;
+  if (initialized) cleanup_fk_constraints(fk_values, fk_count);
+  free(fk_values);
+
+  for (int i = 0; i < fk_count; i++) {
+    free_constraint(&referencing_fks[i]);
+  }
+  free(referencing_fks);
+
+  return result;
+}
+
+bool resolve_fk_columns(TableSchema* schema, char** columns, int column_count, int* out) {
+  if (column_count <= 0 || column_count > TUPLE_SET_MAX_WIDTH) return false;
+
+  for (int i = 0; i < column_count; i++) {
+    out[i] = find_column_index(schema, columns[i]);
+    if (out[i] < 0) {
+      LOG_WARN("Reference column '%s' not found in schema '%s'", columns[i], schema->table_name);
+      return false;
     }
+  }
 
-    char query[1024];
-    snprintf(query, sizeof(query), "DELETE FROM %s WHERE %s;", ref_schema->table_name, where_clause);
+  return true;
+}
 
-    // LOG_DEBUG("[~frnkey cascade delete]: %s", query);
+bool collect_referencing_rows(Database* db, TableSchema* schema, Constraint* fk, FKConstraintValues* fk_values, RowSet* out) {
+  uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+  BufferPool* pool = &db->lake[schema_idx];
+  pool_materialize(pool, schema);
 
-    ParserState state = parser_save_state(db->core->parser);
-    Result res = process(db, query);
-    parser_restore_state(db->core->parser, state);
+  int columns[TUPLE_SET_MAX_WIDTH];
+  if (!resolve_fk_columns(schema, fk->columns, fk->column_count, columns)) return false;
+  if (fk_values->keys.count == 0) return true;
 
-    bool success = (res.exec.code == 0);
-    
-    if (!success) {
-      LOG_ERROR("Cascade delete failed for table '%s': %s", ref_schema->table_name, query);
-      free_result(&res);
+  ColumnDefinition* first = &schema->columns[columns[0]];
+
+  if (fk->column_count == 1 && first->is_primary_key) {
+    load_btree_cluster(db, schema->table_name);
+    BTree* tree = db->tc[schema_idx].btree[hash_fnv1a(first->name, MAX_COLUMNS)];
+
+    if (tree) {
+      // one index probe per distinct parent key
+      for (uint32_t k = 0; k < fk_values->keys.count; k++) {
+        ColumnValue probe = *tuple_set_get(&fk_values->keys, k);
+        if (!infer_and_cast_value(&probe, first)) continue;
+
+        RowID rid = btree_search(tree, get_column_value_as_pointer(&probe));
+        if (is_struct_zeroed(&rid, sizeof(RowID))) continue;
+
+        for (uint16_t page_idx = 0; page_idx < pool->num_pages; page_idx++) {
+          Page* page = pool->pages[page_idx];
+          if (!page || page->page_id != rid.page_id || rid.row_id == 0 || rid.row_id > page->num_rows) continue;
+
+          Row* row = &page->rows[rid.row_id - 1];
+          if (is_struct_zeroed(row, sizeof(Row)) || row->deleted) break;
+
+          if (!expand_row_set(out)) return false;
+          out->rows[out->count++] = (RowID){page_idx, rid.row_id - 1};
+          break;
+        }
+      }
+
+      return true;
+    }
+  }
+
+  // no index on the referencing columns: one pass probing the distinct parent keys
+  ColumnValue tuple[TUPLE_SET_MAX_WIDTH];
+
+  for (uint16_t page_idx = 0; page_idx < pool->num_pages; page_idx++) {
+    Page* page = pool->pages[page_idx];
+    if (!page || page->num_rows == 0) continue;
+
+    for (uint16_t row_idx = 0; row_idx < page->num_rows; row_idx++) {
+      Row* row = &page->rows[row_idx];
+      if (is_struct_zeroed(row, sizeof(Row)) || row->deleted) continue;
+
+      bool has_null = false;
+      for (int i = 0; i < fk->column_count; i++) {
+        tuple[i] = row->values[columns[i]];
+        has_null |= tuple[i].is_null;
+      }
+
+      if (has_null || tuple_set_find(&fk_values->keys, tuple) < 0) continue;
+
+      if (!expand_row_set(out)) return false;
+      out->rows[out->count++] = (RowID){page_idx, row_idx};
+    }
+  }
+
+  return true;
+}
+
+bool update_referencing_row(Database* db, TableSchema* schema, RowID rid, int* columns, int column_count, ColumnValue* new_values) {
+  uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+  Page* page = db->lake[schema_idx].pages[rid.page_id];
+  Row* row = &page->rows[rid.row_id];
+
+  uint16_t cols[TUPLE_SET_MAX_WIDTH];
+  ColumnValue old_vals[TUPLE_SET_MAX_WIDTH];
+  ColumnValue new_vals[TUPLE_SET_MAX_WIDTH];
+
+  for (int i = 0; i < column_count; i++) {
+    cols[i] = columns[i];
+    old_vals[i] = row->values[columns[i]];
+    new_vals[i] = new_values[i];
+
+    if (!new_vals[i].is_null && !infer_and_cast_value(&new_vals[i], &schema->columns[columns[i]])) {
+      LOG_ERROR("Invalid conversion whilst propagating key into '%s'", schema->table_name);
       return false;
     }
+  }
 
-    LOG_INFO("Cascade deleted %d rows from table '%s'", res.exec.row_count, ref_schema->table_name);
-    free_result(&res);
+  write_update_wal(db->wal, schema_idx, rid.page_id, rid.row_id, cols, old_vals, new_vals, column_count, schema);
+  track_constraint_blooms(db, schema, row->values, schema->column_count, false);
+  track_statistics(db, schema, row->values, schema->column_count, false);
+
+  for (int i = 0; i < column_count; i++) {
+    row->values[cols[i]] = new_vals[i];
+
+    if (row->null_bitmap) {
+      if (new_vals[i].is_null) {
+        row->null_bitmap[cols[i] / 8] |= (1 << (cols[i] % 8));
+      } else {
+        row->null_bitmap[cols[i] / 8] &= ~(1 << (cols[i] % 8));
+      }
+    }
   }
 
+  track_constraint_blooms(db, schema, row->values, schema->column_count, true);
+  track_statistics(db, schema, row->values, schema->column_count, true);
+  reindex_primary_keys(db, schema, row, cols, old_vals, column_count);
+  page_zone_add(page, row, schema);
+  page->is_dirty = true;
+  result_cache_invalidate(db, schema_idx);
+
   return true;
 }
 
+bool cascade_delete(Database* db, Constraint* fk, FKConstraintValues* fk_values) {
+  TableSchema* ref_schema = get_table_schema_by_id(db, fk->table_id);
+  if (!ref_schema) {
+    LOG_WARN("Referencing table schema not found for ID: %ld", fk->table_id);
+    return false;
+  }
+
+  RowSet delete_set = {malloc(sizeof(RowID) * 64), 0, 64};
+  if (!delete_set.rows) return false;
+
+  if (!collect_referencing_rows(db, ref_schema, fk, fk_values, &delete_set)) {
+    free(delete_set.rows);
+    return false;
+  }
+
+  bool success = true;
+  if (delete_set.count > 0) {
+    ExecutionResult res = delete_rows(db, ref_schema, fk->table_id, &delete_set, NULL);
+    success = res.code == 0;
+
+    if (success) {
+      LOG_INFO("Cascade deleted %d rows from table '%s'", res.row_count, ref_schema->table_name);
+    } else {
+      LOG_ERROR("Cascade delete failed for table '%s': %s", ref_schema->table_name, res.message);
+    }
+  }
+
+  free(delete_set.rows);
+  return success;
+}
+
 Constraint* get_fk_constr_ref_table(Database* db, int64_t table_id, int* out_count) {
   if (!db || !out_count) return NULL;
 
@@ -969,349 +1364,140 @@ Constraint* get_fk_constr_ref_table(Database* db, int64_t table_id, int* out_cou
   return constraints;
 }
 
-bool set_null_on_delete(Database* db, int64_t referencing_table_id, char** ref_columns, int ref_column_count, ColumnValue* values, int value_count) {
-  TableSchema* ref_schema = get_table_schema_by_id(db, referencing_table_id);
+bool assign_referencing_rows(Database* db, Constraint* fk, FKConstraintValues* fk_values, bool use_default) {
+  TableSchema* ref_schema = get_table_schema_by_id(db, fk->table_id);
   if (!ref_schema) {
     return false;
   }
 
-  char set_clause[512] = {0};
-  bool first = true;
-  
-  for (int i = 0; i < ref_column_count; i++) {
-    if (!first) {
-      strcat(set_clause, ", ");
-    }
-    
-    char set_part[128];
-    snprintf(set_part, sizeof(set_part), "%s = NULL", ref_columns[i]);
-    strcat(set_clause, set_part);
-    
-    first = false;
-  }
-
-  char where_clause[1024] = {0};
-  first = true;
-  
-  for (int i = 0; i < ref_column_count && i < value_count; i++) {
-    if (!first) {
-      strcat(where_clause, " AND ");
-    }
-    
-    char value_str[256];
-    format_column_value(value_str, sizeof(value_str), &values[i]);
-    
-    char condition[512];
-    snprintf(condition, sizeof(condition), "%s = %s", ref_columns[i], value_str);
-    strcat(where_clause, condition);
-    
-    first = false;
-  }
-
-  char query[2048];
-  snprintf(query, sizeof(query), "UPDATE %s SET %s WHERE %s;", 
-    ref_schema->table_name, set_clause, where_clause);
-
-  LOG_DEBUG("[~frnkey set null]: %s", query);
-
-  ParserState state = parser_save_state(db->core->parser);
-  Result res = process_silent(db->core, query);
-  parser_restore_state(db->core->parser, state);
-
-  bool success = (res.exec.code == 0);
-  free_result(&res);
+  int columns[TUPLE_SET_MAX_WIDTH];
+  ColumnValue new_values[TUPLE_SET_MAX_WIDTH];
 
-  return success;
-}
+  if (!resolve_fk_columns(ref_schema, fk->columns, fk->column_count, columns)) return false;
 
-bool set_default_on_delete(Database* db, int64_t referencing_table_id, char** ref_columns, int ref_column_count, ColumnValue* values, int value_count) {
-  TableSchema* ref_schema = get_table_schema_by_id(db, referencing_table_id);
-  if (!ref_schema) {
-    return false;
-  }
+  for (int i = 0; i < fk->column_count; i++) {
+    ColumnDefinition* def = &ref_schema->columns[columns[i]];
 
-  char set_clause[512] = {0};
-  bool first = true;
-  
-  for (int i = 0; i < ref_column_count; i++) {
-    if (!first) {
-      strcat(set_clause, ", ");
-    }
-    
-    int col_idx = find_column_index(ref_schema, ref_columns[i]);
-    char set_part[128];
-    
-    if (col_idx >= 0 && ref_schema->columns[col_idx].default_value) {
-      snprintf(set_part, sizeof(set_part), "%s = %s", 
-        ref_columns[i], ref_schema->columns[col_idx].default_value);
+    if (use_default && def->has_default && def->default_value) {
+      new_values[i] = *def->default_value;
     } else {
-      snprintf(set_part, sizeof(set_part), "%s = NULL", ref_columns[i]);
+      new_values[i] = (ColumnValue){0};
+      new_values[i].type = def->type;
+      new_values[i].is_null = true;
     }
-    
-    strcat(set_clause, set_part);
-    first = false;
   }
 
-  char where_clause[1024] = {0};
-  first = true;
-  
-  for (int i = 0; i < ref_column_count && i < value_count; i++) {
-    if (!first) {
-      strcat(where_clause, " AND ");
-    }
-    
-    char value_str[256];
-    format_column_value(value_str, sizeof(value_str), &values[i]);
-    
-    char condition[512];
-    snprintf(condition, sizeof(condition), "%s = %s", ref_columns[i], value_str);
-    strcat(where_clause, condition);
-    
-    first = false;
-  }
+  RowSet rows = {malloc(sizeof(RowID) * 64), 0, 64};
+  if (!rows.rows) return false;
 
-  char query[2048];
-  snprintf(query, sizeof(query), "UPDATE %s SET %s WHERE %s;", 
-    ref_schema->table_name, set_clause, where_clause);
-
-  ParserState state = parser_save_state(db->core->parser);
-  Result res = process_silent(db->core, query);
-  parser_restore_state(db->core->parser, state);
+  bool success = collect_referencing_rows(db, ref_schema, fk, fk_values, &rows);
 
-  bool success = (res.exec.code == 0);
-  free_result(&res);
+  for (uint32_t i = 0; success && i < rows.count; i++) {
+    success = update_referencing_row(db, ref_schema, rows.rows[i], columns, fk->column_count, new_values);
+  }
 
+  free(rows.rows);
   return success;
 }
 
-bool check_no_del_references(Database* db, int64_t referencing_table_id, char** ref_columns, int ref_column_count, ColumnValue* values, int value_count) {
-  TableSchema* ref_schema = get_table_schema_by_id(db, referencing_table_id);
-  if (!ref_schema) {
-    return false;
-  }
-
-  char where_clause[1024] = {0};
-  bool first = true;
-
-  for (int i = 0; i < value_count; i++) {
-    LOG_DEBUG("at %i %s", i, str_column_value(&(values[i])));
-  }
-  
-  for (int i = 0; i < ref_column_count && i < value_count; i++) {
-    if (!first) {
-      strncat(where_clause, " AND ", sizeof(where_clause) - strlen(where_clause) - 1);
-    }
-
-    int idx = find_column_index(ref_schema, ref_columns[i]);
-    
-    char value_str[256];
-    LOG_DEBUG("At %s/%d got %s", ref_columns[i], idx, str_column_value(&values[i]));
-    format_column_value(value_str, sizeof(value_str), &values[i]);
-    
-    char condition[512];
-    snprintf(condition, sizeof(condition), "%s = %s", ref_columns[i], value_str);
-    strncat(where_clause, condition, sizeof(where_clause) - strlen(where_clause) - 1);
-    
-    first = false;
-  }
-
-  char query[2048];
-  snprintf(query, sizeof(query), "SELECT COUNT() FROM %s WHERE %s;", 
-    ref_schema->table_name, where_clause);
-
-  LOG_DEBUG("[~frnkey no references]: %s", query);
-
-  ParserState state = parser_save_state(db->core->parser);
-  Result res = process(db, query);
-  parser_restore_state(db->core->parser, state);
-
-  bool no_references = false;
-  if (res.exec.code == 0 && res.exec.row_count == 1) {
-    // char* count_str = res.exec.rows[0].columns[0];
-    // int count = atoi(count_str);
-    no_references = true;
-  }
-
-  if (!no_references) {
-    LOG_INFO("Operation restricted due to foreign key references in table '%s'", 
-      ref_schema->table_name);
-  }
-
-  free_result(&res);
+bool set_null_on_delete(Database* db, Constraint* fk, FKConstraintValues* fk_values) {
+  return assign_referencing_rows(db, fk, fk_values, false);
+}
 
-  return no_references;
+bool set_default_on_delete(Database* db, Constraint* fk, FKConstraintValues* fk_values) {
+  return assign_referencing_rows(db, fk, fk_values, true);
 }
 
-bool check_no_references(Database* db, int64_t referencing_table_id, char** ref_columns, int ref_column_count, ColumnValue* values, int value_count) {
-  TableSchema* ref_schema = get_table_schema_by_id(db, referencing_table_id);
+bool check_no_references(Database* db, Constraint* fk, FKConstraintValues* fk_values) {
+  TableSchema* ref_schema = get_table_schema_by_id(db, fk->table_id);
   if (!ref_schema) return false;
 
-  for (int i = 0; i < value_count; i++) {
-    char where_clause[512] = {0};
-    bool first = true;
-
-    for (int j = 0; j < ref_column_count; j++) {
-      if (!first) strcat(where_clause, " AND ");
-
-      int idx = find_column_index(ref_schema, ref_columns[j]);
-      if (idx == -1) {
-        LOG_WARN("Reference column '%s' not found in schema '%s'", ref_columns[j], ref_schema->table_name);
-        return false;
-      }
-
-      char value_str[256];
-      format_column_value(value_str, sizeof(value_str), &values[i * ref_column_count + j]);
-
-      char condition[512];
-      snprintf(condition, sizeof(condition), "%s = %s", ref_columns[j], value_str);
-      strcat(where_clause, condition);
+  RowSet rows = {malloc(sizeof(RowID) * 64), 0, 64};
+  if (!rows.rows) return false;
 
-      first = false;
-    }
-
-    char query[1024];
-    snprintf(query, sizeof(query), "SELECT COUNT() FROM %s WHERE %s;", ref_schema->table_name, where_clause);
+  bool no_references = collect_referencing_rows(db, ref_schema, fk, fk_values, &rows) && rows.count == 0;
 
-    LOG_DEBUG("[~frnkey no references]: %s", query);
-
-    ParserState state = parser_save_state(db->core->parser);
-    Result res = process(db, query);
-    parser_restore_state(db->core->parser, state);
-
-    bool no_references = (res.exec.code == 0 && res.exec.row_count == 0);
-
-    if (!no_references) {
-      LOG_INFO("Operation restricted due to foreign key references in table '%s'", ref_schema->table_name);
-      free_result(&res);
-      return false; 
-    }
-
-    free_result(&res);
+  if (!no_references) {
+    LOG_INFO("Operation restricted due to foreign key references in table '%s'", ref_schema->table_name);
   }
 
-  return true;
+  free(rows.rows);
+  return no_references;
 }
 
-bool cascade_update(Database* db, int64_t referencing_table_id, char** ref_columns, int ref_column_count, ColumnValue* old_values, ColumnValue* new_values, int value_count) {
-  TableSchema* ref_schema = get_table_schema_by_id(db, referencing_table_id);
+bool cascade_update(Database* db, Constraint* fk, FKConstraintValues* fk_values) {
+  TableSchema* ref_schema = get_table_schema_by_id(db, fk->table_id);
   if (!ref_schema) {
-    LOG_WARN("Referenced table schema not found for ID: %ld", referencing_table_id);
+    LOG_WARN("Referencing table schema not found for ID: %ld", fk->table_id);
     return false;
   }
 
-  for (int j = 0; j < ref_column_count; j++) {
-    int idx = find_column_index(ref_schema, ref_columns[j]);
-    if (idx == -1) {
-      LOG_WARN("Reference column '%s' not found in schema '%s'", ref_columns[j], ref_schema->table_name);
-      return false;
-    }
-  }
+  uint8_t schema_idx = hash_fnv1a(ref_schema->table_name, MAX_TABLES);
+  BufferPool* pool = &db->lake[schema_idx];
 
-  for (int i = 0; i < value_count; i++) {
-    char set_clause[512] = {0};
-    bool first = true;
-    
-    for (int j = 0; j < ref_column_count; j++) {
-      if (!first) strcat(set_clause, ", ");
-      
-      char value_str[256];
-      format_column_value(value_str, sizeof(value_str), &new_values[j]);
-      
-      char set_part[256];
-      snprintf(set_part, sizeof(set_part), "%s = %s", ref_columns[j], value_str);
-      strcat(set_clause, set_part);
-      
-      first = false;
-    }
+  int columns[TUPLE_SET_MAX_WIDTH];
+  if (!resolve_fk_columns(ref_schema, fk->columns, fk->column_count, columns)) return false;
 
-    char where_clause[512] = {0};
-    first = true;
-    
-    for (int j = 0; j < ref_column_count; j++) {
-      if (!first) strcat(where_clause, " AND ");
-      
-      char value_str[256];
-      format_column_value(value_str, sizeof(value_str), &old_values[j]);
-      
-      char condition[512];
-      snprintf(condition, sizeof(condition), "%s = %s", ref_columns[j], value_str);
-      strcat(where_clause, condition);
-      
-      first = false;
-    }
+  RowSet rows = {malloc(sizeof(RowID) * 64), 0, 64};
+  if (!rows.rows) return false;
 
-    char query[2048];
-    snprintf(query, sizeof(query), "UPDATE %s SET %s WHERE %s;", 
-      ref_schema->table_name, set_clause, where_clause);
+  bool success = collect_referencing_rows(db, ref_schema, fk, fk_values, &rows);
 
-    LOG_DEBUG("[~frnkey cascade update]: %s", query);
+  for (uint32_t i = 0; success && i < rows.count; i++) {
+    Row* row = &pool->pages[rows.rows[i].page_id]->rows[rows.rows[i].row_id];
 
-    ParserState state = parser_save_state(db->core->parser);
-    Result res = process(db, query);
-    parser_restore_state(db->core->parser, state);
-
-    bool success = (res.exec.code == 0);
-    
-    if (!success) {
-      LOG_ERROR("Cascade update failed for table '%s': %s", ref_schema->table_name, query);
-      free_result(&res);
-      return false;
+    ColumnValue key[TUPLE_SET_MAX_WIDTH];
+    for (int j = 0; j < fk->column_count; j++) {
+      key[j] = row->values[columns[j]];
     }
 
-    LOG_INFO("Cascade updated %d rows in table '%s'", res.exec.row_count, ref_schema->table_name);
-    free_result(&res);
+    int64_t key_idx = tuple_set_find(&fk_values->keys, key);
+    if (key_idx < 0) continue;
+
+    success = update_referencing_row(db, ref_schema, rows.rows[i], columns, fk->column_count,
+                                     &fk_values->new_values[key_idx * fk->column_count]);
   }
 
-  return true;
+  if (success) {
+    LOG_INFO("Cascade updated %d rows in table '%s'", rows.count, ref_schema->table_name);
+  } else {
+    LOG_ERROR("Cascade update failed for table '%s'", ref_schema->table_name);
+  }
+
+  free(rows.rows);
+  return success;
 }
 
-bool handle_on_update_constraints(Database* db, Constraint* constraint, FKConstraintValues* old_fk, FKConstraintValues* new_fk) {
-  if (!db || !constraint || !old_fk || !new_fk) return false;
+bool handle_on_update_constraints(Database* db, Constraint* constraint, FKConstraintValues* fk_values) {
+  if (!db || !constraint || !fk_values) return false;
+  if (fk_values->keys.count == 0) return true;
 
   switch (constraint->on_update) {
     case FK_CASCADE:
-      if (!cascade_update(db, constraint->table_id, constraint->columns,
-                          constraint->column_count, old_fk->values, 
-                          new_fk->values, constraint->column_count)) {
-        return false;
-      }
-      return true;
+      return cascade_update(db, constraint, fk_values);
     case FK_SET_NULL:
-      if (!set_null_on_delete(db, constraint->table_id, constraint->columns,
-                              constraint->column_count, old_fk->values, 
-                              constraint->column_count)) {
-        return false;
-      }
-      return true;
+      return set_null_on_delete(db, constraint, fk_values);
     case FK_RESTRICT:
-      for (int i = 0; i < old_fk->count; i++) {
-        if (!check_no_references(db, constraint->table_id, constraint->columns,
-                                constraint->column_count, old_fk->values, 
-                                constraint->column_count)) {
-          return false;
-        }
-      }
-      return true;
     case FK_NO_ACTION:
     default:
-      return true;
+      return check_no_references(db, constraint, fk_values);
   }
 }
 
 bool handle_on_delete_constraints(Database* db, Constraint* constraint, FKConstraintValues* fk_constraint) {
+  if (fk_constraint->keys.count == 0) return true;
+
   bool success = true;
 
   switch (constraint->on_delete) {
     case FK_CASCADE:
-      success = cascade_delete(db, constraint->table_id, constraint->columns, 
-        constraint->column_count, fk_constraint->values, fk_constraint->count
-      );
+      success = cascade_delete(db, constraint, fk_constraint);
+      break;
+    case FK_SET_NULL:
+      success = set_null_on_delete(db, constraint, fk_constraint);
       break;
-    // case FK_SET_NULL:
     case FK_RESTRICT:
-      success = check_no_references(db, constraint->table_id, constraint->columns, 
-        constraint->column_count, fk_constraint->values, fk_constraint->count
-      );
+      success = check_no_references(db, constraint, fk_constraint);
       break;
     case FK_NO_ACTION:
     default:
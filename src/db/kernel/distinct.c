@@ -0,0 +1,210 @@
+#include "kernel/kernel.h"
+
+/*
+  Hash DISTINCT for SELECT. Rows coming out of the scan, join or group
+  operator are keyed on the values of their select list, and only the first
+  row of every key is passed on, ahead of any sorting or limiting. Keys live
+  in a TupleSet typed by each value (TOK_T_TBEV), so computed columns hash the
+  same way stored ones do.
+
+  Once the set holds as many keys as the memory budget allows, rows whose key
+  it has not seen are hashed into one of a few partition files under the tmp
+  directory instead. No key is shared between two partitions or between a
+  partition and the set, so when the input ends each partition is
+  deduplicated on its own with the set emptied, and may split again up to a
+  fixed depth. Rows read back from a partition own their strings: repeated
+  ones are released right away, and the first row of every key stays with
+  the table, which frees whatever strings the result did not take over.
+*/
+
+bool distinct_table_init(DistinctTable* table, Database* db, JQLCommand* cmd, TableSchema* schema, size_t memory_budget) {
+  memset(table, 0, sizeof(DistinctTable));
+  table->db = db;
+  table->cmd = cmd;
+  table->schema = schema;
+  table->schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+
+  uint8_t width = cmd->value_counts[0];
+  uint8_t types[UINT8_MAX];
+  memset(types, TOK_T_TBEV, sizeof(types));
+
+  table->key = malloc(width * sizeof(ColumnValue));
+  if (!table->key || !tuple_set_init(&table->seen, width, types, 0)) {
+    table->error = "Memory allocation failed for DISTINCT keys";
+    return false;
+  }
+
+  if (memory_budget > 0) {
+    size_t per_key = width * sizeof(ColumnValue) + sizeof(uint64_t) + 2 * sizeof(uint32_t);
+    size_t max_keys = memory_budget / per_key;
+    table->max_keys = max_keys < 16 ? 16 : (max_keys > UINT32_MAX / 2 ? UINT32_MAX / 2 : (uint32_t)max_keys);
+  }
+
+  return true;
+}
+
+static void distinct_key(DistinctTable* table, Row* row) {
+  JQLCommand* cmd = table->cmd;
+
+  for (int j = 0; j < cmd->value_counts[0]; j++) {
+    table->key[j] = evaluate_expression(cmd->sel_columns[j].expr, row, table->schema, table->db, table->schema_idx);
+  }
+}
+
+static bool distinct_spill(DistinctTable* table, Row* row) {
+  uint64_t h;
+  if (!hash_tuple(table->key, table->seen.width, table->seen.types, &h)) {
+    table->error = "DISTINCT cannot compare array values";
+    return false;
+  }
+
+  // reseeded per level so a partition that splits again spreads over new files
+  h ^= (uint64_t)(table->depth + 1) * 0x9E3779B97F4A7C15ULL;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+
+  GroupPartition* part = &table->spill[h >> (64 - 3)];
+
+  if (!part->file) {
+    snprintf(part->path, MAX_PATH_LENGTH, "%s" SEP "distinct_%p_%u.part",
+      table->db->fs->tmp_dir, (void*)table, table->spill_files++);
+    part->depth = table->depth + 1;
+
+    part->file = fopen(part->path, "w+b");
+    if (!part->file) {
+      LOG_ERROR("Failed to open distinct partition file: %s", part->path);
+      table->error = "Failed to spill DISTINCT partition";
+      return false;
+    }
+  }
+
+  if (!write_spill_row(part->file, row, table->schema)) {
+    LOG_ERROR("Failed to write distinct partition file: %s", part->path);
+    table->error = "Failed to spill DISTINCT partition";
+    return false;
+  }
+
+  return true;
+}
+
+bool distinct_table_add(DistinctTable* table, Row* row, bool* is_new) {
+  *is_new = false;
+  distinct_key(table, row);
+
+  if (tuple_set_find(&table->seen, table->key) >= 0) return true;
+
+  if (table->max_keys && table->seen.count >= table->max_keys && table->depth < DISTINCT_MAX_SPILL_DEPTH) {
+    return distinct_spill(table, row);
+  }
+
+  if (tuple_set_insert(&table->seen, table->key, NULL) < 0) {
+    table->error = "DISTINCT cannot compare array values";
+    return false;
+  }
+
+  *is_new = true;
+  return true;
+}
+
+static bool distinct_retire(DistinctTable* table, Row* row) {
+  Row* retired = realloc(table->retired, (table->retired_count + 1) * sizeof(Row));
+  if (!retired) {
+    table->error = "Memory allocation failed for DISTINCT rows";
+    return false;
+  }
+
+  table->retired = retired;
+  table->retired[table->retired_count++] = *row;
+  return true;
+}
+
+// queues the partitions filled so far and opens the next one with an empty set
+static bool distinct_load_partition(DistinctTable* table) {
+  for (int p = 0; p < DISTINCT_SPILL_PARTITIONS; p++) {
+    GroupPartition* part = &table->spill[p];
+    if (!part->file) continue;
+
+    GroupPartition* pending = realloc(table->pending, (table->pending_count + 1) * sizeof(GroupPartition));
+    if (!pending) {
+      table->error = "Memory allocation failed for DISTINCT partitions";
+      return false;
+    }
+    table->pending = pending;
+
+    rewind(part->file);
+    table->pending[table->pending_count++] = *part;
+    memset(part, 0, sizeof(GroupPartition));
+  }
+
+  if (table->pending_count == 0) return false;
+
+  table->reading = table->pending[--table->pending_count];
+  table->depth = table->reading.depth;
+  tuple_set_clear(&table->seen);
+
+  LOG_DEBUG("Deduplicating spilled partition %s at depth %u", table->reading.path, table->reading.depth);
+  return true;
+}
+
+static void distinct_close_partition(DistinctTable* table) {
+  fclose(table->reading.file);
+  remove(table->reading.path);
+  memset(&table->reading, 0, sizeof(GroupPartition));
+}
+
+bool distinct_table_next_spilled(DistinctTable* table, Row* out) {
+  while (table->reading.file || distinct_load_partition(table)) {
+    Row row;
+    while (read_spill_row(table->reading.file, &row, table->schema)) {
+      bool is_new;
+      if (!distinct_table_add(table, &row, &is_new)) {
+        free_spill_row(&row);
+        return false;
+      }
+
+      if (!is_new) {
+        free_spill_row(&row);
+        continue;
+      }
+
+      // the row is still referenced downstream, its values go when the table does
+      if (!distinct_retire(table, &row)) {
+        free_spill_row(&row);
+        return false;
+      }
+
+      *out = row;
+      return true;
+    }
+
+    distinct_close_partition(table);
+  }
+
+  return false;
+}
+
+void distinct_table_free(DistinctTable* table) {
+  if (!table) return;
+
+  if (table->reading.file) distinct_close_partition(table);
+
+  for (int p = 0; p < DISTINCT_SPILL_PARTITIONS; p++) {
+    if (!table->spill[p].file) continue;
+    fclose(table->spill[p].file);
+    remove(table->spill[p].path);
+  }
+  for (uint32_t i = 0; i < table->pending_count; i++) {
+    fclose(table->pending[i].file);
+    remove(table->pending[i].path);
+  }
+  for (uint32_t i = 0; i < table->retired_count; i++) {
+    free_spill_row(&table->retired[i]);
+  }
+
+  tuple_set_free(&table->seen);
+  free(table->pending);
+  free(table->retired);
+  free(table->key);
+  memset(table, 0, sizeof(DistinctTable));
+}
@@ -0,0 +1,372 @@
+#include "kernel/kernel.h"
+
+/*
+  EXPLAIN and EXPLAIN ANALYZE. The plan comes back as one TEXT row per
+  line. EXPLAIN only plans the statement: a SELECT has its pipeline built
+  and described operator by operator with the access path the statistics
+  chose, an UPDATE or DELETE reports the scan that finds its rows and the
+  foreign keys that reference the table.
+
+  EXPLAIN ANALYZE also runs the statement, writes included, and reports
+  what every operator did along with the time spent in each phase of it.
+*/
+
+#define EXPLAIN_LINE_LENGTH 256
+
+typedef struct ExplainOutput {
+  Row* rows;
+  uint32_t count;
+  uint32_t capacity;
+  bool failed;
+} ExplainOutput;
+
+static uint64_t clock_ns(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+ProfileClock profile_now(void) {
+  return (ProfileClock){ clock_ns(CLOCK_MONOTONIC), clock_ns(CLOCK_PROCESS_CPUTIME_ID) };
+}
+
+// statements only read the clocks when someone is profiling them
+ProfileClock profile_start(QueryProfile* profile) {
+  return profile ? profile_now() : (ProfileClock){0};
+}
+
+void profile_add(ProfileClock* total, ProfileClock* since) {
+  ProfileClock now = profile_now();
+  total->wall_ns += now.wall_ns - since->wall_ns;
+  total->cpu_ns += now.cpu_ns - since->cpu_ns;
+  *since = now;
+}
+
+void profile_phase(QueryProfile* profile, ProfilePhase phase, ProfileClock* since) {
+  if (!profile) return;
+
+  profile->ran[phase] = true;
+  profile_add(&profile->phases[phase], since);
+}
+
+static double ms(uint64_t ns) {
+  return (double)ns / 1000000.0;
+}
+
+static void explain_line(ExplainOutput* out, uint8_t depth, bool detail, const char* fmt, ...) {
+  if (out->failed) return;
+
+  if (out->count == out->capacity) {
+    uint32_t capacity = out->capacity ? out->capacity * 2 : 16;
+    Row* grown = realloc(out->rows, capacity * sizeof(Row));
+    if (!grown) {
+      out->failed = true;
+      return;
+    }
+    out->rows = grown;
+    out->capacity = capacity;
+  }
+
+  char line[EXPLAIN_LINE_LENGTH];
+  int indent = depth * 2 + (detail ? (depth ? 5 : 2) : 0);
+  int written = snprintf(line, sizeof(line), "%*s%s", indent, "", !detail && depth ? "-> " : "");
+
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(line + written, sizeof(line) - written, fmt, args);
+  va_end(args);
+
+  ColumnValue* value = calloc(1, sizeof(ColumnValue));
+  char* text = strdup(line);
+  if (!value || !text) {
+    free(value);
+    free(text);
+    out->failed = true;
+    return;
+  }
+
+  value->type = TOK_T_TEXT;
+  value->str_value = text;
+  out->rows[out->count++] = (Row){ .values = value, .n_values = 1 };
+}
+
+static void explain_scan(ExplainOutput* out, QueryOperator* op, uint8_t depth) {
+  char* table = op->schema->table_name;
+  AccessPlan* plan = &op->scan.plan;
+
+  if (op->scan.counted) {
+    TableStatistics* stats = table_statistics(op->db, op->schema);
+    explain_line(out, depth, false, "Row Count on %s  (rows=%llu)", table,
+      (unsigned long long)(stats ? stats->row_count : 0));
+    return;
+  }
+
+  if (plan->method == ACCESS_PK_LOOKUP) {
+    explain_line(out, depth, false, "Primary Key Lookup on %s using %s  (cost=%.2f rows=%.0f)", table,
+      op->schema->columns[plan->column].name, plan->lookup_cost, plan->rows);
+    explain_line(out, depth, true, "Seq Scan cost: %.2f", plan->seq_cost);
+    return;
+  }
+
+  explain_line(out, depth, false, "Seq Scan on %s  (cost=%.2f rows=%.0f)", table, plan->seq_cost, plan->rows);
+
+  if (op->cmd->has_where) {
+    explain_line(out, depth, true, "Filter: %s%s", op->scan.filter || op->scan.drain ? "vectorized" : "row by row",
+      op->scan.drain ? ", across the scan workers before the first row" : "");
+  }
+
+  if (op->cmd->sample_method != SAMPLE_NONE) {
+    explain_line(out, depth, true, "Sample: %s (%.2f%%)",
+      op->cmd->sample_method == SAMPLE_SYSTEM ? "SYSTEM" : "BERNOULLI", op->cmd->sample_percent);
+  }
+}
+
+static void explain_join(ExplainOutput* out, QueryOperator* op, uint8_t depth) {
+  JoinExecutor* join = &op->join;
+  if (!join->build || !join->probe) {
+    explain_line(out, depth, false, "Join");
+    return;
+  }
+
+  char* build = join->build->schema->table_name;
+  char* probe = join->probe->schema->table_name;
+
+  switch (join->strategy) {
+    case JOIN_HASH:
+      explain_line(out, depth, false, "Hash Join  (build=%s probe=%s)", build, probe);
+      break;
+    case JOIN_INDEX_NESTED_LOOP:
+      explain_line(out, depth, false, "Index Nested Loop  (outer=%s inner=%s)", probe, build);
+      break;
+    case JOIN_NESTED_LOOP:
+      explain_line(out, depth, false, "Nested Loop  (outer=%s inner=%s)", probe, build);
+      break;
+  }
+
+  if (join->strategy != JOIN_NESTED_LOOP) {
+    explain_line(out, depth, true, "Rows: %s=%llu %s=%llu", join->left.schema->table_name,
+      (unsigned long long)join->left.row_count, join->right.schema->table_name,
+      (unsigned long long)join->right.row_count);
+  }
+}
+
+static void explain_operator(ExplainOutput* out, QueryOperator* op, uint8_t depth) {
+  JQLCommand* cmd = op->cmd;
+
+  switch (op->type) {
+    case OPERATOR_SCAN:
+      explain_scan(out, op, depth);
+      break;
+    case OPERATOR_JOIN:
+      explain_join(out, op, depth);
+      break;
+    case OPERATOR_GROUP:
+      explain_line(out, depth, false, "Hash Aggregate  (keys=%u)", cmd->has_group_by ? cmd->group_by_count : 0);
+      break;
+    case OPERATOR_DISTINCT:
+      explain_line(out, depth, false, "Hash Distinct");
+      break;
+    case OPERATOR_AGGREGATE:
+      explain_line(out, depth, false, "Aggregate  (functions=%u)", op->aggregate.count);
+      break;
+    case OPERATOR_SORT:
+      explain_line(out, depth, false, "Sort  (keys=%u)", cmd->order_by_count);
+      break;
+    case OPERATOR_TOP_N:
+      explain_line(out, depth, false, "Top-N Sort  (keys=%u bound=%u)", cmd->order_by_count, op->sort.bound);
+      break;
+    case OPERATOR_LIMIT:
+      if (op->limit.limit == UINT32_MAX) explain_line(out, depth, false, "Limit  (offset=%u)", op->limit.offset);
+      else explain_line(out, depth, false, "Limit  (offset=%u limit=%u)", op->limit.offset, op->limit.limit);
+      break;
+    case OPERATOR_PROJECT:
+      explain_line(out, depth, false, "Project  (columns=%d)", cmd->value_counts[0]);
+      break;
+  }
+}
+
+static void explain_operator_stats(ExplainOutput* out, QueryOperator* op, uint8_t depth) {
+  OperatorStats* stats = op->stats;
+  if (!stats) return;
+
+  uint64_t rows_in = op->child && op->child->stats ? op->child->stats->rows_out : stats->rows_in;
+  explain_line(out, depth, true, "Actual: rows in=%llu out=%llu, time=%.3f ms, cpu=%.3f ms",
+    (unsigned long long)rows_in, (unsigned long long)stats->rows_out, ms(stats->time.wall_ns), ms(stats->time.cpu_ns));
+
+  switch (op->type) {
+    case OPERATOR_SCAN:
+      if (stats->pages_decoded + stats->pages_cached == 0) break;
+      explain_line(out, depth, true, "Pages: %llu decoded from disk, %llu cached, filter=%.3f ms",
+        (unsigned long long)stats->pages_decoded, (unsigned long long)stats->pages_cached, ms(stats->filter.wall_ns));
+      break;
+    case OPERATOR_JOIN:
+      explain_line(out, depth, true, "Memory: %u build rows, %llu spilled", op->join.build_count,
+        (unsigned long long)op->join.spilled_rows);
+      break;
+    case OPERATOR_GROUP:
+      explain_line(out, depth, true, "Memory: %u groups, %u spill files", op->group.table.group_count,
+        op->group.table.spill_files);
+      break;
+    case OPERATOR_AGGREGATE:
+      explain_line(out, depth, true, "Memory: %u rows per batch", op->aggregate.capacity);
+      break;
+    case OPERATOR_DISTINCT:
+      explain_line(out, depth, true, "Memory: %u keys, %u spill files", op->distinct.table.seen.count,
+        op->distinct.table.spill_files);
+      break;
+    case OPERATOR_SORT:
+    case OPERATOR_TOP_N:
+      explain_line(out, depth, true, "Memory: %u rows buffered, %llu spilled in %u runs", op->sort.sorter.count,
+        (unsigned long long)op->sort.sorter.spilled_rows, op->sort.sorter.run_count);
+      break;
+    case OPERATOR_PROJECT:
+      explain_line(out, depth, true, "Memory: %llu rows allocated, %u values each",
+        (unsigned long long)stats->rows_out, op->project.width);
+      break;
+    default:
+      break;
+  }
+}
+
+static void explain_pipeline(ExplainOutput* out, QueryOperator* pipeline) {
+  uint8_t depth = 0;
+  for (QueryOperator* op = pipeline; op; op = op->child, depth++) {
+    explain_operator(out, op, depth);
+    explain_operator_stats(out, op, depth);
+  }
+}
+
+static void explain_phases(ExplainOutput* out, JQLCommand* explain, QueryProfile* profile) {
+  static const char* names[PHASE_COUNT] = {
+    "Parse", "Bind", "Plan", "Execute", "Collect", "Foreign key collect", "Foreign key actions", "Write"
+  };
+
+  profile->phases[PHASE_PARSE] = (ProfileClock){ explain->parse_wall_ns, explain->parse_cpu_ns };
+  profile->ran[PHASE_PARSE] = true;
+
+  ProfileClock total = {0};
+  for (int phase = 0; phase < PHASE_COUNT; phase++) {
+    if (!profile->ran[phase]) continue;
+
+    ProfileClock* time = &profile->phases[phase];
+    explain_line(out, 0, false, "%s: %.3f ms (cpu %.3f ms)", names[phase], ms(time->wall_ns), ms(time->cpu_ns));
+    total.wall_ns += time->wall_ns;
+    total.cpu_ns += time->cpu_ns;
+  }
+
+  explain_line(out, 0, false, "Total: %.3f ms (cpu %.3f ms)", ms(total.wall_ns), ms(total.cpu_ns));
+}
+
+static ExecutionResult explain_select(Database* db, JQLCommand* cmd, ExplainOutput* out) {
+  const char* error = NULL;
+  TableSchema* rows_schema = bind_select(db, cmd, &error);
+  if (!rows_schema) return (ExecutionResult){1, error};
+
+  QueryOperator* pipeline = pipeline_build(db, cmd, rows_schema);
+  if (!pipeline) return (ExecutionResult){1, "Memory allocation failed for select pipeline"};
+
+  error = pipeline_error(pipeline);
+  if (!error) explain_pipeline(out, pipeline);
+  pipeline_free(pipeline);
+
+  return error ? (ExecutionResult){1, error} : (ExecutionResult){0, "Explain executed successfully"};
+}
+
+static ExecutionResult explain_write(Database* db, JQLCommand* cmd, ExplainOutput* out) {
+  TableSchema* schema = get_table_schema(db, cmd->schema->table_name);
+  if (!schema) return (ExecutionResult){1, "Error: Invalid schema"};
+
+  int64_t table_id = find_table(db, schema->table_name);
+  if (table_id == -1) return (ExecutionResult){1, "Table not found in catalog"};
+
+  // both find their rows with a full filtered scan
+  AccessPlan plan = plan_table_access(db, cmd, schema);
+
+  explain_line(out, 0, false, "%s on %s", cmd->type == CMD_UPDATE ? "Update" : "Delete", schema->table_name);
+  explain_line(out, 1, false, "Seq Scan on %s  (cost=%.2f rows=%.0f)", schema->table_name, plan.seq_cost, plan.rows);
+
+  int fk_count = 0;
+  Constraint* referencing_fks = get_fk_constr_ref_table(db, table_id, &fk_count);
+  for (int i = 0; i < fk_count; i++) {
+    TableSchema* referencing = get_table_schema_by_id(db, referencing_fks[i].table_id);
+    explain_line(out, 0, true, "Foreign key %s from %s", referencing_fks[i].name,
+      referencing ? referencing->table_name : "?");
+    free_constraint(&referencing_fks[i]);
+  }
+  free(referencing_fks);
+
+  return (ExecutionResult){0, "Explain executed successfully"};
+}
+
+static ExecutionResult explain_analyze(Database* db, JQLCommand* explain, ExplainOutput* out) {
+  JQLCommand* cmd = explain->prepared;
+  QueryProfile profile = {0};
+
+  db->profile = &profile;
+  ExecutionResult result = cmd->type == CMD_SELECT ? execute_select(db, cmd)
+    : cmd->type == CMD_UPDATE ? execute_update(db, cmd) : execute_delete(db, cmd);
+  db->profile = NULL;
+
+  if (result.code == 0) {
+    if (cmd->type == CMD_SELECT) {
+      explain_pipeline(out, profile.pipeline);
+    } else {
+      explain_line(out, 0, false, "%s on %s  (rows=%u)", cmd->type == CMD_UPDATE ? "Update" : "Delete",
+        cmd->schema->table_name, result.row_count);
+    }
+
+    explain_phases(out, explain, &profile);
+  }
+
+  pipeline_free(profile.pipeline);
+
+  // the rows themselves are not part of the plan
+  if (result.owns_rows) {
+    for (uint32_t i = 0; i < result.row_count; i++) {
+      free(result.rows[i].values);
+    }
+    free(result.rows);
+  }
+  free_execution_result(&result);
+
+  return result.code == 0 ? (ExecutionResult){0, "Explain executed successfully"} : (ExecutionResult){1, result.message};
+}
+
+ExecutionResult execute_explain(Database* db, JQLCommand* cmd) {
+  if (!db || !cmd || !cmd->prepared || !cmd->prepared->schema) {
+    return (ExecutionResult){1, "Invalid execution context or command"};
+  }
+
+  JQLCommand* explained = cmd->prepared;
+  ExplainOutput out = {0};
+
+  ExecutionResult result;
+  if (cmd->explain_analyze) result = explain_analyze(db, cmd, &out);
+  else if (explained->type == CMD_SELECT) result = explain_select(db, explained, &out);
+  else result = explain_write(db, explained, &out);
+
+  char** aliases = malloc(sizeof(char*));
+  if (aliases) aliases[0] = strdup("QUERY PLAN");
+
+  if (result.code != 0 || out.failed || !aliases || !aliases[0]) {
+    for (uint32_t i = 0; i < out.count; i++) {
+      free(out.rows[i].values->str_value);
+      free(out.rows[i].values);
+    }
+    free(out.rows);
+    if (aliases) free(aliases[0]);
+    free(aliases);
+
+    return result.code != 0 ? result : (ExecutionResult){1, "Memory allocation failed for the query plan"};
+  }
+
+  return (ExecutionResult){
+    .code = 0,
+    .message = result.message,
+    .rows = out.rows,
+    .aliases = aliases,
+    .row_count = out.count,
+    .alias_limit = 1,
+    .owns_rows = 1
+  };
+}
@@ -99,14 +99,18 @@ ColumnValue evaluate_array_access_expression(ExprNode* expr, Row* row, TableSche
 
 ColumnValue evaluate_unary_op_expression(ExprNode* expr, Row* row, TableSchema* schema, 
                                          Database* db, uint8_t schema_idx) {
-  ColumnValue result;
   ColumnDefinition defn;
-  memset(&result, 0, sizeof(ColumnValue));
   
   ColumnValue operand = resolve_expr_value(expr->arth_unary.expr, row, schema, db, schema_idx, &defn);
-  result.type = defn.type;
+  return evaluate_unary_op(operand, expr->arth_unary.op);
+}
+
+ColumnValue evaluate_unary_op(ColumnValue operand, int op) {
+  ColumnValue result;
+  memset(&result, 0, sizeof(ColumnValue));
+  result.type = operand.type;
   
-  switch (expr->arth_unary.op) {
+  switch (op) {
     case TOK_SUB:
       if (operand.type == TOK_T_INT || operand.type == TOK_T_UINT) {
         result.type = TOK_T_INT;
@@ -121,7 +125,7 @@ ColumnValue evaluate_unary_op_expression(ExprNode* expr, Row* row, TableSchema*
       break;
       
     default:
-      LOG_WARN("Unsupported unary operation: %d", expr->arth_unary.op);
+      LOG_WARN("Unsupported unary operation: %d", op);
       memset(&result, 0, sizeof(ColumnValue));
       break;
   }
@@ -131,35 +135,46 @@ ColumnValue evaluate_unary_op_expression(ExprNode* expr, Row* row, TableSchema*
 
 ColumnValue evaluate_binary_op_expression(ExprNode* expr, Row* row, TableSchema* schema, 
                                           Database* db, uint8_t schema_idx) {
-  ColumnValue result;
   ColumnDefinition defn;
-  memset(&result, 0, sizeof(ColumnValue));
   
   ColumnValue left = resolve_expr_value(expr->binary.left, row, schema, db, schema_idx, &defn);
   ColumnValue right = resolve_expr_value(expr->binary.right, row, schema, db, schema_idx, &defn);
+
+  bool has_column = expr->binary.left->type == EXPR_COLUMN || expr->binary.right->type == EXPR_COLUMN;
+  return evaluate_binary_op(left, right, expr->binary.op, has_column ? defn.type : -1);
+}
+
+ColumnValue evaluate_binary_op(ColumnValue left, ColumnValue right, int op, int16_t type) {
+  ColumnValue result;
+  memset(&result, 0, sizeof(ColumnValue));
   
   if (left.is_null || right.is_null) {
     result.is_null = true;
     return result;
   }
+
+  // without a column operand the operands themselves decide the arithmetic
+  if (type < 0) {
+    type = (left.type == TOK_T_INTERVAL) ? right.type : left.type;
+  }
   
-  switch (defn.type) {
+  switch (type) {
     case TOK_T_INT:
     case TOK_T_UINT:
     case TOK_T_SERIAL:
     case TOK_T_FLOAT:
     case TOK_T_DOUBLE:
-      return evaluate_numeric_binary_op(left, right, expr->binary.op);
+      return evaluate_numeric_binary_op(left, right, op);
       
     case TOK_T_INTERVAL:
     case TOK_T_DATETIME:
     case TOK_T_TIMESTAMP:
     case TOK_T_DATETIME_TZ:
     case TOK_T_TIMESTAMP_TZ:
-      return evaluate_datetime_binary_op(left, right, expr->binary.op);
+      return evaluate_datetime_binary_op(left, right, op);
       
     default:
-      LOG_DEBUG("Unsupported binary expression type: %d", defn.type);
+      LOG_DEBUG("Unsupported binary expression type: %d", type);
       return result;
   }
 }
@@ -335,10 +350,15 @@ ColumnValue evaluate_datetime_binary_op(ColumnValue left, ColumnValue right, int
 
 ColumnValue evaluate_comparison_expression(ExprNode* expr, Row* row, TableSchema* schema, 
                                           Database* db, uint8_t schema_idx) {
-  ColumnDefinition defn;
+  ColumnDefinition defn = {0};
   
   ColumnValue left = resolve_expr_value(expr->binary.left, row, schema, db, schema_idx, &defn);
   ColumnValue right = resolve_expr_value(expr->binary.right, row, schema, db, schema_idx, &defn);
+
+  // with no column on either side there is no declared type, compare as the left operand
+  if (expr->binary.left->type != EXPR_COLUMN && expr->binary.right->type != EXPR_COLUMN) {
+    defn.type = left.type;
+  }
   
   if (expr->binary.op == TOK_EQ &&
       expr->binary.left->type == EXPR_COLUMN &&
@@ -365,8 +385,12 @@ ColumnValue evaluate_comparison_expression(ExprNode* expr, Row* row, TableSchema
     return create_bool_column_value(left.is_null, false);
   }
   
-  bool valid_conversion = infer_and_cast_value(&left, &defn) && 
-                          infer_and_cast_value(&right, &defn);
+  return compare_column_values(left, right, expr->binary.op, &defn);
+}
+
+ColumnValue compare_column_values(ColumnValue left, ColumnValue right, int op, ColumnDefinition* defn) {
+  bool valid_conversion = infer_and_cast_value(&left, defn) && 
+                          infer_and_cast_value(&right, defn);
   
   if (!valid_conversion) {
     return create_null_column_value();
@@ -374,10 +398,10 @@ ColumnValue evaluate_comparison_expression(ExprNode* expr, Row* row, TableSchema
   
   int cmp = key_compare(get_column_value_as_pointer(&left),
                         get_column_value_as_pointer(&right), 
-                        defn.is_array ? -1 : defn.type);
+                        defn->is_array ? -1 : defn->type);
   
   bool result_value = false;
-  switch (expr->binary.op) {
+  switch (op) {
     case TOK_EQ: result_value = (cmp == 0); break;
     case TOK_NE: result_value = (cmp != 0); break;
     case TOK_LT: result_value = (cmp == -1); break;
@@ -385,7 +409,7 @@ ColumnValue evaluate_comparison_expression(ExprNode* expr, Row* row, TableSchema
     case TOK_LE: result_value = (cmp <= 0); break;
     case TOK_GE: result_value = (cmp >= 0); break;
     default: 
-      LOG_WARN("Unknown comparison operator: %d", expr->binary.op);
+      LOG_WARN("Unknown comparison operator: %d", op);
       result_value = false; 
       break;
   }
@@ -405,7 +429,9 @@ ColumnValue evaluate_like_expression(ExprNode* expr, Row* row, TableSchema* sche
     return create_bool_column_value(false, false);
   }
   
-  bool result = like_match(left.str_value, expr->like.pattern);
+  bool result = expr->like.matcher
+    ? like_matches(expr->like.matcher, left.str_value, strlen(left.str_value))
+    : like_match(left.str_value, expr->like.pattern);
   return create_bool_column_value(result, left.is_null);
 }
 
@@ -437,26 +463,27 @@ ColumnValue evaluate_between_expression(ExprNode* expr, Row* row, TableSchema* s
 
 ColumnValue evaluate_in_expression(ExprNode* expr, Row* row, TableSchema* schema, 
                                   Database* db, uint8_t schema_idx) {
-  ColumnDefinition defn;
+  ColumnDefinition defn = {0};
   
   ColumnValue value = resolve_expr_value(expr->in.value, row, schema, db, schema_idx, &defn);
+  if (expr->in.value->type != EXPR_COLUMN) defn.type = value.type;
+
+  if (value.is_null) {
+    return create_bool_column_value(false, true);
+  }
   
+  // items are cast to the tested value's type, so every comparable type matches like '=' would
   for (size_t i = 0; i < expr->in.count; ++i) {
-    ColumnValue val = resolve_expr_value(expr->in.list[i], row, schema, db, schema_idx, &defn);
-    
-    bool match = false;
-    if (value.type == TOK_T_INT || value.type == TOK_T_UINT || value.type == TOK_T_SERIAL) {
-      match = (value.int_value == val.int_value);
-    } else if (value.type == TOK_T_VARCHAR && value.str_value && val.str_value) {
-      match = (strcmp(value.str_value, val.str_value) == 0);
-    }
-    
-    if (match) {
-      return create_bool_column_value(true, value.is_null || val.is_null);
+    ColumnDefinition item_defn;
+    ColumnValue val = resolve_expr_value(expr->in.list[i], row, schema, db, schema_idx, &item_defn);
+    if (val.is_null || !infer_and_cast_value(&val, &defn)) continue;
+
+    if (column_values_equal(&value, &val, defn.type)) {
+      return create_bool_column_value(true, false);
     }
   }
 
-  return create_bool_column_value(false, value.is_null);
+  return create_bool_column_value(false, false);
 }
 
 ColumnValue evaluate_logical_and_expression(ExprNode* expr, Row* row, TableSchema* schema, 
@@ -549,6 +576,8 @@ ColumnValue evaluate_expression(ExprNode* expr, Row* row, TableSchema* schema, D
       if (expr->fn.type == NOT_AGG) {
         return evaluate_function(expr->fn.name, expr->fn.args, expr->fn.arg_count, 
                                row, schema, db, schema_idx);
+      } else if (expr->fn.grouped) {
+        return row->values[schema->column_count + expr->fn.group_slot];
       } else {
         LOG_WARN("Evaluation of AGG function attempted, post-evaluation will be used");
         return (ColumnValue){ .tbev = &(expr->fn) };
@@ -574,6 +603,10 @@ ColumnValue evaluate_expression(ExprNode* expr, Row* row, TableSchema* schema, D
       
     case EXPR_LOGICAL_NOT:
       return evaluate_logical_not_expression(expr, row, schema, db, schema_idx);
+
+    case EXPR_PARAMETER:
+      LOG_ERROR("Parameter $%u has no bound value", expr->param + 1);
+      return create_null_column_value();
       
     default:
       LOG_WARN("Unsupported expression type: %d", expr->type);
@@ -589,4 +622,64 @@ bool evaluate_condition(ExprNode* expr, Row* row, TableSchema* schema, Database*
   ColumnValue result = evaluate_expression(expr, row, schema, db, schema_idx);
   
   return result.bool_value && !result.is_null;
-}
\ No newline at end of file
+}
+
+// marks the row columns an expression reads; anything it cannot see through marks them all
+void expr_column_set(ExprNode* expr, uint8_t* columns) {
+  if (!expr) return;
+
+  switch (expr->type) {
+    case EXPR_LITERAL:
+    case EXPR_PARAMETER:
+      return;
+
+    case EXPR_COLUMN:
+      columns[expr->column.index / 8] |= 1 << (expr->column.index % 8);
+      return;
+
+    case EXPR_ARRAY_ACCESS:
+      columns[expr->column.index / 8] |= 1 << (expr->column.index % 8);
+      expr_column_set(expr->column.array_idx, columns);
+      return;
+
+    case EXPR_UNARY_OP:
+    case EXPR_LOGICAL_NOT:
+      expr_column_set(expr->arth_unary.expr, columns);
+      return;
+
+    case EXPR_BINARY_OP:
+    case EXPR_COMPARISON:
+    case EXPR_LOGICAL_AND:
+    case EXPR_LOGICAL_OR:
+      expr_column_set(expr->binary.left, columns);
+      expr_column_set(expr->binary.right, columns);
+      return;
+
+    case EXPR_FUNCTION:
+      for (uint8_t i = 0; i < expr->fn.arg_count; i++) {
+        expr_column_set(expr->fn.args[i], columns);
+      }
+      return;
+
+    case EXPR_LIKE:
+      expr_column_set(expr->like.left, columns);
+      return;
+
+    case EXPR_BETWEEN:
+      expr_column_set(expr->between.value, columns);
+      expr_column_set(expr->between.lower, columns);
+      expr_column_set(expr->between.upper, columns);
+      return;
+
+    case EXPR_IN:
+      expr_column_set(expr->in.value, columns);
+      for (size_t i = 0; i < expr->in.count; i++) {
+        expr_column_set(expr->in.list[i], columns);
+      }
+      return;
+
+    default:
+      memset(columns, 0xff, PAGE_COLUMN_BYTES);
+      return;
+  }
+}
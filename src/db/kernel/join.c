@@ -0,0 +1,629 @@
+#include "kernel/kernel.h"
+
+/*
+  Joins between the FROM table and one JOIN table. A joined row holds the
+  left table's columns followed by the right table's, so every clause past
+  the join reads it through the joined schema the parser built.
+
+  An equality between a column of each table in the ON condition is used as
+  the join key. A hash join buffers the smaller input in buckets keyed on it
+  and streams the other input past them. When the buffered side outgrows the
+  memory budget both inputs are hashed into partition files under the tmp
+  directory instead (Grace hash join), and each pair of partitions is joined
+  on its own. An index nested-loop join looks every outer row's key up in the
+  inner table's primary key B-tree; join_choose_strategy picks between the
+  two from the input sizes. ON conditions without such an equality fall back
+  to a plain nested loop.
+
+  Joined values are copied into blocks owned by the executor, since sorting
+  and grouping above the join hold on to the rows it hands out. Partition
+  rows are released once joined, so a joined row built from them gets its
+  own copies of their strings and is marked as owning them; the executor
+  frees whichever of those the operators above did not take over.
+*/
+
+static uint64_t join_hash_finalize(uint64_t h) {
+  // partitions come from the high bits and buckets from the low ones, so both must be mixed
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// keys only join within a class; out-of-line TEXT, JSON and BLOB values never act as keys
+static int join_key_class(int type) {
+  switch (type) {
+    case TOK_T_INT:
+    case TOK_T_UINT:
+    case TOK_T_SERIAL:
+      return TOK_T_INT;
+
+    case TOK_T_STRING:
+    case TOK_T_VARCHAR:
+    case TOK_T_CHAR:
+      return TOK_T_VARCHAR;
+
+    case TOK_T_TEXT:
+    case TOK_T_JSON:
+    case TOK_T_BLOB:
+      return -1;
+
+    default:
+      return type;
+  }
+}
+
+static bool join_key_hash(JoinExecutor* join, ColumnValue* value, uint64_t* out) {
+  if (value->is_null) return false;
+
+  uint64_t hash = 0;
+  if (!hash_column_value(value, join->key_type, &hash)) return false;
+
+  *out = join_hash_finalize(hash);
+  return true;
+}
+
+static ExprNode* find_join_key(ExprNode* node, uint8_t left_columns) {
+  if (!node) return NULL;
+
+  if (node->type == EXPR_LOGICAL_AND) {
+    ExprNode* key = find_join_key(node->binary.left, left_columns);
+    return key ? key : find_join_key(node->binary.right, left_columns);
+  }
+
+  if (node->type != EXPR_COMPARISON || node->binary.op != TOK_EQ) return NULL;
+
+  ExprNode* a = node->binary.left;
+  ExprNode* b = node->binary.right;
+  if (a->type != EXPR_COLUMN || b->type != EXPR_COLUMN) return NULL;
+  if ((a->column.index < left_columns) == (b->column.index < left_columns)) return NULL;
+
+  return node;
+}
+
+static bool join_side_next(JoinExecutor* join, JoinSide* side, Row** out) {
+  BufferPool* pool = &join->db->lake[side->schema_idx];
+
+  while (side->page < pool->num_pages) {
+    Page* page = pool->pages[side->page];
+    if (!page || side->row >= page->num_rows) {
+      side->page++;
+      side->row = 0;
+      continue;
+    }
+
+    Row* row = &page->rows[side->row++];
+    if (is_struct_zeroed(row, sizeof(Row)) || row->deleted) continue;
+
+    *out = row;
+    return true;
+  }
+
+  return false;
+}
+
+static uint64_t join_side_rows(JoinExecutor* join, JoinSide* side) {
+  // the maintained row count saves a pass over the table
+  TableStatistics* stats = table_statistics(join->db, side->schema);
+  if (stats) return stats->row_count;
+
+  uint64_t count = 0;
+
+  Row* row;
+  while (join_side_next(join, side, &row)) count++;
+
+  side->page = 0;
+  side->row = 0;
+  return count;
+}
+
+static bool join_side_indexed(JoinExecutor* join, JoinSide* side) {
+  TableSchema* schema = side->schema;
+  ColumnDefinition* def = &schema->columns[side->key];
+  if (!def->is_primary_key) return false;
+
+  for (uint8_t i = 0; i < schema->column_count; i++) {
+    if (i != side->key && schema->columns[i].is_primary_key) return false;
+  }
+
+  return join->db->tc[side->schema_idx].btree[hash_fnv1a(def->name, MAX_COLUMNS)] != NULL;
+}
+
+JoinStrategy join_choose_strategy(uint64_t outer_rows, uint64_t inner_rows, bool inner_indexed, bool spills) {
+  if (!inner_indexed) return JOIN_HASH;
+
+  // hashing reads both inputs once, and twice more when its partitions go through disk
+  uint64_t hash_cost = (outer_rows + inner_rows) * (spills ? 3 : 1);
+
+  // while every index probe descends about log2(inner) keys
+  uint64_t depth = 1;
+  while (depth < 64 && (1ULL << depth) <= inner_rows) depth++;
+
+  return outer_rows * depth < hash_cost ? JOIN_INDEX_NESTED_LOOP : JOIN_HASH;
+}
+
+bool join_init(JoinExecutor* join, Database* db, JQLCommand* cmd, TableSchema* schema, size_t memory_budget) {
+  memset(join, 0, sizeof(JoinExecutor));
+  join->db = db;
+  join->cmd = cmd;
+  join->schema = schema;
+  join->schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+  join->match = UINT32_MAX;
+
+  TableSchema* left = get_table_schema(db, cmd->schema->table_name);
+  TableSchema* right = get_table_schema(db, cmd->join_table);
+  if (!left || !right) {
+    join->error = "Invalid schema for joined table";
+    return false;
+  }
+
+  if (!cmd->join_condition) {
+    join->error = "JOIN needs an ON condition";
+    return false;
+  }
+
+  join->left = (JoinSide){ .schema = left, .schema_idx = hash_fnv1a(left->table_name, MAX_TABLES), .key = -1 };
+  join->right = (JoinSide){ .schema = right, .schema_idx = hash_fnv1a(right->table_name, MAX_TABLES),
+    .key = -1, .offset = left->column_count };
+
+  // joined rows are assembled from every column of both sides
+  pool_materialize(&db->lake[join->left.schema_idx], left);
+  pool_materialize(&db->lake[join->right.schema_idx], right);
+
+  join->scratch = calloc(schema->column_count, sizeof(ColumnValue));
+  if (!join->scratch) {
+    join->error = "Memory allocation failed for joined rows";
+    return false;
+  }
+
+  if (memory_budget > 0) {
+    size_t max_rows = memory_budget / (sizeof(Row) + sizeof(uint64_t) + 2 * sizeof(uint32_t));
+    join->max_build_rows = max_rows < 16 ? 16 : (max_rows > UINT32_MAX / 2 ? UINT32_MAX / 2 : (uint32_t)max_rows);
+  }
+
+  ExprNode* key = find_join_key(cmd->join_condition, left->column_count);
+  if (key) {
+    uint16_t a = key->binary.left->column.index;
+    uint16_t b = key->binary.right->column.index;
+    uint16_t left_key = a < b ? a : b;
+    uint16_t right_key = (a < b ? b : a) - left->column_count;
+
+    ColumnDefinition* left_def = &left->columns[left_key];
+    ColumnDefinition* right_def = &right->columns[right_key];
+    int key_class = join_key_class(left_def->type);
+
+    if (key_class != -1 && key_class == join_key_class(right_def->type) &&
+        !left_def->is_array && !right_def->is_array) {
+      join->left.key = left_key;
+      join->right.key = right_key;
+      join->key_type = key_class;
+      join->residual = key != cmd->join_condition;
+    }
+  }
+
+  if (join->left.key < 0) {
+    join->strategy = JOIN_NESTED_LOOP;
+    join->residual = true;
+    join->probe = &join->left;
+    join->build = &join->right;
+    return true;
+  }
+
+  join->left.row_count = join_side_rows(join, &join->left);
+  join->right.row_count = join_side_rows(join, &join->right);
+
+  JoinSide* smaller = join->left.row_count <= join->right.row_count ? &join->left : &join->right;
+  JoinSide* larger = smaller == &join->left ? &join->right : &join->left;
+
+  // with both keys indexed the larger table is the one worth probing
+  JoinSide* inner = NULL;
+  bool left_indexed = join_side_indexed(join, &join->left);
+  bool right_indexed = join_side_indexed(join, &join->right);
+  if (left_indexed && right_indexed) inner = larger;
+  else if (right_indexed) inner = &join->right;
+  else if (left_indexed) inner = &join->left;
+
+  bool spills = join->max_build_rows && smaller->row_count > join->max_build_rows;
+  join->strategy = JOIN_HASH;
+
+  if (inner) {
+    JoinSide* outer = inner == &join->left ? &join->right : &join->left;
+    join->strategy = join_choose_strategy(outer->row_count, inner->row_count, true, spills);
+
+    if (join->strategy == JOIN_INDEX_NESTED_LOOP) {
+      join->build = inner;
+      join->probe = outer;
+      return true;
+    }
+  }
+
+  join->build = smaller;
+  join->probe = larger;
+  return true;
+}
+
+static bool join_buffer_row(JoinExecutor* join, Row row, uint64_t hash) {
+  if (join->build_count == join->build_capacity) {
+    uint32_t capacity = join->build_capacity ? join->build_capacity * 2 : 64;
+
+    Row* rows = realloc(join->build_rows, capacity * sizeof(Row));
+    if (!rows) return false;
+    join->build_rows = rows;
+
+    uint64_t* hashes = realloc(join->hashes, capacity * sizeof(uint64_t));
+    if (!hashes) return false;
+    join->hashes = hashes;
+
+    uint32_t* next = realloc(join->next, capacity * sizeof(uint32_t));
+    if (!next) return false;
+    join->next = next;
+
+    join->build_capacity = capacity;
+  }
+
+  join->build_rows[join->build_count] = row;
+  join->hashes[join->build_count] = hash;
+  join->build_count++;
+  return true;
+}
+
+static bool join_index_buckets(JoinExecutor* join) {
+  uint32_t bucket_count = 1;
+  while (bucket_count < join->build_count && bucket_count < (1u << 30)) bucket_count <<= 1;
+
+  free(join->buckets);
+  join->buckets = malloc(bucket_count * sizeof(uint32_t));
+  if (!join->buckets) {
+    join->error = "Memory allocation failed for join buckets";
+    return false;
+  }
+
+  memset(join->buckets, 0xff, bucket_count * sizeof(uint32_t));
+  join->bucket_mask = bucket_count - 1;
+
+  // chains are threaded back to front so matches come out in input order
+  for (uint32_t i = join->build_count; i-- > 0;) {
+    uint32_t b = (uint32_t)join->hashes[i] & join->bucket_mask;
+    join->next[i] = join->buckets[b];
+    join->buckets[b] = i;
+  }
+
+  return true;
+}
+
+static bool join_spill(JoinExecutor* join, Row* row, uint64_t hash, bool build) {
+  uint32_t p = (uint32_t)((hash >> 32) % JOIN_SPILL_PARTITIONS);
+  JoinPartition* part = &join->partitions[p];
+
+  FILE** file = build ? &part->build : &part->probe;
+  char* path = build ? part->build_path : part->probe_path;
+  TableSchema* schema = build ? join->build->schema : join->probe->schema;
+
+  if (!*file) {
+    snprintf(path, MAX_PATH_LENGTH, "%s" SEP "join_%p_%u_%s.part",
+      join->db->fs->tmp_dir, (void*)join, p, build ? "build" : "probe");
+
+    *file = fopen(path, "w+b");
+    if (!*file) {
+      LOG_ERROR("Failed to open join partition file: %s", path);
+      join->error = "Failed to spill join partition";
+      return false;
+    }
+  }
+
+  if (!write_spill_row(*file, row, schema)) {
+    LOG_ERROR("Failed to write join partition file: %s", path);
+    join->error = "Failed to spill join partition";
+    return false;
+  }
+
+  join->spilled_rows++;
+  return true;
+}
+
+static bool join_load_partition(JoinExecutor* join) {
+  for (uint32_t i = 0; i < join->build_count; i++) {
+    free_spill_row(&join->build_rows[i]);
+  }
+  join->build_count = 0;
+
+  // an inner join has nothing to emit from a partition with one side empty
+  while (join->partition < JOIN_SPILL_PARTITIONS) {
+    JoinPartition* part = &join->partitions[join->partition];
+    if (part->build && part->probe) break;
+    join->partition++;
+  }
+
+  if (join->partition == JOIN_SPILL_PARTITIONS) return true;
+
+  // partitions are not split again; a skewed one is still joined in memory
+  FILE* file = join->partitions[join->partition].build;
+  Row row;
+  while (read_spill_row(file, &row, join->build->schema)) {
+    uint64_t hash = 0;
+    join_key_hash(join, &row.values[join->build->key], &hash);
+
+    if (!join_buffer_row(join, row, hash)) {
+      free_spill_row(&row);
+      join->error = "Memory allocation failed for join build rows";
+      return false;
+    }
+  }
+
+  return join_index_buckets(join);
+}
+
+static bool join_build(JoinExecutor* join) {
+  Row* row;
+  while (join_side_next(join, join->build, &row)) {
+    uint64_t hash;
+    if (!join_key_hash(join, &row->values[join->build->key], &hash)) continue;
+
+    if (!join->spilled && join->max_build_rows && join->build_count >= join->max_build_rows) {
+      join->spilled = true;
+
+      for (uint32_t i = 0; i < join->build_count; i++) {
+        if (!join_spill(join, &join->build_rows[i], join->hashes[i], true)) return false;
+      }
+      join->build_count = 0;
+    }
+
+    if (join->spilled) {
+      if (!join_spill(join, row, hash, true)) return false;
+    } else if (!join_buffer_row(join, *row, hash)) {
+      join->error = "Memory allocation failed for join build rows";
+      return false;
+    }
+  }
+
+  if (!join->spilled) return join_index_buckets(join);
+
+  LOG_DEBUG("Join build side spilled %llu rows into %d partitions",
+    (unsigned long long)join->spilled_rows, JOIN_SPILL_PARTITIONS);
+
+  while (join_side_next(join, join->probe, &row)) {
+    uint64_t hash;
+    if (!join_key_hash(join, &row->values[join->probe->key], &hash)) continue;
+    if (!join_spill(join, row, hash, false)) return false;
+  }
+
+  for (int p = 0; p < JOIN_SPILL_PARTITIONS; p++) {
+    if (join->partitions[p].build) rewind(join->partitions[p].build);
+    if (join->partitions[p].probe) rewind(join->partitions[p].probe);
+  }
+
+  join->partition = 0;
+  return join_load_partition(join);
+}
+
+static Row* join_index_lookup(JoinExecutor* join, ColumnValue* key) {
+  if (key->is_null) return NULL;
+
+  JoinSide* inner = join->build;
+  ColumnDefinition* def = &inner->schema->columns[inner->key];
+
+  ColumnValue probe = *key;
+  if (!infer_and_cast_value(&probe, def)) return NULL;
+
+  BTree* tree = join->db->tc[inner->schema_idx].btree[hash_fnv1a(def->name, MAX_COLUMNS)];
+  RowID rid = btree_search(tree, get_column_value_as_pointer(&probe));
+  if (is_struct_zeroed(&rid, sizeof(RowID))) return NULL;
+
+  BufferPool* pool = &join->db->lake[inner->schema_idx];
+  for (uint16_t page_idx = 0; page_idx < pool->num_pages; page_idx++) {
+    Page* page = pool->pages[page_idx];
+    if (!page || page->page_id != rid.page_id || rid.row_id == 0 || rid.row_id > page->num_rows) continue;
+
+    Row* row = &page->rows[rid.row_id - 1];
+    if (is_struct_zeroed(row, sizeof(Row)) || row->deleted) return NULL;
+    return row;
+  }
+
+  return NULL;
+}
+
+static bool join_next_outer(JoinExecutor* join) {
+  JoinPartition* parts = join->partitions;
+
+  while (true) {
+    if (join->owns_outer) {
+      free_spill_row(&join->outer);
+      join->owns_outer = false;
+    }
+    join->match = UINT32_MAX;
+
+    if (join->spilled) {
+      if (join->partition == JOIN_SPILL_PARTITIONS) return false;
+
+      if (!read_spill_row(parts[join->partition].probe, &join->outer, join->probe->schema)) {
+        join->partition++;
+        if (!join_load_partition(join)) return false;
+        continue;
+      }
+      join->owns_outer = true;
+    } else {
+      Row* row;
+      if (!join_side_next(join, join->probe, &row)) return false;
+      join->outer = *row;
+    }
+
+    ColumnValue* key = join->probe->key >= 0 ? &join->outer.values[join->probe->key] : NULL;
+
+    switch (join->strategy) {
+      case JOIN_NESTED_LOOP:
+        join->build->page = 0;
+        join->build->row = 0;
+        join->match = 0;
+        return true;
+
+      case JOIN_INDEX_NESTED_LOOP:
+        join->inner = join_index_lookup(join, key);
+        if (!join->inner) continue;
+        join->match = 0;
+        return true;
+
+      case JOIN_HASH:
+        if (!join_key_hash(join, key, &join->outer_hash)) continue;
+        join->match = join->buckets[join->outer_hash & join->bucket_mask];
+        return true;
+    }
+  }
+}
+
+static bool join_next_match(JoinExecutor* join, Row** inner) {
+  switch (join->strategy) {
+    case JOIN_HASH:
+      while (join->match != UINT32_MAX) {
+        uint32_t i = join->match;
+        join->match = join->next[i];
+
+        if (join->hashes[i] == join->outer_hash &&
+            column_values_equal(&join->build_rows[i].values[join->build->key],
+              &join->outer.values[join->probe->key], join->key_type)) {
+          *inner = &join->build_rows[i];
+          return true;
+        }
+      }
+      return false;
+
+    case JOIN_INDEX_NESTED_LOOP:
+      if (join->match == UINT32_MAX) return false;
+      join->match = UINT32_MAX;
+      *inner = join->inner;
+      return true;
+
+    case JOIN_NESTED_LOOP:
+      if (join->match == UINT32_MAX) return false;
+      if (join_side_next(join, join->build, inner)) return true;
+      join->match = UINT32_MAX;
+      return false;
+  }
+
+  return false;
+}
+
+static ColumnValue* join_alloc_values(JoinExecutor* join) {
+  size_t width = join->schema->column_count;
+
+  if (join->block_count == 0 || join->block_used == JOIN_ROW_BLOCK) {
+    ColumnValue** blocks = realloc(join->blocks, (join->block_count + 1) * sizeof(ColumnValue*));
+    if (!blocks) return NULL;
+    join->blocks = blocks;
+
+    blocks[join->block_count] = malloc(JOIN_ROW_BLOCK * width * sizeof(ColumnValue));
+    if (!blocks[join->block_count]) return NULL;
+
+    join->block_count++;
+    join->block_used = 0;
+  }
+
+  return &join->blocks[join->block_count - 1][join->block_used++ * width];
+}
+
+static bool join_emit(JoinExecutor* join, Row* inner, Row* out) {
+  Row* left = join->probe == &join->left ? &join->outer : inner;
+  Row* right = left == inner ? &join->outer : inner;
+
+  memcpy(join->scratch, left->values, join->left.schema->column_count * sizeof(ColumnValue));
+  memcpy(join->scratch + join->right.offset, right->values, join->right.schema->column_count * sizeof(ColumnValue));
+
+  Row joined = { .id = left->id, .values = join->scratch, .n_values = join->schema->column_count };
+  JQLCommand* cmd = join->cmd;
+
+  if (join->residual && !evaluate_condition(cmd->join_condition, &joined, join->schema, join->db, join->schema_idx)) {
+    return false;
+  }
+  if (cmd->has_where && !evaluate_condition(cmd->where, &joined, join->schema, join->db, join->schema_idx)) {
+    return false;
+  }
+
+  ColumnValue* values = join_alloc_values(join);
+  if (!values) {
+    join->error = "Memory allocation failed for joined rows";
+    return false;
+  }
+
+  memcpy(values, join->scratch, join->schema->column_count * sizeof(ColumnValue));
+  *out = joined;
+  out->values = values;
+
+  // both partition rows go before the joined one is released
+  if (join->spilled) {
+    out->owns_strings = true;
+    for (uint16_t i = 0; i < join->schema->column_count; i++) {
+      if (copy_spill_value(&values[i])) continue;
+
+      while (i-- > 0) free_spill_value(&values[i]);
+      join->block_used--;
+      join->error = "Memory allocation failed for joined rows";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool join_next(JoinExecutor* join, Row* out) {
+  if (join->error) return false;
+
+  if (join->strategy == JOIN_HASH && !join->built) {
+    join->built = true;
+    if (!join_build(join)) return false;
+  }
+
+  while (true) {
+    Row* inner;
+    while (join_next_match(join, &inner)) {
+      if (join_emit(join, inner, out)) return true;
+      if (join->error) return false;
+    }
+
+    if (!join_next_outer(join)) return false;
+  }
+}
+
+void join_free(JoinExecutor* join) {
+  if (!join) return;
+
+  // rows read back from partition files own their values, as do the rows joined from them
+  if (join->spilled) {
+    for (uint32_t i = 0; i < join->build_count; i++) {
+      free_spill_row(&join->build_rows[i]);
+    }
+
+    size_t width = join->schema->column_count;
+    for (uint32_t b = 0; b < join->block_count; b++) {
+      uint32_t rows = b + 1 == join->block_count ? join->block_used : JOIN_ROW_BLOCK;
+      for (size_t i = 0; i < rows * width; i++) {
+        free_spill_value(&join->blocks[b][i]);
+      }
+    }
+  }
+  if (join->owns_outer) free_spill_row(&join->outer);
+
+  for (int p = 0; p < JOIN_SPILL_PARTITIONS; p++) {
+    JoinPartition* part = &join->partitions[p];
+    if (part->build) {
+      fclose(part->build);
+      remove(part->build_path);
+    }
+    if (part->probe) {
+      fclose(part->probe);
+      remove(part->probe_path);
+    }
+  }
+
+  for (uint32_t i = 0; i < join->block_count; i++) {
+    free(join->blocks[i]);
+  }
+
+  free(join->blocks);
+  free(join->build_rows);
+  free(join->hashes);
+  free(join->next);
+  free(join->buckets);
+  free(join->scratch);
+  memset(join, 0, sizeof(JoinExecutor));
+}
@@ -11,6 +11,13 @@ Result process(Database* db, char* buffer) {
   JQLCommand* cmd = malloc(sizeof(JQLCommand));
   *cmd = parser_parse(db);
 
+  if (db->parser->param_count > 0 && cmd->type != CMD_PREPARE) {
+    free(cmd);
+    return (Result){(ExecutionResult){1, "Statements with $n parameters have to be prepared"}, NULL};
+  }
+
+  if (db->result_cache_memory && !cmd->is_invalid && cmd->type == CMD_SELECT) cmd->cache_key = statement_fingerprint(buffer, strlen(buffer));
+
   Result result = execute_cmd(db, cmd, true);
   return result;
 }
@@ -27,6 +34,13 @@ Result process_silent(Database* db, char* buffer) {
   JQLCommand* cmd = malloc(sizeof(JQLCommand));
   *cmd = parser_parse(db);
 
+  if (db->parser->param_count > 0 && cmd->type != CMD_PREPARE) {
+    free(cmd);
+    return (Result){(ExecutionResult){1, "Statements with $n parameters have to be prepared"}, NULL};
+  }
+
+  if (db->result_cache_memory && !cmd->is_invalid && cmd->type == CMD_SELECT) cmd->cache_key = statement_fingerprint(buffer, strlen(buffer));
+
   Result result = execute_cmd(db, cmd, false);
   return result;
 }
@@ -50,7 +64,7 @@ Result execute_cmd(Database* db, JQLCommand* cmd, bool show) {
       result = (Result){execute_insert(db, cmd), cmd};
       break;
     case CMD_SELECT:
-      result = (Result){execute_select(db, cmd), cmd};
+      result = (Result){execute_select_cached(db, cmd), cmd};
       break;
     case CMD_UPDATE:
       result = (Result){execute_update(db, cmd), cmd};
@@ -58,6 +72,21 @@ Result execute_cmd(Database* db, JQLCommand* cmd, bool show) {
     case CMD_DELETE:
       result = (Result){execute_delete(db, cmd), cmd};
       break;
+    case CMD_PREPARE:
+      result = (Result){execute_prepare(db, cmd), cmd};
+      break;
+    case CMD_EXECUTE:
+      // the prepared command reports its own rows
+      return execute_named_statement(db, cmd, show);
+    case CMD_DEALLOCATE:
+      result = (Result){execute_deallocate(db, cmd), cmd};
+      break;
+    case CMD_ANALYZE:
+      result = (Result){execute_analyze(db, cmd), cmd};
+      break;
+    case CMD_EXPLAIN:
+      result = (Result){execute_explain(db, cmd), cmd};
+      break;
     default:
       result = (Result){(ExecutionResult){1, "Unknown command type"}, NULL};
   }
@@ -79,12 +108,10 @@ Result execute_cmd(Database* db, JQLCommand* cmd, bool show) {
       printf("Row %u [%u.%u]: ", i + 1, row->id.page_id, row->id.row_id);
 
       uint8_t alias_count = 0;
-      for (uint8_t c = 0; c < cmd->schema->column_count; c++) {
-        ColumnDefinition col = cmd->schema->columns[c];
+      // projected rows are as wide as the select list, which may outgrow the table (or span a join)
+      for (uint8_t c = 0; c < row->n_values; c++) {
         ColumnValue val = row->values[c];
 
-        // LOG_DEBUG("%d : alias: %s norm: %s", c, result.exec.aliases[alias_count], col.name);
-
         if (result.exec.aliases[alias_count]) {
           printf("%s: ", result.exec.aliases[alias_count]);
           alias_count++;
@@ -3,6 +3,8 @@
 
 #include "storage/database.h"
 #include "internal/functions.h"
+#include "internal/hashset.h"
+#include "internal/sketch.h"
 #include "utils/log.h"
 #include "utils/security.h"
 #include <stdarg.h>
@@ -41,6 +43,7 @@ ExecutionResult execute_alter_table(Database* db, JQLCommand* cmd);
 
 ExecutionResult execute_insert(Database* db, JQLCommand* cmd);
 ExecutionResult execute_select(Database* db, JQLCommand* cmd);
+TableSchema* bind_select(Database* db, JQLCommand* cmd, const char** error);
 ExecutionResult execute_update(Database* db, JQLCommand* cmd);
 ExecutionResult execute_delete(Database* db, JQLCommand* cmd);
 
@@ -51,10 +54,54 @@ Row* execute_row_insert(ExprNode** src, Database* db, uint8_t schema_idx,
 
 #endif
 
+#ifndef KERNEL_PREPARED_H
+#define KERNEL_PREPARED_H
+
+// a $n placeholder inside the prepared command, rewritten into a literal on every bind
+typedef struct PreparedSlot {
+  ExprNode* node;
+  uint16_t param;
+  ColumnDefinition* column; // column the bound value is cast for, NULL when the context has none
+} PreparedSlot;
+
+typedef struct PreparedStatement {
+  char name[MAX_IDENTIFIER_LEN];
+  JQLCommand* cmd;
+  uint16_t param_count;
+
+  PreparedSlot* slots;
+  uint16_t slot_count;
+
+  // INSERT and UPDATE store bound strings in rows, other statements free them on rebind
+  bool retains_values;
+  char* fingerprint; // normalized text of a SELECT whose results may be cached, NULL otherwise
+
+  struct PreparedStatement* next;
+} PreparedStatement;
+
+PreparedStatement* prepare_statement(Database* db, const char* name, char* buffer);
+PreparedStatement* find_prepared_statement(Database* db, const char* name);
+Result execute_prepared(Database* db, PreparedStatement* stmt, ColumnValue* params, uint16_t param_count, bool show);
+bool deallocate_prepared_statement(Database* db, const char* name);
+
+ExecutionResult execute_prepare(Database* db, JQLCommand* cmd);
+Result execute_named_statement(Database* db, JQLCommand* cmd, bool show);
+ExecutionResult execute_deallocate(Database* db, JQLCommand* cmd);
+
+void free_prepared_statement(PreparedStatement* stmt);
+void free_prepared_statements(Database* db);
+
+bool value_has_string(ColumnValue* value);
+
+#endif
+
 #ifndef KERNEL_EXPRESSION_H
 #define KERNEL_EXPRESSION_H
 
 
+ColumnValue create_null_column_value(void);
+ColumnValue create_bool_column_value(bool value, bool is_null);
+
 ColumnValue resolve_expr_value(ExprNode* expr, Row* row, TableSchema* schema, Database* db, uint8_t schema_idx, ColumnDefinition* out);
 ColumnValue evaluate_expression(ExprNode* expr, Row* row, TableSchema* schema, Database* db, uint8_t schema_idx);
 bool evaluate_condition(ExprNode* expr, Row* row, TableSchema* schema, Database* db, uint8_t schema_idx);
@@ -64,9 +111,12 @@ ColumnValue evaluate_column_expression(ExprNode* expr, Row* row, TableSchema* sc
 ColumnValue evaluate_array_access_expression(ExprNode* expr, Row* row, TableSchema* schema, Database* db, uint8_t schema_idx);
 
 ColumnValue evaluate_unary_op_expression(ExprNode* expr, Row* row, TableSchema* schema, Database* db, uint8_t schema_idx);
+ColumnValue evaluate_unary_op(ColumnValue operand, int op);
 ColumnValue evaluate_binary_op_expression(ExprNode* expr, Row* row, TableSchema* schema, Database* db, uint8_t schema_idx);
+ColumnValue evaluate_binary_op(ColumnValue left, ColumnValue right, int op, int16_t type);
 ColumnValue evaluate_numeric_binary_op(ColumnValue left, ColumnValue right, int op);
 ColumnValue evaluate_comparison_expression(ExprNode* expr, Row* row, TableSchema* schema, Database* db, uint8_t schema_idx);
+ColumnValue compare_column_values(ColumnValue left, ColumnValue right, int op, ColumnDefinition* defn);
 ColumnValue evaluate_like_expression(ExprNode* expr, Row* row, TableSchema* schema, Database* db, uint8_t schema_idx);
 ColumnValue evaluate_between_expression(ExprNode* expr, Row* row, TableSchema* schema, Database* db, uint8_t schema_idx);
 ColumnValue evaluate_in_expression(ExprNode* expr, Row* row, TableSchema* schema, Database* db, uint8_t schema_idx);
@@ -77,6 +127,8 @@ ColumnValue evaluate_logical_not_expression(ExprNode* expr, Row* row, TableSchem
 
 ColumnValue evaluate_datetime_binary_op(ColumnValue left, ColumnValue right, int op);
 
+void expr_column_set(ExprNode* expr, uint8_t* columns);
+
 #endif
 
 #ifndef KERNEL_SCHEMA_H
@@ -107,6 +159,50 @@ bool load_schema_for_table(Database* db, size_t idx, const char* table_name);
 ExecutionResult execute_create_table_internal(Database* db, TableSchema* schema, int64_t table_id);
 
 TableSchema* get_table_schema_by_id(Database* db, int64_t table_id);
+void check_and_concat_toast(Database* db, ColumnValue* value);
+
+#endif
+
+#ifndef KERNEL_CATALOG_H
+#define KERNEL_CATALOG_H
+
+typedef struct CatalogAttribute {
+  Attribute attr;
+  char* default_expr; // source text from jb_attrdef, NULL when the column has none
+} CatalogAttribute;
+
+/*
+  In-memory mirror of jb_tables, jb_attribute and jb_attrdef, kept on the core
+  database. The three tables are read once; afterwards the catalog writers
+  append to it and DDL that rewrites existing rows drops it for a reload.
+*/
+typedef struct CatalogCache {
+  uint64_t version; // bumped on every change, lets dependants notice DDL
+  bool is_loaded;
+  bool is_loading;
+
+  // both table sets take every entry together, so an index is valid in either
+  TupleSet tables_by_name; // (name) -> table_ids
+  TupleSet tables_by_id;   // (id) -> names through tables_by_name
+  int64_t* table_ids;
+  uint32_t table_ids_capacity;
+
+  TupleSet attributes;     // (table_id, column_name) -> attrs
+  CatalogAttribute* attrs;
+  uint32_t attrs_capacity;
+} CatalogCache;
+
+int64_t catalog_table_id(Database* db, const char* name);
+const char* catalog_table_name(Database* db, int64_t table_id);
+CatalogAttribute* catalog_attribute(Database* db, int64_t table_id, const char* column_name);
+uint64_t catalog_version(Database* db);
+
+void catalog_add_table(Database* db, int64_t table_id, const char* name);
+void catalog_add_attribute(Database* db, int64_t table_id, const char* column_name, Attribute* attr);
+void catalog_set_default(Database* db, int64_t table_id, const char* column_name, const char* default_expr);
+
+void catalog_invalidate(Database* db);
+void catalog_free(Database* db);
 
 #endif
 
@@ -140,7 +236,17 @@ typedef struct {
   bool is_unique;
 } Constraint;
 
-bool init_fk_constraints(FKConstraintValues* fk_constraints, Constraint* referencing_fks, int count);
+/*
+  Distinct referenced-key tuples collected from the parent rows of a DELETE / UPDATE.
+  On UPDATE, new_values holds the replacement tuple for each key, by key index.
+*/
+typedef struct FKConstraintValues {
+  TupleSet keys;
+  ColumnValue* new_values;
+  uint32_t capacity;
+} FKConstraintValues;
+
+bool init_fk_constraints(FKConstraintValues* fk_constraints, Constraint* referencing_fks, int count, TableSchema* schema);
 void cleanup_fk_constraints(FKConstraintValues* fk_constraints, int count);
 
 int64_t insert_constraint(Database* db, int64_t table_id, char* name, 
@@ -165,47 +271,754 @@ Result get_table_constraints(Database* db, int64_t table_id);
 bool validate_not_null_constraint(Constraint* constraint, TableSchema* schema, ColumnValue* values, int value_count);
 bool validate_unique_constraint(Database* db, Constraint* constraint, TableSchema* schema, ColumnValue* values, int value_count);
 bool validate_primary_key_constraint(Database* db, Constraint* constraint, TableSchema* schema, ColumnValue* values, int value_count);
+bool fk_key_exists(Database* db, TableSchema* ref_schema, char** ref_columns, int ref_column_count, ColumnValue* key);
 bool validate_foreign_key_constraint(Database* db, Constraint* constraint, TableSchema* schema, ColumnValue* values, int value_count);
 bool validate_check_constraint(Database* db, Constraint* constraint, TableSchema* schema, ColumnValue* values, int value_count);
 bool validate_constraint(Database* db, Constraint* constraint, TableSchema* schema, ColumnValue* values, int value_count);
 
+bool hash_constraint_key(BloomFilter* filter, TableSchema* schema, ColumnValue* values, int value_count, uint64_t* out_hash);
+BloomFilter* build_constraint_bloom(Database* db, TableSchema* schema, Constraint* constraint, uint32_t expected_items);
+BloomFilter* get_constraint_bloom(Database* db, TableSchema* schema, Constraint* constraint);
+void track_constraint_blooms(Database* db, TableSchema* schema, ColumnValue* values, int value_count, bool is_insert);
+
 void cleanup_fk_constraints(FKConstraintValues* fk_constraints, int count);
 bool expand_row_set(RowSet* set);
 bool expand_fk_constraint(FKConstraintValues* fk_constraint, int ref_col_count);
-bool tuple_exists(FKConstraintValues* fk_constraint, ColumnValue* key_tuple, 
-                        Constraint* fk, TableSchema* schema);
-bool store_fk_tuple(FKConstraintValues* fk_constraint, ColumnValue* key_tuple, 
-                          Constraint* fk, TableSchema* schema);
+int64_t store_fk_tuple(FKConstraintValues* fk_constraint, ColumnValue* key_tuple, bool* inserted);
 bool extract_fk_tuple(Row* row, TableSchema* schema, Constraint* fk, ColumnValue* tuple);
 ExecutionResult collect_fk_tuples_update(Database* db, TableSchema* schema, JQLCommand* cmd,
                                                Constraint* referencing_fks, int fk_count,
-                                               RowSet* update_set, FKConstraintValues* old_fk,
-                                               FKConstraintValues* new_fk);
-ExecutionResult collect_fk_tuples_delete(Database* db, TableSchema* schema, JQLCommand* cmd,
+                                               RowSet* update_set, FKConstraintValues* fk_values);
+ExecutionResult collect_delete_set(Database* db, TableSchema* schema, JQLCommand* cmd, RowSet* delete_set);
+ExecutionResult collect_fk_tuples_delete(Database* db, TableSchema* schema,
                                                Constraint* referencing_fks, int fk_count,
-                                               RowSet* delete_set, FKConstraintValues* fk_constraints);
+                                               RowSet* delete_set, FKConstraintValues* fk_values);
+void reindex_primary_keys(Database* db, TableSchema* schema, Row* row, uint16_t* cols, ColumnValue* old_vals, int count);
 ExecutionResult perform_updates(Database* db, TableSchema* schema, JQLCommand* cmd, RowSet* update_set);
 ExecutionResult perform_deletes(Database* db, TableSchema* schema, RowSet* delete_set);
+ExecutionResult delete_rows(Database* db, TableSchema* schema, int64_t table_id, RowSet* delete_set, QueryProfile* profile);
 
-bool cascade_delete(Database* db, int64_t referencing_table_id, char** ref_columns, int ref_column_count, ColumnValue* values, int value_count);
+bool resolve_fk_columns(TableSchema* schema, char** columns, int column_count, int* out);
+bool collect_referencing_rows(Database* db, TableSchema* schema, Constraint* fk, FKConstraintValues* fk_values, RowSet* out);
+bool update_referencing_row(Database* db, TableSchema* schema, RowID rid, int* columns, int column_count, ColumnValue* new_values);
+bool assign_referencing_rows(Database* db, Constraint* fk, FKConstraintValues* fk_values, bool use_default);
+
+bool cascade_delete(Database* db, Constraint* fk, FKConstraintValues* fk_values);
 Constraint* get_fk_constr_ref_table(Database* db, int64_t table_id, int* out_count);
 
-bool set_null_on_delete(Database* db, int64_t referencing_table_id, char** ref_columns, int ref_column_count, ColumnValue* values, int value_count);
-bool set_default_on_delete(Database* db, int64_t referencing_table_id, char** ref_columns, int ref_column_count, ColumnValue* values, int value_count);
+bool set_null_on_delete(Database* db, Constraint* fk, FKConstraintValues* fk_values);
+bool set_default_on_delete(Database* db, Constraint* fk, FKConstraintValues* fk_values);
 
-bool check_no_del_references(Database* db, int64_t referencing_table_id, char** ref_columns, int ref_column_count, ColumnValue* values, int value_count);
-bool check_no_references(Database* db, int64_t referencing_table_id, char** ref_columns, int ref_column_count, ColumnValue* values, int value_count);
-bool cascade_update(Database* db, int64_t referencing_table_id, char** ref_columns, int ref_column_count, ColumnValue* old_values, ColumnValue* new_values, int value_count);
+bool check_no_references(Database* db, Constraint* fk, FKConstraintValues* fk_values);
+bool cascade_update(Database* db, Constraint* fk, FKConstraintValues* fk_values);
 
-bool handle_single_on_delete_constraint(Database* db, Constraint* constraint, ColumnValue* values, int value_count);
-bool handle_single_on_update_constraint(Database* db, Constraint* constraint, ColumnValue* old_values, ColumnValue* new_values, int value_count);
 bool handle_on_delete_constraints(Database* db, Constraint* constraint, FKConstraintValues* fk_constraint);
-bool handle_on_update_constraints(Database* db, Constraint* constraint, FKConstraintValues* old_fk, FKConstraintValues* new_fk);
+bool handle_on_update_constraints(Database* db, Constraint* constraint, FKConstraintValues* fk_values);
 
 bool validate_all_constraints(Database* db, int64_t table_id, ColumnValue* values, int value_count);
 
 #endif
 
+#ifndef KERNEL_PROGRAM_H
+#define KERNEL_PROGRAM_H
+
+#define PROGRAM_NO_REGISTER UINT16_MAX
+
+typedef enum ProgramOp {
+  PROG_LOAD_COLUMN,
+  PROG_NEGATE,
+  PROG_ARITHMETIC,
+  PROG_COMPARE,
+  PROG_IS_NULL,
+  PROG_NOT,
+  PROG_AND_SHORT,
+  PROG_OR_SHORT,
+  PROG_AND,
+  PROG_OR,
+  PROG_IN_SET,
+  PROG_CALL,
+  PROG_EVAL
+} ProgramOp;
+
+typedef struct ProgramInstr {
+  uint8_t op;
+  uint16_t dst;
+  uint16_t a;
+  uint16_t b;
+
+  int token;
+  int16_t type;
+  uint16_t jump;
+  ColumnDefinition* defn;
+  TupleSet* set;
+
+  BuiltinFunction fn;
+  ExprNode** args;
+  uint8_t arg_count;
+
+  ExprNode* node;
+} ProgramInstr;
+
+typedef struct ExprProgram {
+  ProgramInstr* code;
+  uint16_t length;
+  uint16_t capacity;
+
+  ColumnValue* registers;
+  bool* constant;
+  uint16_t num_registers;
+  uint16_t register_capacity;
+
+  uint16_t* outputs;
+  uint8_t output_count;
+
+  void** owned;
+  uint16_t owned_count;
+  uint16_t owned_capacity;
+
+  TupleSet** sets; // IN lists, freed with the program even if their instruction was dropped
+  uint16_t set_count;
+} ExprProgram;
+
+ExprProgram* expr_program_compile(ExprNode** roots, uint8_t count, TableSchema* schema, Database* db);
+void expr_program_free(ExprProgram* prog);
+
+void expr_program_run(ExprProgram* prog, Row* row, TableSchema* schema, Database* db, uint8_t schema_idx);
+ColumnValue expr_program_result(ExprProgram* prog, uint8_t idx);
+bool expr_program_condition(ExprProgram* prog, Row* row, TableSchema* schema, Database* db, uint8_t schema_idx);
+
+#endif
+
+#ifndef KERNEL_ZONEMAP_H
+#define KERNEL_ZONEMAP_H
+
+#define ZONE_MAX_PREDICATES 16
+
+typedef struct ZonePredicate {
+  uint8_t column;
+  uint8_t type;  // column type, zones taken as another type are not consulted
+  int op;        // a comparison token, TOK_BETWEEN, or TOK_NL for = NULL
+  ZoneKey low;
+  ZoneKey high;  // BETWEEN bounds are DOUBLE
+} ZonePredicate;
+
+typedef struct ZoneFilter {
+  ZonePredicate preds[ZONE_MAX_PREDICATES];
+  uint8_t count;
+} ZoneFilter;
+
+void zone_filter_compile(ZoneFilter* zf, ExprNode* where, TableSchema* schema, Database* db);
+bool zone_filter_page_may_match(ZoneFilter* zf, Page* page);
+
+#endif
+
+#ifndef KERNEL_VECTOR_H
+#define KERNEL_VECTOR_H
+
+#define VECTOR_SIZE (PAGE_SIZE / sizeof(Row))
+#define VECTOR_MAX_COLUMNS 16
+
+enum { VEC_I64, VEC_F64, VEC_STR };
+
+enum {
+  VEC_NODE_CMP,
+  VEC_NODE_BETWEEN,
+  VEC_NODE_IS_NULL,
+  VEC_NODE_NULL,
+  VEC_NODE_AND,
+  VEC_NODE_OR,
+  VEC_NODE_NOT
+};
+
+typedef union VectorScalar {
+  int64_t i64;
+  double f64;
+  char* str;
+} VectorScalar;
+
+typedef struct VectorColumn {
+  uint8_t column;
+  uint8_t kind;
+
+  int64_t i64[VECTOR_SIZE];
+  double f64[VECTOR_SIZE];
+  char* str[VECTOR_SIZE];
+  uint8_t null[VECTOR_SIZE];
+} VectorColumn;
+
+typedef struct VectorNode {
+  uint8_t kind;
+  uint8_t value_kind;
+  uint8_t slot;
+  int op;
+
+  VectorScalar lower;
+  VectorScalar upper;
+  bool bounds_null;
+
+  struct VectorNode* left;
+  struct VectorNode* right;
+
+  uint8_t val[VECTOR_SIZE];
+  uint8_t null[VECTOR_SIZE];
+} VectorNode;
+
+typedef struct VectorFilter {
+  VectorNode* root;
+  ExprProgram* program;
+  VectorColumn columns[VECTOR_MAX_COLUMNS];
+  uint8_t column_count;
+  ZoneFilter zones;
+  uint8_t where_columns[PAGE_COLUMN_BYTES]; // decoded across a page before it is filtered
+} VectorFilter;
+
+VectorFilter* vector_filter_compile(ExprNode* where, TableSchema* schema, Database* db);
+void vector_filter_free(VectorFilter* filter);
+void free_vector_node(VectorNode* node);
+
+bool vector_filter_select(VectorFilter* filter, Row* rows, uint16_t n, uint16_t* sel, uint16_t* out_count);
+uint16_t select_page_rows(Database* db, JQLCommand* cmd, VectorFilter* filter, TableSchema* schema, 
+  uint8_t schema_idx, Page* page, uint16_t* sel);
+
+#endif
+
+#ifndef KERNEL_PARALLEL_H
+#define KERNEL_PARALLEL_H
+
+typedef struct AggregateState AggregateState;
+
+typedef struct ScanSelection {
+  uint16_t page_count;
+  uint16_t counts[POOL_SIZE];
+  uint16_t sel[POOL_SIZE][VECTOR_SIZE];
+} ScanSelection;
+
+uint32_t scan_worker_count(Database* db);
+ScanSelection* scan_select_rows(Database* db, JQLCommand* cmd, TableSchema* schema, uint8_t schema_idx);
+bool parallel_aggregate_rows(Database* db, ExprNode** aggregates, uint8_t count, Row* rows, uint32_t row_count,
+  TableSchema* schema, uint8_t schema_idx, AggregateState* states);
+void worker_pool_free(WorkerPool* pool);
+
+#endif
+
+#ifndef KERNEL_SORT_H
+#define KERNEL_SORT_H
+
+typedef struct SortRun {
+  FILE* file;
+  char path[MAX_PATH_LENGTH];
+  Row head;
+  bool has_head;
+} SortRun;
+
+typedef struct RowSorter {
+  Database* db;
+  JQLCommand* cmd;
+  TableSchema* schema;
+
+  Row* rows;
+  uint32_t count;
+  uint32_t capacity;
+  uint32_t cursor;
+  size_t memory_budget; // 0 keeps every row in memory
+  size_t bytes;
+
+  SortRun* runs;
+  uint32_t run_count;
+  uint32_t* heap;
+  uint32_t heap_count;
+  uint64_t spilled_rows;
+  Row last;
+} RowSorter;
+
+bool write_spill_row(FILE* file, Row* row, TableSchema* schema);
+bool read_spill_row(FILE* file, Row* row, TableSchema* schema);
+bool spill_value_owned(ColumnValue* value);
+bool copy_spill_value(ColumnValue* value);
+void free_spill_value(ColumnValue* value);
+void free_spill_row(Row* row);
+void keep_spill_values(Row* row, ColumnValue* values, uint16_t count);
+
+bool sort_rows_by_key(Row rows[], uint32_t count, JQLCommand* cmd);
+void sort_rows(Row rows[], uint32_t count, JQLCommand* cmd, TableSchema* schema);
+
+void sorter_init(RowSorter* sorter, Database* db, JQLCommand* cmd, TableSchema* schema, size_t memory_budget);
+bool sorter_add(RowSorter* sorter, Row row);
+bool sorter_finish(RowSorter* sorter);
+bool sorter_next(RowSorter* sorter, Row* out);
+void sorter_free(RowSorter* sorter);
+
+#endif
+
+#ifndef KERNEL_AGGREGATE_H
+#define KERNEL_AGGREGATE_H
+
+#define GROUP_SPILL_PARTITIONS 8
+#define GROUP_MAX_SPILL_DEPTH 4
+
+typedef struct AggregateState {
+  uint64_t count;
+  int64_t int_sum;
+  double sum;
+  bool is_double;
+
+  double mean;
+  double m2;
+
+  ColumnValue value;
+  bool truth;
+
+  ColumnValue* values;
+  uint32_t value_count;
+  uint32_t value_capacity;
+
+  TupleSet* distinct; // COUNT(DISTINCT), keyed on each value's own type
+  HyperLogLog* hll;
+  TDigest* digest;
+
+  char* text;
+  size_t text_length;
+  size_t text_capacity;
+} AggregateState;
+
+typedef struct GroupPartition {
+  FILE* file;
+  char path[MAX_PATH_LENGTH];
+  uint8_t depth;
+} GroupPartition;
+
+typedef struct GroupTable {
+  Database* db;
+  JQLCommand* cmd;
+  TableSchema* schema;
+  uint8_t schema_idx;
+  const char* error;
+
+  ExprNode* aggregates[MAX_COLUMNS];
+  uint8_t aggregate_count;
+  uint8_t width;
+
+  uint32_t* slots;
+  uint32_t slot_mask;
+
+  Row* groups;
+  uint64_t* hashes;
+  AggregateState* states;
+  uint32_t group_count;
+  uint32_t group_capacity;
+  uint32_t max_groups;
+  uint32_t cursor;
+  uint8_t depth;
+
+  GroupPartition spill[GROUP_SPILL_PARTITIONS];
+  GroupPartition* pending;
+  uint32_t pending_count;
+  uint32_t spill_files;
+
+  Row* retired; // emitted groups of earlier passes, still referenced downstream
+  uint32_t retired_count;
+} GroupTable;
+
+void aggregate_state_update(AggregateState* state, Function* fn, ColumnValue* value);
+void aggregate_state_merge(AggregateState* state, AggregateState* other, Function* fn);
+ColumnValue aggregate_state_finalize(AggregateState* state, Function* fn);
+void aggregate_state_free(AggregateState* state);
+bool aggregate_returns_input(AggregateType type);
+bool aggregate_is_mergeable(AggregateType type);
+
+bool aggregate_rows(AggregateState* states, ExprNode** aggregates, uint8_t count, Row* rows, uint32_t row_count,
+  TableSchema* schema, Database* db, uint8_t schema_idx);
+ExecutionResult aggregate_select_states(Database* db, JQLCommand* cmd, AggregateState* states);
+
+bool group_table_init(GroupTable* table, Database* db, JQLCommand* cmd, TableSchema* schema, size_t memory_budget);
+bool group_table_add(GroupTable* table, Row* row);
+bool group_table_finish(GroupTable* table);
+bool group_table_next(GroupTable* table, Row* out);
+void group_table_free(GroupTable* table);
+
+#endif
+
+#ifndef KERNEL_DISTINCT_H
+#define KERNEL_DISTINCT_H
+
+#define DISTINCT_SPILL_PARTITIONS 8
+#define DISTINCT_MAX_SPILL_DEPTH 4
+
+typedef struct DistinctTable {
+  Database* db;
+  JQLCommand* cmd;
+  TableSchema* schema;
+  uint8_t schema_idx;
+  const char* error;
+
+  TupleSet seen; // keyed on the select list
+  ColumnValue* key;
+  uint32_t max_keys;
+  uint8_t depth;
+
+  GroupPartition spill[DISTINCT_SPILL_PARTITIONS];
+  GroupPartition* pending;
+  uint32_t pending_count;
+  uint32_t spill_files;
+  GroupPartition reading; // partition being deduplicated
+
+  Row* retired; // emitted partition rows, still referenced downstream
+  uint32_t retired_count;
+} DistinctTable;
+
+bool distinct_table_init(DistinctTable* table, Database* db, JQLCommand* cmd, TableSchema* schema, size_t memory_budget);
+bool distinct_table_add(DistinctTable* table, Row* row, bool* is_new);
+bool distinct_table_next_spilled(DistinctTable* table, Row* out);
+void distinct_table_free(DistinctTable* table);
+
+#endif
+
+#ifndef KERNEL_JOIN_H
+#define KERNEL_JOIN_H
+
+#define JOIN_SPILL_PARTITIONS 8
+#define JOIN_ROW_BLOCK 256
+
+typedef enum {
+  JOIN_NESTED_LOOP,
+  JOIN_HASH,
+  JOIN_INDEX_NESTED_LOOP
+} JoinStrategy;
+
+typedef struct JoinSide {
+  TableSchema* schema;
+  uint8_t schema_idx;
+  int key;
+  uint8_t offset;
+  uint64_t row_count;
+
+  uint16_t page;
+  uint16_t row;
+} JoinSide;
+
+typedef struct JoinPartition {
+  FILE* build;
+  FILE* probe;
+  char build_path[MAX_PATH_LENGTH];
+  char probe_path[MAX_PATH_LENGTH];
+} JoinPartition;
+
+typedef struct JoinExecutor {
+  Database* db;
+  JQLCommand* cmd;
+  TableSchema* schema;
+  uint8_t schema_idx;
+  const char* error;
+
+  JoinStrategy strategy;
+  JoinSide left;
+  JoinSide right;
+  JoinSide* build; // hashed side, or the inner side of a nested loop
+  JoinSide* probe; // streamed side, or the outer side of a nested loop
+  uint8_t key_type;
+  bool residual;
+
+  Row* build_rows;
+  uint64_t* hashes;
+  uint32_t* next;
+  uint32_t* buckets;
+  uint32_t bucket_mask;
+  uint32_t build_count;
+  uint32_t build_capacity;
+  uint32_t max_build_rows;
+  bool built;
+
+  Row outer;
+  uint64_t outer_hash;
+  bool owns_outer;
+  Row* inner;
+  uint32_t match;
+
+  JoinPartition partitions[JOIN_SPILL_PARTITIONS];
+  bool spilled;
+  uint32_t partition;
+  uint64_t spilled_rows;
+
+  ColumnValue* scratch;
+  ColumnValue** blocks;
+  uint32_t block_count;
+  uint32_t block_used;
+} JoinExecutor;
+
+JoinStrategy join_choose_strategy(uint64_t outer_rows, uint64_t inner_rows, bool inner_indexed, bool spills);
+
+bool join_init(JoinExecutor* join, Database* db, JQLCommand* cmd, TableSchema* schema, size_t memory_budget);
+bool join_next(JoinExecutor* join, Row* out);
+void join_free(JoinExecutor* join);
+
+#endif
+
+#ifndef KERNEL_STATISTICS_H
+#define KERNEL_STATISTICS_H
+
+#define STATS_HISTOGRAM_BUCKETS 16
+
+#define STATS_PAGE_COST 1.0         // reading one page of a sequential scan
+#define STATS_ROW_COST 0.01         // evaluating the WHERE clause on one row
+#define STATS_RANDOM_PAGE_COST 4.0  // fetching the page a B-tree lookup points at
+
+#define STATS_DEFAULT_EQ_SELECTIVITY 0.005
+#define STATS_DEFAULT_RANGE_SELECTIVITY (1.0 / 3.0)
+
+typedef struct ColumnStatistics {
+  uint8_t type;             // order the bounds were taken in, PAGE_ZONE_UNBOUNDED without one
+  bool has_range;
+  ZoneKey min, max;
+  uint64_t null_count;
+  HyperLogLog* distinct;
+  double bounds[STATS_HISTOGRAM_BUCKETS + 1]; // equi-depth, as of the last ANALYZE
+  uint8_t bucket_count;
+} ColumnStatistics;
+
+/*
+  Per-table statistics, kept on the database that owns the table. The row
+  count is taken from the buffer pool the first time a table is planned and
+  every insert, update and delete keeps it exact from then on. Column
+  statistics only exist once the table has been analyzed; writes keep their
+  NULL counts exact and widen the bounds and distinct sketches, while the
+  histograms stay as ANALYZE left them.
+*/
+typedef struct TableStatistics {
+  uint64_t row_count;
+  uint8_t column_count;
+  ColumnStatistics* columns; // NULL until ANALYZE
+} TableStatistics;
+
+typedef enum {
+  ACCESS_SEQ_SCAN,
+  ACCESS_PK_LOOKUP
+} AccessMethod;
+
+typedef struct AccessPlan {
+  AccessMethod method;
+  uint8_t column;   // key column of a lookup
+  ColumnValue key;  // the constant it is looked up by, cast to the column's type
+  double rows;      // estimated rows passing the WHERE clause
+  double seq_cost;
+  double lookup_cost;
+} AccessPlan;
+
+TableStatistics* table_statistics(Database* db, TableSchema* schema);
+void track_statistics(Database* db, TableSchema* schema, ColumnValue* values, int value_count, bool is_insert);
+void statistics_invalidate(Database* db, uint8_t schema_idx);
+void statistics_free(Database* db);
+
+ExecutionResult execute_analyze(Database* db, JQLCommand* cmd);
+
+uint64_t column_distinct_count(ColumnStatistics* column);
+double estimate_selectivity(Database* db, TableSchema* schema, ExprNode* where);
+AccessPlan plan_table_access(Database* db, JQLCommand* cmd, TableSchema* schema);
+bool statistics_count_rows(Database* db, JQLCommand* cmd, TableSchema* schema, uint64_t* count);
+
+#endif
+
+#ifndef KERNEL_RESULT_CACHE_H
+#define KERNEL_RESULT_CACHE_H
+
+#define RESULT_CACHE_BUCKETS 256
+
+typedef struct CachedResult {
+  char* key;
+  uint64_t hash;
+  uint8_t tables[2]; // the table read and the joined one
+  uint8_t table_count;
+
+  Row* rows;
+  uint32_t row_count;
+  char** aliases;
+  size_t alias_limit;
+  const char* message;
+  size_t bytes;
+
+  struct CachedResult* chain; // same bucket
+  struct CachedResult* newer;
+  struct CachedResult* older;
+} CachedResult;
+
+/*
+  SELECT results kept by the database that owns the tables, keyed on the
+  statement's token stream (so whitespace and keyword case do not matter)
+  plus the values bound to its parameters. Any write to a table drops the
+  entries that read it, and past db->result_cache_memory bytes the least
+  recently used entries go first.
+*/
+typedef struct ResultCache {
+  CachedResult* buckets[RESULT_CACHE_BUCKETS];
+  CachedResult* newest;
+  CachedResult* oldest;
+  uint32_t per_table[MAX_TABLES]; // entries reading each table, writes elsewhere cost nothing
+  uint32_t count;
+  size_t bytes;
+
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  uint64_t invalidations;
+} ResultCache;
+
+char* statement_fingerprint(const char* text, size_t length);
+char* result_cache_key(const char* fingerprint, ColumnValue* params, uint16_t param_count);
+
+ExecutionResult execute_select_cached(Database* db, JQLCommand* cmd);
+void result_cache_invalidate(Database* db, uint8_t schema_idx);
+void result_cache_free(Database* db);
+
+#endif
+
+#ifndef KERNEL_EXPLAIN_H
+#define KERNEL_EXPLAIN_H
+
+typedef enum {
+  PHASE_PARSE,
+  PHASE_BIND,       // resolving the tables and loading their key btrees
+  PHASE_PLAN,
+  PHASE_EXECUTE,
+  PHASE_COLLECT,    // finding the rows an UPDATE or DELETE touches
+  PHASE_FK_COLLECT, // gathering the keys referencing foreign keys have to check
+  PHASE_FK_ACTIONS, // ON UPDATE / ON DELETE actions, cascades included
+  PHASE_WRITE,
+  PHASE_COUNT
+} ProfilePhase;
+
+typedef struct ProfileClock {
+  uint64_t wall_ns;
+  uint64_t cpu_ns; // the whole process, so scan and aggregate workers count as well
+} ProfileClock;
+
+// what one operator did under EXPLAIN ANALYZE, its time includes the operators below it
+typedef struct OperatorStats {
+  uint64_t rows_in;        // rows a scan examined, other operators take their child's output
+  uint64_t rows_out;
+  uint64_t pages_decoded;  // pages still holding rows encoded as read from disk
+  uint64_t pages_cached;   // pages the buffer pool already held decoded
+  ProfileClock time;
+  ProfileClock filter;     // WHERE evaluation inside a scan
+} OperatorStats;
+
+/*
+  EXPLAIN ANALYZE hands a profile to the statement it runs through
+  db->profile. The statement takes it on entry, so nothing it runs on the
+  way records into it, and adds up the time spent in each phase it goes
+  through. A SELECT also leaves its instrumented pipeline behind for the
+  plan to be read off.
+*/
+typedef struct QueryProfile {
+  ProfileClock phases[PHASE_COUNT];
+  bool ran[PHASE_COUNT];
+  struct QueryOperator* pipeline;
+} QueryProfile;
+
+ProfileClock profile_now(void);
+ProfileClock profile_start(QueryProfile* profile);
+void profile_add(ProfileClock* total, ProfileClock* since);
+void profile_phase(QueryProfile* profile, ProfilePhase phase, ProfileClock* since);
+
+ExecutionResult execute_explain(Database* db, JQLCommand* cmd);
+
+#endif
+
+#ifndef KERNEL_PIPELINE_H
+#define KERNEL_PIPELINE_H
+
+typedef enum {
+  OPERATOR_SCAN,
+  OPERATOR_JOIN,
+  OPERATOR_GROUP,
+  OPERATOR_AGGREGATE,
+  OPERATOR_DISTINCT,
+  OPERATOR_SORT,
+  OPERATOR_TOP_N,
+  OPERATOR_LIMIT,
+  OPERATOR_PROJECT
+} QueryOperatorType;
+
+typedef struct QueryOperator {
+  QueryOperatorType type;
+  struct QueryOperator* child;
+  const char* error;
+
+  Database* db;
+  JQLCommand* cmd;
+  TableSchema* schema;
+  uint8_t schema_idx;
+  OperatorStats* stats; // EXPLAIN ANALYZE only
+
+  union {
+    struct {
+      VectorFilter* filter;
+      ScanSelection* selection;
+      bool drain;
+      Page* current;
+      uint16_t page;
+      uint16_t sel[VECTOR_SIZE];
+      uint16_t* current_sel;
+      uint16_t selected;
+      uint16_t cursor;
+      uint8_t columns[PAGE_COLUMN_BYTES]; // decoded only for the rows the scan hands out
+      AccessPlan plan;
+      bool counted;  // COUNT(*) answered from the row count, a single empty row stands in for the table
+      bool done;     // a lookup or counted scan has handed out its row
+    } scan;
+
+    JoinExecutor join;
+
+    struct {
+      GroupTable table;
+      bool filled;
+    } group;
+
+    struct {
+      ExprNode* aggregates[MAX_COLUMNS];
+      AggregateState* states;
+      uint8_t count;
+      Row* batch; // the input rows not yet folded into the states
+      uint32_t capacity;
+      ColumnValue* values;
+      bool owns_strings; // values copied out of a spilled join's rows
+      bool done;
+    } aggregate;
+
+    struct {
+      DistinctTable table;
+      bool drained;
+    } distinct;
+
+    struct {
+      RowSorter sorter;
+      uint32_t bound;
+      bool filled;
+    } sort;
+
+    struct {
+      uint32_t offset;
+      uint32_t limit;
+      uint32_t skipped;
+      uint32_t produced;
+    } limit;
+
+    struct {
+      ExprProgram* program;
+      bool* is_aggregate;
+      ColumnValue* aggregates;
+      bool aggregates_ready;
+      uint8_t width;
+    } project;
+  };
+} QueryOperator;
+
+QueryOperator* pipeline_build(Database* db, JQLCommand* cmd, TableSchema* schema);
+bool pipeline_instrument(QueryOperator* op);
+bool pipeline_next(QueryOperator* op, Row* out);
+const char* pipeline_error(QueryOperator* op);
+void pipeline_free(QueryOperator* op);
+
+#endif
+
 #ifndef KERNEL_WAL_H
 #define KERNEL_WAL_H
 
@@ -221,9 +1034,12 @@ void write_delete_wal(FILE* wal, uint8_t schema_idx, uint16_t page_idx, uint16_t
 #ifndef KERNEL_SEQUENCE_H
 #define KERNEL_SEQUENCE_H
 
+#define DEFAULT_SEQUENCE_CACHE 32
+
 int64_t sequence_next_val(Database* db, char* name);
-int64_t create_default_sequence(Database* db, char* name, bool is_unsafe);
+int64_t create_default_sequence(Database* db, char* name, uint32_t cache_size, bool is_unsafe);
 int64_t find_sequence(Database* db, char* name);
+void sequence_cache_free(Database* db);
 
 #endif
 
@@ -231,14 +1047,19 @@ int64_t find_sequence(Database* db, char* name);
 #define KERNEL_UTILS_H
 
 void swap_rows(Row* r1, Row* r2);
+int compare_values(ColumnValue* v1, ColumnValue* v2);
 int compare_rows(const Row* r1, const Row* r2, JQLCommand* cmd, TableSchema* schema);
 
 int partition_rows(Row rows[], int low, int high, JQLCommand *cmd, TableSchema *schema);
 void quick_sort_rows(Row rows[], int low, int high, JQLCommand *cmd, TableSchema *schema);
 
+void sift_up_rows(Row rows[], uint32_t idx, JQLCommand *cmd, TableSchema *schema);
+void sift_down_rows(Row rows[], uint32_t idx, uint32_t count, JQLCommand *cmd, TableSchema *schema);
+bool top_n_push_row(Row heap[], uint32_t* count, uint32_t bound, Row row, JQLCommand *cmd, TableSchema *schema);
+void heap_sort_rows(Row rows[], uint32_t count, JQLCommand *cmd, TableSchema *schema);
+
 char* process_str_arg(const char* check_expr);
 
-bool match_char_class(char** pattern_ptr, char* str);
 bool like_match(char* str, char* pattern);
 
 void* get_column_value_as_pointer(ColumnValue* col_val);
@@ -0,0 +1,328 @@
+#include "kernel/kernel.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+/*
+  Morsel-driven parallel scans. A database lazily starts a pool of worker
+  threads; a parallel job hands every worker (and the calling thread) the same
+  context, and workers claim one-page morsels from a shared atomic cursor
+  until the table is exhausted, so fast workers keep taking pages from slow
+  ones. Each worker filters with its own compiled VectorFilter since filters
+  and expression programs carry per-evaluation scratch state.
+*/
+
+typedef void (*ParallelTask)(void* ctx, uint32_t worker);
+
+struct WorkerPool {
+  pthread_t* threads;
+  uint32_t thread_count;
+
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t done;
+
+  ParallelTask task;
+  void* ctx;
+  uint64_t generation;
+  uint32_t next_worker;
+  uint32_t active;
+  bool shutdown;
+};
+
+static void* worker_main(void* arg) {
+  WorkerPool* pool = arg;
+  uint64_t seen = 0;
+
+  pthread_mutex_lock(&pool->lock);
+  while (true) {
+    while (!pool->shutdown && pool->generation == seen) {
+      pthread_cond_wait(&pool->wake, &pool->lock);
+    }
+    if (pool->shutdown) break;
+
+    seen = pool->generation;
+    ParallelTask task = pool->task;
+    void* ctx = pool->ctx;
+    uint32_t worker = pool->next_worker++;
+    pthread_mutex_unlock(&pool->lock);
+
+    task(ctx, worker);
+
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->active == 0) pthread_cond_signal(&pool->done);
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+
+uint32_t scan_worker_count(Database* db) {
+  uint32_t threads = db->scan_threads;
+
+  if (threads == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? (uint32_t)online : 1;
+  }
+
+  return threads > MAX_SCAN_THREADS ? MAX_SCAN_THREADS : threads;
+}
+
+static WorkerPool* worker_pool_get(Database* db) {
+  uint32_t thread_count = scan_worker_count(db) - 1;
+  if (db->workers && db->workers->thread_count == thread_count) return db->workers;
+
+  worker_pool_free(db->workers);
+  db->workers = NULL;
+  if (thread_count == 0) return NULL;
+
+  WorkerPool* pool = calloc(1, sizeof(WorkerPool));
+  if (!pool) return NULL;
+
+  pool->threads = calloc(thread_count, sizeof(pthread_t));
+  if (!pool->threads) {
+    free(pool);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  for (uint32_t i = 0; i < thread_count; i++) {
+    if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+      LOG_WARN("Failed to start scan worker %u, continuing with %u", i, i);
+      break;
+    }
+    pool->thread_count++;
+  }
+
+  db->workers = pool;
+  return pool;
+}
+
+void worker_pool_free(WorkerPool* pool) {
+  if (!pool) return;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = true;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (uint32_t i = 0; i < pool->thread_count; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->wake);
+  pthread_cond_destroy(&pool->done);
+
+  free(pool->threads);
+  free(pool);
+}
+
+// runs `task` on the calling thread (worker 0) and every pool thread; returns once all are done
+static void parallel_run(WorkerPool* pool, ParallelTask task, void* ctx) {
+  pthread_mutex_lock(&pool->lock);
+  pool->task = task;
+  pool->ctx = ctx;
+  pool->next_worker = 1;
+  pool->active = pool->thread_count;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  task(ctx, 0);
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->active > 0) {
+    pthread_cond_wait(&pool->done, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+static bool scan_is_parallel_safe(TableSchema* schema) {
+  // TOAST chunks are read through shared file handles
+  for (uint8_t i = 0; i < schema->column_count; i++) {
+    uint8_t type = schema->columns[i].type;
+    if (type == TOK_T_TEXT || type == TOK_T_JSON || type == TOK_T_BLOB) return false;
+  }
+
+  return true;
+}
+
+typedef struct ScanJob {
+  Database* db;
+  JQLCommand* cmd;
+  TableSchema* schema;
+  uint8_t schema_idx;
+
+  uint32_t workers;
+  VectorFilter* filters[MAX_SCAN_THREADS];
+  ScanSelection* selection;
+  atomic_uint next_page;
+} ScanJob;
+
+static void scan_task(void* ctx, uint32_t worker) {
+  ScanJob* job = ctx;
+  BufferPool* pool = &job->db->lake[job->schema_idx];
+  if (worker >= job->workers) return;
+
+  unsigned page_idx;
+  while ((page_idx = atomic_fetch_add(&job->next_page, 1)) < pool->num_pages) {
+    Page* page = pool->pages[page_idx];
+    if (!page || page->num_rows == 0) continue;
+
+    job->selection->counts[page_idx] = select_page_rows(job->db, job->cmd, job->filters[worker],
+      job->schema, job->schema_idx, page, job->selection->sel[page_idx]);
+  }
+}
+
+ScanSelection* scan_select_rows(Database* db, JQLCommand* cmd, TableSchema* schema, uint8_t schema_idx) {
+  BufferPool* pool = &db->lake[schema_idx];
+
+  ScanSelection* selection = calloc(1, sizeof(ScanSelection));
+  if (!selection) return NULL;
+  selection->page_count = pool->num_pages;
+
+  uint32_t workers = scan_worker_count(db);
+  if (workers > pool->num_pages) workers = pool->num_pages;
+
+  WorkerPool* worker_pool = NULL;
+  if (workers > 1 && scan_is_parallel_safe(schema)) {
+    worker_pool = worker_pool_get(db);
+  }
+
+  if (!worker_pool) workers = 1;
+  else if (workers > worker_pool->thread_count + 1) workers = worker_pool->thread_count + 1;
+
+  ScanJob job = {
+    .db = db,
+    .cmd = cmd,
+    .schema = schema,
+    .schema_idx = schema_idx,
+    .workers = workers,
+    .selection = selection
+  };
+  atomic_init(&job.next_page, 0);
+
+  if (cmd->has_where) {
+    for (uint32_t w = 0; w < workers; w++) {
+      job.filters[w] = vector_filter_compile(cmd->where, schema, db);
+    }
+  }
+
+  if (worker_pool) {
+    parallel_run(worker_pool, scan_task, &job);
+  } else {
+    scan_task(&job, 0);
+  }
+
+  for (uint32_t w = 0; w < workers; w++) {
+    vector_filter_free(job.filters[w]);
+  }
+
+  return selection;
+}
+
+typedef struct AggregateJob {
+  ExprNode** aggregates;
+  uint8_t count;
+  Row* rows;
+  uint32_t row_count;
+  TableSchema* schema;
+  Database* db;
+  uint8_t schema_idx;
+
+  uint32_t workers;
+  AggregateState* states[MAX_SCAN_THREADS];
+  bool failed[MAX_SCAN_THREADS];
+  atomic_uint next_morsel;
+} AggregateJob;
+
+static void aggregate_task(void* ctx, uint32_t worker) {
+  AggregateJob* job = ctx;
+  if (worker >= job->workers) return;
+
+  unsigned morsel;
+  while ((morsel = atomic_fetch_add(&job->next_morsel, 1)) * VECTOR_SIZE < job->row_count) {
+    uint32_t start = morsel * VECTOR_SIZE;
+    uint32_t count = job->row_count - start < VECTOR_SIZE ? job->row_count - start : VECTOR_SIZE;
+
+    if (!aggregate_rows(job->states[worker], job->aggregates, job->count, job->rows + start, count,
+        job->schema, job->db, job->schema_idx)) {
+      job->failed[worker] = true;
+    }
+  }
+}
+
+// partial states can only be merged when their order does not matter and workers never evaluate expressions
+static bool aggregates_are_parallel_safe(ExprNode** aggregates, uint8_t count) {
+  for (uint8_t k = 0; k < count; k++) {
+    Function* fn = &aggregates[k]->fn;
+    if (!aggregate_is_mergeable(fn->type)) return false;
+    if (fn->arg_count > 0 && fn->args[0]->type != EXPR_COLUMN) return false;
+  }
+
+  return true;
+}
+
+// folds the rows into `states`; mergeable aggregates are advanced one partial state per worker
+bool parallel_aggregate_rows(Database* db, ExprNode** aggregates, uint8_t count, Row* rows, uint32_t row_count,
+                             TableSchema* schema, uint8_t schema_idx, AggregateState* states) {
+  if (count == 0 || row_count == 0) return true;
+
+  uint32_t workers = scan_worker_count(db);
+  uint32_t morsels = (row_count + VECTOR_SIZE - 1) / VECTOR_SIZE;
+  if (workers > morsels) workers = morsels;
+
+  if (workers < 2 || !aggregates_are_parallel_safe(aggregates, count) || !scan_is_parallel_safe(schema)) {
+    return aggregate_rows(states, aggregates, count, rows, row_count, schema, db, schema_idx);
+  }
+
+  WorkerPool* pool = worker_pool_get(db);
+  if (!pool) return aggregate_rows(states, aggregates, count, rows, row_count, schema, db, schema_idx);
+  if (workers > pool->thread_count + 1) workers = pool->thread_count + 1;
+
+  AggregateJob* job = calloc(1, sizeof(AggregateJob));
+  if (!job) return false;
+
+  job->aggregates = aggregates;
+  job->count = count;
+  job->rows = rows;
+  job->row_count = row_count;
+  job->schema = schema;
+  job->db = db;
+  job->schema_idx = schema_idx;
+  job->workers = workers;
+  atomic_init(&job->next_morsel, 0);
+
+  bool ok = true;
+  for (uint32_t w = 0; w < workers && ok; w++) {
+    job->states[w] = calloc(count, sizeof(AggregateState));
+    ok = job->states[w] != NULL;
+  }
+
+  if (ok) parallel_run(pool, aggregate_task, job);
+
+  for (uint32_t w = 0; w < workers; w++) {
+    ok = ok && !job->failed[w];
+  }
+
+  for (uint8_t k = 0; k < count && ok; k++) {
+    for (uint32_t w = 0; w < workers; w++) {
+      aggregate_state_merge(&states[k], &job->states[w][k], &aggregates[k]->fn);
+    }
+  }
+
+  for (uint32_t w = 0; w < workers; w++) {
+    if (!job->states[w]) continue;
+    for (uint8_t k = 0; k < count; k++) {
+      aggregate_state_free(&job->states[w][k]);
+    }
+    free(job->states[w]);
+  }
+
+  free(job);
+  return ok;
+}
@@ -0,0 +1,654 @@
+#include "kernel/kernel.h"
+
+/*
+  Pull-based SELECT pipeline. Each operator hands back one row per call to
+  pipeline_next and only pulls from its child when it needs another one, so a
+  LIMIT stops the scan as soon as it is satisfied. ORDER BY still needs every
+  qualifying row and runs through a materializing sort operator placed below
+  the limit, which spills to disk past the database's sort memory budget;
+  ORDER BY with a LIM only keeps the best offset + limit rows in a bounded
+  heap instead. GROUP BY and HAVING hash aggregate the scan into one row per
+  group before any sorting or limiting, and SELECT DISTINCT drops repeated
+  select lists right after that. Aggregates without GROUP BY fold the input
+  into their accumulators a batch at a time and hand out a single row. A
+  joined select reads from a join operator in place of the scan.
+
+  The scan reads the single row a primary key lookup points at when the
+  statistics make that cheaper than reading every page, and a bare COUNT(*)
+  is answered from the table's row count without scanning at all.
+
+  EXPLAIN ANALYZE instruments a built pipeline, after which every operator
+  counts its rows and times its calls, and the scan also tells the pages it
+  had to decode from the ones the buffer pool held decoded already.
+*/
+
+static QueryOperator* operator_create(QueryOperatorType type, QueryOperator* child,
+                                      Database* db, JQLCommand* cmd, TableSchema* schema) {
+  QueryOperator* op = calloc(1, sizeof(QueryOperator));
+  if (!op) {
+    pipeline_free(child);
+    return NULL;
+  }
+
+  op->type = type;
+  op->child = child;
+  op->db = db;
+  op->cmd = cmd;
+  op->schema = schema;
+  op->schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+
+  return op;
+}
+
+// every column the operators above the scan read, the rest stay encoded on the page
+static void scan_projected_columns(JQLCommand* cmd, uint8_t* columns) {
+  if (cmd->select_all) {
+    memset(columns, 0xff, PAGE_COLUMN_BYTES);
+    return;
+  }
+
+  for (int j = 0; j < cmd->value_counts[0]; j++) {
+    expr_column_set(cmd->sel_columns[j].expr, columns);
+  }
+
+  for (uint8_t i = 0; cmd->has_order_by && i < cmd->order_by_count; i++) {
+    columns[cmd->order_by[i].col / 8] |= 1 << (cmd->order_by[i].col % 8);
+  }
+
+  for (uint8_t i = 0; cmd->has_group_by && i < cmd->group_by_count; i++) {
+    columns[cmd->group_by[i] / 8] |= 1 << (cmd->group_by[i] % 8);
+  }
+
+  if (cmd->has_having) expr_column_set(cmd->having, columns);
+}
+
+// aggregates of the select list are finalized into the slots past the table's columns, as a group row holds them
+static bool aggregate_operator_init(QueryOperator* op) {
+  JQLCommand* cmd = op->cmd;
+  uint16_t base = op->schema->column_count;
+
+  for (int j = 0; j < cmd->value_counts[0] && j < MAX_COLUMNS; j++) {
+    ExprNode* expr = cmd->sel_columns[j].expr;
+    if (!expr || expr->type != EXPR_FUNCTION || expr->fn.type == NOT_AGG) continue;
+
+    expr->fn.grouped = true;
+    expr->fn.group_slot = op->aggregate.count;
+    op->aggregate.aggregates[op->aggregate.count++] = expr;
+  }
+
+  // one morsel per scan worker at a time
+  op->aggregate.capacity = VECTOR_SIZE * scan_worker_count(op->db);
+  op->aggregate.batch = malloc(op->aggregate.capacity * sizeof(Row));
+  op->aggregate.states = calloc(op->aggregate.count, sizeof(AggregateState));
+  op->aggregate.values = calloc(base + op->aggregate.count, sizeof(ColumnValue));
+
+  return op->aggregate.batch && op->aggregate.states && op->aggregate.values;
+}
+
+static bool select_has_aggregates(JQLCommand* cmd) {
+  for (int j = 0; j < cmd->value_counts[0]; j++) {
+    ExprNode* expr = cmd->sel_columns[j].expr;
+    if (expr && expr->type == EXPR_FUNCTION && expr->fn.type != NOT_AGG) return true;
+  }
+
+  return false;
+}
+
+QueryOperator* pipeline_build(Database* db, JQLCommand* cmd, TableSchema* schema) {
+  QueryOperator* op = operator_create(cmd->has_join ? OPERATOR_JOIN : OPERATOR_SCAN, NULL, db, cmd, schema);
+  if (!op) return NULL;
+
+  bool grouped = cmd->has_group_by || cmd->has_having;
+  bool has_aggregates = select_has_aggregates(cmd) && !grouped;
+  uint64_t row_count = 0;
+
+  if (cmd->has_join) {
+    // the join applies WHERE to every joined row itself
+    if (!join_init(&op->join, db, cmd, schema, db->sort_memory)) {
+      op->error = op->join.error ? op->join.error : "Failed to plan join";
+    }
+  } else if (has_aggregates && statistics_count_rows(db, cmd, schema, &row_count)) {
+    op->scan.counted = true;
+    has_aggregates = false;
+  } else {
+    op->scan.plan = plan_table_access(db, cmd, schema);
+
+    // a scan that will run to completion anyway is filtered up front across the worker pool
+    op->scan.drain = op->scan.plan.method == ACCESS_SEQ_SCAN &&
+      (!cmd->has_limit || cmd->has_order_by || has_aggregates || grouped);
+    if (cmd->has_where && !op->scan.drain && op->scan.plan.method == ACCESS_SEQ_SCAN) {
+      op->scan.filter = vector_filter_compile(cmd->where, schema, db);
+    }
+    scan_projected_columns(cmd, op->scan.columns);
+  }
+
+  if (grouped) {
+    op = operator_create(OPERATOR_GROUP, op, db, cmd, schema);
+    if (!op) return NULL;
+
+    if (!group_table_init(&op->group.table, db, cmd, schema, db->sort_memory)) {
+      op->error = op->group.table.error ? op->group.table.error : "Failed to build group table";
+    }
+  }
+
+  if (has_aggregates) {
+    op = operator_create(OPERATOR_AGGREGATE, op, db, cmd, schema);
+    if (!op) return NULL;
+
+    if (!aggregate_operator_init(op)) op->error = "Memory allocation failed for aggregates";
+  }
+
+  // a select list of aggregates without GROUP BY is a single row already
+  if (cmd->is_distinct && !has_aggregates) {
+    op = operator_create(OPERATOR_DISTINCT, op, db, cmd, schema);
+    if (!op) return NULL;
+
+    // group rows carry values past the table's columns, which a spill file would drop
+    if (!distinct_table_init(&op->distinct.table, db, cmd, schema, grouped ? 0 : db->sort_memory)) {
+      op->error = op->distinct.table.error ? op->distinct.table.error : "Failed to build distinct table";
+    }
+  }
+
+  if (cmd->has_order_by && cmd->has_limit && !has_aggregates) {
+    op = operator_create(OPERATOR_TOP_N, op, db, cmd, schema);
+    if (!op) return NULL;
+
+    uint64_t bound = (uint64_t)cmd->limit + (cmd->has_offset ? cmd->offset : 0);
+    op->sort.bound = bound > UINT32_MAX ? UINT32_MAX : (uint32_t)bound;
+    sorter_init(&op->sort.sorter, db, cmd, schema, 0);
+  } else if (cmd->has_order_by && !has_aggregates) {
+    op = operator_create(OPERATOR_SORT, op, db, cmd, schema);
+    if (!op) return NULL;
+
+    // group rows carry values past the table's columns, so only a plain ORDER BY may spill
+    sorter_init(&op->sort.sorter, db, cmd, schema, grouped ? 0 : db->sort_memory);
+  }
+
+  if (cmd->has_offset || cmd->has_limit) {
+    op = operator_create(OPERATOR_LIMIT, op, db, cmd, schema);
+    if (!op) return NULL;
+    op->limit.offset = cmd->has_offset ? cmd->offset : 0;
+    op->limit.limit = cmd->has_limit ? cmd->limit : UINT32_MAX;
+  }
+
+  op = operator_create(OPERATOR_PROJECT, op, db, cmd, schema);
+  if (!op) return NULL;
+
+  op->project.width = cmd->value_counts[0] > schema->column_count ? cmd->value_counts[0] : schema->column_count;
+  op->project.is_aggregate = calloc(op->project.width, sizeof(bool));
+  op->project.aggregates = calloc(op->project.width, sizeof(ColumnValue));
+  if (!op->project.is_aggregate || !op->project.aggregates) {
+    pipeline_free(op);
+    return NULL;
+  }
+
+  ExprNode* projections[MAX_COLUMNS] = {0};
+  for (int j = 0; j < cmd->value_counts[0] && j < MAX_COLUMNS; j++) {
+    ExprNode* expr = cmd->sel_columns[j].expr;
+
+    if (expr && expr->type == EXPR_FUNCTION && expr->fn.type != NOT_AGG) {
+      op->project.is_aggregate[j] = true;
+    } else {
+      projections[j] = expr;
+    }
+  }
+
+  op->project.program = expr_program_compile(projections, cmd->value_counts[0], schema, db);
+
+  // every column of a counted scan is COUNT(*)
+  QueryOperator* scan = op;
+  while (scan->child) scan = scan->child;
+  if (scan->type == OPERATOR_SCAN && scan->scan.counted) {
+    for (int j = 0; j < cmd->value_counts[0] && j < MAX_COLUMNS; j++) {
+      op->project.aggregates[j] = (ColumnValue){ .type = TOK_T_INT, .int_value = (int64_t)row_count };
+    }
+    op->project.aggregates_ready = true;
+  }
+
+  return op;
+}
+
+bool pipeline_instrument(QueryOperator* op) {
+  for (; op; op = op->child) {
+    op->stats = calloc(1, sizeof(OperatorStats));
+    if (!op->stats) return false;
+  }
+
+  return true;
+}
+
+static void scan_count_page(QueryOperator* op, Page* page, uint16_t rows) {
+  if (!op->stats || !page) return;
+
+  op->stats->rows_in += rows;
+  if (page->image) op->stats->pages_decoded++;
+  else op->stats->pages_cached++;
+}
+
+// the single row a primary key lookup can find, if it passes the rest of the WHERE clause
+static bool lookup_next(QueryOperator* op, Row* out) {
+  if (op->scan.done) return false;
+  op->scan.done = true;
+
+  AccessPlan* plan = &op->scan.plan;
+  uint8_t btree_idx = hash_fnv1a(op->schema->columns[plan->column].name, MAX_COLUMNS);
+  RowID rid = btree_search(op->db->tc[op->schema_idx].btree[btree_idx], get_column_value_as_pointer(&plan->key));
+  if (is_struct_zeroed(&rid, sizeof(RowID))) return false;
+
+  BufferPool* pool = &op->db->lake[op->schema_idx];
+  Page* page = rid.page_id < pool->num_pages ? pool->pages[rid.page_id] : NULL;
+  if (!page || rid.row_id == 0 || rid.row_id > page->num_rows) return false;
+
+  uint16_t row_idx = rid.row_id - 1;
+  Row* row = &page->rows[row_idx];
+  if (is_struct_zeroed(row, sizeof(Row)) || row->deleted) return false;
+
+  scan_count_page(op, page, 1);
+  page_materialize_row(page, row_idx, op->schema, NULL);
+  if (!evaluate_condition(op->cmd->where, row, op->schema, op->db, op->schema_idx)) return false;
+
+  *out = *row;
+  return true;
+}
+
+static bool scan_next(QueryOperator* op, Row* out) {
+  BufferPool* pool = &op->db->lake[op->schema_idx];
+
+  if (op->scan.counted) {
+    if (op->scan.done) return false;
+    op->scan.done = true;
+    memset(out, 0, sizeof(Row));
+    return true;
+  }
+
+  if (op->scan.plan.method == ACCESS_PK_LOOKUP) return lookup_next(op, out);
+
+  if (op->scan.drain && !op->scan.selection) {
+    for (uint16_t p = 0; op->stats && p < pool->num_pages; p++) {
+      Page* page = pool->pages[p];
+      scan_count_page(op, page, page ? page->num_rows : 0);
+    }
+
+    ProfileClock start = op->stats ? profile_now() : (ProfileClock){0};
+    op->scan.selection = scan_select_rows(op->db, op->cmd, op->schema, op->schema_idx);
+    if (op->stats) profile_add(&op->stats->filter, &start);
+
+    if (!op->scan.selection) {
+      op->error = "Memory allocation failed for scan selection";
+      return false;
+    }
+  }
+
+  while (op->scan.cursor >= op->scan.selected) {
+    if (op->scan.page >= pool->num_pages) return false;
+
+    uint16_t page_idx = op->scan.page++;
+    Page* page = pool->pages[page_idx];
+    op->scan.cursor = 0;
+    op->scan.selected = 0;
+    op->scan.current = page;
+
+    if (!page || page->num_rows == 0) continue;
+
+    if (op->scan.selection) {
+      op->scan.current_sel = op->scan.selection->sel[page_idx];
+      op->scan.selected = op->scan.selection->counts[page_idx];
+    } else {
+      scan_count_page(op, page, page->num_rows);
+
+      ProfileClock start = op->stats ? profile_now() : (ProfileClock){0};
+      op->scan.current_sel = op->scan.sel;
+      op->scan.selected = select_page_rows(op->db, op->cmd, op->scan.filter, op->schema,
+        op->schema_idx, page, op->scan.sel);
+      if (op->stats) profile_add(&op->stats->filter, &start);
+    }
+  }
+
+  uint16_t row_idx = op->scan.current_sel[op->scan.cursor++];
+  page_materialize_row(op->scan.current, row_idx, op->schema, op->scan.columns);
+
+  *out = op->scan.current->rows[row_idx];
+  return true;
+}
+
+static bool join_operator_next(QueryOperator* op, Row* out) {
+  if (join_next(&op->join, out)) return true;
+
+  op->error = op->join.error;
+  return false;
+}
+
+static bool group_next(QueryOperator* op, Row* out) {
+  GroupTable* table = &op->group.table;
+
+  if (!op->group.filled) {
+    op->group.filled = true;
+
+    Row row;
+    while (pipeline_next(op->child, &row)) {
+      if (!group_table_add(table, &row)) {
+        op->error = table->error;
+        return false;
+      }
+    }
+
+    if (pipeline_error(op->child)) return false;
+
+    if (!group_table_finish(table)) {
+      op->error = table->error;
+      return false;
+    }
+  }
+
+  if (group_table_next(table, out)) return true;
+
+  op->error = table->error;
+  return false;
+}
+
+static bool aggregate_fold(QueryOperator* op, uint32_t count) {
+  if (parallel_aggregate_rows(op->db, op->aggregate.aggregates, op->aggregate.count, op->aggregate.batch,
+      count, op->schema, op->schema_idx, op->aggregate.states)) {
+    return true;
+  }
+
+  op->error = "Failed to evaluate aggregates";
+  return false;
+}
+
+static bool aggregate_next(QueryOperator* op, Row* out) {
+  if (op->aggregate.done) return false;
+  op->aggregate.done = true;
+
+  uint16_t base = op->schema->column_count;
+  ColumnValue* values = op->aggregate.values;
+  for (uint16_t i = 0; i < base; i++) {
+    values[i].is_null = true;
+  }
+
+  memset(out, 0, sizeof(Row));
+  uint32_t count = 0;
+  uint64_t seen = 0;
+
+  Row row;
+  while (pipeline_next(op->child, &row)) {
+    // the select list's plain columns read the first row, an empty input leaves them NULL
+    if (seen++ == 0) {
+      out->id = row.id;
+      memcpy(values, row.values, (row.n_values < base ? row.n_values : base) * sizeof(ColumnValue));
+      op->aggregate.owns_strings = row.owns_strings;
+
+      for (uint16_t i = 0; op->aggregate.owns_strings && i < base; i++) {
+        if (copy_spill_value(&values[i])) continue;
+
+        // the values not copied yet are still borrowed
+        while (++i < base) values[i].is_null = true;
+        op->error = "Memory allocation failed for aggregated values";
+        return false;
+      }
+    }
+
+    op->aggregate.batch[count++] = row;
+    if (count == op->aggregate.capacity) {
+      if (!aggregate_fold(op, count)) return false;
+      count = 0;
+    }
+  }
+
+  if (pipeline_error(op->child)) return false;
+  if (count > 0 && !aggregate_fold(op, count)) return false;
+
+  for (uint8_t k = 0; k < op->aggregate.count; k++) {
+    Function* fn = &op->aggregate.aggregates[k]->fn;
+    values[base + k] = aggregate_state_finalize(&op->aggregate.states[k], fn);
+
+    // the input values MIN, MAX and the like return are released along with their rows
+    if (op->aggregate.owns_strings && aggregate_returns_input(fn->type) && !copy_spill_value(&values[base + k])) {
+      op->error = "Memory allocation failed for aggregated values";
+      return false;
+    }
+  }
+
+  out->values = values;
+  out->n_values = base + op->aggregate.count;
+  out->owns_strings = op->aggregate.owns_strings;
+  return true;
+}
+
+static bool distinct_next(QueryOperator* op, Row* out) {
+  DistinctTable* table = &op->distinct.table;
+
+  if (!op->distinct.drained) {
+    Row row;
+    while (pipeline_next(op->child, &row)) {
+      bool is_new;
+      if (!distinct_table_add(table, &row, &is_new)) {
+        op->error = table->error;
+        return false;
+      }
+
+      if (is_new) {
+        *out = row;
+        return true;
+      }
+    }
+
+    if (pipeline_error(op->child)) return false;
+    op->distinct.drained = true;
+  }
+
+  if (distinct_table_next_spilled(table, out)) return true;
+
+  op->error = table->error;
+  return false;
+}
+
+static bool sort_fill(QueryOperator* op) {
+  RowSorter* sorter = &op->sort.sorter;
+
+  Row row;
+  while (pipeline_next(op->child, &row)) {
+    if (!sorter_add(sorter, row)) {
+      op->error = "Failed to buffer rows for sorting";
+      return false;
+    }
+  }
+
+  if (pipeline_error(op->child)) return false;
+
+  if (!sorter_finish(sorter)) {
+    op->error = "Failed to merge sorted runs";
+    return false;
+  }
+
+  return true;
+}
+
+static bool top_n_fill(QueryOperator* op) {
+  RowSorter* sorter = &op->sort.sorter;
+  uint32_t bound = op->sort.bound;
+
+  Row row;
+  while (pipeline_next(op->child, &row)) {
+    if (sorter->count == sorter->capacity && sorter->count < bound) {
+      uint32_t capacity = sorter->capacity ? sorter->capacity * 2 : 64;
+      if (capacity > bound) capacity = bound;
+
+      Row* rows = realloc(sorter->rows, capacity * sizeof(Row));
+      if (!rows) {
+        op->error = "Memory allocation failed for result rows";
+        return false;
+      }
+
+      sorter->rows = rows;
+      sorter->capacity = capacity;
+    }
+
+    top_n_push_row(sorter->rows, &sorter->count, bound, row, op->cmd, op->schema);
+  }
+
+  if (pipeline_error(op->child)) return false;
+
+  heap_sort_rows(sorter->rows, sorter->count, op->cmd, op->schema);
+  return true;
+}
+
+static bool sort_next(QueryOperator* op, Row* out) {
+  if (!op->sort.filled) {
+    op->sort.filled = true;
+    bool filled = op->type == OPERATOR_TOP_N ? top_n_fill(op) : sort_fill(op);
+    if (!filled) return false;
+  }
+
+  return sorter_next(&op->sort.sorter, out);
+}
+
+static bool limit_next(QueryOperator* op, Row* out) {
+  if (op->limit.produced >= op->limit.limit) return false;
+
+  while (op->limit.skipped < op->limit.offset) {
+    if (!pipeline_next(op->child, out)) return false;
+    op->limit.skipped++;
+  }
+
+  if (!pipeline_next(op->child, out)) return false;
+
+  op->limit.produced++;
+  return true;
+}
+
+static bool project_next(QueryOperator* op, Row* out) {
+  Row src;
+  if (!pipeline_next(op->child, &src)) return false;
+
+  JQLCommand* cmd = op->cmd;
+
+  memset(out, 0, sizeof(Row));
+  out->id = src.id;
+  out->n_values = op->project.width;
+  out->values = calloc(op->project.width, sizeof(ColumnValue));
+  if (!out->values) {
+    op->error = "Memory allocation failed for projected values";
+    return false;
+  }
+
+  for (int k = 0; k < op->project.width; k++) {
+    out->values[k].is_null = true;
+  }
+
+  if (op->project.program) {
+    expr_program_run(op->project.program, &src, op->schema, op->db, op->schema_idx);
+  }
+
+  for (int j = 0; j < cmd->value_counts[0]; j++) {
+    ExprNode* expr = cmd->sel_columns[j].expr;
+    if (!expr) continue;
+
+    if (op->project.is_aggregate[j]) {
+      // grouped and aggregated rows already hold their finalized aggregates
+      out->values[j] = op->project.aggregates_ready ? op->project.aggregates[j]
+        : evaluate_expression(expr, &src, op->schema, op->db, op->schema_idx);
+    } else if (op->project.program) {
+      out->values[j] = expr_program_result(op->project.program, j);
+    } else {
+      out->values[j] = evaluate_expression(expr, &src, op->schema, op->db, op->schema_idx);
+    }
+  }
+
+  // the result row outlives the spilled row it was projected from
+  keep_spill_values(&src, out->values, cmd->value_counts[0]);
+
+  return true;
+}
+
+static bool operator_next(QueryOperator* op, Row* out) {
+  switch (op->type) {
+    case OPERATOR_SCAN: return scan_next(op, out);
+    case OPERATOR_JOIN: return join_operator_next(op, out);
+    case OPERATOR_GROUP: return group_next(op, out);
+    case OPERATOR_AGGREGATE: return aggregate_next(op, out);
+    case OPERATOR_DISTINCT: return distinct_next(op, out);
+    case OPERATOR_SORT:
+    case OPERATOR_TOP_N: return sort_next(op, out);
+    case OPERATOR_LIMIT: return limit_next(op, out);
+    case OPERATOR_PROJECT: return project_next(op, out);
+  }
+
+  return false;
+}
+
+bool pipeline_next(QueryOperator* op, Row* out) {
+  if (!op || op->error) return false;
+  if (!op->stats) return operator_next(op, out);
+
+  ProfileClock start = profile_now();
+  bool produced = operator_next(op, out);
+  profile_add(&op->stats->time, &start);
+
+  op->stats->rows_out += produced;
+  return produced;
+}
+
+const char* pipeline_error(QueryOperator* op) {
+  for (; op; op = op->child) {
+    if (op->error) return op->error;
+  }
+
+  return NULL;
+}
+
+void pipeline_free(QueryOperator* op) {
+  while (op) {
+    QueryOperator* child = op->child;
+
+    switch (op->type) {
+      case OPERATOR_SCAN:
+        vector_filter_free(op->scan.filter);
+        free(op->scan.selection);
+        break;
+      case OPERATOR_JOIN:
+        join_free(&op->join);
+        break;
+      case OPERATOR_GROUP:
+        group_table_free(&op->group.table);
+        break;
+      case OPERATOR_AGGREGATE:
+        for (uint8_t k = 0; op->aggregate.states && k < op->aggregate.count; k++) {
+          aggregate_state_free(&op->aggregate.states[k]);
+        }
+        if (op->aggregate.owns_strings && op->aggregate.values) {
+          uint16_t base = op->schema->column_count;
+          for (uint16_t i = 0; i < base; i++) {
+            free_spill_value(&op->aggregate.values[i]);
+          }
+          for (uint8_t k = 0; k < op->aggregate.count; k++) {
+            if (aggregate_returns_input(op->aggregate.aggregates[k]->fn.type)) {
+              free_spill_value(&op->aggregate.values[base + k]);
+            }
+          }
+        }
+        free(op->aggregate.states);
+        free(op->aggregate.batch);
+        free(op->aggregate.values);
+        break;
+      case OPERATOR_DISTINCT:
+        distinct_table_free(&op->distinct.table);
+        break;
+      case OPERATOR_SORT:
+      case OPERATOR_TOP_N:
+        sorter_free(&op->sort.sorter);
+        break;
+      case OPERATOR_PROJECT:
+        expr_program_free(op->project.program);
+        free(op->project.is_aggregate);
+        free(op->project.aggregates);
+        break;
+      default:
+        break;
+    }
+
+    free(op->stats);
+    free(op);
+    op = child;
+  }
+}
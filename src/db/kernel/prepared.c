@@ -0,0 +1,338 @@
+#include "kernel/kernel.h"
+
+/*
+  Prepared statements. A statement is lexed, parsed and resolved against its
+  schema once; every $n placeholder in the resulting command is remembered as
+  a slot. Binding rewrites each slot into a literal of the bound value, cast to
+  the type of the column it is compared with or stored into, so executions run
+  the same literal paths (vector kernels, compiled programs, key lookups) as an
+  inline query would, without re-lexing or re-parsing the text.
+*/
+
+bool value_has_string(ColumnValue* value) {
+  if (value->is_null || value->is_array || value->is_toast || !value->str_value) return false;
+
+  switch (value->type) {
+    case TOK_T_VARCHAR:
+    case TOK_T_CHAR:
+    case TOK_T_TEXT:
+    case TOK_T_STRING:
+    case TOK_T_JSON:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool add_slot(PreparedStatement* stmt, ExprNode* node, ColumnDefinition* column) {
+  PreparedSlot* slots = realloc(stmt->slots, sizeof(PreparedSlot) * (stmt->slot_count + 1));
+  if (!slots) return false;
+
+  stmt->slots = slots;
+  stmt->slots[stmt->slot_count++] = (PreparedSlot){ .node = node, .param = node->param, .column = column };
+  return true;
+}
+
+static ColumnDefinition* column_of(ExprNode* node, TableSchema* schema) {
+  if (!node || !schema || node->type != EXPR_COLUMN || node->column.index >= schema->column_count) return NULL;
+  return &schema->columns[node->column.index];
+}
+
+// a placeholder compared with (or ranged against) a bare column takes that column's type
+static bool collect_slots(PreparedStatement* stmt, ExprNode* node, TableSchema* schema, ColumnDefinition* column) {
+  if (!node) return true;
+
+  switch (node->type) {
+    case EXPR_PARAMETER:
+      return add_slot(stmt, node, column);
+
+    case EXPR_ARRAY_ACCESS:
+      return collect_slots(stmt, node->column.array_idx, schema, NULL);
+
+    case EXPR_UNARY_OP:
+    case EXPR_LOGICAL_NOT:
+      return collect_slots(stmt, node->arth_unary.expr, schema, NULL);
+
+    case EXPR_COMPARISON:
+      return collect_slots(stmt, node->binary.left, schema, column_of(node->binary.right, schema)) &&
+             collect_slots(stmt, node->binary.right, schema, column_of(node->binary.left, schema));
+
+    case EXPR_BINARY_OP:
+    case EXPR_LOGICAL_AND:
+    case EXPR_LOGICAL_OR:
+      return collect_slots(stmt, node->binary.left, schema, NULL) &&
+             collect_slots(stmt, node->binary.right, schema, NULL);
+
+    case EXPR_FUNCTION:
+      for (uint8_t i = 0; i < node->fn.arg_count; i++) {
+        if (!collect_slots(stmt, node->fn.args[i], schema, NULL)) return false;
+      }
+      return true;
+
+    case EXPR_LIKE:
+      return collect_slots(stmt, node->like.left, schema, NULL);
+
+    case EXPR_BETWEEN: {
+      ColumnDefinition* bound = column_of(node->between.value, schema);
+      return collect_slots(stmt, node->between.value, schema, NULL) &&
+             collect_slots(stmt, node->between.lower, schema, bound) &&
+             collect_slots(stmt, node->between.upper, schema, bound);
+    }
+
+    case EXPR_IN: {
+      ColumnDefinition* item = column_of(node->in.value, schema);
+      if (!collect_slots(stmt, node->in.value, schema, NULL)) return false;
+      for (size_t i = 0; i < node->in.count; i++) {
+        if (!collect_slots(stmt, node->in.list[i], schema, item)) return false;
+      }
+      return true;
+    }
+
+    default:
+      return true;
+  }
+}
+
+static bool collect_command_slots(Database* db, PreparedStatement* stmt) {
+  JQLCommand* cmd = stmt->cmd;
+
+  TableSchema* schema = cmd->schema ? get_table_schema(db, cmd->schema->table_name) : NULL;
+  TableSchema* rows_schema = cmd->has_join ? cmd->join_schema : schema;
+
+  if (cmd->sel_columns) {
+    for (int i = 0; i < MAX_COLUMNS && cmd->sel_columns[i].expr; i++) {
+      if (!collect_slots(stmt, cmd->sel_columns[i].expr, rows_schema, NULL)) return false;
+    }
+  }
+
+  if (cmd->type == CMD_INSERT && schema) {
+    for (uint8_t r = 0; r < cmd->row_count; r++) {
+      for (uint8_t c = 0; c < schema->column_count; c++) {
+        if (!collect_slots(stmt, cmd->values[r][c], schema, &schema->columns[c])) return false;
+      }
+    }
+  } else if (cmd->type == CMD_UPDATE && schema) {
+    for (uint8_t i = 0; i < cmd->value_counts[0]; i++) {
+      ColumnDefinition* column = &schema->columns[cmd->update_columns[i].index];
+      if (!collect_slots(stmt, cmd->values[0][i], schema, column)) return false;
+    }
+  }
+
+  return collect_slots(stmt, cmd->join_condition, rows_schema, NULL) &&
+         collect_slots(stmt, cmd->where, rows_schema, NULL) &&
+         collect_slots(stmt, cmd->having, rows_schema, NULL);
+}
+
+static void release_bound_strings(PreparedStatement* stmt) {
+  if (stmt->retains_values) return;
+
+  for (uint16_t i = 0; i < stmt->slot_count; i++) {
+    ExprNode* node = stmt->slots[i].node;
+    if (node->type != EXPR_LITERAL || !value_has_string(&node->literal)) continue;
+
+    free(node->literal.str_value);
+    node->literal.str_value = NULL;
+  }
+}
+
+static const char* bind_parameters(PreparedStatement* stmt, ColumnValue* params, uint16_t param_count) {
+  if (param_count < stmt->param_count) {
+    return "Not enough parameters for prepared statement";
+  }
+
+  release_bound_strings(stmt);
+
+  for (uint16_t i = 0; i < stmt->slot_count; i++) {
+    PreparedSlot* slot = &stmt->slots[i];
+    ColumnValue value = params[slot->param];
+
+    if (value.is_null) {
+      value.type = TOK_NL;
+    } else if (slot->column && !infer_and_cast_value(&value, slot->column)) {
+      return "Parameter type does not match the column it is bound to";
+    }
+
+    // the caller's buffers may not outlive the rows an INSERT or UPDATE writes
+    if (value_has_string(&value)) value.str_value = strdup(value.str_value);
+
+    slot->node->type = EXPR_LITERAL;
+    slot->node->literal = value;
+  }
+
+  return NULL;
+}
+
+static PreparedStatement* create_prepared_statement(Database* db, const char* name, JQLCommand* cmd, uint16_t param_count) {
+  PreparedStatement* stmt = calloc(1, sizeof(PreparedStatement));
+  if (!stmt) return NULL;
+
+  if (name) strncpy(stmt->name, name, MAX_IDENTIFIER_LEN - 1);
+  stmt->cmd = cmd;
+  stmt->param_count = param_count;
+  stmt->retains_values = cmd->type == CMD_INSERT || cmd->type == CMD_UPDATE;
+
+  // the lexer still holds the text the command was parsed from
+  if (cmd->type == CMD_SELECT) stmt->fingerprint = statement_fingerprint(db->lexer->buf, db->lexer->buf_size);
+
+  if (!collect_command_slots(db, stmt)) {
+    free(stmt->slots);
+    free(stmt->fingerprint);
+    free(stmt);
+    return NULL;
+  }
+
+  if (name) {
+    stmt->next = db->prepared;
+    db->prepared = stmt;
+  }
+
+  return stmt;
+}
+
+PreparedStatement* prepare_statement(Database* db, const char* name, char* buffer) {
+  if (!db || !db->lexer || !db->parser || !buffer) return NULL;
+
+  if (name && find_prepared_statement(db, name)) {
+    LOG_ERROR("Prepared statement '%s' already exists", name);
+    return NULL;
+  }
+
+  lexer_set_buffer(db->lexer, buffer);
+  parser_reset(db->parser);
+
+  JQLCommand* cmd = malloc(sizeof(JQLCommand));
+  if (!cmd) return NULL;
+  *cmd = parser_parse(db);
+
+  if (cmd->is_invalid || cmd->type == CMD_PREPARE || cmd->type == CMD_EXECUTE || cmd->type == CMD_DEALLOCATE) {
+    free(cmd);
+    return NULL;
+  }
+
+  PreparedStatement* stmt = create_prepared_statement(db, name, cmd, db->parser->param_count);
+  if (!stmt) {
+    free_jql_command(cmd);
+    free(cmd);
+  }
+
+  return stmt;
+}
+
+PreparedStatement* find_prepared_statement(Database* db, const char* name) {
+  for (PreparedStatement* stmt = db->prepared; stmt; stmt = stmt->next) {
+    if (strcmp(stmt->name, name) == 0) return stmt;
+  }
+  return NULL;
+}
+
+Result execute_prepared(Database* db, PreparedStatement* stmt, ColumnValue* params, uint16_t param_count, bool show) {
+  if (!db || !stmt || !stmt->cmd) {
+    return (Result){(ExecutionResult){1, "Invalid prepared statement"}, NULL};
+  }
+
+  const char* error = bind_parameters(stmt, params, param_count);
+  if (error) {
+    return (Result){(ExecutionResult){1, error}, NULL};
+  }
+
+  free(stmt->cmd->cache_key);
+  stmt->cmd->cache_key = db->result_cache_memory && stmt->fingerprint
+    ? result_cache_key(stmt->fingerprint, params, param_count) : NULL;
+
+  Result result = execute_cmd(db, stmt->cmd, show);
+
+  // RETURNING hands out the command's own column names, which free_result would release
+  if (result.exec.aliases && result.exec.aliases == stmt->cmd->returning_columns) {
+    char** aliases = malloc(sizeof(char*) * result.exec.alias_limit);
+    for (size_t i = 0; i < result.exec.alias_limit; i++) {
+      aliases[i] = result.exec.aliases[i] ? strdup(result.exec.aliases[i]) : NULL;
+    }
+    result.exec.aliases = aliases;
+  }
+
+  // the command stays with the statement for the next execution
+  result.cmd = NULL;
+  return result;
+}
+
+bool deallocate_prepared_statement(Database* db, const char* name) {
+  for (PreparedStatement** link = &db->prepared; *link; link = &(*link)->next) {
+    PreparedStatement* stmt = *link;
+    if (strcmp(stmt->name, name) != 0) continue;
+
+    *link = stmt->next;
+    free_prepared_statement(stmt);
+    return true;
+  }
+
+  return false;
+}
+
+ExecutionResult execute_prepare(Database* db, JQLCommand* cmd) {
+  if (find_prepared_statement(db, cmd->statement_name)) {
+    return (ExecutionResult){1, "Prepared statement already exists"};
+  }
+
+  if (!create_prepared_statement(db, cmd->statement_name, cmd->prepared, cmd->param_count)) {
+    return (ExecutionResult){1, "Failed to prepare statement"};
+  }
+
+  // the statement owns the parsed command from here on
+  cmd->prepared = NULL;
+  return (ExecutionResult){0, "Statement prepared"};
+}
+
+Result execute_named_statement(Database* db, JQLCommand* cmd, bool show) {
+  PreparedStatement* stmt = find_prepared_statement(db, cmd->statement_name);
+  if (!stmt) {
+    return (Result){(ExecutionResult){1, "Prepared statement does not exist"}, cmd};
+  }
+
+  if (cmd->param_count != stmt->param_count) {
+    LOG_ERROR("Prepared statement '%s' takes %u parameter(s), %u given",
+      stmt->name, stmt->param_count, cmd->param_count);
+    return (Result){(ExecutionResult){1, "Wrong number of parameters for prepared statement"}, cmd};
+  }
+
+  Row no_row = {0};
+  TableSchema no_columns = {0};
+  ColumnValue params[MAX_PARAMS];
+
+  for (uint16_t i = 0; i < cmd->param_count; i++) {
+    params[i] = evaluate_expression(cmd->params[i], &no_row, &no_columns, db, 0);
+  }
+
+  Result result = execute_prepared(db, stmt, params, cmd->param_count, show);
+  result.cmd = cmd;
+  return result;
+}
+
+ExecutionResult execute_deallocate(Database* db, JQLCommand* cmd) {
+  if (!deallocate_prepared_statement(db, cmd->statement_name)) {
+    return (ExecutionResult){1, "Prepared statement does not exist"};
+  }
+
+  return (ExecutionResult){0, "Statement deallocated"};
+}
+
+void free_prepared_statement(PreparedStatement* stmt) {
+  if (!stmt) return;
+
+  release_bound_strings(stmt);
+  free(stmt->slots);
+  free(stmt->fingerprint);
+
+  free_jql_command(stmt->cmd);
+  free(stmt->cmd);
+  free(stmt);
+}
+
+void free_prepared_statements(Database* db) {
+  PreparedStatement* stmt = db->prepared;
+  while (stmt) {
+    PreparedStatement* next = stmt->next;
+    free_prepared_statement(stmt);
+    stmt = next;
+  }
+  db->prepared = NULL;
+}
@@ -0,0 +1,622 @@
+#include "kernel/kernel.h"
+
+/*
+  Expression programs. A statement's expression trees are lowered once into a
+  flat, register-based instruction list: literals become constant registers,
+  function names are resolved to their BuiltinFunction up front, subtrees whose
+  inputs are all constant are folded at compile time and structurally equal
+  subtrees share a register. Shapes the compiler does not lower run through
+  evaluate_expression as a single PROG_EVAL instruction. A column tested
+  against a list of constants with IN probes a hash set built at compile time.
+*/
+
+typedef struct ProgramSubexpr {
+  ExprNode* node;
+  uint16_t reg;
+} ProgramSubexpr;
+
+typedef struct ProgramCompiler {
+  ExprProgram* prog;
+  TableSchema* schema;
+  Database* db;
+
+  ProgramSubexpr* subexprs;
+  uint16_t subexpr_count;
+  uint16_t subexpr_capacity;
+} ProgramCompiler;
+
+static const char* volatile_functions[] = { "RAND" };
+
+static bool function_is_volatile(const char* name) {
+  for (size_t i = 0; i < sizeof(volatile_functions) / sizeof(volatile_functions[0]); i++) {
+    if (strcmp(volatile_functions[i], name) == 0) return true;
+  }
+  return false;
+}
+
+static bool expr_nodes_equal(ExprNode* a, ExprNode* b) {
+  if (a == b) return true;
+  if (!a || !b || a->type != b->type) return false;
+
+  switch (a->type) {
+    case EXPR_LITERAL:
+      if (a->literal.is_null || b->literal.is_null) return a->literal.is_null && b->literal.is_null;
+      if (a->literal.type != b->literal.type || a->literal.is_array || b->literal.is_array) return false;
+      return column_values_equal(&a->literal, &b->literal, a->literal.type);
+
+    case EXPR_COLUMN:
+      return a->column.index == b->column.index && !a->column.array_idx && !b->column.array_idx;
+
+    case EXPR_UNARY_OP:
+      return a->arth_unary.op == b->arth_unary.op && expr_nodes_equal(a->arth_unary.expr, b->arth_unary.expr);
+
+    case EXPR_BINARY_OP:
+    case EXPR_COMPARISON:
+    case EXPR_LOGICAL_AND:
+    case EXPR_LOGICAL_OR:
+      return a->binary.op == b->binary.op &&
+             expr_nodes_equal(a->binary.left, b->binary.left) &&
+             expr_nodes_equal(a->binary.right, b->binary.right);
+
+    case EXPR_LOGICAL_NOT:
+      return expr_nodes_equal(a->unary, b->unary);
+
+    case EXPR_FUNCTION:
+      if (a->fn.type != NOT_AGG || b->fn.type != NOT_AGG) return false;
+      if (strcmp(a->fn.name, b->fn.name) != 0 || a->fn.arg_count != b->fn.arg_count) return false;
+      if (function_is_volatile(a->fn.name)) return false;
+
+      for (uint8_t i = 0; i < a->fn.arg_count; i++) {
+        if (!expr_nodes_equal(a->fn.args[i], b->fn.args[i])) return false;
+      }
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+static uint16_t program_register(ExprProgram* prog) {
+  if (prog->num_registers == PROGRAM_NO_REGISTER) return PROGRAM_NO_REGISTER;
+
+  if (prog->num_registers == prog->register_capacity) {
+    uint16_t capacity = prog->register_capacity ? prog->register_capacity * 2 : 16;
+
+    ColumnValue* registers = realloc(prog->registers, sizeof(ColumnValue) * capacity);
+    if (!registers) return PROGRAM_NO_REGISTER;
+    prog->registers = registers;
+
+    bool* constant = realloc(prog->constant, sizeof(bool) * capacity);
+    if (!constant) return PROGRAM_NO_REGISTER;
+    prog->constant = constant;
+
+    prog->register_capacity = capacity;
+  }
+
+  uint16_t reg = prog->num_registers++;
+  memset(&prog->registers[reg], 0, sizeof(ColumnValue));
+  prog->constant[reg] = false;
+
+  return reg;
+}
+
+static uint16_t program_constant(ExprProgram* prog, ColumnValue value) {
+  uint16_t reg = program_register(prog);
+  if (reg == PROGRAM_NO_REGISTER) return reg;
+
+  prog->registers[reg] = value;
+  prog->constant[reg] = true;
+
+  return reg;
+}
+
+static bool program_own(ExprProgram* prog, void* ptr) {
+  if (prog->owned_count == prog->owned_capacity) {
+    uint16_t capacity = prog->owned_capacity ? prog->owned_capacity * 2 : 8;
+    void** owned = realloc(prog->owned, sizeof(void*) * capacity);
+    if (!owned) return false;
+
+    prog->owned = owned;
+    prog->owned_capacity = capacity;
+  }
+
+  prog->owned[prog->owned_count++] = ptr;
+  return true;
+}
+
+static ExprNode* program_literal_node(ExprProgram* prog, ColumnValue value) {
+  ExprNode* node = calloc(1, sizeof(ExprNode));
+  if (!node) return NULL;
+
+  node->type = EXPR_LITERAL;
+  node->literal = value;
+
+  if (!program_own(prog, node)) {
+    free(node);
+    return NULL;
+  }
+
+  return node;
+}
+
+static void program_step(ExprProgram* prog, ProgramInstr* in, Row* row, TableSchema* schema,
+                         Database* db, uint8_t schema_idx, uint16_t* pc) {
+  ColumnValue* regs = prog->registers;
+
+  switch (in->op) {
+    case PROG_LOAD_COLUMN:
+      regs[in->dst] = row->values[in->token];
+      if (regs[in->dst].is_toast) {
+        check_and_concat_toast(db, &regs[in->dst]);
+      }
+      break;
+
+    case PROG_NEGATE:
+      regs[in->dst] = evaluate_unary_op(regs[in->a], in->token);
+      break;
+
+    case PROG_ARITHMETIC:
+      regs[in->dst] = evaluate_binary_op(regs[in->a], regs[in->b], in->token, in->type);
+      break;
+
+    case PROG_COMPARE:
+      regs[in->dst] = compare_column_values(regs[in->a], regs[in->b], in->token, in->defn);
+      break;
+
+    case PROG_IS_NULL:
+      regs[in->dst] = create_bool_column_value(regs[in->a].is_null, false);
+      break;
+
+    case PROG_NOT:
+      regs[in->dst] = create_bool_column_value(!regs[in->a].bool_value, regs[in->a].is_null);
+      break;
+
+    case PROG_AND_SHORT:
+      if (!regs[in->a].bool_value && !regs[in->a].is_null) {
+        regs[in->dst] = create_bool_column_value(false, false);
+        *pc = in->jump;
+      }
+      break;
+
+    case PROG_OR_SHORT:
+      if (regs[in->a].bool_value && !regs[in->a].is_null) {
+        regs[in->dst] = create_bool_column_value(true, false);
+        *pc = in->jump;
+      }
+      break;
+
+    case PROG_AND:
+      regs[in->dst] = create_bool_column_value(regs[in->a].bool_value && regs[in->b].bool_value,
+                                               regs[in->a].is_null || regs[in->b].is_null);
+      break;
+
+    case PROG_OR:
+      regs[in->dst] = create_bool_column_value(regs[in->a].bool_value || regs[in->b].bool_value,
+                                               regs[in->a].is_null || regs[in->b].is_null);
+      break;
+
+    case PROG_IN_SET: {
+      ColumnValue* value = &regs[in->a];
+      bool found = !value->is_null && tuple_set_find(in->set, value) != -1;
+      regs[in->dst] = create_bool_column_value(found, value->is_null);
+      break;
+    }
+
+    case PROG_CALL:
+      regs[in->dst] = in->fn(in->args, in->arg_count, row, schema, db, schema_idx);
+      break;
+
+    case PROG_EVAL:
+      regs[in->dst] = evaluate_expression(in->node, row, schema, db, schema_idx);
+      break;
+  }
+}
+
+static uint16_t program_emit(ProgramCompiler* c, ProgramInstr instr, bool constant_inputs) {
+  ExprProgram* prog = c->prog;
+
+  if (constant_inputs) {
+    // every input is known, run it now and keep only the value
+    Row empty_row = {0};
+    uint16_t pc = 0;
+    program_step(prog, &instr, &empty_row, c->schema, c->db, 0, &pc);
+    prog->constant[instr.dst] = true;
+    return instr.dst;
+  }
+
+  if (prog->length == prog->capacity) {
+    uint16_t capacity = prog->capacity ? prog->capacity * 2 : 16;
+    ProgramInstr* code = realloc(prog->code, sizeof(ProgramInstr) * capacity);
+    if (!code) return PROGRAM_NO_REGISTER;
+
+    prog->code = code;
+    prog->capacity = capacity;
+  }
+
+  prog->code[prog->length++] = instr;
+  return instr.dst;
+}
+
+static uint16_t find_subexpr(ProgramCompiler* c, ExprNode* node) {
+  for (uint16_t i = 0; i < c->subexpr_count; i++) {
+    if (expr_nodes_equal(c->subexprs[i].node, node)) return c->subexprs[i].reg;
+  }
+  return PROGRAM_NO_REGISTER;
+}
+
+static uint16_t remember_subexpr(ProgramCompiler* c, ExprNode* node, uint16_t reg) {
+  if (reg == PROGRAM_NO_REGISTER) return reg;
+
+  if (c->subexpr_count == c->subexpr_capacity) {
+    uint16_t capacity = c->subexpr_capacity ? c->subexpr_capacity * 2 : 16;
+    ProgramSubexpr* subexprs = realloc(c->subexprs, sizeof(ProgramSubexpr) * capacity);
+    if (!subexprs) return reg;
+
+    c->subexprs = subexprs;
+    c->subexpr_capacity = capacity;
+  }
+
+  c->subexprs[c->subexpr_count++] = (ProgramSubexpr){ node, reg };
+  return reg;
+}
+
+static uint16_t compile_node(ProgramCompiler* c, ExprNode* node);
+
+static uint16_t compile_eval(ProgramCompiler* c, ExprNode* node) {
+  uint16_t dst = program_register(c->prog);
+  if (dst == PROGRAM_NO_REGISTER) return dst;
+
+  return program_emit(c, (ProgramInstr){ .op = PROG_EVAL, .dst = dst, .node = node }, false);
+}
+
+static uint16_t compile_comparison(ProgramCompiler* c, ExprNode* node) {
+  ExprNode* left = node->binary.left;
+  ExprNode* right = node->binary.right;
+  ExprProgram* prog = c->prog;
+
+  if (node->binary.op == TOK_EQ && left->type == EXPR_COLUMN &&
+      right->type == EXPR_LITERAL && right->literal.is_null) {
+    uint16_t a = compile_node(c, left);
+    uint16_t dst = program_register(prog);
+    if (a == PROGRAM_NO_REGISTER || dst == PROGRAM_NO_REGISTER) return PROGRAM_NO_REGISTER;
+
+    return program_emit(c, (ProgramInstr){ .op = PROG_IS_NULL, .dst = dst, .a = a }, prog->constant[a]);
+  }
+
+  // the cast target comes from the column operand, as in evaluate_comparison_expression
+  ExprNode* column = right->type == EXPR_COLUMN ? right : (left->type == EXPR_COLUMN ? left : NULL);
+  if (!column || column->column.index >= c->schema->column_count) return compile_eval(c, node);
+
+  ColumnDefinition* defn = &c->schema->columns[column->column.index];
+
+  uint16_t a = compile_node(c, left);
+  uint16_t b = a == PROGRAM_NO_REGISTER ? a : compile_node(c, right);
+  if (b == PROGRAM_NO_REGISTER) return PROGRAM_NO_REGISTER;
+
+  uint16_t operands[2] = { a, b };
+  for (int i = 0; i < 2; i++) {
+    if (!prog->constant[operands[i]]) continue;
+
+    ColumnValue cast = prog->registers[operands[i]];
+    if (infer_and_cast_value(&cast, defn)) {
+      operands[i] = program_constant(prog, cast);
+      if (operands[i] == PROGRAM_NO_REGISTER) return PROGRAM_NO_REGISTER;
+    }
+  }
+
+  uint16_t dst = program_register(prog);
+  if (dst == PROGRAM_NO_REGISTER) return dst;
+
+  return program_emit(c, (ProgramInstr){
+    .op = PROG_COMPARE, .dst = dst, .a = operands[0], .b = operands[1],
+    .token = node->binary.op, .defn = defn
+  }, prog->constant[operands[0]] && prog->constant[operands[1]]);
+}
+
+static uint16_t compile_logical(ProgramCompiler* c, ExprNode* node) {
+  ExprProgram* prog = c->prog;
+  bool is_and = node->type == EXPR_LOGICAL_AND;
+
+  uint16_t a = compile_node(c, node->binary.left);
+  if (a == PROGRAM_NO_REGISTER) return a;
+
+  if (prog->constant[a] && !prog->registers[a].is_null &&
+      prog->registers[a].bool_value != is_and) {
+    return program_constant(prog, create_bool_column_value(!is_and, false));
+  }
+
+  uint16_t dst = program_register(prog);
+  if (dst == PROGRAM_NO_REGISTER) return dst;
+
+  uint16_t short_pc = PROGRAM_NO_REGISTER;
+  if (!prog->constant[a]) {
+    short_pc = prog->length;
+    ProgramInstr shortcut = { .op = is_and ? PROG_AND_SHORT : PROG_OR_SHORT, .dst = dst, .a = a };
+    if (program_emit(c, shortcut, false) == PROGRAM_NO_REGISTER) return PROGRAM_NO_REGISTER;
+  }
+
+  // subexpressions first seen on the right may be skipped, so they do not outlive it
+  uint16_t subexpr_mark = c->subexpr_count;
+  uint16_t b = compile_node(c, node->binary.right);
+  c->subexpr_count = subexpr_mark;
+  if (b == PROGRAM_NO_REGISTER) return b;
+
+  ProgramInstr combine = { .op = is_and ? PROG_AND : PROG_OR, .dst = dst, .a = a, .b = b };
+  if (program_emit(c, combine, prog->constant[a] && prog->constant[b]) == PROGRAM_NO_REGISTER) {
+    return PROGRAM_NO_REGISTER;
+  }
+
+  if (short_pc != PROGRAM_NO_REGISTER) {
+    prog->code[short_pc].jump = prog->length;
+  }
+
+  return dst;
+}
+
+static uint16_t compile_function(ProgramCompiler* c, ExprNode* node) {
+  ExprProgram* prog = c->prog;
+
+  BuiltinFunction fn = node->fn.type == NOT_AGG ? find_function(node->fn.name) : NULL;
+  if (!fn) return compile_eval(c, node);
+
+  ExprNode** args = calloc(node->fn.arg_count ? node->fn.arg_count : 1, sizeof(ExprNode*));
+  if (!args || !program_own(prog, args)) {
+    free(args);
+    return PROGRAM_NO_REGISTER;
+  }
+
+  bool constant_args = true;
+  for (uint8_t i = 0; i < node->fn.arg_count; i++) {
+    uint16_t code_mark = prog->length;
+    uint16_t subexpr_mark = c->subexpr_count;
+    uint16_t reg = compile_node(c, node->fn.args[i]);
+
+    // builtins read their arguments as trees, so only folded constants are handed over
+    if (reg != PROGRAM_NO_REGISTER && prog->constant[reg]) {
+      args[i] = program_literal_node(prog, prog->registers[reg]);
+      if (!args[i]) return PROGRAM_NO_REGISTER;
+      continue;
+    }
+
+    prog->length = code_mark;
+    c->subexpr_count = subexpr_mark;
+    args[i] = node->fn.args[i];
+    constant_args = false;
+  }
+
+  uint16_t dst = program_register(prog);
+  if (dst == PROGRAM_NO_REGISTER) return dst;
+
+  return program_emit(c, (ProgramInstr){
+    .op = PROG_CALL, .dst = dst, .fn = fn, .args = args, .arg_count = node->fn.arg_count
+  }, constant_args && !function_is_volatile(node->fn.name));
+}
+
+static void free_in_set(TupleSet* set) {
+  tuple_set_free(set);
+  free(set);
+}
+
+static bool program_own_set(ExprProgram* prog, TupleSet* set) {
+  TupleSet** sets = realloc(prog->sets, sizeof(TupleSet*) * (prog->set_count + 1));
+  if (!sets) return false;
+
+  prog->sets = sets;
+  prog->sets[prog->set_count++] = set;
+  return true;
+}
+
+// list items are cast to the column's type once, so each row is a single probe
+static uint16_t compile_in(ProgramCompiler* c, ExprNode* node) {
+  ExprProgram* prog = c->prog;
+  ExprNode* value = node->in.value;
+
+  if (value->type != EXPR_COLUMN || value->column.array_idx || value->column.index >= c->schema->column_count) {
+    return compile_eval(c, node);
+  }
+
+  ColumnDefinition* defn = &c->schema->columns[value->column.index];
+  uint8_t type = defn->type;
+
+  TupleSet* set = malloc(sizeof(TupleSet));
+  if (!set || !tuple_set_init(set, 1, &type, (uint32_t)node->in.count)) {
+    free(set);
+    return PROGRAM_NO_REGISTER;
+  }
+
+  if (!program_own_set(prog, set)) {
+    free_in_set(set);
+    return PROGRAM_NO_REGISTER;
+  }
+
+  for (size_t i = 0; i < node->in.count; i++) {
+    uint16_t code_mark = prog->length;
+    uint16_t subexpr_mark = c->subexpr_count;
+    uint16_t reg = compile_node(c, node->in.list[i]);
+
+    ColumnValue item = reg == PROGRAM_NO_REGISTER ? (ColumnValue){0} : prog->registers[reg];
+    bool is_constant = reg != PROGRAM_NO_REGISTER && prog->constant[reg];
+
+    // a NULL item never equals anything
+    if (is_constant && item.is_null) continue;
+
+    // items that vary per row, or that do not hash as the column's type, keep the list form
+    if (!is_constant || !infer_and_cast_value(&item, defn) || tuple_set_insert(set, &item, NULL) < 0) {
+      prog->length = code_mark;
+      c->subexpr_count = subexpr_mark;
+      return compile_eval(c, node);
+    }
+  }
+
+  uint16_t a = compile_node(c, value);
+  uint16_t dst = a == PROGRAM_NO_REGISTER ? a : program_register(prog);
+  if (dst == PROGRAM_NO_REGISTER) return dst;
+
+  return program_emit(c, (ProgramInstr){ .op = PROG_IN_SET, .dst = dst, .a = a, .set = set }, false);
+}
+
+static uint16_t compile_node(ProgramCompiler* c, ExprNode* node) {
+  if (!node) return PROGRAM_NO_REGISTER;
+
+  ExprProgram* prog = c->prog;
+
+  if (node->type == EXPR_LITERAL) {
+    return program_constant(prog, evaluate_literal_expression(node, c->db));
+  }
+
+  uint16_t reg = find_subexpr(c, node);
+  if (reg != PROGRAM_NO_REGISTER) return reg;
+
+  switch (node->type) {
+    case EXPR_COLUMN: {
+      if (node->column.index >= c->schema->column_count) return compile_eval(c, node);
+
+      uint16_t dst = program_register(prog);
+      if (dst == PROGRAM_NO_REGISTER) return dst;
+
+      reg = program_emit(c, (ProgramInstr){ .op = PROG_LOAD_COLUMN, .dst = dst, .token = node->column.index }, false);
+      break;
+    }
+
+    case EXPR_UNARY_OP: {
+      uint16_t a = compile_node(c, node->arth_unary.expr);
+      uint16_t dst = program_register(prog);
+      if (a == PROGRAM_NO_REGISTER || dst == PROGRAM_NO_REGISTER) return PROGRAM_NO_REGISTER;
+
+      reg = program_emit(c, (ProgramInstr){
+        .op = PROG_NEGATE, .dst = dst, .a = a, .token = node->arth_unary.op
+      }, prog->constant[a]);
+      break;
+    }
+
+    case EXPR_BINARY_OP: {
+      uint16_t a = compile_node(c, node->binary.left);
+      uint16_t b = a == PROGRAM_NO_REGISTER ? a : compile_node(c, node->binary.right);
+      uint16_t dst = b == PROGRAM_NO_REGISTER ? b : program_register(prog);
+      if (dst == PROGRAM_NO_REGISTER) return PROGRAM_NO_REGISTER;
+
+      // a column operand fixes the arithmetic domain, otherwise the values decide
+      ExprNode* column = node->binary.right->type == EXPR_COLUMN ? node->binary.right :
+                         (node->binary.left->type == EXPR_COLUMN ? node->binary.left : NULL);
+      int16_t type = -1;
+      if (column && column->column.index < c->schema->column_count) {
+        type = c->schema->columns[column->column.index].type;
+      }
+
+      reg = program_emit(c, (ProgramInstr){
+        .op = PROG_ARITHMETIC, .dst = dst, .a = a, .b = b, .token = node->binary.op, .type = type
+      }, prog->constant[a] && prog->constant[b]);
+      break;
+    }
+
+    case EXPR_COMPARISON:
+      reg = compile_comparison(c, node);
+      break;
+
+    case EXPR_LOGICAL_NOT: {
+      uint16_t a = compile_node(c, node->unary);
+      uint16_t dst = program_register(prog);
+      if (a == PROGRAM_NO_REGISTER || dst == PROGRAM_NO_REGISTER) return PROGRAM_NO_REGISTER;
+
+      reg = program_emit(c, (ProgramInstr){ .op = PROG_NOT, .dst = dst, .a = a }, prog->constant[a]);
+      break;
+    }
+
+    case EXPR_LOGICAL_AND:
+    case EXPR_LOGICAL_OR:
+      reg = compile_logical(c, node);
+      break;
+
+    case EXPR_FUNCTION:
+      reg = compile_function(c, node);
+      break;
+
+    case EXPR_IN:
+      reg = compile_in(c, node);
+      break;
+
+    default:
+      return compile_eval(c, node);
+  }
+
+  return remember_subexpr(c, node, reg);
+}
+
+ExprProgram* expr_program_compile(ExprNode** roots, uint8_t count, TableSchema* schema, Database* db) {
+  if (!roots || count == 0 || !schema) return NULL;
+
+  ExprProgram* prog = calloc(1, sizeof(ExprProgram));
+  if (!prog) return NULL;
+
+  prog->outputs = malloc(sizeof(uint16_t) * count);
+  prog->output_count = count;
+  if (!prog->outputs) {
+    expr_program_free(prog);
+    return NULL;
+  }
+
+  ProgramCompiler c = { .prog = prog, .schema = schema, .db = db };
+
+  for (uint8_t i = 0; i < count; i++) {
+    if (!roots[i]) {
+      prog->outputs[i] = PROGRAM_NO_REGISTER;
+      continue;
+    }
+
+    prog->outputs[i] = compile_node(&c, roots[i]);
+    if (prog->outputs[i] == PROGRAM_NO_REGISTER) {
+      free(c.subexprs);
+      expr_program_free(prog);
+      return NULL;
+    }
+  }
+
+  free(c.subexprs);
+  return prog;
+}
+
+void expr_program_free(ExprProgram* prog) {
+  if (!prog) return;
+
+  for (uint16_t i = 0; i < prog->set_count; i++) {
+    free_in_set(prog->sets[i]);
+  }
+  free(prog->sets);
+
+  for (uint16_t i = 0; i < prog->owned_count; i++) {
+    free(prog->owned[i]);
+  }
+
+  free(prog->owned);
+  free(prog->code);
+  free(prog->registers);
+  free(prog->constant);
+  free(prog->outputs);
+  free(prog);
+}
+
+void expr_program_run(ExprProgram* prog, Row* row, TableSchema* schema, Database* db, uint8_t schema_idx) {
+  uint16_t pc = 0;
+
+  while (pc < prog->length) {
+    ProgramInstr* in = &prog->code[pc++];
+    program_step(prog, in, row, schema, db, schema_idx, &pc);
+  }
+}
+
+ColumnValue expr_program_result(ExprProgram* prog, uint8_t idx) {
+  if (idx >= prog->output_count || prog->outputs[idx] == PROGRAM_NO_REGISTER) {
+    ColumnValue empty;
+    memset(&empty, 0, sizeof(ColumnValue));
+    return empty;
+  }
+
+  return prog->registers[prog->outputs[idx]];
+}
+
+bool expr_program_condition(ExprProgram* prog, Row* row, TableSchema* schema, Database* db, uint8_t schema_idx) {
+  expr_program_run(prog, row, schema, db, schema_idx);
+
+  ColumnValue result = expr_program_result(prog, 0);
+  return result.bool_value && !result.is_null;
+}
@@ -0,0 +1,459 @@
+#include "kernel/kernel.h"
+
+#include <strings.h>
+
+/*
+  Result cache for repeated reads. A statement's key is its token stream,
+  keywords by type and everything else by value, so spacing and keyword
+  case do not split entries; prepared statements append the values bound
+  to their parameters. Entries hold deep copies of the rows and every hit
+  hands out another copy, so neither side depends on the other's lifetime
+  or on the pages the rows came from.
+
+  Statements that may answer differently without a write in between are
+  never cached: RAND() and NOW() calls and TABLESAMPLE without REPEATABLE.
+*/
+
+static const char* uncacheable_functions[] = { "RAND", "NOW" };
+
+typedef struct KeyBuffer {
+  char* data;
+  size_t length;
+  size_t capacity;
+  bool failed;
+} KeyBuffer;
+
+static void key_append(KeyBuffer* key, const char* fmt, ...) {
+  if (key->failed) return;
+
+  va_list args;
+  va_start(args, fmt);
+  int needed = vsnprintf(NULL, 0, fmt, args);
+  va_end(args);
+
+  if (needed < 0 || key->length + needed + 1 > key->capacity) {
+    size_t capacity = key->capacity ? key->capacity : 128;
+    while (needed >= 0 && key->length + needed + 1 > capacity) capacity *= 2;
+
+    char* grown = needed < 0 ? NULL : realloc(key->data, capacity);
+    if (!grown) {
+      key->failed = true;
+      return;
+    }
+    key->data = grown;
+    key->capacity = capacity;
+  }
+
+  va_start(args, fmt);
+  vsnprintf(key->data + key->length, key->capacity - key->length, fmt, args);
+  va_end(args);
+  key->length += needed;
+}
+
+static char* key_finish(KeyBuffer* key) {
+  if (!key->failed && key->data) return key->data;
+
+  free(key->data);
+  return NULL;
+}
+
+static bool token_keeps_value(TokenType type) {
+  switch (type) {
+    case TOK_ID:
+    case TOK_PARAM:
+    case TOK_L_UINT:
+    case TOK_L_INT:
+    case TOK_L_FLOAT:
+    case TOK_L_DOUBLE:
+    case TOK_L_CHAR:
+    case TOK_L_STRING:
+    case TOK_L_BOOL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool function_is_uncacheable(const char* name) {
+  for (size_t i = 0; i < sizeof(uncacheable_functions) / sizeof(uncacheable_functions[0]); i++) {
+    if (strcasecmp(uncacheable_functions[i], name) == 0) return true;
+  }
+  return false;
+}
+
+// NULL for statements the cache must not answer, the text need not be terminated past length
+char* statement_fingerprint(const char* text, size_t length) {
+  char* statement = text ? strndup(text, length) : NULL;
+  if (!statement) return NULL;
+
+  Lexer* lexer = lexer_init();
+  lexer_set_buffer(lexer, statement);
+  free(statement);
+
+  KeyBuffer key = {0};
+  bool sampled = false;
+  bool repeatable = false;
+  bool uncacheable = false;
+  bool first = true;
+  bool skipping = false;
+
+  Token* token;
+  while ((token = lexer_next_token(lexer))->type != TOK_EOF && token->type != TOK_SC) {
+    TokenType type = token->type;
+
+    // PREPARE name AS <statement> is keyed on the statement alone
+    if (first && type == TOK_PREPARE) skipping = true;
+    first = false;
+
+    if (skipping) {
+      if (type == TOK_AS) skipping = false;
+    } else {
+      if (type == TOK_TABLESAMPLE) sampled = true;
+      if (type == TOK_REPEATABLE) repeatable = true;
+      if (type == TOK_ID && function_is_uncacheable(token->value)) uncacheable = true;
+
+      if (token_keeps_value(type)) key_append(&key, "%d.%zu:%s ", type, strlen(token->value), token->value);
+      else key_append(&key, "%d ", type);
+    }
+
+    token_free(token);
+  }
+  token_free(token);
+  lexer_free(lexer);
+
+  if (uncacheable || (sampled && !repeatable)) {
+    free(key.data);
+    return NULL;
+  }
+
+  return key_finish(&key);
+}
+
+char* result_cache_key(const char* fingerprint, ColumnValue* params, uint16_t param_count) {
+  KeyBuffer key = {0};
+  key_append(&key, "%s", fingerprint);
+
+  for (uint16_t i = 0; i < param_count; i++) {
+    ColumnValue* value = &params[i];
+    key_append(&key, "$%u=", i + 1);
+
+    if (value->is_null) {
+      key_append(&key, "NULL ");
+      continue;
+    }
+
+    if (value_has_string(value)) {
+      key_append(&key, "%d.%zu:%s ", value->type, strlen(value->str_value), value->str_value);
+      continue;
+    }
+
+    // anything else by the bytes it is stored in
+    key_append(&key, "%d:", value->type);
+    unsigned char* bytes = (unsigned char*)&value->int_value;
+    size_t size = sizeof(ColumnValue) - offsetof(ColumnValue, int_value);
+    for (size_t b = 0; b < size; b++) {
+      key_append(&key, "%02x", bytes[b]);
+    }
+    key_append(&key, " ");
+  }
+
+  return key_finish(&key);
+}
+
+static void release_value(ColumnValue* value) {
+  if (value->is_array && value->array.array_value) {
+    for (uint16_t i = 0; i < value->array.array_size; i++) {
+      release_value(&value->array.array_value[i]);
+    }
+    free(value->array.array_value);
+  } else if (value_has_string(value)) {
+    free(value->str_value);
+  }
+}
+
+static bool copy_value(ColumnValue* dst, ColumnValue* src, size_t* bytes) {
+  *dst = *src;
+
+  if (src->is_array && src->array.array_value) {
+    dst->array.array_value = calloc(src->array.array_size, sizeof(ColumnValue));
+    if (!dst->array.array_value) return false;
+    *bytes += src->array.array_size * sizeof(ColumnValue);
+
+    for (uint16_t i = 0; i < src->array.array_size; i++) {
+      if (!copy_value(&dst->array.array_value[i], &src->array.array_value[i], bytes)) {
+        dst->array.array_size = i;
+        return false;
+      }
+    }
+  } else if (value_has_string(src)) {
+    dst->str_value = strdup(src->str_value);
+    if (!dst->str_value) return false;
+    *bytes += strlen(src->str_value) + 1;
+  }
+
+  return true;
+}
+
+static void release_rows(Row* rows, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    for (size_t v = 0; v < rows[i].n_values; v++) {
+      release_value(&rows[i].values[v]);
+    }
+    free(rows[i].values);
+  }
+  free(rows);
+}
+
+static void release_aliases(char** aliases, size_t count) {
+  if (!aliases) return;
+
+  for (size_t i = 0; i < count; i++) {
+    free(aliases[i]);
+  }
+  free(aliases);
+}
+
+// deep copies, a row whose values fail to copy keeps what it got so the whole set can be released
+static bool copy_rows(Row* src, uint32_t count, Row** out, size_t* bytes) {
+  Row* rows = calloc(count ? count : 1, sizeof(Row));
+  if (!rows) return false;
+  *bytes += count * sizeof(Row);
+
+  for (uint32_t i = 0; i < count; i++) {
+    rows[i].id = src[i].id;
+    rows[i].values = calloc(src[i].n_values ? src[i].n_values : 1, sizeof(ColumnValue));
+    if (!rows[i].values) {
+      release_rows(rows, i);
+      return false;
+    }
+    *bytes += src[i].n_values * sizeof(ColumnValue);
+
+    for (size_t v = 0; v < src[i].n_values; v++) {
+      if (!copy_value(&rows[i].values[v], &src[i].values[v], bytes)) {
+        rows[i].n_values = v + 1;
+        release_rows(rows, i + 1);
+        return false;
+      }
+    }
+    rows[i].n_values = src[i].n_values;
+  }
+
+  *out = rows;
+  return true;
+}
+
+static bool copy_aliases(char** src, size_t count, char*** out, size_t* bytes) {
+  if (!src) {
+    *out = NULL;
+    return true;
+  }
+
+  char** aliases = calloc(count ? count : 1, sizeof(char*));
+  if (!aliases) return false;
+  *bytes += count * sizeof(char*);
+
+  for (size_t i = 0; i < count; i++) {
+    if (!src[i]) continue;
+
+    aliases[i] = strdup(src[i]);
+    if (!aliases[i]) {
+      release_aliases(aliases, i);
+      return false;
+    }
+    *bytes += strlen(src[i]) + 1;
+  }
+
+  *out = aliases;
+  return true;
+}
+
+static ResultCache* result_cache_of(Database* db) {
+  if (!db->results) db->results = calloc(1, sizeof(ResultCache));
+  return db->results;
+}
+
+static void unlink_entry(ResultCache* cache, CachedResult* entry) {
+  CachedResult** link = &cache->buckets[entry->hash % RESULT_CACHE_BUCKETS];
+  while (*link != entry) link = &(*link)->chain;
+  *link = entry->chain;
+
+  if (entry->newer) entry->newer->older = entry->older;
+  else cache->newest = entry->older;
+  if (entry->older) entry->older->newer = entry->newer;
+  else cache->oldest = entry->newer;
+
+  for (uint8_t t = 0; t < entry->table_count; t++) {
+    cache->per_table[entry->tables[t]]--;
+  }
+  cache->count--;
+  cache->bytes -= entry->bytes;
+}
+
+static void free_entry(CachedResult* entry) {
+  release_rows(entry->rows, entry->row_count);
+  release_aliases(entry->aliases, entry->alias_limit);
+  free(entry->key);
+  free(entry);
+}
+
+static void push_newest(ResultCache* cache, CachedResult* entry) {
+  entry->older = cache->newest;
+  entry->newer = NULL;
+  if (cache->newest) cache->newest->newer = entry;
+  else cache->oldest = entry;
+  cache->newest = entry;
+}
+
+static uint64_t key_hash(char* key) {
+  ColumnValue value = { .type = TOK_T_TEXT, .str_value = key };
+  uint64_t hash = 0;
+  hash_column_value(&value, TOK_T_TEXT, &hash);
+  return hash;
+}
+
+static bool result_cache_lookup(ResultCache* cache, char* key, ExecutionResult* out) {
+  uint64_t hash = key_hash(key);
+
+  CachedResult* entry = cache->buckets[hash % RESULT_CACHE_BUCKETS];
+  while (entry && (entry->hash != hash || strcmp(entry->key, key) != 0)) entry = entry->chain;
+
+  if (!entry) {
+    cache->misses++;
+    return false;
+  }
+
+  size_t bytes = 0;
+  Row* rows = NULL;
+  char** aliases = NULL;
+  if (!copy_rows(entry->rows, entry->row_count, &rows, &bytes)) return false;
+  if (!copy_aliases(entry->aliases, entry->alias_limit, &aliases, &bytes)) {
+    release_rows(rows, entry->row_count);
+    return false;
+  }
+
+  // most recently used moves to the front
+  if (entry != cache->newest) {
+    if (entry->newer) entry->newer->older = entry->older;
+    if (entry->older) entry->older->newer = entry->newer;
+    else cache->oldest = entry->newer;
+    push_newest(cache, entry);
+  }
+
+  cache->hits++;
+  *out = (ExecutionResult){
+    .code = 0,
+    .message = entry->message,
+    .rows = rows,
+    .aliases = aliases,
+    .row_count = entry->row_count,
+    .alias_limit = entry->alias_limit,
+    .owns_rows = 1
+  };
+  return true;
+}
+
+static void result_cache_store(Database* db, ResultCache* cache, JQLCommand* cmd, ExecutionResult* result) {
+  CachedResult* entry = calloc(1, sizeof(CachedResult));
+  if (!entry) return;
+
+  entry->key = strdup(cmd->cache_key);
+  entry->bytes = sizeof(CachedResult) + (entry->key ? strlen(entry->key) + 1 : 0);
+
+  if (!entry->key || !copy_rows(result->rows, result->row_count, &entry->rows, &entry->bytes)) {
+    free(entry->key);
+    free(entry);
+    return;
+  }
+  entry->row_count = result->row_count;
+
+  if (!copy_aliases(result->aliases, result->alias_limit, &entry->aliases, &entry->bytes)) {
+    free_entry(entry);
+    return;
+  }
+  entry->alias_limit = result->alias_limit;
+  entry->message = result->message;
+
+  // a result larger than the whole cache would only flush it
+  if (entry->bytes > db->result_cache_memory) {
+    free_entry(entry);
+    return;
+  }
+
+  while (cache->oldest && cache->bytes + entry->bytes > db->result_cache_memory) {
+    CachedResult* victim = cache->oldest;
+    unlink_entry(cache, victim);
+    free_entry(victim);
+    cache->evictions++;
+  }
+
+  entry->tables[entry->table_count++] = hash_fnv1a(cmd->schema->table_name, MAX_TABLES);
+  if (cmd->has_join) entry->tables[entry->table_count++] = hash_fnv1a(cmd->join_table, MAX_TABLES);
+
+  entry->hash = key_hash(entry->key);
+  CachedResult** bucket = &cache->buckets[entry->hash % RESULT_CACHE_BUCKETS];
+  entry->chain = *bucket;
+  *bucket = entry;
+  push_newest(cache, entry);
+
+  for (uint8_t t = 0; t < entry->table_count; t++) {
+    cache->per_table[entry->tables[t]]++;
+  }
+  cache->count++;
+  cache->bytes += entry->bytes;
+}
+
+ExecutionResult execute_select_cached(Database* db, JQLCommand* cmd) {
+  if (!db || !cmd || !cmd->schema) return execute_select(db, cmd);
+
+  if (!db->result_cache_memory) {
+    result_cache_free(db);
+    return execute_select(db, cmd);
+  }
+
+  ResultCache* cache = cmd->cache_key ? result_cache_of(db) : NULL;
+  if (!cache) return execute_select(db, cmd);
+
+  ExecutionResult result;
+  if (result_cache_lookup(cache, cmd->cache_key, &result)) return result;
+
+  result = execute_select(db, cmd);
+  if (result.code == 0) result_cache_store(db, cache, cmd, &result);
+
+  return result;
+}
+
+void result_cache_invalidate(Database* db, uint8_t schema_idx) {
+  ResultCache* cache = db->results;
+  if (!cache || !cache->per_table[schema_idx]) return;
+
+  CachedResult* entry = cache->newest;
+  while (entry) {
+    CachedResult* older = entry->older;
+
+    for (uint8_t t = 0; t < entry->table_count; t++) {
+      if (entry->tables[t] != schema_idx) continue;
+
+      unlink_entry(cache, entry);
+      free_entry(entry);
+      cache->invalidations++;
+      break;
+    }
+
+    entry = older;
+  }
+}
+
+void result_cache_free(Database* db) {
+  ResultCache* cache = db->results;
+  if (!cache) return;
+
+  CachedResult* entry = cache->newest;
+  while (entry) {
+    CachedResult* older = entry->older;
+    free_entry(entry);
+    entry = older;
+  }
+
+  free(cache);
+  db->results = NULL;
+}
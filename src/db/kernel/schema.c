@@ -21,32 +21,12 @@ int64_t find_table(Database* db, char* name) {
     return -1;
   }
 
-  if (!db->core) db->core = db;
-
-  ParserState state = parser_save_state(db->core->parser);
-
-  char query[2048];
-  snprintf(query, sizeof(query),
-    "SELECT id FROM jb_tables "
-    "WHERE name = '%s';",
-    name
-  );
-
-  // LOG_DEBUG("> %s", query);
-
-  Result res = process_silent(db->core, query);
-  bool success = res.exec.code == 0 && res.exec.row_count > 0;
-
-  if (!success) {
+  int64_t table_id = catalog_table_id(db, name);
+  if (table_id == -1) {
     LOG_ERROR("Failed to find table '%s'", name);
-    return -1;
   }
 
-  int64_t value = res.exec.rows[0].values[0].int_value;
-  parser_restore_state(db->core->parser, state);
-  free_result(&res);
-
-  return value;
+  return table_id;
 }
 
 int64_t insert_table(Database* db, char* name) {
@@ -80,6 +60,7 @@ int64_t insert_table(Database* db, char* name) {
   parser_restore_state(db->core->parser, state);
   free_result(&res);
 
+  catalog_add_table(db, value, name);
   return value;
 }
 
@@ -126,6 +107,15 @@ int64_t insert_attribute(Database* db, int64_t table_id, const char* column_name
   parser_restore_state(db->core->parser, state);
   free_result(&res);
 
+  Attribute attr = {
+    .data_type = data_type,
+    .ordinal_position = ordinal_position,
+    .is_nullable = is_nullable,
+    .has_default = has_default,
+    .has_constraints = has_constraints,
+  };
+  catalog_add_attribute(db, table_id, column_name, &attr);
+
   return value;
 }
 
@@ -136,43 +126,16 @@ Attribute* load_attribute(Database* db, int64_t table_id, const char* column_nam
     return NULL;
   }
 
-  if (!db->core) db->core = db;
-
-  ParserState state = parser_save_state(db->core->parser);
-
-  char query[512];
-  snprintf(query, sizeof(query),
-    "SELECT data_type, ordinal_position, is_nullable, has_default, has_constraints "
-    "FROM jb_attribute "
-    "WHERE table_id = %ld AND column_name = '%s';",
-    table_id, column_name);
-
-  // LOG_DEBUG("l[attribute]: %s", query);
-
-  Result res = process_silent(db->core, query);
-  if (res.exec.code != 0 || res.exec.row_count == 0) {
-    LOG_ERROR("Failed to load attribute '%s' - %s", column_name, res.exec.message);
-    parser_restore_state(db->core->parser, state);
-    free_result(&res);
-    return NULL;
-  } else if (res.exec.row_count > 1) {
-    LOG_ERROR("Internal: found %u conflicting attributes for '%s' - %s", res.exec.row_count, column_name, res.exec.message);
-    parser_restore_state(db->core->parser, state);
-    free_result(&res);
+  CatalogAttribute* entry = catalog_attribute(db, table_id, column_name);
+  if (!entry) {
+    LOG_ERROR("Failed to load attribute '%s'", column_name);
     return NULL;
   }
 
-  Attribute* attr = calloc(1, sizeof(Attribute));
-  Row result = res.exec.rows[0];
-  attr->data_type = result.values[0].int_value;
-  attr->ordinal_position = result.values[1].int_value;
-  attr->is_nullable = result.values[2].bool_value;
-  attr->has_default = result.values[3].bool_value;
-  attr->has_constraints = result.values[4].bool_value;
-
-  parser_restore_state(db->core->parser, state);
-  free_result(&res);
+  Attribute* attr = malloc(sizeof(Attribute));
+  if (!attr) return NULL;
 
+  *attr = entry->attr;
   return attr;
 }
 
@@ -211,6 +174,7 @@ int64_t insert_attr_default(Database* db, int64_t table_id, const char* column_n
   parser_restore_state(db->core->parser, state);
   free_result(&res);
 
+  catalog_set_default(db, table_id, column_name, default_expr);
   return value;
 }
 
@@ -229,37 +193,15 @@ ExprNode* load_attr_default(Database* db, int64_t table_id, char* column_name) {
     return NULL;
   }
 
-  if (!db->core) db->core = db;
-
-  ParserState state = parser_save_state(db->core->parser);
-
-  char query[512];
-  snprintf(query, sizeof(query),
-    "SELECT default_expr FROM jb_attrdef "
-    "WHERE table_id = %ld AND column_name = \"%s\";",
-    table_id, column_name);
-
-  // LOG_DEBUG("l(default_expr): %s", query);
-
-  Result res = process_silent(db->core, query);
-  if (res.exec.code != 0 || res.exec.row_count == 0) {
+  CatalogAttribute* entry = catalog_attribute(db, table_id, column_name);
+  if (!entry || !entry->default_expr) {
     LOG_ERROR("Failed to load default for column '%s'", column_name);
-    parser_restore_state(db->core->parser, state);
-    free_result(&res);
     return NULL;
   }
 
-  char* default_expr_str = res.exec.rows[0].values[0].str_value;
-  if (!default_expr_str) {
-    LOG_ERROR("Default expression is NULL for column '%s'", column_name);
-    parser_restore_state(db->core->parser, state);
-    free_result(&res);
-    return NULL;
-  } 
-
-  // LOG_DEBUG("Trying to load: %s", default_expr_str);
+  ParserState state = parser_save_state(db->core->parser);
 
-  lexer_set_buffer(db->core->lexer, default_expr_str);
+  lexer_set_buffer(db->core->lexer, entry->default_expr);
   parser_reset(db->core->parser);
 
   ExprNode* expr_node = parser_parse_expression(db->core->parser, db->tc[table_id].schema);
@@ -268,7 +210,6 @@ ExprNode* load_attr_default(Database* db, int64_t table_id, char* column_name) {
   }
 
   parser_restore_state(db->core->parser, state);
-  free_result(&res);
 
   return expr_node;
 }
@@ -408,29 +349,8 @@ TableSchema* get_table_schema_by_id(Database* db, int64_t table_id) {
     return NULL;
   }
 
-  if (!db->core) db->core = db;
+  const char* table_name = catalog_table_name(db, table_id);
+  if (!table_name) return NULL;
 
-  ParserState state = parser_save_state(db->core->parser);
-
-  char query[256];
-  snprintf(query, sizeof(query),
-    "SELECT name FROM jb_tables WHERE id = %ld;",
-    table_id
-  );
-
-  Result res = process_silent(db->core, query);
-  
-  if (res.exec.code != 0 || res.exec.row_count == 0) {
-    parser_restore_state(db->core->parser, state);
-    free_result(&res);
-    return NULL;
-  }
-
-  char* table_name = res.exec.rows[0].values[0].str_value;
-  TableSchema* schema = get_table_schema(db, table_name);
-
-  parser_restore_state(db->core->parser, state);
-  free_result(&res);
-
-  return schema;
-}
\ No newline at end of file
+  return get_table_schema(db, table_name);
+}
@@ -1,59 +1,207 @@
 #include "kernel/kernel.h"
 
-int64_t sequence_next_val(Database* db, char* name) {
-  if (!db || !name) {
-    LOG_ERROR("Invalid parameters to insert_table");
-    return -1;
-  }
+#include <pthread.h>
+#include <stdatomic.h>
+
+/*
+  Sequences hand out values from blocks reserved in memory. Reserving a block
+  moves jb_sequences.current_value to the block's last value, so the catalog
+  only ever holds the high-water mark and a restart resumes past anything that
+  may have been handed out. Inside a block nextval is one atomic increment
+  under a shared lock; running off its end takes the lock exclusively to
+  reserve the next block.
+*/
 
+typedef struct SequenceRange {
+  atomic_llong next;
+  atomic_llong last; // persisted as current_value
+  int64_t increment_by;
+  uint32_t cache_size;
+} SequenceRange;
+
+struct SequenceCache {
+  pthread_rwlock_t lock;
+
+  TupleSet by_name;        // (name) -> ranges
+  SequenceRange** ranges;  // boxed, a range stays put while the set grows
+  uint32_t ranges_capacity;
+};
+
+static SequenceCache* sequences_of(Database* db) {
   if (!db->core) db->core = db;
 
-  ParserState state = parser_save_state(db->core->parser);
+  Database* core = db->core;
+  if (core->sequences) return core->sequences;
 
-  char pquery[2048];
-  snprintf(pquery, sizeof(pquery),
-    "UPDATE jb_sequences SET current_value = current_value + increment_by "
-    "WHERE name = '%s'; ",
-    name
-  );
+  SequenceCache* cache = calloc(1, sizeof(SequenceCache));
+  if (!cache) return NULL;
 
-  Result pres = process_silent(db->core, pquery);
-  bool psuccess = pres.exec.code == 0;
-  if (!psuccess) {
-    LOG_ERROR("Failed to update the sequence '%s'", name);
-    return -1;
+  uint8_t name_type = TOK_T_TEXT;
+  if (!tuple_set_init(&cache->by_name, 1, &name_type, 0)) {
+    free(cache);
+    return NULL;
   }
 
-  free_result(&pres);
+  pthread_rwlock_init(&cache->lock, NULL);
+  core->sequences = cache;
+  return cache;
+}
 
-  char query[2048];
-  snprintf(query, sizeof(query),
-    "SELECT current_value, increment_by FROM jb_sequences "
-    "WHERE name = '%s'; ",
-    name
-  );
+static SequenceRange* find_range(SequenceCache* cache, char* name) {
+  ColumnValue key = { .type = TOK_T_TEXT, .str_value = name };
+  int64_t idx = tuple_set_find(&cache->by_name, &key);
+  return idx == -1 ? NULL : cache->ranges[idx];
+}
+
+static PreparedStatement* sequence_statement(Database* core, const char* name, char* query) {
+  PreparedStatement* stmt = find_prepared_statement(core, name);
+  if (stmt) return stmt;
+
+  ParserState state = parser_save_state(core->parser);
+  stmt = prepare_statement(core, name, query);
+  parser_restore_state(core->parser, state);
+
+  if (!stmt) LOG_ERROR("Failed to prepare sequence statement '%s'", name);
+  return stmt;
+}
+
+static SequenceRange* load_range(Database* core, SequenceCache* cache, char* name) {
+  PreparedStatement* stmt = sequence_statement(core, "jb_sequence_read",
+    "SELECT current_value, increment_by, cache_size FROM jb_sequences WHERE name = $1;");
+  if (!stmt) return NULL;
+
+  ColumnValue param = { .type = TOK_T_TEXT, .str_value = name };
+  Result res = execute_prepared(core, stmt, &param, 1, false);
+
+  if (res.exec.code != 0 || res.exec.row_count == 0) {
+    LOG_ERROR("Failed to find a valid sequence '%s'", name);
+    free_result(&res);
+    return NULL;
+  }
+
+  Row* row = &res.exec.rows[0];
+  int64_t current_value = row->values[0].is_null ? 0 : row->values[0].int_value;
+  int64_t increment_by = row->values[1].is_null ? 1 : row->values[1].int_value;
+  int64_t cache_size = row->values[2].is_null ? 0 : row->values[2].int_value;
+  free_result(&res);
+
+  if (increment_by <= 0) {
+    LOG_ERROR("Sequence '%s' has a non-positive increment, which is not supported", name);
+    return NULL;
+  }
+
+  SequenceRange* range = calloc(1, sizeof(SequenceRange));
+  if (!range) return NULL;
+
+  // nothing is reserved yet, the first nextval runs off the end and reserves a block
+  atomic_init(&range->next, current_value + increment_by);
+  atomic_init(&range->last, current_value);
+  range->increment_by = increment_by;
+  range->cache_size = cache_size > 0 ? (uint32_t)cache_size : DEFAULT_SEQUENCE_CACHE;
+
+  if (cache->by_name.count >= cache->ranges_capacity) {
+    uint32_t capacity = cache->ranges_capacity ? cache->ranges_capacity * 2 : 16;
+    SequenceRange** ranges = realloc(cache->ranges, sizeof(SequenceRange*) * capacity);
+    if (!ranges) {
+      free(range);
+      return NULL;
+    }
+
+    cache->ranges = ranges;
+    cache->ranges_capacity = capacity;
+  }
+
+  ColumnValue key = { .type = TOK_T_TEXT, .str_value = strdup(name) };
+  int64_t idx = key.str_value ? tuple_set_insert(&cache->by_name, &key, NULL) : -1;
+  if (idx < 0) {
+    free(key.str_value);
+    free(range);
+    return NULL;
+  }
+
+  cache->ranges[idx] = range;
+  return range;
+}
 
-  Result res = process_silent(db->core, query);
+// moves the high-water mark far enough to cover value, in whole blocks
+static bool reserve_block(Database* core, char* name, SequenceRange* range, int64_t value) {
+  int64_t block = range->increment_by * range->cache_size;
+  int64_t last = atomic_load(&range->last);
+  while (last < value) last += block;
+
+  PreparedStatement* stmt = sequence_statement(core, "jb_sequence_reserve",
+    "UPDATE jb_sequences SET current_value = $1 WHERE name = $2;");
+  if (!stmt) return false;
+
+  ColumnValue params[] = {
+    { .type = TOK_T_INT, .int_value = last },
+    { .type = TOK_T_TEXT, .str_value = name },
+  };
+
+  Result res = execute_prepared(core, stmt, params, 2, false);
   bool success = res.exec.code == 0;
+  free_result(&res);
+
   if (!success) {
-    LOG_ERROR("Failed to find a valid sequence '%s'", name);
+    LOG_ERROR("Failed to update the sequence '%s'", name);
+    return false;
+  }
+
+  // only published once persisted, so no value outlives a crash unrecorded
+  atomic_store(&range->last, last);
+  return true;
+}
+
+int64_t sequence_next_val(Database* db, char* name) {
+  if (!db || !name) {
+    LOG_ERROR("Invalid parameters to sequence_next_val");
     return -1;
   }
 
-  int table_idx = hash_fnv1a("jb_sequences", MAX_TABLES);
-  int cv_idx = find_column_index(db->core->tc[table_idx].schema, "current_value");
+  SequenceCache* cache = sequences_of(db);
+  if (!cache) return -1;
 
-  int copy = res.exec.rows[0].values[0].int_value;
-  // free_result(&res);
+  int64_t value = 0;
+  bool taken = false;
 
-  parser_restore_state(db->core->parser, state);
+  pthread_rwlock_rdlock(&cache->lock);
+  SequenceRange* range = find_range(cache, name);
+  if (range) {
+    value = atomic_fetch_add(&range->next, range->increment_by);
+    taken = true;
+
+    if (value <= atomic_load(&range->last)) {
+      pthread_rwlock_unlock(&cache->lock);
+      return value;
+    }
+  }
+  pthread_rwlock_unlock(&cache->lock);
+
+  // the block ran out or the sequence was never read, both are settled exclusively
+  pthread_rwlock_wrlock(&cache->lock);
+
+  if (!taken) {
+    range = find_range(cache, name);
+    if (!range) range = load_range(db->core, cache, name);
+
+    if (!range) {
+      pthread_rwlock_unlock(&cache->lock);
+      return -1;
+    }
+    value = atomic_fetch_add(&range->next, range->increment_by);
+  }
 
-  return copy;
+  if (value > atomic_load(&range->last) && !reserve_block(db->core, name, range, value)) {
+    value = -1;
+  }
+
+  pthread_rwlock_unlock(&cache->lock);
+  return value;
 }
 
-int64_t create_default_sequence(Database* db, char* name, bool is_unsafe) {
+int64_t create_default_sequence(Database* db, char* name, uint32_t cache_size, bool is_unsafe) {
   if (!db || !name) {
-    LOG_ERROR("Invalid parameters to insert_table");
+    LOG_ERROR("Invalid parameters to create_default_sequence");
     return -1;
   }
 
@@ -61,15 +209,19 @@ int64_t create_default_sequence(Database* db, char* name, bool is_unsafe) {
 
   ParserState state = parser_save_state(db->core->parser);
 
+  char cache_value[16] = "NULL";
+  if (cache_size > 0) snprintf(cache_value, sizeof(cache_value), "%u", cache_size);
+
   char query[2048];
 
   snprintf(query, sizeof(query),
     "%s jb_sequences "
-    "(name, current_value, increment_by, min_value, max_value, cycle) "
-    "VALUES ('%s', 0, 1, 0, NULL, false) "
+    "(name, current_value, increment_by, min_value, max_value, cycle, cache_size) "
+    "VALUES ('%s', 0, 1, 0, NULL, false, %s) "
     "RETURNING id; ",
     is_unsafe ? "INSERT _unsafecon INTO" : "INSERT INTO",
-    name
+    name,
+    cache_value
   );
 
   Result res = process(db->core, query);
@@ -88,28 +240,43 @@ int64_t create_default_sequence(Database* db, char* name, bool is_unsafe) {
 
 int64_t find_sequence(Database* db, char* name) {
   if (!db || !name) {
-    LOG_ERROR("Invalid parameters to insert_table");
+    LOG_ERROR("Invalid parameters to find_sequence");
     return -1;
   }
 
   if (!db->core) db->core = db;
 
-  ParserState state = parser_save_state(db->core->parser);
-  char query[2048];
+  PreparedStatement* stmt = sequence_statement(db->core, "jb_sequence_find",
+    "SELECT id FROM jb_sequences WHERE name = $1;");
+  if (!stmt) return -1;
 
-  snprintf(query, sizeof(query),
-    "SELECT id FROM jb_sequences "
-    "WHERE name = '%s';",
-    name
-  );
+  ColumnValue param = { .type = TOK_T_TEXT, .str_value = name };
+  Result res = execute_prepared(db->core, stmt, &param, 1, false);
 
-  Result res = process_silent(db->core, query);
-  bool success = res.exec.code == 0;
-  if (!success) {
+  if (res.exec.code != 0 || res.exec.row_count == 0) {
     LOG_ERROR("Failed to find a valid sequence '%s'", name);
+    free_result(&res);
     return -1;
   }
 
-  parser_restore_state(db->core->parser, state);
-  return res.exec.rows[0].values[0].int_value;
-}
\ No newline at end of file
+  int64_t id = res.exec.rows[0].values[0].int_value;
+  free_result(&res);
+  return id;
+}
+
+void sequence_cache_free(Database* db) {
+  if (!db || !db->sequences) return;
+
+  SequenceCache* cache = db->sequences;
+  for (uint32_t i = 0; i < cache->by_name.count; i++) {
+    free(tuple_set_get(&cache->by_name, i)[0].str_value);
+    free(cache->ranges[i]);
+  }
+
+  tuple_set_free(&cache->by_name);
+  free(cache->ranges);
+  pthread_rwlock_destroy(&cache->lock);
+
+  free(cache);
+  db->sequences = NULL;
+}
@@ -0,0 +1,525 @@
+#include "kernel/kernel.h"
+
+/*
+  External merge sort for ORDER BY. Rows are buffered up to the sorter's
+  memory budget, charged for each row's values and the strings they point
+  to; a full buffer is sorted and spilled as a run under the database's tmp
+  directory, and once the input ends the runs are k-way merged through a
+  min-heap of run heads. Inputs that fit the budget never touch disk. A
+  merged row read back from a run is released on the next pull, except for
+  the strings the caller took over with keep_spill_values.
+
+  Rows read back from any spill file own their strings and arrays, and are
+  marked so. Operators that hold on to values of such a row past the next
+  pull copy them with copy_spill_value, and the rows they build from those
+  copies are marked as owning their strings in turn.
+
+  In-memory batches are ordered by normalized keys: each row's ORDER BY
+  columns are encoded once into a byte string whose memcmp order is the
+  row order, and the keys are MSD radix sorted. Column types without an
+  encoding fall back to compare_rows.
+*/
+
+#define SORT_KEY_INSERTION_THRESHOLD 32
+
+typedef struct SortKey {
+  uint8_t* bytes;
+  uint32_t length;
+  uint32_t row;
+} SortKey;
+
+static bool sort_key_type_supported(uint8_t type) {
+  switch (type) {
+    case TOK_T_INT:
+    case TOK_T_UINT:
+    case TOK_T_SERIAL:
+    case TOK_T_FLOAT:
+    case TOK_T_DOUBLE:
+    case TOK_T_BOOL:
+    case TOK_T_VARCHAR:
+    case TOK_T_STRING:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static void encode_u64(uint8_t* out, uint64_t bits) {
+  for (int b = 7; b >= 0; b--) {
+    *out++ = (uint8_t)(bits >> (b * 8));
+  }
+}
+
+// returns the key length, writing the key when `out` is set; 0 means the row has no encoding
+static uint32_t encode_sort_key(Row* row, JQLCommand* cmd, uint8_t* out) {
+  uint32_t length = 0;
+
+  for (uint8_t i = 0; i < cmd->order_by_count; i++) {
+    ColumnValue* value = &row->values[cmd->order_by[i].col];
+    uint32_t start = length;
+
+    if (value->is_array || value->is_toast) return 0;
+    if (!value->is_null && !sort_key_type_supported(value->type)) return 0;
+
+    if (out) out[length] = value->is_null ? 0x00 : 0x01;
+    length++;
+
+    if (!value->is_null) {
+      switch (value->type) {
+        case TOK_T_INT:
+        case TOK_T_UINT:
+        case TOK_T_SERIAL:
+          if (out) encode_u64(out + length, (uint64_t)value->int_value ^ (1ULL << 63));
+          length += 8;
+          break;
+
+        case TOK_T_FLOAT:
+        case TOK_T_DOUBLE: {
+          double d = value->type == TOK_T_FLOAT ? (double)value->float_value : value->double_value;
+          uint64_t bits;
+          memcpy(&bits, &d, sizeof(bits));
+          bits = (bits >> 63) ? ~bits : bits ^ (1ULL << 63);
+
+          if (out) encode_u64(out + length, bits);
+          length += 8;
+          break;
+        }
+
+        case TOK_T_BOOL:
+          if (out) out[length] = value->bool_value ? 1 : 0;
+          length++;
+          break;
+
+        default: {
+          uint32_t str_len = (uint32_t)strlen(value->str_value);
+          if (out) memcpy(out + length, value->str_value, str_len + 1);
+          length += str_len + 1;
+          break;
+        }
+      }
+    }
+
+    if (out && cmd->order_by[i].decend) {
+      for (uint32_t b = start; b < length; b++) {
+        out[b] = ~out[b];
+      }
+    }
+  }
+
+  return length;
+}
+
+static int compare_sort_keys(const SortKey* a, const SortKey* b, uint32_t depth) {
+  uint32_t min = a->length < b->length ? a->length : b->length;
+  if (min > depth) {
+    int cmp = memcmp(a->bytes + depth, b->bytes + depth, min - depth);
+    if (cmp != 0) return cmp;
+  }
+
+  return (a->length > b->length) - (a->length < b->length);
+}
+
+static void sort_keys_msd(SortKey* keys, SortKey* scratch, uint32_t n, uint32_t depth) {
+  if (n < SORT_KEY_INSERTION_THRESHOLD) {
+    for (uint32_t i = 1; i < n; i++) {
+      SortKey key = keys[i];
+      uint32_t j = i;
+      while (j > 0 && compare_sort_keys(&keys[j - 1], &key, depth) > 0) {
+        keys[j] = keys[j - 1];
+        j--;
+      }
+      keys[j] = key;
+    }
+    return;
+  }
+
+  // bucket 0 holds keys that end at this depth; they sort before any byte
+  uint32_t counts[257] = {0};
+  for (uint32_t i = 0; i < n; i++) {
+    counts[keys[i].length > depth ? keys[i].bytes[depth] + 1 : 0]++;
+  }
+
+  uint32_t offsets[257];
+  uint32_t offset = 0;
+  for (int b = 0; b < 257; b++) {
+    offsets[b] = offset;
+    offset += counts[b];
+  }
+
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t bucket = keys[i].length > depth ? keys[i].bytes[depth] + 1 : 0;
+    scratch[offsets[bucket]++] = keys[i];
+  }
+  memcpy(keys, scratch, n * sizeof(SortKey));
+
+  uint32_t start = counts[0];
+  for (int b = 1; b < 257; b++) {
+    if (counts[b] > 1) {
+      sort_keys_msd(keys + start, scratch + start, counts[b], depth + 1);
+    }
+    start += counts[b];
+  }
+}
+
+bool sort_rows_by_key(Row rows[], uint32_t count, JQLCommand* cmd) {
+  if (count < 2) return true;
+
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t length = encode_sort_key(&rows[i], cmd, NULL);
+    if (length == 0) return false;
+    total += length;
+  }
+
+  uint8_t* arena = malloc(total);
+  SortKey* keys = malloc(count * sizeof(SortKey));
+  SortKey* scratch = malloc(count * sizeof(SortKey));
+  Row* sorted = malloc(count * sizeof(Row));
+  if (!arena || !keys || !scratch || !sorted) {
+    free(arena);
+    free(keys);
+    free(scratch);
+    free(sorted);
+    return false;
+  }
+
+  uint8_t* cursor = arena;
+  for (uint32_t i = 0; i < count; i++) {
+    keys[i].bytes = cursor;
+    keys[i].length = encode_sort_key(&rows[i], cmd, cursor);
+    keys[i].row = i;
+    cursor += keys[i].length;
+  }
+
+  sort_keys_msd(keys, scratch, count, 0);
+
+  for (uint32_t i = 0; i < count; i++) {
+    sorted[i] = rows[keys[i].row];
+  }
+  memcpy(rows, sorted, count * sizeof(Row));
+
+  free(arena);
+  free(keys);
+  free(scratch);
+  free(sorted);
+  return true;
+}
+
+void sort_rows(Row rows[], uint32_t count, JQLCommand* cmd, TableSchema* schema) {
+  if (count < 2 || sort_rows_by_key(rows, count, cmd)) return;
+
+  quick_sort_rows(rows, 0, count - 1, cmd, schema);
+}
+
+bool write_spill_row(FILE* file, Row* row, TableSchema* schema) {
+  fwrite(&row->id, sizeof(RowID), 1, file);
+
+  for (uint8_t j = 0; j < schema->column_count; j++) {
+    uint8_t is_null = row->values[j].is_null ? 1 : 0;
+    fwrite(&is_null, sizeof(uint8_t), 1, file);
+
+    if (!is_null) {
+      write_column_value(file, &row->values[j], &schema->columns[j]);
+    }
+  }
+
+  return !ferror(file);
+}
+
+bool read_spill_row(FILE* file, Row* row, TableSchema* schema) {
+  memset(row, 0, sizeof(Row));
+  if (fread(&row->id, sizeof(RowID), 1, file) != 1) return false;
+
+  row->n_values = schema->column_count;
+  row->values = calloc(schema->column_count, sizeof(ColumnValue));
+  if (!row->values) return false;
+  row->owns_strings = true;
+
+  for (uint8_t j = 0; j < schema->column_count; j++) {
+    ColumnDefinition* def = &schema->columns[j];
+    ColumnValue* value = &row->values[j];
+
+    uint8_t is_null = 1;
+    if (fread(&is_null, sizeof(uint8_t), 1, file) != 1) {
+      free(row->values);
+      row->values = NULL;
+      return false;
+    }
+
+    value->column_index = j;
+    value->type = def->type;
+    value->is_null = is_null;
+    if (is_null) continue;
+
+    if (!def->is_array && (def->type == TOK_T_CHAR || def->type == TOK_T_UUID)) {
+      value->str_value = calloc(17, sizeof(char));
+    }
+
+    read_column_value(file, value, def);
+  }
+
+  return true;
+}
+
+// strings and arrays read_spill_row decodes into memory of their own
+bool spill_value_owned(ColumnValue* value) {
+  if (value->is_null || value->is_toast || !value->str_value) return false;
+  if (value->is_array) return true;
+
+  return value_has_string(value) || value->type == TOK_T_UUID || value->type == TOK_T_BLOB;
+}
+
+void free_spill_value(ColumnValue* value) {
+  if (!spill_value_owned(value)) return;
+
+  if (value->is_array) {
+    for (uint16_t i = 0; i < value->array.array_size; i++) {
+      free_spill_value(&value->array.array_value[i]);
+    }
+  }
+
+  // an array's elements share the union slot of the string pointer
+  free(value->str_value);
+  value->str_value = NULL;
+}
+
+// a value borrowed from a row that is about to be released gets memory of its own; on failure it turns NULL
+bool copy_spill_value(ColumnValue* value) {
+  if (!spill_value_owned(value)) return true;
+
+  if (value->is_array) {
+    uint16_t size = value->array.array_size;
+    ColumnValue* elements = malloc((size ? size : 1) * sizeof(ColumnValue));
+
+    for (uint16_t i = 0; elements && i < size; i++) {
+      elements[i] = value->array.array_value[i];
+      if (copy_spill_value(&elements[i])) continue;
+
+      while (i-- > 0) free_spill_value(&elements[i]);
+      free(elements);
+      elements = NULL;
+    }
+
+    value->array.array_value = elements;
+  } else if (value->type == TOK_T_UUID) {
+    char* uuid = malloc(17);
+    if (uuid) memcpy(uuid, value->str_value, 17);
+    value->str_value = uuid;
+  } else {
+    value->str_value = strdup(value->str_value);
+  }
+
+  if (value->str_value) return true;
+
+  value->is_null = true;
+  return false;
+}
+
+void free_spill_row(Row* row) {
+  if (!row->values) return;
+
+  for (uint16_t i = 0; i < row->n_values; i++) {
+    free_spill_value(&row->values[i]);
+  }
+
+  free(row->values);
+  row->values = NULL;
+}
+
+// the strings and arrays of an owning row that `values` point into are left to the caller
+void keep_spill_values(Row* row, ColumnValue* values, uint16_t count) {
+  if (!row->owns_strings || !row->values) return;
+
+  for (uint16_t j = 0; j < count; j++) {
+    if (values[j].is_null || values[j].is_toast) continue;
+
+    for (uint16_t i = 0; i < row->n_values; i++) {
+      ColumnValue* owner = &row->values[i];
+      if (spill_value_owned(owner) && owner->str_value == values[j].str_value) owner->str_value = NULL;
+    }
+  }
+}
+
+// what a buffered row holds on to: its slot, its values and whatever they point to
+static size_t sort_row_bytes(Row* row) {
+  size_t bytes = sizeof(Row) + row->n_values * sizeof(ColumnValue);
+
+  for (uint16_t i = 0; row->values && i < row->n_values; i++) {
+    ColumnValue* value = &row->values[i];
+
+    if (value->is_null || value->is_toast) continue;
+    if (value->is_array) bytes += value->array.array_size * sizeof(ColumnValue);
+    else if (value_has_string(value)) bytes += strlen(value->str_value) + 1;
+  }
+
+  return bytes;
+}
+
+static bool run_less(RowSorter* sorter, uint32_t a, uint32_t b) {
+  return compare_rows(&sorter->runs[a].head, &sorter->runs[b].head, sorter->cmd, sorter->schema) < 0;
+}
+
+static void merge_sift_down(RowSorter* sorter, uint32_t idx) {
+  uint32_t* heap = sorter->heap;
+
+  while (true) {
+    uint32_t smallest = idx;
+    uint32_t left = 2 * idx + 1;
+    uint32_t right = left + 1;
+
+    if (left < sorter->heap_count && run_less(sorter, heap[left], heap[smallest])) smallest = left;
+    if (right < sorter->heap_count && run_less(sorter, heap[right], heap[smallest])) smallest = right;
+    if (smallest == idx) break;
+
+    uint32_t tmp = heap[idx];
+    heap[idx] = heap[smallest];
+    heap[smallest] = tmp;
+    idx = smallest;
+  }
+}
+
+static bool sorter_spill(RowSorter* sorter) {
+  if (sorter->count == 0) return true;
+
+  SortRun* runs = realloc(sorter->runs, (sorter->run_count + 1) * sizeof(SortRun));
+  if (!runs) return false;
+  sorter->runs = runs;
+
+  SortRun* run = &sorter->runs[sorter->run_count];
+  memset(run, 0, sizeof(SortRun));
+  snprintf(run->path, MAX_PATH_LENGTH, "%s" SEP "sort_%p_%u.run",
+    sorter->db->fs->tmp_dir, (void*)sorter, sorter->run_count);
+
+  run->file = fopen(run->path, "w+b");
+  if (!run->file) {
+    LOG_ERROR("Failed to open sort run file: %s", run->path);
+    return false;
+  }
+  sorter->run_count++;
+
+  sort_rows(sorter->rows, sorter->count, sorter->cmd, sorter->schema);
+
+  for (uint32_t i = 0; i < sorter->count; i++) {
+    if (!write_spill_row(run->file, &sorter->rows[i], sorter->schema)) {
+      LOG_ERROR("Failed to write sort run file: %s", run->path);
+      return false;
+    }
+  }
+
+  LOG_DEBUG("Spilled sort run %u with %u rows", sorter->run_count - 1, sorter->count);
+
+  sorter->spilled_rows += sorter->count;
+  sorter->count = 0;
+  sorter->bytes = 0;
+  return true;
+}
+
+void sorter_init(RowSorter* sorter, Database* db, JQLCommand* cmd, TableSchema* schema, size_t memory_budget) {
+  memset(sorter, 0, sizeof(RowSorter));
+  sorter->db = db;
+  sorter->cmd = cmd;
+  sorter->schema = schema;
+
+  sorter->memory_budget = memory_budget;
+}
+
+bool sorter_add(RowSorter* sorter, Row row) {
+  size_t bytes = sorter->memory_budget ? sort_row_bytes(&row) : 0;
+
+  // a run holds at least two rows, however wide they are
+  if (sorter->memory_budget && sorter->count >= 2 && sorter->bytes + bytes > sorter->memory_budget) {
+    if (!sorter_spill(sorter)) return false;
+  }
+
+  if (sorter->count == sorter->capacity) {
+    if (sorter->capacity == UINT32_MAX) return false;
+    uint32_t capacity = sorter->capacity ? (sorter->capacity > UINT32_MAX / 2 ? UINT32_MAX : sorter->capacity * 2) : 64;
+
+    Row* rows = realloc(sorter->rows, (size_t)capacity * sizeof(Row));
+    if (!rows) return false;
+
+    sorter->rows = rows;
+    sorter->capacity = capacity;
+  }
+
+  sorter->rows[sorter->count++] = row;
+  sorter->bytes += bytes;
+  return true;
+}
+
+bool sorter_finish(RowSorter* sorter) {
+  sorter->cursor = 0;
+
+  if (sorter->run_count == 0) {
+    if (sorter->cmd->has_order_by) {
+      sort_rows(sorter->rows, sorter->count, sorter->cmd, sorter->schema);
+    }
+    return true;
+  }
+
+  if (!sorter_spill(sorter)) return false;
+
+  free(sorter->rows);
+  sorter->rows = NULL;
+  sorter->capacity = 0;
+
+  sorter->heap = malloc(sorter->run_count * sizeof(uint32_t));
+  if (!sorter->heap) return false;
+
+  for (uint32_t i = 0; i < sorter->run_count; i++) {
+    SortRun* run = &sorter->runs[i];
+    rewind(run->file);
+
+    run->has_head = read_spill_row(run->file, &run->head, sorter->schema);
+    if (run->has_head) sorter->heap[sorter->heap_count++] = i;
+  }
+
+  for (uint32_t i = sorter->heap_count / 2; i-- > 0;) {
+    merge_sift_down(sorter, i);
+  }
+
+  return true;
+}
+
+bool sorter_next(RowSorter* sorter, Row* out) {
+  if (sorter->run_count == 0) {
+    if (sorter->cursor >= sorter->count) return false;
+
+    *out = sorter->rows[sorter->cursor++];
+    return true;
+  }
+
+  // merged rows are only borrowed until the next pull
+  free_spill_row(&sorter->last);
+
+  if (sorter->heap_count == 0) return false;
+
+  SortRun* run = &sorter->runs[sorter->heap[0]];
+  *out = run->head;
+  sorter->last = run->head;
+
+  run->has_head = read_spill_row(run->file, &run->head, sorter->schema);
+  if (!run->has_head) {
+    sorter->heap[0] = sorter->heap[--sorter->heap_count];
+  }
+
+  merge_sift_down(sorter, 0);
+  return true;
+}
+
+void sorter_free(RowSorter* sorter) {
+  if (!sorter) return;
+
+  for (uint32_t i = 0; i < sorter->run_count; i++) {
+    SortRun* run = &sorter->runs[i];
+    if (run->has_head) free_spill_row(&run->head);
+    if (run->file) fclose(run->file);
+    remove(run->path);
+  }
+
+  free_spill_row(&sorter->last);
+  free(sorter->runs);
+  free(sorter->heap);
+  free(sorter->rows);
+  memset(sorter, 0, sizeof(RowSorter));
+}
@@ -0,0 +1,612 @@
+#include "kernel/kernel.h"
+
+/*
+  Table statistics and the access path chooser. ANALYZE decodes a table once
+  and records for every column its NULL fraction, a distinct count (from a
+  HyperLogLog sketch), bounds and an equi-depth histogram, both in memory and
+  as rows of jb_statistics on the core database. The planner turns them into
+  a selectivity for the WHERE clause and costs a sequential scan against a
+  primary key lookup; plain COUNT(*) queries read the maintained row count.
+*/
+
+static TableStatistics* statistics_create(Database* db, uint8_t schema_idx) {
+  TableStatistics* stats = calloc(1, sizeof(TableStatistics));
+  if (!stats) {
+    LOG_ERROR("Failed to allocate table statistics");
+    return NULL;
+  }
+
+  // the row structs tell live rows apart without decoding anything
+  BufferPool* pool = &db->lake[schema_idx];
+  for (uint16_t p = 0; p < pool->num_pages; p++) {
+    Page* page = pool->pages[p];
+    for (uint16_t r = 0; page && r < page->num_rows; r++) {
+      Row* row = &page->rows[r];
+      if (!is_struct_zeroed(row, sizeof(Row)) && !row->deleted) stats->row_count++;
+    }
+  }
+
+  db->statistics[schema_idx] = stats;
+  return stats;
+}
+
+TableStatistics* table_statistics(Database* db, TableSchema* schema) {
+  if (!db || !schema) return NULL;
+
+  uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+  if (db->statistics[schema_idx]) return db->statistics[schema_idx];
+
+  return statistics_create(db, schema_idx);
+}
+
+static void free_column_statistics(TableStatistics* stats) {
+  for (uint8_t i = 0; stats->columns && i < stats->column_count; i++) {
+    free(stats->columns[i].distinct);
+  }
+
+  free(stats->columns);
+  stats->columns = NULL;
+  stats->column_count = 0;
+}
+
+void statistics_invalidate(Database* db, uint8_t schema_idx) {
+  if (!db || !db->statistics[schema_idx]) return;
+
+  free_column_statistics(db->statistics[schema_idx]);
+  free(db->statistics[schema_idx]);
+  db->statistics[schema_idx] = NULL;
+}
+
+void statistics_free(Database* db) {
+  for (int i = 0; db && i < MAX_TABLES; i++) {
+    statistics_invalidate(db, i);
+  }
+}
+
+static double zone_key_double(ZoneKey key, uint8_t type) {
+  return zone_key_is_float(type) ? key.d : (double)key.i;
+}
+
+static void column_add_value(ColumnStatistics* column, ColumnValue* value, uint8_t type) {
+  if (value->is_null) {
+    column->null_count++;
+    return;
+  }
+
+  uint64_t hash = 0;
+  if (column->distinct && hash_column_value(value, type, &hash)) hll_add(column->distinct, hash);
+
+  if (column->type == PAGE_ZONE_UNBOUNDED) return;
+
+  ZoneKey key;
+  if (!zone_key(value, column->type, &key)) {
+    column->type = PAGE_ZONE_UNBOUNDED;
+    column->has_range = false;
+    return;
+  }
+
+  bool is_float = zone_key_is_float(column->type);
+  if (!column->has_range) {
+    column->min = column->max = key;
+    column->has_range = true;
+  } else if (is_float ? key.d < column->min.d : key.i < column->min.i) {
+    column->min = key;
+  } else if (is_float ? key.d > column->max.d : key.i > column->max.i) {
+    column->max = key;
+  }
+}
+
+void track_statistics(Database* db, TableSchema* schema, ColumnValue* values, int value_count, bool is_insert) {
+  if (!db || !schema || !values) return;
+
+  // a table nobody planned yet is counted from its pages when it first is
+  TableStatistics* stats = db->statistics[hash_fnv1a(schema->table_name, MAX_TABLES)];
+  if (!stats) return;
+
+  if (is_insert) stats->row_count++;
+  else if (stats->row_count > 0) stats->row_count--;
+
+  uint8_t count = value_count < stats->column_count ? value_count : stats->column_count;
+  for (uint8_t i = 0; stats->columns && i < count; i++) {
+    ColumnStatistics* column = &stats->columns[i];
+
+    // removed values cannot be taken out of the sketch or the bounds, which only ever grow
+    if (!is_insert) {
+      if (values[i].is_null && column->null_count > 0) column->null_count--;
+      continue;
+    }
+
+    column_add_value(column, &values[i], schema->columns[i].type);
+  }
+}
+
+static int compare_doubles(const void* a, const void* b) {
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+static void build_histogram(ColumnStatistics* column, double* values, uint64_t count) {
+  column->bucket_count = 0;
+  if (count == 0) return;
+
+  qsort(values, count, sizeof(double), compare_doubles);
+
+  uint8_t buckets = count < STATS_HISTOGRAM_BUCKETS ? (uint8_t)count : STATS_HISTOGRAM_BUCKETS;
+  for (uint8_t i = 0; i <= buckets; i++) {
+    column->bounds[i] = values[(uint64_t)i * (count - 1) / buckets];
+  }
+  column->bucket_count = buckets;
+}
+
+static bool analyze_table(Database* db, TableSchema* schema, TableStatistics* stats) {
+  uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+  BufferPool* pool = &db->lake[schema_idx];
+
+  free_column_statistics(stats);
+
+  stats->columns = calloc(schema->column_count, sizeof(ColumnStatistics));
+  double** samples = calloc(schema->column_count, sizeof(double*));
+  uint64_t* sampled = calloc(schema->column_count, sizeof(uint64_t));
+  if (!stats->columns || !samples || !sampled) {
+    free(stats->columns);
+    free(samples);
+    free(sampled);
+    stats->columns = NULL;
+    return false;
+  }
+  stats->column_count = schema->column_count;
+
+  uint64_t capacity = 0;
+  for (uint16_t p = 0; p < pool->num_pages; p++) {
+    if (pool->pages[p]) capacity += pool->pages[p]->num_rows;
+  }
+
+  bool success = true;
+  for (uint8_t i = 0; i < schema->column_count && success; i++) {
+    ColumnDefinition* def = &schema->columns[i];
+    ColumnStatistics* column = &stats->columns[i];
+
+    ColumnValue probe = { .type = def->type };
+    ZoneKey key;
+    bool is_ordered = !def->is_array && zone_key(&probe, def->type, &key);
+    column->type = is_ordered ? def->type : PAGE_ZONE_UNBOUNDED;
+
+    column->distinct = malloc(sizeof(HyperLogLog));
+    success = column->distinct != NULL;
+    if (success) hll_init(column->distinct);
+
+    if (success && is_ordered && capacity > 0) {
+      samples[i] = malloc(capacity * sizeof(double));
+      success = samples[i] != NULL;
+    }
+  }
+
+  stats->row_count = 0;
+  for (uint16_t p = 0; p < pool->num_pages && success; p++) {
+    Page* page = pool->pages[p];
+    if (!page) continue;
+
+    page_materialize(page, schema, NULL);
+
+    for (uint16_t r = 0; r < page->num_rows; r++) {
+      Row* row = &page->rows[r];
+      if (is_struct_zeroed(row, sizeof(Row)) || row->deleted || !row->values) continue;
+
+      stats->row_count++;
+
+      for (uint8_t i = 0; i < schema->column_count && i < row->n_values; i++) {
+        ColumnStatistics* column = &stats->columns[i];
+        column_add_value(column, &row->values[i], schema->columns[i].type);
+
+        ZoneKey key;
+        if (samples[i] && column->type != PAGE_ZONE_UNBOUNDED && zone_key(&row->values[i], column->type, &key)) {
+          samples[i][sampled[i]++] = zone_key_double(key, column->type);
+        }
+      }
+    }
+  }
+
+  for (uint8_t i = 0; i < schema->column_count; i++) {
+    if (success && stats->columns[i].type != PAGE_ZONE_UNBOUNDED) {
+      build_histogram(&stats->columns[i], samples[i], sampled[i]);
+    }
+    free(samples[i]);
+  }
+
+  free(samples);
+  free(sampled);
+
+  if (!success) {
+    LOG_ERROR("Failed to allocate statistics for '%s'", schema->table_name);
+    free_column_statistics(stats);
+  }
+
+  return success;
+}
+
+static Result statistics_query(Database* core, char* query) {
+  ParserState state = parser_save_state(core->parser);
+  Result res = process_silent(core, query);
+  parser_restore_state(core->parser, state);
+  return res;
+}
+
+static bool record_statistics(Database* db, TableSchema* schema, TableStatistics* stats) {
+  if (!db->core) db->core = db;
+
+  int64_t table_id = find_table(db, schema->table_name);
+  if (table_id == -1) return false;
+
+  char query[1024];
+  snprintf(query, sizeof(query), "DELETE FROM jb_statistics WHERE table_id = %ld;", table_id);
+
+  Result res = statistics_query(db->core, query);
+  bool success = res.exec.code == 0;
+  free_result(&res);
+
+  for (uint8_t i = 0; success && i < stats->column_count; i++) {
+    ColumnStatistics* column = &stats->columns[i];
+    double null_frac = stats->row_count ? (double)column->null_count / (double)stats->row_count : 0.0;
+
+    char min_value[64] = "NULL";
+    char max_value[64] = "NULL";
+    if (column->has_range) {
+      snprintf(min_value, sizeof(min_value), "%.6f", zone_key_double(column->min, column->type));
+      snprintf(max_value, sizeof(max_value), "%.6f", zone_key_double(column->max, column->type));
+    }
+
+    char histogram[STATS_HISTOGRAM_BUCKETS * 32] = "";
+    size_t used = 0;
+    for (uint8_t b = 0; b <= column->bucket_count && column->bucket_count > 0; b++) {
+      used += snprintf(histogram + used, sizeof(histogram) - used, "%s%g", b ? "," : "", column->bounds[b]);
+      if (used >= sizeof(histogram)) break;
+    }
+
+    snprintf(query, sizeof(query),
+      "INSERT INTO jb_statistics (table_id, column_name, row_count, null_frac, n_distinct, min_value, max_value, "
+      "histogram, analyzed_at) VALUES (%ld, '%s', %lu, %.6f, %lu, %s, %s, '%s', NOW());",
+      table_id, schema->columns[i].name, (unsigned long)stats->row_count, null_frac,
+      (unsigned long)column_distinct_count(column), min_value, max_value, histogram);
+
+    res = statistics_query(db->core, query);
+    success = res.exec.code == 0;
+    free_result(&res);
+  }
+
+  if (!success) LOG_ERROR("Failed to record statistics of '%s' in jb_statistics", schema->table_name);
+  return success;
+}
+
+static bool analyze_one(Database* db, TableSchema* schema) {
+  TableStatistics* stats = table_statistics(db, schema);
+  if (!stats || !analyze_table(db, schema, stats)) return false;
+
+  return record_statistics(db, schema, stats);
+}
+
+ExecutionResult execute_analyze(Database* db, JQLCommand* cmd) {
+  if (!db || !cmd) {
+    return (ExecutionResult){1, "Invalid execution context or command"};
+  }
+
+  uint32_t analyzed = 0;
+
+  if (cmd->schema) {
+    TableSchema* schema = get_table_schema(db, cmd->schema->table_name);
+    if (!schema) {
+      return (ExecutionResult){1, "Error: Invalid schema"};
+    }
+
+    if (!analyze_one(db, schema)) {
+      return (ExecutionResult){1, "Failed to analyze table"};
+    }
+    analyzed++;
+  } else {
+    for (int i = 0; i < MAX_TABLES; i++) {
+      TableSchema* schema = db->tc[i].schema;
+      if (!schema) continue;
+
+      if (!analyze_one(db, schema)) {
+        return (ExecutionResult){1, "Failed to analyze table"};
+      }
+      analyzed++;
+    }
+  }
+
+  return (ExecutionResult){0, "Analyze executed successfully", .row_count = analyzed};
+}
+
+uint64_t column_distinct_count(ColumnStatistics* column) {
+  if (!column || !column->distinct) return 0;
+  return hll_estimate(column->distinct);
+}
+
+static ColumnDefinition* statistics_column(ExprNode* node, TableSchema* schema) {
+  if (!node || node->type != EXPR_COLUMN || node->column.array_idx) return NULL;
+  if (node->column.index >= schema->column_count) return NULL;
+  return &schema->columns[node->column.index];
+}
+
+// where a constant falls in the order the column's statistics are kept in
+static bool literal_position(ExprNode* literal, ColumnDefinition* def, uint8_t type, Database* db, double* out) {
+  if (!literal || literal->type != EXPR_LITERAL || literal->literal.is_null) return false;
+  if (type == PAGE_ZONE_UNBOUNDED) return false;
+
+  ColumnValue value = evaluate_literal_expression(literal, db);
+  ZoneKey key;
+  if (!infer_and_cast_value(&value, def) || !zone_key(&value, type, &key)) return false;
+
+  *out = zone_key_double(key, type);
+  return true;
+}
+
+// share of the non-NULL values below x, negative when nothing is known about the column
+static double fraction_below(ColumnStatistics* column, double x) {
+  if (column->bucket_count > 0) {
+    double* bounds = column->bounds;
+    uint8_t n = column->bucket_count;
+    if (x <= bounds[0]) return 0.0;
+    if (x > bounds[n]) return 1.0;
+
+    for (uint8_t i = 0; i < n; i++) {
+      if (x <= bounds[i + 1]) {
+        double width = bounds[i + 1] - bounds[i];
+        double within = width > 0.0 ? (x - bounds[i]) / width : 1.0;
+        return (i + within) / n;
+      }
+    }
+    return 1.0;
+  }
+
+  if (column->has_range) {
+    double low = zone_key_double(column->min, column->type);
+    double high = zone_key_double(column->max, column->type);
+    if (x <= low) return 0.0;
+    if (x > high) return 1.0;
+    return high > low ? (x - low) / (high - low) : 1.0;
+  }
+
+  return -1.0;
+}
+
+static bool is_sole_key(TableSchema* schema, uint16_t index) {
+  ColumnDefinition* def = &schema->columns[index];
+  if (def->is_unique) return true;
+  if (!def->is_primary_key) return false;
+
+  for (uint8_t i = 0; i < schema->column_count; i++) {
+    if (i != index && schema->columns[i].is_primary_key) return false;
+  }
+  return true;
+}
+
+static double clamp_selectivity(double s) {
+  return s < 0.0 ? 0.0 : (s > 1.0 ? 1.0 : s);
+}
+
+static double equality_selectivity(TableStatistics* stats, ColumnStatistics* column, TableSchema* schema,
+                                   uint16_t index, double position, bool has_position) {
+  double rows = stats->row_count ? (double)stats->row_count : 1.0;
+  if (is_sole_key(schema, index)) return 1.0 / rows;
+  if (!column) return STATS_DEFAULT_EQ_SELECTIVITY;
+
+  if (has_position && column->has_range &&
+      (position < zone_key_double(column->min, column->type) || position > zone_key_double(column->max, column->type))) {
+    return 0.0;
+  }
+
+  uint64_t distinct = column_distinct_count(column);
+  if (distinct == 0) return STATS_DEFAULT_EQ_SELECTIVITY;
+
+  double non_null = 1.0 - (double)column->null_count / rows;
+  return clamp_selectivity(non_null / (double)distinct);
+}
+
+static double comparison_selectivity(Database* db, TableSchema* schema, TableStatistics* stats, ExprNode* node) {
+  int op = node->binary.op;
+  ExprNode* column_node = node->binary.left;
+  ExprNode* literal = node->binary.right;
+
+  if (column_node->type != EXPR_COLUMN) {
+    column_node = node->binary.right;
+    literal = node->binary.left;
+    switch (op) {
+      case TOK_LT: op = TOK_GT; break;
+      case TOK_LE: op = TOK_GE; break;
+      case TOK_GT: op = TOK_LT; break;
+      case TOK_GE: op = TOK_LE; break;
+    }
+  }
+
+  ColumnDefinition* def = statistics_column(column_node, schema);
+  if (!def || !literal || literal->type != EXPR_LITERAL) return STATS_DEFAULT_RANGE_SELECTIVITY;
+
+  uint16_t index = column_node->column.index;
+  ColumnStatistics* column = stats->columns && index < stats->column_count ? &stats->columns[index] : NULL;
+  double rows = stats->row_count ? (double)stats->row_count : 1.0;
+  double null_frac = column ? (double)column->null_count / rows : 0.0;
+
+  if (literal->literal.is_null) {
+    return op == TOK_EQ && column ? null_frac : (op == TOK_EQ ? STATS_DEFAULT_EQ_SELECTIVITY : 0.0);
+  }
+
+  double position = 0.0;
+  bool has_position = column && literal_position(literal, def, column->type, db, &position);
+
+  if (op == TOK_EQ) return equality_selectivity(stats, column, schema, index, position, has_position);
+  if (op == TOK_NE) {
+    return clamp_selectivity(1.0 - null_frac - equality_selectivity(stats, column, schema, index, position, has_position));
+  }
+
+  double below = has_position ? fraction_below(column, position) : -1.0;
+  if (below < 0.0) return STATS_DEFAULT_RANGE_SELECTIVITY;
+
+  switch (op) {
+    case TOK_LT:
+    case TOK_LE:
+      return clamp_selectivity(below * (1.0 - null_frac));
+    case TOK_GT:
+    case TOK_GE:
+      return clamp_selectivity((1.0 - below) * (1.0 - null_frac));
+    default:
+      return STATS_DEFAULT_RANGE_SELECTIVITY;
+  }
+}
+
+static double between_selectivity(Database* db, TableSchema* schema, TableStatistics* stats, ExprNode* node) {
+  ColumnDefinition* def = statistics_column(node->between.value, schema);
+  uint16_t index = def ? node->between.value->column.index : 0;
+  if (!def || !stats->columns || index >= stats->column_count) return STATS_DEFAULT_RANGE_SELECTIVITY;
+
+  ColumnStatistics* column = &stats->columns[index];
+  double low, high;
+  if (!literal_position(node->between.lower, def, column->type, db, &low) ||
+      !literal_position(node->between.upper, def, column->type, db, &high)) {
+    return STATS_DEFAULT_RANGE_SELECTIVITY;
+  }
+
+  double from = fraction_below(column, low);
+  double to = fraction_below(column, high);
+  if (from < 0.0 || to < 0.0) return STATS_DEFAULT_RANGE_SELECTIVITY;
+
+  // the upper bound is inclusive, so a single-valued range still keeps its own rows
+  double rows = stats->row_count ? (double)stats->row_count : 1.0;
+  double span = to - from;
+  if (span <= 0.0 && high >= low) span = equality_selectivity(stats, column, schema, index, low, true);
+  return clamp_selectivity(span * (1.0 - (double)column->null_count / rows));
+}
+
+static double expression_selectivity(Database* db, TableSchema* schema, TableStatistics* stats, ExprNode* node) {
+  if (!node) return 1.0;
+
+  switch (node->type) {
+    case EXPR_LOGICAL_AND:
+      return expression_selectivity(db, schema, stats, node->binary.left) *
+             expression_selectivity(db, schema, stats, node->binary.right);
+
+    case EXPR_LOGICAL_OR: {
+      double a = expression_selectivity(db, schema, stats, node->binary.left);
+      double b = expression_selectivity(db, schema, stats, node->binary.right);
+      return a + b - a * b;
+    }
+
+    case EXPR_LOGICAL_NOT:
+      return 1.0 - expression_selectivity(db, schema, stats, node->arth_unary.expr);
+
+    case EXPR_COMPARISON:
+      return comparison_selectivity(db, schema, stats, node);
+
+    case EXPR_BETWEEN:
+      return between_selectivity(db, schema, stats, node);
+
+    case EXPR_IN: {
+      ExprNode eq = { .type = EXPR_COMPARISON };
+      eq.binary.left = node->in.value;
+      eq.binary.op = TOK_EQ;
+
+      double s = 0.0;
+      for (size_t i = 0; i < node->in.count; i++) {
+        eq.binary.right = node->in.list[i];
+        s += comparison_selectivity(db, schema, stats, &eq);
+      }
+      return clamp_selectivity(s);
+    }
+
+    default:
+      return STATS_DEFAULT_RANGE_SELECTIVITY;
+  }
+}
+
+double estimate_selectivity(Database* db, TableSchema* schema, ExprNode* where) {
+  TableStatistics* stats = table_statistics(db, schema);
+  if (!stats || !where) return 1.0;
+
+  return clamp_selectivity(expression_selectivity(db, schema, stats, where));
+}
+
+// a top-level conjunct `key = constant` on a table whose primary key is that one column
+static ExprNode* find_key_equality(ExprNode* node, TableSchema* schema) {
+  if (!node) return NULL;
+
+  if (node->type == EXPR_LOGICAL_AND) {
+    ExprNode* found = find_key_equality(node->binary.left, schema);
+    return found ? found : find_key_equality(node->binary.right, schema);
+  }
+
+  if (node->type != EXPR_COMPARISON || node->binary.op != TOK_EQ) return NULL;
+
+  ExprNode* column = node->binary.left->type == EXPR_COLUMN ? node->binary.left : node->binary.right;
+  ExprNode* literal = column == node->binary.left ? node->binary.right : node->binary.left;
+  if (!statistics_column(column, schema) || literal->type != EXPR_LITERAL || literal->literal.is_null) return NULL;
+
+  uint16_t index = column->column.index;
+  if (!schema->columns[index].is_primary_key || !is_sole_key(schema, index)) return NULL;
+
+  return node;
+}
+
+static bool lookup_key(ExprNode* node, TableSchema* schema, Database* db, AccessPlan* plan) {
+  ExprNode* column = node->binary.left->type == EXPR_COLUMN ? node->binary.left : node->binary.right;
+  ExprNode* literal = column == node->binary.left ? node->binary.right : node->binary.left;
+  ColumnDefinition* def = &schema->columns[column->column.index];
+
+  // the constant has to land on the key it names, not on one a cast rounded it to
+  ColumnValue original = evaluate_literal_expression(literal, db);
+  ColumnValue key = original;
+  if (!infer_and_cast_value(&key, def)) return false;
+
+  bool integer_column = def->type == TOK_T_INT || def->type == TOK_T_UINT || def->type == TOK_T_SERIAL;
+  bool integer_literal = original.type == TOK_T_INT || original.type == TOK_T_UINT || original.type == TOK_T_SERIAL;
+  if (integer_column != integer_literal) return false;
+
+  plan->column = column->column.index;
+  plan->key = key;
+  return true;
+}
+
+AccessPlan plan_table_access(Database* db, JQLCommand* cmd, TableSchema* schema) {
+  AccessPlan plan = { .method = ACCESS_SEQ_SCAN };
+  if (!db || !cmd || !schema) return plan;
+
+  uint8_t schema_idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+  TableStatistics* stats = table_statistics(db, schema);
+  double rows = stats ? (double)stats->row_count : 0.0;
+
+  plan.rows = cmd->has_where ? rows * estimate_selectivity(db, schema, cmd->where) : rows;
+  plan.seq_cost = db->lake[schema_idx].num_pages * STATS_PAGE_COST + rows * STATS_ROW_COST;
+
+  // a sample has to see the pages it keeps, a lookup would bypass it
+  if (!cmd->has_where || cmd->has_join || cmd->sample_method != SAMPLE_NONE) return plan;
+
+  ExprNode* equality = find_key_equality(cmd->where, schema);
+  if (!equality || !lookup_key(equality, schema, db, &plan)) return plan;
+
+  BTree* btree = db->tc[schema_idx].btree[hash_fnv1a(schema->columns[plan.column].name, MAX_COLUMNS)];
+  if (!btree) return plan;
+
+  plan.lookup_cost = STATS_RANDOM_PAGE_COST + log2(rows + 1.0) * STATS_ROW_COST;
+  if (plan.lookup_cost < plan.seq_cost) plan.method = ACCESS_PK_LOOKUP;
+
+  return plan;
+}
+
+bool statistics_count_rows(Database* db, JQLCommand* cmd, TableSchema* schema, uint64_t* count) {
+  if (!db || !cmd || !schema) return false;
+
+  if (cmd->has_where || cmd->has_join || cmd->has_group_by || cmd->has_having || cmd->is_distinct ||
+      cmd->has_order_by || cmd->sample_method != SAMPLE_NONE || cmd->value_counts[0] == 0) {
+    return false;
+  }
+
+  for (int j = 0; j < cmd->value_counts[0]; j++) {
+    ExprNode* expr = cmd->sel_columns[j].expr;
+    if (!expr || expr->type != EXPR_FUNCTION || expr->fn.type != AGG_COUNT || expr->fn.arg_count != 0) return false;
+  }
+
+  TableStatistics* stats = table_statistics(db, schema);
+  if (!stats) return false;
+
+  *count = stats->row_count;
+  return true;
+}
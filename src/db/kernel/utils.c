@@ -6,50 +6,39 @@ void swap_rows(Row* r1, Row* r2) {
   *r2 = temp;
 }
 
-int compare_rows(const Row* r1, const Row* r2, JQLCommand* cmd, TableSchema* schema) {
-  for (uint8_t i = 0; i < cmd->order_by_count; i++) {
-    uint8_t col = cmd->order_by[i].col;
-    bool desc = cmd->order_by[i].decend;
-
-    ColumnValue v1 = r1->values[col];
-    ColumnValue v2 = r2->values[col];
-
-    if (v1.type == TOK_T_VARCHAR || v1.type == TOK_T_STRING) {
-      if (v1.is_null && !v2.is_null) return desc ? 1 : -1; 
-      if (!v1.is_null && v2.is_null) return desc ? -1 : 1;
-      
-      if (v1.is_null && v2.is_null) {
-        if (strlen(v1.str_value) == 0 && strlen(v2.str_value) == 0) return 0;
-        if (strlen(v1.str_value) == 0) return desc ? 1 : -1;
-        if (strlen(v2.str_value) == 0) return desc ? -1 : 1;
-      }
+int compare_values(ColumnValue* v1, ColumnValue* v2) {
+  if (v1->is_null != v2->is_null) return v1->is_null ? -1 : 1;
+  if (v1->is_null) return 0;
 
-      char* str1 = v1.str_value;
-      char* str2 = v2.str_value;
+  if (v1->type == TOK_T_VARCHAR || v1->type == TOK_T_STRING) {
+    int cmp = strcmp(v1->str_value, v2->str_value);
+    return (cmp > 0) - (cmp < 0);
+  }
 
-      while (*str1 && *str2) {
-        if (*str1 != *str2) {
-          return desc ? (*str1 > *str2 ? -1 : 1) : (*str1 > *str2 ? 1 : -1);
-        }
-        str1++;
-        str2++;
-      }
+  if (v1->type == TOK_T_INT || v1->type == TOK_T_UINT || v1->type == TOK_T_SERIAL) {
+    return (v1->int_value > v2->int_value) - (v1->int_value < v2->int_value);
+  }
 
-      if (*str1 && !*str2) return desc ? -1 : 1;
-      if (!*str1 && *str2) return desc ? 1 : -1;
-    }
+  return key_compare(get_column_value_as_pointer(v1), get_column_value_as_pointer(v2), v1->type);
+}
 
-    int cmp = key_compare(get_column_value_as_pointer(&v1),
-      get_column_value_as_pointer(&v2),
-      cmd->order_by[i].type);
+int compare_rows(const Row* r1, const Row* r2, JQLCommand* cmd, TableSchema* schema) {
+  for (uint8_t i = 0; i < cmd->order_by_count; i++) {
+    uint8_t col = cmd->order_by[i].col;
 
-    if (cmp != 0) return desc ? -cmp : cmp;
+    int cmp = compare_values(&r1->values[col], &r2->values[col]);
+    if (cmp != 0) return cmd->order_by[i].decend ? -cmp : cmp;
   }
   return 0;
 }
 
 int partition_rows(Row rows[], int low, int high,
                           JQLCommand *cmd, TableSchema *schema) {
+  int mid = low + (high - low) / 2;
+  if (compare_rows(&rows[mid], &rows[low], cmd, schema) < 0) swap_rows(&rows[mid], &rows[low]);
+  if (compare_rows(&rows[high], &rows[low], cmd, schema) < 0) swap_rows(&rows[high], &rows[low]);
+  if (compare_rows(&rows[mid], &rows[high], cmd, schema) < 0) swap_rows(&rows[mid], &rows[high]);
+
   Row pivot = rows[high];
   int i = low - 1;
   for (int j = low; j < high; ++j) {
@@ -64,103 +53,80 @@ int partition_rows(Row rows[], int low, int high,
 
 void quick_sort_rows(Row rows[], int low, int high,
                      JQLCommand *cmd, TableSchema *schema) {
-  if (low < high) {
+  while (low < high) {
     int pi = partition_rows(rows, low, high, cmd, schema);
-    quick_sort_rows(rows,     low, pi - 1, cmd, schema);
-    quick_sort_rows(rows, pi + 1,   high, cmd, schema);
+
+    if (pi - low < high - pi) {
+      quick_sort_rows(rows, low, pi - 1, cmd, schema);
+      low = pi + 1;
+    } else {
+      quick_sort_rows(rows, pi + 1, high, cmd, schema);
+      high = pi - 1;
+    }
   }
 }
 
+void sift_up_rows(Row rows[], uint32_t idx, JQLCommand *cmd, TableSchema *schema) {
+  while (idx > 0) {
+    uint32_t parent = (idx - 1) / 2;
+    if (compare_rows(&rows[parent], &rows[idx], cmd, schema) >= 0) break;
 
-bool match_char_class(char** pattern_ptr, char* str) {
-  char* pattern = *pattern_ptr;
-  bool negated = false;
-
-  LOG_DEBUG("Initial pattern: %s", pattern);
-  LOG_DEBUG("Character to match: %c", *str);
-
-  if (*pattern == '^') {
-    negated = true;
-    pattern++;
-    LOG_DEBUG("Negated character class detected, moving pattern pointer to: %s", pattern);
+    swap_rows(&rows[parent], &rows[idx]);
+    idx = parent;
   }
+}
 
-  bool matched = false;
-
-  while (*pattern && *pattern != ']') {
-    if (*(pattern + 1) == '-' && *(pattern + 2) && *(pattern + 2) != ']') {
-      char start = *pattern;
-      char end = *(pattern + 2);
+void sift_down_rows(Row rows[], uint32_t idx, uint32_t count,
+                    JQLCommand *cmd, TableSchema *schema) {
+  while (true) {
+    uint32_t largest = idx;
+    uint32_t left = 2 * idx + 1;
+    uint32_t right = left + 1;
 
-      LOG_DEBUG("Character range: %c-%c", start, end);
+    if (left < count && compare_rows(&rows[left], &rows[largest], cmd, schema) > 0) largest = left;
+    if (right < count && compare_rows(&rows[right], &rows[largest], cmd, schema) > 0) largest = right;
+    if (largest == idx) break;
 
-      if (start <= *str && *str <= end) {
-        matched = true;
-        LOG_DEBUG("Matched range: %c is between %c and %c", *str, start, end);
-      }
-      pattern += 3; 
-    } else {
-      if (*pattern == *str) {
-        matched = true;
-        LOG_DEBUG("Matched character: %c == %c", *pattern, *str);
-      }
-      pattern++; 
-    }
+    swap_rows(&rows[idx], &rows[largest]);
+    idx = largest;
   }
+}
 
-  if (*pattern == ']') {
-    pattern++; 
-    LOG_DEBUG("Closing character class found, moving pattern pointer to: %s", pattern);
+bool top_n_push_row(Row heap[], uint32_t* count, uint32_t bound, Row row,
+                    JQLCommand *cmd, TableSchema *schema) {
+  if (*count < bound) {
+    heap[*count] = row;
+    sift_up_rows(heap, (*count)++, cmd, schema);
+    return true;
   }
 
-  *pattern_ptr = pattern;
-  LOG_DEBUG("Pattern pointer updated to: %s", pattern);
+  if (bound == 0 || compare_rows(&row, &heap[0], cmd, schema) >= 0) return false;
 
-  return negated ? !matched : matched;
+  heap[0] = row;
+  sift_down_rows(heap, 0, *count, cmd, schema);
+  return true;
 }
 
-bool like_match(char* str, char* pattern) {
-  bool case_insensitive = false;
-
-  if (strncmp(pattern, "(?i)", 4) == 0) {
-    case_insensitive = true;
-    pattern += 4;
-    str = tolower_copy(str);
-    pattern = tolower_copy(pattern);
+void heap_sort_rows(Row rows[], uint32_t count, JQLCommand *cmd, TableSchema *schema) {
+  for (uint32_t i = count / 2; i-- > 0;) {
+    sift_down_rows(rows, i, count, cmd, schema);
   }
 
-  while (*pattern) {
-    if (*pattern == '\\') {
-      pattern++;
-      if (!*pattern) return false;
-      if (*str != *pattern) return false;
-      str++; pattern++;
-    }
-    else if (*pattern == '%' || *pattern == '*') {
-      pattern++;
-      if (!*pattern) return true;
-      while (*str) {
-        if (like_match(str, pattern)) return true;
-        str++;
-      }
-      return false;
-    }
-    else if (*pattern == '_') {
-      if (!*str) return false;
-      str++; pattern++;
-    }
-    else if (*pattern == '[') {
-      if (!*str) return false;
-      pattern++;
-      bool res = match_char_class(&pattern, str);
-      if (!res) return false;
-    } else {
-      if (*str != *pattern) return false;
-      str++; pattern++;
-    }
+  for (uint32_t end = count; end > 1; end--) {
+    swap_rows(&rows[0], &rows[end - 1]);
+    sift_down_rows(rows, 0, end - 1, cmd, schema);
   }
+}
+
+
+// one-off matches compile the pattern for a single use, statements keep theirs on the ExprNode
+bool like_match(char* str, char* pattern) {
+  LikeMatcher* matcher = like_compile(pattern);
+  if (!matcher) return false;
 
-  return *str == '\0';
+  bool result = like_matches(matcher, str, strlen(str));
+  like_free(matcher);
+  return result;
 }
 
 void* get_column_value_as_pointer(ColumnValue* col_val) {
@@ -0,0 +1,495 @@
+#include "kernel/kernel.h"
+
+/*
+  Batch WHERE evaluation. A supported predicate tree is compiled once per
+  statement; each page is then filtered a whole vector at a time. Column
+  values are gathered into typed arrays and every leaf runs a branch-free
+  kernel over them, producing (value, null) byte vectors that mirror the
+  three-valued results of evaluate_condition exactly.
+
+  select_page_rows is also where TABLESAMPLE applies: SYSTEM skips whole
+  pages before anything on them is decoded, BERNOULLI thins out the rows
+  that passed the filter.
+*/
+
+static bool vector_kind_for(uint8_t type, uint8_t* kind) {
+  switch (type) {
+    case TOK_T_INT:
+    case TOK_T_UINT:
+    case TOK_T_SERIAL:
+    case TOK_T_BOOL:
+      *kind = VEC_I64;
+      return true;
+    case TOK_T_FLOAT:
+    case TOK_T_DOUBLE:
+      *kind = VEC_F64;
+      return true;
+    case TOK_T_VARCHAR:
+    case TOK_T_CHAR:
+      *kind = VEC_STR;
+      return true;
+    default:
+      return false;
+  }
+}
+
+static int vector_column_slot(VectorFilter* filter, uint8_t column, uint8_t kind) {
+  for (uint8_t i = 0; i < filter->column_count; i++) {
+    if (filter->columns[i].column == column && filter->columns[i].kind == kind) return i;
+  }
+
+  if (filter->column_count >= VECTOR_MAX_COLUMNS) return -1;
+
+  VectorColumn* col = &filter->columns[filter->column_count];
+  col->column = column;
+  col->kind = kind;
+
+  return filter->column_count++;
+}
+
+static bool vector_literal(ColumnValue literal, ColumnDefinition* def, uint8_t kind, VectorScalar* out) {
+  if (literal.type == TOK_T_STRING && literal.str_value && strlen(literal.str_value) > TOAST_CHUNK_SIZE) {
+    return false;
+  }
+
+  if (!infer_and_cast_value(&literal, def) || literal.is_null) return false;
+
+  switch (kind) {
+    case VEC_I64:
+      out->i64 = def->type == TOK_T_BOOL ? literal.bool_value : literal.int_value;
+      return true;
+    case VEC_F64:
+      out->f64 = def->type == TOK_T_FLOAT ? literal.float_value : literal.double_value;
+      return true;
+    case VEC_STR:
+      out->str = literal.str_value;
+      return out->str != NULL;
+  }
+
+  return false;
+}
+
+static int flip_comparison(int op) {
+  switch (op) {
+    case TOK_LT: return TOK_GT;
+    case TOK_GT: return TOK_LT;
+    case TOK_LE: return TOK_GE;
+    case TOK_GE: return TOK_LE;
+    default: return op;
+  }
+}
+
+static VectorNode* vector_node_new(uint8_t kind) {
+  VectorNode* node = calloc(1, sizeof(VectorNode));
+  if (node) node->kind = kind;
+  return node;
+}
+
+static VectorNode* vector_compile_comparison(VectorFilter* filter, ExprNode* expr, TableSchema* schema) {
+  ExprNode* left = expr->binary.left;
+  ExprNode* right = expr->binary.right;
+  int op = expr->binary.op;
+
+  if (op != TOK_EQ && op != TOK_NE && op != TOK_LT && op != TOK_GT && op != TOK_LE && op != TOK_GE) {
+    return NULL;
+  }
+
+  bool column_left = left->type == EXPR_COLUMN && right->type == EXPR_LITERAL;
+  bool column_right = right->type == EXPR_COLUMN && left->type == EXPR_LITERAL;
+  if (!column_left && !column_right) return NULL;
+
+  ExprNode* column = column_left ? left : right;
+  ExprNode* literal = column_left ? right : left;
+
+  if (column->column.index >= schema->column_count) return NULL;
+  ColumnDefinition* def = &schema->columns[column->column.index];
+  if (def->is_array) return NULL;
+
+  if (literal->literal.is_null) {
+    // `col = NULL` reads as IS NULL, every other comparison against NULL is NULL
+    VectorNode* node = vector_node_new(column_left && op == TOK_EQ ? VEC_NODE_IS_NULL : VEC_NODE_NULL);
+    if (!node) return NULL;
+
+    if (node->kind == VEC_NODE_IS_NULL) {
+      int slot = vector_column_slot(filter, column->column.index, VEC_I64);
+      if (slot < 0) {
+        free(node);
+        return NULL;
+      }
+      node->slot = slot;
+    }
+    return node;
+  }
+
+  uint8_t kind;
+  if (!vector_kind_for(def->type, &kind)) return NULL;
+
+  VectorNode* node = vector_node_new(VEC_NODE_CMP);
+  if (!node) return NULL;
+
+  int slot = vector_column_slot(filter, column->column.index, kind);
+  if (slot < 0 || !vector_literal(literal->literal, def, kind, &node->lower)) {
+    free(node);
+    return NULL;
+  }
+
+  node->slot = slot;
+  node->value_kind = kind;
+  node->op = column_left ? op : flip_comparison(op);
+
+  return node;
+}
+
+static VectorNode* vector_compile_between(VectorFilter* filter, ExprNode* expr, TableSchema* schema) {
+  ExprNode* value = expr->between.value;
+  ExprNode* lower = expr->between.lower;
+  ExprNode* upper = expr->between.upper;
+
+  if (value->type != EXPR_COLUMN || lower->type != EXPR_LITERAL || upper->type != EXPR_LITERAL) return NULL;
+  if (value->column.index >= schema->column_count) return NULL;
+
+  ColumnDefinition* def = &schema->columns[value->column.index];
+  uint8_t kind;
+  if (def->is_array || !vector_kind_for(def->type, &kind) || kind == VEC_STR || def->type == TOK_T_BOOL) {
+    return NULL;
+  }
+
+  // BETWEEN compares as doubles, matching evaluate_between_expression
+  ColumnDefinition as_double = { .type = TOK_T_DOUBLE };
+  VectorNode* node = vector_node_new(VEC_NODE_BETWEEN);
+  if (!node) return NULL;
+
+  int slot = vector_column_slot(filter, value->column.index, VEC_F64);
+  node->bounds_null = lower->literal.is_null || upper->literal.is_null;
+
+  if (slot < 0 || (!node->bounds_null &&
+      (!vector_literal(lower->literal, &as_double, VEC_F64, &node->lower) ||
+       !vector_literal(upper->literal, &as_double, VEC_F64, &node->upper)))) {
+    free(node);
+    return NULL;
+  }
+
+  node->slot = slot;
+  node->value_kind = VEC_F64;
+
+  return node;
+}
+
+static VectorNode* vector_compile_node(VectorFilter* filter, ExprNode* expr, TableSchema* schema) {
+  if (!expr) return NULL;
+
+  switch (expr->type) {
+    case EXPR_COMPARISON:
+      return vector_compile_comparison(filter, expr, schema);
+
+    case EXPR_BETWEEN:
+      return vector_compile_between(filter, expr, schema);
+
+    case EXPR_LOGICAL_AND:
+    case EXPR_LOGICAL_OR: {
+      VectorNode* node = vector_node_new(expr->type == EXPR_LOGICAL_AND ? VEC_NODE_AND : VEC_NODE_OR);
+      if (!node) return NULL;
+
+      node->left = vector_compile_node(filter, expr->binary.left, schema);
+      node->right = node->left ? vector_compile_node(filter, expr->binary.right, schema) : NULL;
+
+      if (!node->left || !node->right) {
+        free_vector_node(node);
+        return NULL;
+      }
+      return node;
+    }
+
+    case EXPR_LOGICAL_NOT: {
+      VectorNode* node = vector_node_new(VEC_NODE_NOT);
+      if (!node) return NULL;
+
+      node->left = vector_compile_node(filter, expr->unary, schema);
+      if (!node->left) {
+        free(node);
+        return NULL;
+      }
+      return node;
+    }
+
+    default:
+      return NULL;
+  }
+}
+
+VectorFilter* vector_filter_compile(ExprNode* where, TableSchema* schema, Database* db) {
+  if (!where || !schema) return NULL;
+
+  VectorFilter* filter = calloc(1, sizeof(VectorFilter));
+  if (!filter) return NULL;
+
+  filter->root = vector_compile_node(filter, where, schema);
+  if (!filter->root) {
+    // predicates the kernels cannot take still run compiled, one row at a time
+    filter->column_count = 0;
+    filter->program = expr_program_compile(&where, 1, schema, db);
+  }
+
+  if (!filter->root && !filter->program) {
+    free(filter);
+    return NULL;
+  }
+
+  zone_filter_compile(&filter->zones, where, schema, db);
+  expr_column_set(where, filter->where_columns);
+  return filter;
+}
+
+void free_vector_node(VectorNode* node) {
+  if (!node) return;
+
+  free_vector_node(node->left);
+  free_vector_node(node->right);
+  free(node);
+}
+
+void vector_filter_free(VectorFilter* filter) {
+  if (!filter) return;
+
+  free_vector_node(filter->root);
+  expr_program_free(filter->program);
+  free(filter);
+}
+
+static bool vector_gather(VectorColumn* col, Row* rows, uint16_t n) {
+  for (uint16_t i = 0; i < n; i++) {
+    ColumnValue* value = rows[i].values ? &rows[i].values[col->column] : NULL;
+    col->null[i] = !value || value->is_null;
+
+    if (col->null[i]) {
+      col->i64[i] = 0;
+      col->f64[i] = 0;
+      col->str[i] = NULL;
+      continue;
+    }
+
+    switch (col->kind) {
+      case VEC_I64:
+        col->i64[i] = value->type == TOK_T_BOOL ? value->bool_value : value->int_value;
+        break;
+      case VEC_F64:
+        if (value->type == TOK_T_FLOAT) col->f64[i] = value->float_value;
+        else if (value->type == TOK_T_DOUBLE) col->f64[i] = value->double_value;
+        else col->f64[i] = (double)value->int_value;
+        break;
+      case VEC_STR:
+        // TOAST strings need a catalog round trip, leave the page to the interpreter
+        if (value->is_toast) return false;
+        col->str[i] = value->str_value;
+        break;
+    }
+  }
+
+  return true;
+}
+
+#define VECTOR_CMP_KERNEL(name, elem_t)                                                   \
+  static void name(const elem_t* restrict col, elem_t k, int op, uint16_t n,             \
+                   uint8_t* restrict out) {                                              \
+    switch (op) {                                                                        \
+      case TOK_EQ: for (uint16_t i = 0; i < n; i++) out[i] = col[i] == k; break;         \
+      case TOK_NE: for (uint16_t i = 0; i < n; i++) out[i] = col[i] != k; break;         \
+      case TOK_LT: for (uint16_t i = 0; i < n; i++) out[i] = col[i] < k; break;          \
+      case TOK_GT: for (uint16_t i = 0; i < n; i++) out[i] = col[i] > k; break;          \
+      case TOK_LE: for (uint16_t i = 0; i < n; i++) out[i] = col[i] <= k; break;         \
+      case TOK_GE: for (uint16_t i = 0; i < n; i++) out[i] = col[i] >= k; break;         \
+    }                                                                                    \
+  }
+
+VECTOR_CMP_KERNEL(vector_cmp_i64, int64_t)
+VECTOR_CMP_KERNEL(vector_cmp_f64, double)
+
+static void vector_cmp_str(char** col, const char* k, int op, uint16_t n, uint8_t* out) {
+  int8_t cmp[VECTOR_SIZE];
+
+  for (uint16_t i = 0; i < n; i++) {
+    int c = col[i] ? strcmp(col[i], k) : 0;
+    cmp[i] = (c > 0) - (c < 0);
+  }
+
+  switch (op) {
+    case TOK_EQ: for (uint16_t i = 0; i < n; i++) out[i] = cmp[i] == 0; break;
+    case TOK_NE: for (uint16_t i = 0; i < n; i++) out[i] = cmp[i] != 0; break;
+    case TOK_LT: for (uint16_t i = 0; i < n; i++) out[i] = cmp[i] < 0; break;
+    case TOK_GT: for (uint16_t i = 0; i < n; i++) out[i] = cmp[i] > 0; break;
+    case TOK_LE: for (uint16_t i = 0; i < n; i++) out[i] = cmp[i] <= 0; break;
+    case TOK_GE: for (uint16_t i = 0; i < n; i++) out[i] = cmp[i] >= 0; break;
+  }
+}
+
+static void vector_eval(VectorFilter* filter, VectorNode* node, uint16_t n) {
+  uint8_t* restrict val = node->val;
+  uint8_t* restrict null = node->null;
+
+  switch (node->kind) {
+    case VEC_NODE_NULL:
+      memset(val, 0, n);
+      memset(null, 1, n);
+      break;
+
+    case VEC_NODE_IS_NULL: {
+      VectorColumn* col = &filter->columns[node->slot];
+      memcpy(val, col->null, n);
+      memset(null, 0, n);
+      break;
+    }
+
+    case VEC_NODE_CMP: {
+      VectorColumn* col = &filter->columns[node->slot];
+
+      if (node->value_kind == VEC_I64) {
+        vector_cmp_i64(col->i64, node->lower.i64, node->op, n, val);
+      } else if (node->value_kind == VEC_F64) {
+        vector_cmp_f64(col->f64, node->lower.f64, node->op, n, val);
+      } else {
+        vector_cmp_str(col->str, node->lower.str, node->op, n, val);
+      }
+      memcpy(null, col->null, n);
+      break;
+    }
+
+    case VEC_NODE_BETWEEN: {
+      VectorColumn* col = &filter->columns[node->slot];
+      const double* restrict f64 = col->f64;
+      double lower = node->lower.f64, upper = node->upper.f64;
+
+      for (uint16_t i = 0; i < n; i++) {
+        val[i] = (f64[i] >= lower) & (f64[i] <= upper);
+        null[i] = col->null[i] | node->bounds_null;
+      }
+      break;
+    }
+
+    case VEC_NODE_AND: {
+      vector_eval(filter, node->left, n);
+      vector_eval(filter, node->right, n);
+      const uint8_t* lv = node->left->val; const uint8_t* ln = node->left->null;
+      const uint8_t* rv = node->right->val; const uint8_t* rn = node->right->null;
+
+      // a definite FALSE on the left short-circuits to a non-null FALSE
+      for (uint16_t i = 0; i < n; i++) {
+        uint8_t short_circuit = !lv[i] & !ln[i];
+        val[i] = lv[i] & rv[i];
+        null[i] = (short_circuit ^ 1) & (ln[i] | rn[i]);
+      }
+      break;
+    }
+
+    case VEC_NODE_OR: {
+      vector_eval(filter, node->left, n);
+      vector_eval(filter, node->right, n);
+      const uint8_t* lv = node->left->val; const uint8_t* ln = node->left->null;
+      const uint8_t* rv = node->right->val; const uint8_t* rn = node->right->null;
+
+      for (uint16_t i = 0; i < n; i++) {
+        uint8_t short_circuit = lv[i] & !ln[i];
+        val[i] = lv[i] | rv[i];
+        null[i] = (short_circuit ^ 1) & (ln[i] | rn[i]);
+      }
+      break;
+    }
+
+    case VEC_NODE_NOT: {
+      vector_eval(filter, node->left, n);
+      const uint8_t* lv = node->left->val; const uint8_t* ln = node->left->null;
+
+      for (uint16_t i = 0; i < n; i++) {
+        val[i] = !lv[i];
+        null[i] = ln[i];
+      }
+      break;
+    }
+  }
+}
+
+bool vector_filter_select(VectorFilter* filter, Row* rows, uint16_t n, uint16_t* sel, uint16_t* out_count) {
+  if (!filter->root) return false;
+  if (n > VECTOR_SIZE) n = VECTOR_SIZE;
+
+  for (uint8_t i = 0; i < filter->column_count; i++) {
+    if (!vector_gather(&filter->columns[i], rows, n)) return false;
+  }
+
+  vector_eval(filter, filter->root, n);
+
+  uint16_t count = 0;
+  const uint8_t* val = filter->root->val;
+  const uint8_t* null = filter->root->null;
+
+  for (uint16_t i = 0; i < n; i++) {
+    sel[count] = i;
+    count += val[i] & !null[i] & (rows[i].values != NULL) & !rows[i].deleted;
+  }
+
+  *out_count = count;
+  return true;
+}
+
+// TABLESAMPLE draws are a hash of the statement's seed and the page (and row), so every
+// worker and every pass over the same page makes the same choice
+static bool sample_keeps(JQLCommand* cmd, uint32_t page_id, uint32_t row_idx) {
+  uint64_t h = ((uint64_t)cmd->sample_seed << 32) ^ ((uint64_t)page_id * 0x9E3779B97F4A7C15ULL) ^ row_idx;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  return (double)(h >> 11) * (100.0 / 9007199254740992.0) < cmd->sample_percent;
+}
+
+static uint16_t filter_page_rows(Database* db, JQLCommand* cmd, VectorFilter* filter, TableSchema* schema,
+                                 uint8_t schema_idx, Page* page, uint16_t* sel) {
+  uint16_t count = 0;
+  if (filter && !zone_filter_page_may_match(&filter->zones, page)) {
+    return 0;
+  }
+
+  if (filter) {
+    page_materialize(page, schema, filter->where_columns);
+  } else if (cmd->has_where) {
+    page_materialize(page, schema, NULL);
+  }
+
+  if (filter && vector_filter_select(filter, page->rows, page->num_rows, sel, &count)) {
+    return count;
+  }
+
+  for (uint16_t row_idx = 0; row_idx < page->num_rows; row_idx++) {
+    Row* row = &page->rows[row_idx];
+
+    if (is_struct_zeroed(row, sizeof(Row)) || row->deleted) continue;
+
+    if (filter && filter->program) {
+      if (!expr_program_condition(filter->program, row, schema, db, schema_idx)) continue;
+    } else if (cmd->has_where && !evaluate_condition(cmd->where, row, schema, db, schema_idx)) {
+      continue;
+    }
+
+    sel[count++] = row_idx;
+  }
+
+  return count;
+}
+
+uint16_t select_page_rows(Database* db, JQLCommand* cmd, VectorFilter* filter, TableSchema* schema,
+                          uint8_t schema_idx, Page* page, uint16_t* sel) {
+  // a page left out of a SYSTEM sample is never decoded or filtered
+  if (cmd->sample_method == SAMPLE_SYSTEM && !sample_keeps(cmd, page->page_id, UINT32_MAX)) return 0;
+
+  uint16_t count = filter_page_rows(db, cmd, filter, schema, schema_idx, page, sel);
+  if (cmd->sample_method != SAMPLE_BERNOULLI) return count;
+
+  uint16_t kept = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    sel[kept] = sel[i];
+    kept += sample_keeps(cmd, page->page_id, sel[i]);
+  }
+
+  return kept;
+}
@@ -0,0 +1,202 @@
+#include "kernel/kernel.h"
+
+/*
+  Zone map predicates. The top-level conjuncts of a WHERE clause that compare
+  a column with a constant (=, <, <=, >, >=, BETWEEN and = NULL) are turned
+  into bounds checks against each page's zone map, so a page whose range
+  cannot satisfy one of them is skipped without looking at its rows.
+*/
+
+static bool is_integer_type(uint8_t type) {
+  return type == TOK_T_INT || type == TOK_T_UINT || type == TOK_T_SERIAL;
+}
+
+static bool literal_as_double(ColumnValue* value, double* out) {
+  switch (value->type) {
+    case TOK_T_INT:
+    case TOK_T_UINT:
+    case TOK_T_SERIAL:
+      *out = (double)value->int_value;
+      return true;
+    case TOK_T_FLOAT:
+      *out = value->float_value;
+      return true;
+    case TOK_T_DOUBLE:
+      *out = value->double_value;
+      return true;
+    default:
+      return false;
+  }
+}
+
+static ColumnDefinition* zone_column(ExprNode* node, TableSchema* schema) {
+  if (!node || node->type != EXPR_COLUMN || node->column.array_idx) return NULL;
+  if (node->column.index >= schema->column_count || node->column.index >= PAGE_ZONE_COLUMNS) return NULL;
+
+  ColumnDefinition* column = &schema->columns[node->column.index];
+  return column->is_array ? NULL : column;
+}
+
+// the constant as the column compares it, refused when casting would move it
+static bool zone_literal_key(ExprNode* literal, ColumnDefinition* column, Database* db, ZoneKey* key) {
+  if (!literal || literal->type != EXPR_LITERAL) return false;
+
+  ColumnValue original = evaluate_literal_expression(literal, db);
+  ColumnValue value = original;
+  if (value.is_null || !infer_and_cast_value(&value, column) || !zone_key(&value, column->type, key)) return false;
+
+  if (is_integer_type(column->type)) return is_integer_type(original.type);
+
+  if (zone_key_is_float(column->type)) {
+    double exact;
+    return literal_as_double(&original, &exact) && key->d == exact;
+  }
+
+  return true;
+}
+
+static void zone_add_predicate(ZoneFilter* zf, ZonePredicate pred) {
+  if (zf->count < ZONE_MAX_PREDICATES) zf->preds[zf->count++] = pred;
+}
+
+static int flip_comparison(int op) {
+  switch (op) {
+    case TOK_LT: return TOK_GT;
+    case TOK_LE: return TOK_GE;
+    case TOK_GT: return TOK_LT;
+    case TOK_GE: return TOK_LE;
+    default: return op;
+  }
+}
+
+static void zone_collect(ZoneFilter* zf, ExprNode* node, TableSchema* schema, Database* db) {
+  if (!node) return;
+
+  switch (node->type) {
+    case EXPR_LOGICAL_AND:
+      zone_collect(zf, node->binary.left, schema, db);
+      zone_collect(zf, node->binary.right, schema, db);
+      return;
+
+    case EXPR_COMPARISON: {
+      int op = node->binary.op;
+      if (op != TOK_EQ && op != TOK_LT && op != TOK_LE && op != TOK_GT && op != TOK_GE) return;
+
+      ExprNode* column_node = node->binary.left;
+      ExprNode* literal = node->binary.right;
+      if (column_node->type != EXPR_COLUMN) {
+        column_node = node->binary.right;
+        literal = node->binary.left;
+        op = flip_comparison(op);
+      }
+
+      ColumnDefinition* column = zone_column(column_node, schema);
+      if (!column || !literal || literal->type != EXPR_LITERAL) return;
+
+      ZonePredicate pred = { .column = column_node->column.index, .type = column->type, .op = op };
+
+      if (literal->literal.is_null) {
+        if (op == TOK_EQ) {
+          pred.op = TOK_NL;
+          zone_add_predicate(zf, pred);
+        }
+        return;
+      }
+
+      if (zone_literal_key(literal, column, db, &pred.low)) {
+        pred.high = pred.low;
+        zone_add_predicate(zf, pred);
+      }
+      return;
+    }
+
+    case EXPR_BETWEEN: {
+      // BETWEEN compares as DOUBLE, so only numeric columns share its order
+      ColumnDefinition* column = zone_column(node->between.value, schema);
+      if (!column || !(is_integer_type(column->type) || zone_key_is_float(column->type))) return;
+
+      ExprNode* bounds[2] = { node->between.lower, node->between.upper };
+      double keys[2];
+      for (int i = 0; i < 2; i++) {
+        if (!bounds[i] || bounds[i]->type != EXPR_LITERAL || bounds[i]->literal.is_null) return;
+
+        ColumnValue value = evaluate_literal_expression(bounds[i], db);
+        if (!infer_and_cast_value_raw(&value, TOK_T_DOUBLE)) return;
+        keys[i] = value.double_value;
+      }
+
+      zone_add_predicate(zf, (ZonePredicate){
+        .column = node->between.value->column.index, .type = column->type, .op = TOK_BETWEEN,
+        .low.d = keys[0], .high.d = keys[1]
+      });
+      return;
+    }
+
+    default:
+      return;
+  }
+}
+
+void zone_filter_compile(ZoneFilter* zf, ExprNode* where, TableSchema* schema, Database* db) {
+  zf->count = 0;
+  if (!where || !schema) return;
+
+  zone_collect(zf, where, schema, db);
+}
+
+static int zone_compare(ZoneKey a, ZoneKey b, bool is_float) {
+  if (is_float) return (a.d > b.d) - (a.d < b.d);
+  return (a.i > b.i) - (a.i < b.i);
+}
+
+static double zone_double(ZoneKey key, uint8_t type) {
+  return zone_key_is_float(type) ? key.d : (double)key.i;
+}
+
+bool zone_filter_page_may_match(ZoneFilter* zf, Page* page) {
+  if (!zf || !page) return true;
+
+  for (uint8_t i = 0; i < zf->count; i++) {
+    ZonePredicate* pred = &zf->preds[i];
+    if (pred->column >= page->zone_count) continue;
+
+    PageZone* zone = &page->zones[pred->column];
+    if (zone->type != pred->type) continue;
+
+    if (pred->op == TOK_NL) {
+      if (zone->null_count == 0) return false;
+      continue;
+    }
+
+    // nothing but NULLs, which no comparison accepts
+    if (!zone->has_range) return false;
+
+    bool is_float = zone_key_is_float(zone->type);
+    bool excluded = false;
+
+    switch (pred->op) {
+      case TOK_EQ:
+        excluded = zone_compare(pred->low, zone->min, is_float) < 0 || zone_compare(pred->low, zone->max, is_float) > 0;
+        break;
+      case TOK_LT:
+        excluded = zone_compare(zone->min, pred->low, is_float) >= 0;
+        break;
+      case TOK_LE:
+        excluded = zone_compare(zone->min, pred->low, is_float) > 0;
+        break;
+      case TOK_GT:
+        excluded = zone_compare(zone->max, pred->low, is_float) <= 0;
+        break;
+      case TOK_GE:
+        excluded = zone_compare(zone->max, pred->low, is_float) < 0;
+        break;
+      case TOK_BETWEEN:
+        excluded = zone_double(zone->max, zone->type) < pred->low.d || zone_double(zone->min, zone->type) > pred->high.d;
+        break;
+    }
+
+    if (excluded) return false;
+  }
+
+  return true;
+}
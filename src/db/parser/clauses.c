@@ -149,7 +149,7 @@ bool parse_alter_add_constraint(Parser* parser, AlterTableCommand* cmd) {
   parser_consume(parser);
 
   if (parser->cur->type == TOK_PK) {
-    cmd->constraint.constraint_type = 1;  // PRIMARY KEY
+    cmd->constraint.constraint_type = ALTER_CONSTRAINT_PRIMARY_KEY;
     parser_consume(parser);
 
     if (parser->cur->type != TOK_LP) {
@@ -180,7 +180,7 @@ bool parse_alter_add_constraint(Parser* parser, AlterTableCommand* cmd) {
   }
 
   else if (parser->cur->type == TOK_UNQ) {
-    cmd->constraint.constraint_type = 2;  // UNIQUE
+    cmd->constraint.constraint_type = ALTER_CONSTRAINT_UNIQUE;
     parser_consume(parser);
 
     if (parser->cur->type != TOK_LP) {
@@ -214,7 +214,7 @@ bool parse_alter_add_constraint(Parser* parser, AlterTableCommand* cmd) {
   }
 
   else if (parser->cur->type == TOK_FK) {
-    cmd->constraint.constraint_type = 3;  // FOREIGN KEY
+    cmd->constraint.constraint_type = ALTER_CONSTRAINT_FOREIGN_KEY;
     parser_consume(parser);
 
     if (parser->cur->type != TOK_LP) {
@@ -327,7 +327,7 @@ bool parse_alter_add_constraint(Parser* parser, AlterTableCommand* cmd) {
   }
 
   else if (parser->cur->type == TOK_CHK) {
-    cmd->constraint.constraint_type = 4;  // CHECK
+    cmd->constraint.constraint_type = ALTER_CONSTRAINT_CHECK;
     parser_consume(parser);
 
     if (parser->cur->type != TOK_LP) {
@@ -451,11 +451,141 @@ bool parse_alter_set_tablespace(Parser* parser, AlterTableCommand* cmd) {
 }
 
 
+// clauses of a joined select resolve their columns against the joined row
+static TableSchema* clause_schema(Database* db, JQLCommand* command, uint32_t idx) {
+  return command->has_join ? command->join_schema : db->tc[idx].schema;
+}
+
+static void append_join_columns(TableSchema* joined, TableSchema* source) {
+  for (uint8_t i = 0; i < source->column_count; i++) {
+    ColumnDefinition* def = &joined->columns[joined->column_count++];
+    *def = source->columns[i];
+    snprintf(def->name, MAX_IDENTIFIER_LEN, "%.127s.%.127s", source->table_name, source->columns[i].name);
+
+    // joined rows are never stored, so no index or constraint of the source applies to them
+    def->is_primary_key = false;
+    def->is_unique = false;
+    def->is_index = false;
+    def->is_foreign_key = false;
+    def->has_constraints = false;
+  }
+}
+
+bool parse_join_schema(Parser* parser, Database* db, JQLCommand* command) {
+  parser_consume(parser);
+  if (parser->cur->type != TOK_ID) {
+    REPORT_ERROR(parser->lexer, "SYE_E_MISSING_TABLE_NAME");
+    return false;
+  }
+
+  TableSchema* left = get_validated_table(db, command->schema->table_name);
+  TableSchema* right = get_validated_table(db, parser->cur->value);
+  if (!left || !right) return false;
+
+  if (strcmp(left->table_name, right->table_name) == 0) {
+    LOG_ERROR("Joining `%s` with itself needs table aliases, which are not supported", left->table_name);
+    return false;
+  }
+
+  int column_count = left->column_count + right->column_count;
+  if (column_count >= MAX_COLUMNS) {
+    LOG_ERROR("Joined tables have %d columns, at most %d are supported", column_count, MAX_COLUMNS - 1);
+    return false;
+  }
+
+  TableSchema* schema = calloc(1, sizeof(TableSchema));
+  if (!schema) return false;
+
+  schema->columns = calloc(column_count, sizeof(ColumnDefinition));
+  if (!schema->columns) {
+    free(schema);
+    return false;
+  }
+
+  strcpy(schema->table_name, left->table_name);
+  append_join_columns(schema, left);
+  append_join_columns(schema, right);
+
+  strcpy(command->join_table, right->table_name);
+  command->join_schema = schema;
+  command->has_join = true;
+  return true;
+}
+
+void parse_join_clause(Parser* parser, JQLCommand* command) {
+  if (!command->has_join || parser->cur->type != TOK_JN) return;
+
+  // the joined table was validated while building the joined schema
+  parser_consume(parser);
+  parser_consume(parser);
+
+  if (parser->cur->type != TOK_ON) {
+    REPORT_ERROR(parser->lexer, "SYE_E_EXPECTED_ON_AFTER_JOIN");
+    return;
+  }
+
+  parser_consume(parser);
+  command->join_condition = parser_parse_expression(parser, command->join_schema);
+}
+
+// a parenthesized number between 0 and max
+static bool parse_sample_argument(Parser* parser, double max, double* out) {
+  if (parser->cur->type != TOK_LP) return false;
+  parser_consume(parser);
+
+  TokenType type = parser->cur->type;
+  if (type != TOK_L_UINT && type != TOK_L_INT && type != TOK_L_FLOAT && type != TOK_L_DOUBLE) return false;
+
+  char* endptr;
+  *out = strtod(parser->cur->value, &endptr);
+  if (*endptr != '\0' || *out < 0.0 || *out > max) return false;
+  parser_consume(parser);
+
+  if (parser->cur->type != TOK_RP) return false;
+  parser_consume(parser);
+  return true;
+}
+
+// TABLESAMPLE SYSTEM (p) keeps about p% of the table's pages, BERNOULLI (p) about p% of its rows
+bool parse_tablesample_clause(Parser* parser, JQLCommand* command) {
+  if (parser->cur->type != TOK_TABLESAMPLE) return true;
+  parser_consume(parser);
+
+  if (parser->cur->type == TOK_SYSTEM) {
+    command->sample_method = SAMPLE_SYSTEM;
+  } else if (parser->cur->type == TOK_BERNOULLI) {
+    command->sample_method = SAMPLE_BERNOULLI;
+  } else {
+    REPORT_ERROR(parser->lexer, "SYE_E_SAMPLE_METHOD");
+    return false;
+  }
+  parser_consume(parser);
+
+  if (!parse_sample_argument(parser, 100.0, &command->sample_percent)) {
+    REPORT_ERROR(parser->lexer, "SYE_E_SAMPLE_PERCENT");
+    return false;
+  }
+
+  command->sample_seed = (uint32_t)rand();
+  if (parser->cur->type == TOK_REPEATABLE) {
+    parser_consume(parser);
+
+    double seed;
+    if (!parse_sample_argument(parser, (double)UINT32_MAX, &seed)) {
+      REPORT_ERROR(parser->lexer, "SYE_E_SAMPLE_SEED");
+      return false;
+    }
+    command->sample_seed = (uint32_t)seed;
+  }
+
+  return true;
+}
+
 void parse_where_clause(Parser* parser, Database* db, JQLCommand* command, uint32_t idx) {
   if (parser->cur->type == TOK_WR) {
     parser_consume(parser);
     command->has_where = true;
-    command->where = parser_parse_expression(parser, db->tc[idx].schema);
+    command->where = parser_parse_expression(parser, clause_schema(db, command, idx));
   }
 }
 
@@ -489,6 +619,54 @@ void parse_offset_clause(Parser* parser, JQLCommand* command) {
   }
 }
 
+bool parse_group_by_clause(Parser* parser, Database* db, JQLCommand* command, uint32_t idx) {
+  if (parser->cur->type != TOK_GRP) return true;
+
+  parser_consume(parser);
+  if (parser->cur->type != TOK_BY) {
+    REPORT_ERROR(parser->lexer, "SYE_E_EXPECTED_BY_AFTER_GROUP");
+    return false;
+  }
+
+  parser_consume(parser);
+
+  TableSchema* schema = clause_schema(db, command, idx);
+  command->has_group_by = true;
+  command->group_by_count = 0;
+  command->group_by = calloc(schema->column_count, sizeof(uint8_t));
+
+  while (true) {
+    ExprNode* grp_expr = parser_parse_expression(parser, schema);
+    if (!grp_expr || grp_expr->type != EXPR_COLUMN) {
+      REPORT_ERROR(parser->lexer, "E_INVALID_GROUP_EXPRESSION");
+      free_expr_node(grp_expr);
+      return false;
+    }
+
+    if (command->group_by_count >= schema->column_count) {
+      LOG_ERROR("Got more GROUP basises (%d) than existing columns (%d)", command->group_by_count + 1, schema->column_count);
+      free_expr_node(grp_expr);
+      return false;
+    }
+
+    command->group_by[command->group_by_count++] = grp_expr->column.index;
+    free_expr_node(grp_expr);
+
+    if (parser->cur->type != TOK_COM) break;
+    parser_consume(parser);
+  }
+
+  return true;
+}
+
+void parse_having_clause(Parser* parser, Database* db, JQLCommand* command, uint32_t idx) {
+  if (parser->cur->type == TOK_HAV) {
+    parser_consume(parser);
+    command->has_having = true;
+    command->having = parser_parse_expression(parser, clause_schema(db, command, idx));
+  }
+}
+
 void parse_order_by_clause(Parser* parser, Database* db, JQLCommand* command, uint32_t idx) {
   if (parser->cur->type == TOK_ODR) {
     parser_consume(parser);
@@ -501,10 +679,11 @@ void parse_order_by_clause(Parser* parser, Database* db, JQLCommand* command, ui
 
     command->has_order_by = true;
     command->order_by_count = 0;
-    command->order_by = calloc(db->tc[idx].schema->column_count, (sizeof(bool) + (2 * sizeof(uint8_t))));
+    TableSchema* schema = clause_schema(db, command, idx);
+    command->order_by = calloc(schema->column_count, (sizeof(bool) + (2 * sizeof(uint8_t))));
 
     while (true) {
-      ExprNode* ord_expr = parser_parse_expression(parser, db->tc[idx].schema);
+      ExprNode* ord_expr = parser_parse_expression(parser, schema);
       if (!ord_expr || ord_expr->type != EXPR_COLUMN) {
         REPORT_ERROR(parser->lexer, "E_INVALID_ORDER_EXPRESSION");
         return;
@@ -523,8 +702,8 @@ void parse_order_by_clause(Parser* parser, Database* db, JQLCommand* command, ui
       command->order_by_count++;
 
       if (parser->cur->type != TOK_COM) break;
-      if (command->order_by_count > db->tc[idx].schema->column_count) {
-        LOG_ERROR("Got more ORDER basises (%d) than existing columns (%d)", command->order_by_count, db->tc[idx].schema->column_count);
+      if (command->order_by_count > schema->column_count) {
+        LOG_ERROR("Got more ORDER basises (%d) than existing columns (%d)", command->order_by_count, schema->column_count);
         return;
       }
       parser_consume(parser);
@@ -791,6 +970,21 @@ bool parser_parse_column_definition(Parser *parser, JQLCommand *command) {
         column.is_index = true;
         parser_consume(parser);
         break;
+      case TOK_CACHE:
+        if (!column.has_sequence) {
+          REPORT_ERROR(parser->lexer, "SYE_E_CACHE_SERIAL");
+          return false;
+        }
+        parser_consume(parser);
+
+        if (parser->cur->type != TOK_L_UINT || parser->cur->value[0] == '0') {
+          REPORT_ERROR(parser->lexer, "SYE_E_CACHE_VALUE", parser->cur->value);
+          return false;
+        }
+
+        column.sequence_cache = (uint32_t)strtoul(parser->cur->value, NULL, 10);
+        parser_consume(parser);
+        break;
       default:
         REPORT_ERROR(parser->lexer, "SYE_U_COLDEF", parser->cur->value);
         return false;
@@ -6,12 +6,14 @@ Parser* parser_init(Lexer* lexer) {
   
   parser->lexer = lexer;
   parser->cur = NULL;
+  parser->param_count = 0;
 
   return parser;
 }
 
 void parser_reset(Parser* parser) {
   parser->cur = lexer_next_token(parser->lexer);
+  parser->param_count = 0;
 }
 
 JQLCommand* jql_command_init(JQLCommandType type) {
@@ -39,10 +41,7 @@ JQLCommand* jql_command_init(JQLCommandType type) {
   memset(cmd->value_counts, 0, MAX_OPERATIONS);
   memset(cmd->conditions, 0, MAX_IDENTIFIER_LEN);
   memset(cmd->order_by, 0, MAX_IDENTIFIER_LEN);
-  memset(cmd->group_by, 0, MAX_IDENTIFIER_LEN);
-  memset(cmd->having, 0, MAX_IDENTIFIER_LEN);
   memset(cmd->join_table, 0, MAX_IDENTIFIER_LEN);
-  memset(cmd->join_condition, 0, MAX_IDENTIFIER_LEN);
   memset(cmd->transaction, 0, MAX_IDENTIFIER_LEN);
 
   return cmd;
@@ -190,6 +189,14 @@ AggregateType get_aggregate_type(const char* name) {
   if (strcmp(name, "VARIANCE") == 0) return AGG_VARIANCE;
   if (strcmp(name, "FIRST") == 0) return AGG_FIRST;
   if (strcmp(name, "LAST") == 0) return AGG_LAST;
+  if (strcmp(name, "MEDIAN") == 0) return AGG_MEDIAN;
+  if (strcmp(name, "MODE") == 0) return AGG_MODE;
+  if (strcmp(name, "STRING_AGG") == 0) return AGG_STRING_AGG;
+  if (strcmp(name, "GROUP_CONCAT") == 0) return AGG_GROUP_CONCAT;
+  if (strcmp(name, "BOOL_AND") == 0) return AGG_BOOL_AND;
+  if (strcmp(name, "BOOL_OR") == 0) return AGG_BOOL_OR;
+  if (strcmp(name, "APPROX_COUNT_DISTINCT") == 0) return AGG_APPROX_COUNT_DISTINCT;
+  if (strcmp(name, "APPROX_PERCENTILE") == 0) return AGG_APPROX_PERCENTILE;
 
   return NOT_AGG;
 }
@@ -672,6 +679,7 @@ void free_expr_node(ExprNode* node) {
     case EXPR_LIKE:
       free_expr_node(node->like.left);
       if (node->like.pattern) free(node->like.pattern);
+      like_free(node->like.matcher);
       break;
 
     case EXPR_BETWEEN:
@@ -752,10 +760,6 @@ void free_jql_command(JQLCommand* cmd) {
 
   // if (cmd->bitmap) free(cmd->bitmap);
 
-  if (cmd->has_where) {
-    free_expr_node(cmd->where);
-  }
-
   // if (cmd->values) {
   //   for (uint8_t i = 0; i < cmd->row_count; i++) {
   //     if (cmd->values[i]) {
@@ -806,4 +810,30 @@ void free_jql_command(JQLCommand* cmd) {
   if (cmd->order_by) {
     free(cmd->order_by);
   }
+
+  free(cmd->group_by);
+  if (cmd->has_having) {
+    free_expr_node(cmd->having);
+  }
+
+  if (cmd->has_join) {
+    free_expr_node(cmd->join_condition);
+    if (cmd->join_schema) free(cmd->join_schema->columns);
+    free(cmd->join_schema);
+  }
+
+  if (cmd->prepared) {
+    free_jql_command(cmd->prepared);
+    free(cmd->prepared);
+  }
+
+  free(cmd->cache_key);
+
+  if (cmd->params) {
+    for (uint16_t i = 0; i < cmd->param_count; i++) {
+      free_expr_node(cmd->params[i]);
+      free(cmd->params[i]);
+    }
+    free(cmd->params);
+  }
 }
\ No newline at end of file
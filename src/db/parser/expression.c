@@ -146,6 +146,35 @@ ExprNode* parser_parse_unary(Parser* parser, TableSchema* schema) {
   return parser_parse_primary(parser, schema); 
 }
 
+// joined schemas name their columns table.column, so a bare name resolves to the
+// one joined column carrying it; -2 flags an ambiguous reference already reported
+static int resolve_column_index(Parser* parser, TableSchema* schema, const char* table, const char* column) {
+  if (table) {
+    char qualified[MAX_IDENTIFIER_LEN];
+    snprintf(qualified, sizeof(qualified), "%s.%s", table, column);
+
+    int idx = find_column_index(schema, qualified);
+    if (idx == -1 && strcmp(schema->table_name, table) == 0) idx = find_column_index(schema, column);
+    return idx;
+  }
+
+  int idx = find_column_index(schema, column);
+  if (idx != -1) return idx;
+
+  for (uint8_t i = 0; i < schema->column_count; i++) {
+    const char* dot = strchr(schema->columns[i].name, '.');
+    if (!dot || strcmp(dot + 1, column) != 0) continue;
+
+    if (idx != -1) {
+      REPORT_ERROR(parser->lexer, "SYE_E_AMBIGUOUS_COLUMN", column);
+      return -2;
+    }
+    idx = i;
+  }
+
+  return idx;
+}
+
 ExprNode* parser_parse_primary(Parser* parser, TableSchema* schema) {
   if (parser->cur->type == TOK_LP) {
     parser_consume(parser);
@@ -162,7 +191,23 @@ ExprNode* parser_parse_primary(Parser* parser, TableSchema* schema) {
     char* ident = strdup(parser->cur->value);
     parser_consume(parser);
 
+    char* table = NULL;
+    if (parser->cur->type == TOK_DOT) {
+      parser_consume(parser);
+      if (parser->cur->type != TOK_ID) {
+        REPORT_ERROR(parser->lexer, "SYE_E_CNA");
+        free(ident);
+        return NULL;
+      }
+
+      table = ident;
+      ident = strdup(parser->cur->value);
+      parser_consume(parser);
+    }
+
     if (parser->cur->type == TOK_LP) {
+      free(table);
+
       ExprNode* node = calloc(1, sizeof(ExprNode));
       node->type = EXPR_FUNCTION;
       node->fn.name = ident;
@@ -170,9 +215,23 @@ ExprNode* parser_parse_primary(Parser* parser, TableSchema* schema) {
       node->fn.args = calloc(MAX_FN_ARGS, sizeof(ExprNode*));
       node->fn.arg_count = 0;
 
-      parser_consume(parser); 
+      parser_consume(parser);
 
-      if (parser->cur->type != TOK_RP) {
+      // COUNT(DISTINCT x) counts each value of x once
+      if (parser->cur->type == TOK_DST) {
+        if (node->fn.type != AGG_COUNT) {
+          REPORT_ERROR(parser->lexer, "SYE_E_DISTINCT_AGG");
+          return NULL;
+        }
+
+        node->fn.type = AGG_COUNT_DISTINCT;
+        parser_consume(parser);
+      }
+
+      // COUNT(*) and friends take no argument and see every row
+      if (node->fn.type != NOT_AGG && node->fn.type != AGG_COUNT_DISTINCT && parser->cur->type == TOK_MUL) {
+        parser_consume(parser);
+      } else if (parser->cur->type != TOK_RP) {
         while (true) {
           if (node->fn.arg_count >= MAX_FN_ARGS) {
             REPORT_ERROR(parser->lexer, "SYE_E_TOO_MANY_FN_ARGS");
@@ -202,11 +261,13 @@ ExprNode* parser_parse_primary(Parser* parser, TableSchema* schema) {
       return node;
     }
 
-    int col_index = find_column_index(schema, ident);
+    int col_index = resolve_column_index(parser, schema, table, ident);
+    free(table);
     if (col_index == -1) {
       REPORT_ERROR(parser->lexer, "SYE_E_UNKNOWN_COLUMN", ident);
       return NULL;
     }
+    if (col_index < 0) return NULL;
 
     ExprNode* base = calloc(1, sizeof(ExprNode));
     base->type = EXPR_COLUMN;
@@ -232,6 +293,23 @@ ExprNode* parser_parse_primary(Parser* parser, TableSchema* schema) {
     return base;
   }
 
+  // $n placeholders are bound per execution of a prepared statement
+  if (parser->cur->type == TOK_PARAM) {
+    long n = strtol(parser->cur->value, NULL, 10);
+    if (n < 1 || n > MAX_PARAMS) {
+      REPORT_ERROR(parser->lexer, "SYE_E_PARAM_RANGE", parser->cur->value, MAX_PARAMS);
+      return NULL;
+    }
+    parser_consume(parser);
+
+    ExprNode* node = calloc(1, sizeof(ExprNode));
+    node->type = EXPR_PARAMETER;
+    node->param = n - 1;
+
+    if (n > parser->param_count) parser->param_count = n;
+    return node;
+  }
+
   ColumnValue val;
   if (!parser_parse_value(parser, &val)) return NULL;
 
@@ -254,6 +332,7 @@ ExprNode* parser_parse_like(Parser* parser, TableSchema* schema, ExprNode* left)
   node->type = EXPR_LIKE;
   node->like.left = left;
   node->like.pattern = strdup(parser->cur->value);
+  node->like.matcher = like_compile(node->like.pattern);
 
   parser_consume(parser);
   return node;
@@ -11,14 +11,15 @@ char* keywords[NO_OF_KEYWORDS] = {
   "SELECT", "INSERT", "UPDATE", "DELETE", "CREATE", "DROP", "ALTER", "TABLE",
   "FROM", "WHERE", "AND", "OR", "NOT", "ORDER", "BY", "GROUP",
   "HAVING", "LIM", "OFFSET", "VALUES", "SET", "INTO", "AS", "JOIN",
-  "ON", "IN", "IS", "NULL", "DISCT", "PRIMKEY", "FRNKEY", "REFERENCES",
+  "ON", "IN", "IS", "NULL", "DISTINCT", "PRIMKEY", "FRNKEY", "REFERENCES",
   "INDEX", "CAST", "CASE", "WHEN", "THEN", "ELSE", "END", "DEFAULT",
   "CHECK", "UNIQUE", "CONSTRAINT", "INT", "VARCHAR", "CHAR", "TEXT", "BOOL",
   "FLOAT", "DOUBLE", "DECIMAL", "DATE", "TIME", "TIMETZ", "DATETIME", "DATETIMETZ",
   "TIMESTAMP", "TIMESTAMPTZ", "INTERVAL", "BLOB", "JSON", "UUID", "SERIAL", "true",
   "false", "UINT", "LIKE", "BETWEEN", "ASC", "DESC", "IF", "EXISTS",
   "CASCADE", "RESTRICT", "RETURNING", "TO", "RENAME", "TABLESPACE", "OWNER", "ADD",
-  "COLUMN", "_unsafecon"
+  "COLUMN", "_unsafecon", "PREPARE", "EXECUTE", "DEALLOCATE", "CACHE", "TABLESAMPLE", "SYSTEM",
+  "BERNOULLI", "REPEATABLE", "ANALYZE", "EXPLAIN"
 };
 
 uint8_t KWCHAR_TYPE_MAP[NO_OF_KEYWORDS] = {
@@ -32,7 +33,8 @@ uint8_t KWCHAR_TYPE_MAP[NO_OF_KEYWORDS] = {
   TOK_T_TIMESTAMP, TOK_T_TIMESTAMP_TZ, TOK_T_INTERVAL, TOK_T_BLOB, TOK_T_JSON, TOK_T_UUID, TOK_T_SERIAL, TOK_L_BOOL,
   TOK_L_BOOL, TOK_T_UINT, TOK_LIKE, TOK_BETWEEN, TOK_ASC, TOK_DESC, TOK_IF, TOK_EXISTS,
   TOK_CASCADE, TOK_RESTRICT, TOK_RETURNING, TOK_TO, TOK_RENAME, TOK_TABLESPACE, TOK_OWNER, TOK_KW_ADD,
-  TOK_KW_COL, TOK_NO_CONSTRAINTS
+  TOK_KW_COL, TOK_NO_CONSTRAINTS, TOK_PREPARE, TOK_EXECUTE, TOK_DEALLOCATE, TOK_CACHE, TOK_TABLESAMPLE, TOK_SYSTEM,
+  TOK_BERNOULLI, TOK_REPEATABLE, TOK_ANALYZE, TOK_EXPLAIN
 };
 
 Lexer* lexer_init() {
@@ -494,6 +496,9 @@ Token* lexer_handle_1char(Lexer* lexer) {
     case '\"':
       return lexer_process_double_quote(lexer);
       break;
+    case '$':
+      return lexer_process_parameter(lexer);
+      break;
     default:
       break;
   }
@@ -686,6 +691,25 @@ Token* lexer_process_double_quote(Lexer* lexer) {
   return lexer_next_token(lexer);
 }
 
+Token* lexer_process_parameter(Lexer* lexer) {
+  lexer_advance(lexer, 1);
+
+  if (!isdigit(lexer->c)) {
+    REPORT_ERROR(lexer, "E_PARAM_NUMBER");
+    lexer_handle_error(lexer);
+    return lexer_next_token(lexer);
+  }
+
+  char* buf = calloc(1, sizeof(char));
+  if (!buf) exit(EXIT_FAILURE);
+
+  lexer_process_digits(lexer, &buf, false);
+
+  Token* token = lexer_token_init(lexer, buf, TOK_PARAM);
+  free(buf);
+  return token;
+}
+
 struct ErrorTemplate templates[] = {
   {"SYE_UNSUPPORTED", "Unsupported syntax"},
   {"SYE_E_CNA", "Expected a column name"},
@@ -700,6 +724,21 @@ struct ErrorTemplate templates[] = {
   {"SYE_E_VARCHAR_VALUE", "Expected a value > 0 and <= 255 to specify number of charachters, not VARCHAR(%s)"},
   {"SYE_U_COLDEF", "Expected a proper column definition, not '%s'"},
   {"SYE_E_CDTYPE", "Expected a correct data type but got %s"},
+  {"SYE_E_AMBIGUOUS_COLUMN", "Column reference '%s' is ambiguous, qualify it with its table name"},
+  {"E_PARAM_NUMBER", "Expected a parameter number after '$'"},
+  {"SYE_E_PARAM_RANGE", "Parameter $%s is out of range, expected $1 to $%d"},
+  {"SYE_E_TOO_MANY_PARAMS", "A prepared statement takes at most %d parameters"},
+  {"SYE_E_NESTED_PREPARE", "Only SELECT, INSERT, UPDATE, DELETE, CREATE and ALTER statements can be prepared"},
+  {"SYE_E_EXPECTED_STATEMENT_NAME", "Expected a prepared statement name"},
+  {"SYE_E_EXPECTED_AS_AFTER_PREPARE", "Expected 'AS' after the prepared statement name"},
+  {"SYE_E_CACHE_VALUE", "Expected a number of values > 0 after CACHE, not '%s'"},
+  {"SYE_E_CACHE_SERIAL", "CACHE only applies to SERIAL columns"},
+  {"SYE_E_DISTINCT_AGG", "DISTINCT only applies to COUNT(...)"},
+  {"SYE_E_SAMPLE_METHOD", "Expected SYSTEM or BERNOULLI after TABLESAMPLE"},
+  {"SYE_E_SAMPLE_PERCENT", "Expected a sampling percentage between 0 and 100 in parentheses"},
+  {"SYE_E_SAMPLE_SEED", "Expected a non-negative seed in parentheses after REPEATABLE"},
+  {"SYE_E_SAMPLE_JOIN", "TABLESAMPLE cannot be combined with JOIN"},
+  {"SYE_E_EXPLAIN_STATEMENT", "Only SELECT, UPDATE and DELETE statements can be explained"},
   {"SYE_E_INVALID_VALUES", "Unexpected token '%s' (type %d), expected ',' or ')' while parsing VALUES list."}
 };
 
@@ -62,6 +62,7 @@ Token* lexer_process_minus_op(Lexer* lexer, char next_char);
 
 Token* lexer_process_single_quote(Lexer* lexer);
 Token* lexer_process_double_quote(Lexer* lexer);
+Token* lexer_process_parameter(Lexer* lexer);
 
 #ifndef REPORT_ERROR
 #define REPORT_ERROR lexer_report_error
@@ -5,8 +5,10 @@
 #include "utils/io.h"
 
 #include "internal/btree.h"
+#include "internal/bloom.h"
 #include "internal/toast.h"
 #include "internal/datetime.h"
+#include "internal/like.h"
 
 #include "utils/security.h"
 
@@ -20,6 +22,7 @@
 #define MAX_FN_ARGS 40
 #define MAX_LIKE_PATTERNS 32
 #define MAX_ARRAY_SIZE 2048
+#define MAX_PARAMS 64
 
 struct Database;
 typedef struct Database Database;
@@ -43,6 +46,11 @@ typedef enum JQLCommandType {
   CMD_CREATE,
   CMD_DROP,
   CMD_ALTER,
+  CMD_PREPARE,
+  CMD_EXECUTE,
+  CMD_DEALLOCATE,
+  CMD_ANALYZE,
+  CMD_EXPLAIN,
   CMD_UNKNOWN 
 } JQLCommandType;
 
@@ -105,6 +113,7 @@ typedef enum {
   EXPR_LOGICAL_NOT,
   EXPR_LOGICAL_AND,
   EXPR_LOGICAL_OR,
+  EXPR_PARAMETER,
 } ExprType;
 
 typedef enum AggregateType {
@@ -124,6 +133,8 @@ typedef enum AggregateType {
   AGG_LAST,            
   AGG_BOOL_AND,        // TRUE if all are TRUE
   AGG_BOOL_OR,         // TRUE if any are TRUE
+  AGG_APPROX_COUNT_DISTINCT, // HyperLogLog estimate
+  AGG_APPROX_PERCENTILE,     // t-digest estimate
   NOT_AGG
 } AggregateType;
 
@@ -133,6 +144,10 @@ typedef struct Function {
 
   ExprNode** args;
   uint8_t arg_count;
+
+  // set on grouped or aggregated queries: the finalized value lives in the row past the table's columns
+  bool grouped;
+  uint8_t group_slot;
 } Function;  
 
 typedef struct ExprNode {
@@ -160,6 +175,7 @@ typedef struct ExprNode {
     struct like {
       ExprNode* left;
       char* pattern;
+      LikeMatcher* matcher;
     } like;
 
     struct {
@@ -175,6 +191,8 @@ typedef struct ExprNode {
     } in;
 
     Function fn;  
+
+    uint16_t param; // $n is stored as slot n - 1
   };
 } ExprNode;
 
@@ -182,7 +200,7 @@ typedef struct ParsedConstraint {
   char constraint_name[MAX_IDENTIFIER_LEN];
   
   enum {
-    ALTER_CONSTRAINT_PRIMARY_KEY,
+    ALTER_CONSTRAINT_PRIMARY_KEY = 1,
     ALTER_CONSTRAINT_UNIQUE,
     ALTER_CONSTRAINT_FOREIGN_KEY,
     ALTER_CONSTRAINT_CHECK
@@ -199,13 +217,6 @@ typedef struct ParsedConstraint {
   FKAction on_delete, on_update;
 } ParsedConstraint;
 
-typedef struct FKConstraintValues {
-  ColumnValue* values;
-  uint32_t count;       
-  uint32_t capacity;  
-  uint8_t column_idx; 
-} FKConstraintValues;
-
 typedef struct {
   char name[MAX_IDENTIFIER_LEN];
 
@@ -216,6 +227,7 @@ typedef struct {
 
   bool has_sequence;
   int64_t sequence_id;
+  uint32_t sequence_cache; // values reserved per block, 0 for the default
 
   bool has_constraints;
   bool is_primary_key;
@@ -256,6 +268,10 @@ typedef struct {
   TableSchema* schema;
   BTree* btree[MAX_COLUMNS];
   bool is_populated;
+
+  BloomFilter* bloom[BLOOM_MAX_FILTERS];
+  uint8_t bloom_count;
+  bool bloom_loaded;
 } TableCatalogEntry;
 
 typedef struct SelectColumn {
@@ -337,7 +353,13 @@ typedef struct AlterTableCommand {
   bool is_invalid;
 } AlterTableCommand;
 
-typedef struct {
+typedef enum TableSampleMethod {
+  SAMPLE_NONE,
+  SAMPLE_SYSTEM,    // whole pages
+  SAMPLE_BERNOULLI, // individual rows
+} TableSampleMethod;
+
+typedef struct JQLCommand {
   JQLCommandType type;
   TableSchema* schema;
   char* schema_name;
@@ -356,6 +378,7 @@ typedef struct {
 
   SelectColumn* sel_columns;
   bool select_all;
+  bool is_distinct;
 
   UpdateColumn* update_columns;
 
@@ -375,15 +398,35 @@ typedef struct {
     bool decend;
   }* order_by; 
 
+  bool has_group_by;
+  uint8_t group_by_count;
+  uint8_t* group_by;
+
+  bool has_having;
+  ExprNode* having;
+
   AlterTableCommand* alter;
   ParsedConstraint constraint;
 
   char conditions[MAX_IDENTIFIER_LEN]; // WHERE conditions
-  char group_by[MAX_IDENTIFIER_LEN];  // GROUP BY clause
-  char having[MAX_IDENTIFIER_LEN];    // HAVING clause
 
+  bool has_join;
   char join_table[MAX_IDENTIFIER_LEN]; 
-  char join_condition[MAX_IDENTIFIER_LEN];
+  ExprNode* join_condition;
+  TableSchema* join_schema; // left columns then right columns, named table.column
+
+  TableSampleMethod sample_method;
+  double sample_percent;
+  uint32_t sample_seed; // REPEATABLE (n), otherwise drawn per statement
+
+  char statement_name[MAX_IDENTIFIER_LEN]; // PREPARE, EXECUTE and DEALLOCATE
+  struct JQLCommand* prepared; // the statement PREPARE stores or EXPLAIN describes
+  bool explain_analyze;        // EXPLAIN ANALYZE runs the statement as well
+  uint64_t parse_wall_ns;      // time EXPLAIN spent parsing the statement it describes
+  uint64_t parse_cpu_ns;
+  char* cache_key;   // fingerprint plus bound parameters, set when the result cache may answer a SELECT
+  ExprNode** params; // EXECUTE arguments
+  uint16_t param_count;
 
   int constraint_count;
 
@@ -410,6 +453,8 @@ typedef struct {
   Lexer* lexer;
   Token* cur;
   ParserState state;
+
+  uint16_t param_count; // highest $n seen since the last reset
 } Parser;
 
 typedef bool (*alter_handler_t)(Parser*, AlterTableCommand*);
@@ -431,6 +476,11 @@ JQLCommand parser_parse_select(Parser* parser, Database* db);
 JQLCommand parser_parse_update(Parser* parser, Database* db);
 JQLCommand parser_parse_delete(Parser* parser, Database* db);
 JQLCommand parser_parse_alter_table(Parser* parser, Database* db);
+JQLCommand parser_parse_prepare(Parser* parser, Database* db);
+JQLCommand parser_parse_execute(Parser* parser, Database* db);
+JQLCommand parser_parse_deallocate(Parser* parser, Database* db);
+JQLCommand parser_parse_analyze(Parser* parser, Database* db);
+JQLCommand parser_parse_explain(Parser* parser, Database* db);
 
 #endif // JQL_PARSER_STATEMENTS_H
 
@@ -466,9 +516,14 @@ ExprNode* parser_parse_like(Parser* parser, TableSchema* schema, ExprNode* left)
 ExprNode* parser_parse_between(Parser* parser, TableSchema* schema, ExprNode* left);
 ExprNode* parser_parse_in(Parser* parser, TableSchema* schema, ExprNode* left);
 
+bool parse_join_schema(Parser* parser, Database* db, JQLCommand* command);
+void parse_join_clause(Parser* parser, JQLCommand* command);
+bool parse_tablesample_clause(Parser* parser, JQLCommand* command);
 void parse_where_clause(Parser* parser, Database* db, JQLCommand* command, uint32_t idx);
 void parse_limit_clause(Parser* parser, JQLCommand* command);
 void parse_offset_clause(Parser* parser, JQLCommand* command);
+bool parse_group_by_clause(Parser* parser, Database* db, JQLCommand* command, uint32_t idx);
+void parse_having_clause(Parser* parser, Database* db, JQLCommand* command, uint32_t idx);
 void parse_order_by_clause(Parser* parser, Database* db, JQLCommand* command, uint32_t idx);
 bool parser_parse_column_definition(Parser *parser, JQLCommand *command);
 
@@ -14,29 +14,43 @@ static const AlterHandler __alter_handlers[] = {
   {TOK_SET, TOK_OWNER, parse_alter_set_owner}
 };
 
+typedef struct StatementHandler {
+  TokenType token;
+  JQLCommand (*handler)(Parser*, Database*);
+} StatementHandler;
+
+// the first N_PREPARABLE_STATEMENTS entries are the ones PREPARE may wrap
+#define N_PREPARABLE_STATEMENTS 6
+
+static const StatementHandler statement_handlers[] = {
+  {TOK_CRT, parser_parse_create_table},
+  {TOK_ALT, parser_parse_alter_table},
+  {TOK_INS, parser_parse_insert},
+  {TOK_SEL, parser_parse_select},
+  {TOK_UPD, parser_parse_update},
+  {TOK_DEL, parser_parse_delete},
+  {TOK_PREPARE, parser_parse_prepare},
+  {TOK_EXECUTE, parser_parse_execute},
+  {TOK_DEALLOCATE, parser_parse_deallocate},
+  {TOK_ANALYZE, parser_parse_analyze},
+  {TOK_EXPLAIN, parser_parse_explain}
+};
+
+static const StatementHandler* find_statement_handler(TokenType token, int count) {
+  for (int i = 0; i < count; i++) {
+    if (statement_handlers[i].token == token) return &statement_handlers[i];
+  }
+  return NULL;
+}
+
 JQLCommand parser_parse(Database* db) {
   while (db->parser->cur->type == TOK_SC) parser_consume(db->parser);
 
   JQLCommand command = {0};
   
-  static const struct {
-    TokenType token;
-    JQLCommand (*handler)(Parser*, Database*);
-  } handlers[] = {
-    {TOK_CRT, parser_parse_create_table},
-    {TOK_ALT, parser_parse_alter_table},
-    {TOK_INS, parser_parse_insert},
-    {TOK_SEL, parser_parse_select},
-    {TOK_UPD, parser_parse_update},
-    {TOK_DEL, parser_parse_delete}
-  };
-  
-  for (int i = 0; i < sizeof(handlers)/sizeof(handlers[0]); i++) {
-    if (db->parser->cur->type == handlers[i].token) {
-      command = handlers[i].handler(db->parser, db);
-      break;
-    }
-  }
+  int n_handlers = sizeof(statement_handlers)/sizeof(statement_handlers[0]);
+  const StatementHandler* handler = find_statement_handler(db->parser->cur->type, n_handlers);
+  if (handler) command = handler->handler(db->parser, db);
   
   if (db->parser->cur->type == TOK_EOF) return command;
   
@@ -227,9 +241,20 @@ JQLCommand parser_parse_select(Parser* parser, Database* db) {
   
   command.schema = calloc(1, sizeof(TableSchema));
   strcpy(command.schema->table_name, parser->cur->value);
+
+  // a joined select reads its columns off the left and right tables side by side
+  parser_consume(parser);
+  if (parser->cur->type == TOK_JN) {
+    if (!parse_join_schema(parser, db, &command)) return command;
+    schema = command.join_schema;
+  }
   
   parser_restore_state(parser, state);
-  
+
+  if (parser->cur->type == TOK_DST) {
+    command.is_distinct = true;
+    parser_consume(parser);
+  }
 
   command.sel_columns = calloc(MAX_COLUMNS, sizeof(SelectColumn));
   int column_count = 0;
@@ -279,11 +304,21 @@ JQLCommand parser_parse_select(Parser* parser, Database* db) {
   parser_expect_nc(parser, TOK_ID, "SYE_E_MISSING_TABLE_NAME");
   
   parser_consume(parser);
+  if (!parse_tablesample_clause(parser, &command)) return command;
+
+  // the join operator reads its tables without going through the sampled page loop
+  if (command.sample_method != SAMPLE_NONE && parser->cur->type == TOK_JN) {
+    REPORT_ERROR(parser->lexer, "SYE_E_SAMPLE_JOIN");
+    return command;
+  }
+  parse_join_clause(parser, &command);
 
   command.value_counts[0] = column_count;
   
   uint32_t idx = hash_fnv1a(command.schema->table_name, MAX_TABLES);
   parse_where_clause(parser, db, &command, idx);
+  if (!parse_group_by_clause(parser, db, &command, idx)) return command;
+  parse_having_clause(parser, db, &command, idx);
   parse_order_by_clause(parser, db, &command, idx);
   parse_limit_clause(parser, &command);
   parse_offset_clause(parser, &command);
@@ -339,7 +374,8 @@ JQLCommand parser_parse_update(Parser* parser, Database* db) {
     update_col->array_idx = (expr->type == EXPR_ARRAY_ACCESS) ? expr->column.array_idx : NULL;
     command.values[0][value_count] = value;
     
-    if (command.schema->columns[update_col->index].is_not_null /* && value->is_null */) {
+    if (command.schema->columns[update_col->index].is_not_null &&
+        value->type == EXPR_LITERAL && value->literal.is_null) {
       LOG_ERROR("Column is NOT NULL but attempted to set NULL");
       free_expr_node(expr);
       return command;
@@ -417,4 +453,159 @@ JQLCommand parser_parse_alter_table(Parser* parser, Database* db) {
   REPORT_ERROR(parser->lexer, "Unknown ALTER TABLE operation");
   free(alter_cmd);
   return command;
-}
\ No newline at end of file
+}
+
+JQLCommand parser_parse_prepare(Parser* parser, Database* db) {
+  JQLCommand command;
+  jql_command_plain_init(&command, CMD_PREPARE);
+
+  parser_consume(parser);
+  if (parser->cur->type != TOK_ID) {
+    REPORT_ERROR(parser->lexer, "SYE_E_EXPECTED_STATEMENT_NAME");
+    return command;
+  }
+  strncpy(command.statement_name, parser->cur->value, MAX_IDENTIFIER_LEN - 1);
+  parser_consume(parser);
+
+  if (parser->cur->type != TOK_AS) {
+    REPORT_ERROR(parser->lexer, "SYE_E_EXPECTED_AS_AFTER_PREPARE");
+    return command;
+  }
+  parser_consume(parser);
+
+  const StatementHandler* handler = find_statement_handler(parser->cur->type, N_PREPARABLE_STATEMENTS);
+  if (!handler) {
+    REPORT_ERROR(parser->lexer, "SYE_E_NESTED_PREPARE");
+    return command;
+  }
+
+  parser->param_count = 0;
+  JQLCommand prepared = handler->handler(parser, db);
+  if (prepared.is_invalid) return command;
+
+  command.prepared = malloc(sizeof(JQLCommand));
+  *command.prepared = prepared;
+  command.param_count = parser->param_count;
+  command.is_invalid = false;
+
+  return command;
+}
+
+JQLCommand parser_parse_execute(Parser* parser, Database* db) {
+  JQLCommand command;
+  jql_command_plain_init(&command, CMD_EXECUTE);
+
+  parser_consume(parser);
+  if (parser->cur->type != TOK_ID) {
+    REPORT_ERROR(parser->lexer, "SYE_E_EXPECTED_STATEMENT_NAME");
+    return command;
+  }
+  strncpy(command.statement_name, parser->cur->value, MAX_IDENTIFIER_LEN - 1);
+  parser_consume(parser);
+
+  command.params = calloc(MAX_PARAMS, sizeof(ExprNode*));
+
+  if (parser->cur->type == TOK_LP) {
+    parser_consume(parser);
+
+    // arguments are constant expressions, there is no table to take columns from
+    TableSchema no_columns = {0};
+
+    while (parser->cur->type != TOK_RP) {
+      if (command.param_count >= MAX_PARAMS) {
+        REPORT_ERROR(parser->lexer, "SYE_E_TOO_MANY_PARAMS", MAX_PARAMS);
+        return command;
+      }
+
+      ExprNode* arg = parser_parse_expression(parser, &no_columns);
+      if (!arg) return command;
+      command.params[command.param_count++] = arg;
+
+      if (parser->cur->type != TOK_COM) break;
+      parser_consume(parser);
+    }
+
+    if (parser->cur->type != TOK_RP) {
+      REPORT_ERROR(parser->lexer, "SYE_E_EXPECTED_RP");
+      return command;
+    }
+    parser_consume(parser);
+  }
+
+  command.is_invalid = false;
+  return command;
+}
+
+JQLCommand parser_parse_deallocate(Parser* parser, Database* db) {
+  JQLCommand command;
+  jql_command_plain_init(&command, CMD_DEALLOCATE);
+
+  parser_consume(parser);
+  if (parser->cur->type != TOK_ID) {
+    REPORT_ERROR(parser->lexer, "SYE_E_EXPECTED_STATEMENT_NAME");
+    return command;
+  }
+  strncpy(command.statement_name, parser->cur->value, MAX_IDENTIFIER_LEN - 1);
+  parser_consume(parser);
+
+  command.is_invalid = false;
+  return command;
+}
+
+JQLCommand parser_parse_analyze(Parser* parser, Database* db) {
+  JQLCommand command;
+  jql_command_plain_init(&command, CMD_ANALYZE);
+
+  parser_consume(parser);
+
+  // without a table name every table of the database is analyzed
+  if (parser->cur->type == TOK_ID) {
+    command.schema = malloc(sizeof(TableSchema));
+    strcpy(command.schema->table_name, parser->cur->value);
+
+    if (!get_validated_table(db, command.schema->table_name)) return command;
+    parser_consume(parser);
+  }
+
+  command.is_invalid = false;
+  return command;
+}
+
+static uint64_t parse_clock_ns(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+JQLCommand parser_parse_explain(Parser* parser, Database* db) {
+  JQLCommand command;
+  jql_command_plain_init(&command, CMD_EXPLAIN);
+
+  parser_consume(parser);
+  if (parser->cur->type == TOK_ANALYZE) {
+    command.explain_analyze = true;
+    parser_consume(parser);
+  }
+
+  TokenType type = parser->cur->type;
+  if (type != TOK_SEL && type != TOK_UPD && type != TOK_DEL) {
+    REPORT_ERROR(parser->lexer, "SYE_E_EXPLAIN_STATEMENT");
+    return command;
+  }
+
+  uint64_t wall = parse_clock_ns(CLOCK_MONOTONIC);
+  uint64_t cpu = parse_clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+
+  const StatementHandler* handler = find_statement_handler(type, N_PREPARABLE_STATEMENTS);
+  JQLCommand explained = handler->handler(parser, db);
+  if (explained.is_invalid) return command;
+
+  command.parse_wall_ns = parse_clock_ns(CLOCK_MONOTONIC) - wall;
+  command.parse_cpu_ns = parse_clock_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+
+  command.prepared = malloc(sizeof(JQLCommand));
+  *command.prepared = explained;
+  command.is_invalid = false;
+
+  return command;
+}
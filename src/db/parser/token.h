@@ -3,7 +3,7 @@
 
 #include <stdint.h>
 
-#define NO_OF_KEYWORDS 82
+#define NO_OF_KEYWORDS 92
 #define KEYWORDS keywords
 
 #define MAX_KEYWORD_LEN 11
@@ -69,6 +69,7 @@ typedef enum TokenType {
   TOK_COL,      // :
   TOK_PP,       // ||
   TOK_AA,       // &&
+  TOK_PARAM,    // $n (prepared statement parameter)
 
   // Slightly Shortened SQL Keywords
   TOK_SEL,      // SELECT
@@ -127,6 +128,16 @@ typedef enum TokenType {
   TOK_OWNER, // OWNER
   TOK_KW_ADD,      // ADD
   TOK_KW_COL,      // COLUMN
+  TOK_PREPARE,     // PREPARE
+  TOK_EXECUTE,     // EXECUTE
+  TOK_DEALLOCATE,  // DEALLOCATE
+  TOK_CACHE,       // CACHE
+  TOK_TABLESAMPLE, // TABLESAMPLE
+  TOK_SYSTEM,      // SYSTEM (page sampling)
+  TOK_BERNOULLI,   // BERNOULLI (row sampling)
+  TOK_REPEATABLE,  // REPEATABLE (sampling seed)
+  TOK_ANALYZE,     // ANALYZE
+  TOK_EXPLAIN,     // EXPLAIN
 
   // Sorting & Transactions
   TOK_ASC,      // ASC (Ascending Sort)
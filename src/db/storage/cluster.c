@@ -310,6 +310,125 @@ Result cluster_execute_all(ClusterManager* manager, char* cmd) {
   return (Result){result, NULL};
 }
 
+static JQLCommand* cluster_parse(Database* db, char* cmd) {
+  lexer_set_buffer(db->lexer, cmd);
+  parser_reset(db->parser);
+
+  JQLCommand* parsed = malloc(sizeof(JQLCommand));
+  if (!parsed) return NULL;
+
+  *parsed = parser_parse(db);
+  if (parsed->is_invalid) {
+    free_jql_command(parsed);
+    free(parsed);
+    return NULL;
+  }
+
+  return parsed;
+}
+
+/*
+  Runs a select list of aggregates on every database of the active cluster
+  and answers with one row for all of them. Each database only builds
+  partial states (sums, moments, HyperLogLog and t-digest sketches), which
+  are merged before a single finalize, so approximate distinct counts and
+  percentiles stay correct for the union instead of being added up.
+*/
+Result cluster_aggregate_all(ClusterManager* manager, char* cmd) {
+  if (!manager || manager->active_cluster < 0 || !cmd) {
+    return (Result){(ExecutionResult){-1, "No active cluster"}, NULL};
+  }
+
+  DbCluster* cluster = &manager->clusters[manager->active_cluster];
+  if (cluster->db_count == 0) {
+    return (Result){(ExecutionResult){-1, "Cluster has no databases"}, NULL};
+  }
+
+  JQLCommand* first = NULL;
+  AggregateState* merged = NULL;
+  AggregateState* states = NULL;
+  ExecutionResult result = {0, "Aggregates merged across the cluster"};
+  uint8_t count = 0;
+
+  for (int i = 0; i < cluster->db_count && result.code == 0; i++) {
+    Database* db = cluster->databases[i];
+    JQLCommand* parsed = db ? cluster_parse(db, cmd) : NULL;
+    if (!parsed) {
+      result = (ExecutionResult){1, "Failed to parse aggregate query"};
+      break;
+    }
+
+    if (!first) {
+      first = parsed;
+      count = parsed->value_counts[0];
+      merged = calloc(count ? count : 1, sizeof(AggregateState));
+      states = calloc(count ? count : 1, sizeof(AggregateState));
+      if (!merged || !states) {
+        result = (ExecutionResult){1, "Memory allocation failed for aggregate"};
+        break;
+      }
+    } else if (parsed->value_counts[0] != count) {
+      free_jql_command(parsed);
+      free(parsed);
+      result = (ExecutionResult){1, "Databases disagree on the aggregate query"};
+      break;
+    }
+
+    result = aggregate_select_states(db, parsed, states);
+
+    for (uint8_t k = 0; k < count; k++) {
+      if (result.code == 0) aggregate_state_merge(&merged[k], &states[k], &first->sel_columns[k].expr->fn);
+      aggregate_state_free(&states[k]);
+    }
+
+    if (parsed != first) {
+      free_jql_command(parsed);
+      free(parsed);
+    }
+  }
+
+  if (result.code == 0) {
+    Row* row = calloc(1, sizeof(Row));
+    char** aliases = malloc((count ? count : 1) * sizeof(char*));
+    ColumnValue* values = calloc(count ? count : 1, sizeof(ColumnValue));
+
+    if (!row || !aliases || !values) {
+      free(row);
+      free(aliases);
+      free(values);
+      result = (ExecutionResult){1, "Memory allocation failed for aggregate"};
+    } else {
+      for (uint8_t k = 0; k < count; k++) {
+        ExprNode* expr = first->sel_columns[k].expr;
+        values[k] = aggregate_state_finalize(&merged[k], &expr->fn);
+        aliases[k] = strdup(first->sel_columns[k].alias ? first->sel_columns[k].alias : expr->fn.name);
+      }
+
+      row->values = values;
+      row->n_values = count;
+      result.rows = row;
+      result.row_count = 1;
+      result.aliases = aliases;
+      result.alias_limit = count;
+      result.owns_rows = 1;
+    }
+  }
+
+  for (uint8_t k = 0; merged && k < count; k++) {
+    aggregate_state_free(&merged[k]);
+  }
+  free(merged);
+  free(states);
+
+  if (result.code != 0 && first) {
+    free_jql_command(first);
+    free(first);
+    first = NULL;
+  }
+
+  return (Result){result, first};
+}
+
 Result cluster_list(ClusterManager* manager) {
   ExecutionResult result = {0};
   
@@ -485,6 +604,31 @@ bool process_cluster_cmd(ClusterManager* manager, Database** current_db, char* i
     }
     return true;
   }
+  else if (strcmp(cmd, "agg") == 0) {
+    if (arg1[0] == '\0') {
+      LOG_ERROR("Aggregate query required");
+      return true;
+    }
+
+    char full_cmd[512] = {0};
+    if (arg2[0] != '\0') {
+      snprintf(full_cmd, sizeof(full_cmd), "%s %s", arg1, arg2);
+    } else {
+      strncpy(full_cmd, arg1, sizeof(full_cmd) - 1);
+    }
+
+    Result result = cluster_aggregate_all(manager, full_cmd);
+    if (result.exec.code == 0) {
+      for (uint32_t k = 0; k < result.exec.alias_limit; k++) {
+        printf("%s: ", result.exec.aliases[k]);
+        print_column_value(&result.exec.rows[0].values[k]);
+        printf("\n");
+      }
+    } else {
+      printf("Failed to aggregate across the cluster: %s\n", result.exec.message);
+    }
+    return true;
+  }
   
   LOG_ERROR("Unknown cluster command: %s", cmd);
   return true;  
@@ -42,6 +42,7 @@ bool cluster_switch(ClusterManager* manager, int cluster_idx);
 bool cluster_switch_db(ClusterManager* manager, int db_idx);
 Database* cluster_get_active_db(ClusterManager* manager);
 Result cluster_execute_all(ClusterManager* manager, char* cmd);
+Result cluster_aggregate_all(ClusterManager* manager, char* cmd);
 Result cluster_list(ClusterManager* manager);
 bool process_cluster_cmd(ClusterManager* manager, Database** current_db, char* input);
 bool is_cluster_cmd(char* input);
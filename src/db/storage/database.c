@@ -58,6 +58,7 @@ Database* db_init(char* dir, Database* core) {
   db->wal = wal_open(db->fs->wal_file, "w+b");
 
   db->core = core;
+  db->sort_memory = DEFAULT_SORT_MEMORY;
 
   load_tc(db);
   if (!load_initial_schema(db)) {
@@ -78,6 +79,12 @@ void db_free(Database* db) {
   io_close(db->tc_writer);
   io_close(db->tc_appender);
   flush_lake(db);
+  worker_pool_free(db->workers);
+  free_prepared_statements(db);
+  catalog_free(db);
+  sequence_cache_free(db);
+  statistics_free(db);
+  result_cache_free(db);
 
   for (int i = 0; i < BTREE_LIFETIME_THRESHOLD; i++) {
     uint32_t idx = db->btree_idx_stack[i];
@@ -104,6 +111,8 @@ void db_free(Database* db) {
   }
 
   for (int i = 0; i < MAX_TABLES; i++) {
+    unload_table_blooms(db, i);
+
     TableSchema* schema = db->tc[i].schema;
     free_table_schema(schema);
   }
@@ -459,6 +468,86 @@ void pop_btree_cluster(Database* db) {
   db->loaded_btree_clusters--;
 }
 
+void load_table_blooms(Database* db, TableSchema* schema) {
+  uint8_t idx = hash_fnv1a(schema->table_name, MAX_TABLES);
+  TableCatalogEntry* tc = &db->tc[idx];
+
+  tc->bloom_loaded = true;
+
+  char bloom_file_path[MAX_PATH_LENGTH];
+  snprintf(bloom_file_path, sizeof(bloom_file_path), "%s" SEP "%s" SEP "constraints.bloom",
+          db->fs->tables_dir, schema->table_name);
+
+  FILE* fp = fopen(bloom_file_path, "rb");
+  if (!fp) return;
+
+  uint32_t magic = 0;
+  uint8_t filter_count = 0;
+  bool is_invalid = false;
+
+  eof_fread(&magic, sizeof(uint32_t), 1, fp, &is_invalid);
+  eof_fread(&filter_count, sizeof(uint8_t), 1, fp, &is_invalid);
+
+  if (is_invalid || magic != BLOOM_FILE_MAGIC) {
+    LOG_WARN("Discarding unreadable bloom filters for '%s'", schema->table_name);
+    filter_count = 0;
+  }
+
+  for (uint8_t i = 0; i < filter_count && tc->bloom_count < BLOOM_MAX_FILTERS; i++) {
+    BloomFilter* filter = load_bloom(fp);
+
+    if (!filter) {
+      LOG_WARN("Discarding truncated bloom filters for '%s'", schema->table_name);
+      for (uint8_t j = 0; j < tc->bloom_count; j++) {
+        bloom_destroy(tc->bloom[j]);
+        tc->bloom[j] = NULL;
+      }
+      tc->bloom_count = 0;
+      break;
+    }
+
+    tc->bloom[tc->bloom_count++] = filter;
+  }
+
+  fclose(fp);
+
+  // filters now live in memory; a stale file must not outlive an unclean shutdown
+  remove(bloom_file_path);
+}
+
+void unload_table_blooms(Database* db, uint8_t idx) {
+  TableCatalogEntry* tc = &db->tc[idx];
+
+  if (tc->bloom_count > 0 && tc->schema) {
+    char bloom_file_path[MAX_PATH_LENGTH];
+    snprintf(bloom_file_path, sizeof(bloom_file_path), "%s" SEP "%s" SEP "constraints.bloom",
+            db->fs->tables_dir, tc->schema->table_name);
+
+    FILE* fp = fopen(bloom_file_path, "wb");
+    if (fp) {
+      uint32_t magic = BLOOM_FILE_MAGIC;
+      fwrite(&magic, sizeof(uint32_t), 1, fp);
+      fwrite(&tc->bloom_count, sizeof(uint8_t), 1, fp);
+
+      for (uint8_t i = 0; i < tc->bloom_count; i++) {
+        save_bloom(tc->bloom[i], fp);
+      }
+
+      fclose(fp);
+    } else {
+      LOG_WARN("Failed to persist bloom filters to '%s'", bloom_file_path);
+    }
+  }
+
+  for (uint8_t i = 0; i < tc->bloom_count; i++) {
+    bloom_destroy(tc->bloom[i]);
+    tc->bloom[i] = NULL;
+  }
+
+  tc->bloom_count = 0;
+  tc->bloom_loaded = false;
+}
+
 bool load_schema_tc(Database* db, char* table_name) {
   if (!db || !db->tc_reader) {
     LOG_ERROR("No database file is open.");
@@ -12,9 +12,18 @@
 #define MAX_COMMANDS 1024
 #define MAX_TABLES 256 
 #define DB_INIT_MAGIC 0x4A554741  // "JUGA" 
+#define DEFAULT_SORT_MEMORY (4 * 1024 * 1024)
+#define MAX_SCAN_THREADS 32
 
 typedef struct Database Database;
 typedef struct ClusterManager ClusterManager;
+typedef struct WorkerPool WorkerPool;
+typedef struct PreparedStatement PreparedStatement;
+typedef struct CatalogCache CatalogCache;
+typedef struct SequenceCache SequenceCache;
+typedef struct TableStatistics TableStatistics;
+typedef struct QueryProfile QueryProfile;
+typedef struct ResultCache ResultCache;
 
 typedef struct Database {
   Lexer* lexer;
@@ -35,6 +44,18 @@ typedef struct Database {
 
   FS* fs;
   Database* core;
+
+  size_t sort_memory;
+  size_t result_cache_memory; // 0 leaves the result cache off
+  uint32_t scan_threads;
+  WorkerPool* workers;
+
+  PreparedStatement* prepared; // named statements, newest first
+  CatalogCache* catalog; // only populated on the core database
+  SequenceCache* sequences; // reserved value blocks, core database only
+  TableStatistics* statistics[MAX_TABLES]; // built the first time a table is planned
+  QueryProfile* profile;                   // set by EXPLAIN ANALYZE for the statement it runs
+  ResultCache* results;                    // allocated once a SELECT is cached
 } Database;
 
 Database* db_init(char* dir, Database* core);
@@ -49,6 +70,9 @@ void load_table_schema(Database* db);
 void load_btree_cluster(Database* db, char* table_name);
 void pop_btree_cluster(Database* db);
 
+void load_table_blooms(Database* db, TableSchema* schema);
+void unload_table_blooms(Database* db, uint8_t idx);
+
 bool load_schema_tc(Database* db, char* table_name);
 TableSchema* get_table_schema(Database* db, const char* filename);
 bool load_initial_schema(Database* db);
@@ -74,6 +74,9 @@ FS* fs_init(char* root_directory) {
   fs->config_dir = malloc(MAX_PATH_LENGTH);
   snprintf(fs->config_dir, MAX_PATH_LENGTH, "%s" SEP "config", root_directory);
 
+  fs->tmp_dir = malloc(MAX_PATH_LENGTH);
+  snprintf(fs->tmp_dir, MAX_PATH_LENGTH, "%s" SEP "tmp", root_directory);
+
   fs->global_transaction_log = malloc(MAX_PATH_LENGTH);
   snprintf(fs->global_transaction_log, MAX_PATH_LENGTH, "%s" SEP "logs" SEP "global_transaction_log", root_directory);
 
@@ -93,6 +96,7 @@ FS* fs_init(char* root_directory) {
   log_directory_status(fs->logs_dir, "logs", &any_directory_created);
   log_directory_status(fs->backups_dir, "backups", &any_directory_created);
   log_directory_status(fs->config_dir, "config", &any_directory_created);
+  log_directory_status(fs->tmp_dir, "tmp", &any_directory_created);
 
   char schema_dir[MAX_PATH_LENGTH];
   fs->schema_file = malloc(MAX_PATH_LENGTH);
@@ -117,6 +121,7 @@ void fs_free(FS* fs) {
   free(fs->logs_dir);
   free(fs->backups_dir);
   free(fs->config_dir);
+  free(fs->tmp_dir);
   free(fs->global_transaction_log);
   free(fs->db_config_file);
   free(fs->logging_config_file);
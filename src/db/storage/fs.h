@@ -56,6 +56,7 @@ typedef struct {
   char* logs_dir;
   char* backups_dir;
   char* config_dir;
+  char* tmp_dir;
   char* global_transaction_log;
   char* db_config_file;
   char* schema_file;
@@ -21,7 +21,10 @@ Page* page_init(uint32_t pg_n) {
 
   page->page_id = pg_n;          
   page->num_rows = 0;         
-  page->free_space = PAGE_SIZE; 
+  page->free_space = PAGE_SIZE - PAGE_HEADER_SIZE; 
+  page->format = PAGE_FORMAT_VERSION;
+  page->zone_count = 0;
+  page->image = NULL;
 
   page->is_dirty = false;    
   page->is_full = false;   
@@ -29,45 +32,223 @@ Page* page_init(uint32_t pg_n) {
   return page; 
 }
 
-void read_page(FILE* file, uint64_t page_number, Page* page, TableCatalogEntry tc) {
+static void read_page_rows(FILE* file, uint64_t page_number, Page* page, TableCatalogEntry tc) {
   fseek(file, page_number * PAGE_SIZE, SEEK_SET);
 
   fread(&page->page_id, sizeof(page->page_id), 1, file);
   fread(&page->num_rows, sizeof(page->num_rows), 1, file);
   fread(&page->free_space, sizeof(page->free_space), 1, file);
 
+  uint32_t magic = 0;
+  fread(&magic, sizeof(magic), 1, file);
+
+  page->zone_count = 0;
+  if (magic == PAGE_FORMAT_MAGIC) {
+    fread(&page->format, sizeof(page->format), 1, file);
+    fread(&page->zone_count, sizeof(page->zone_count), 1, file);
+  } else if (page->num_rows > 0) {
+    page->format = PAGE_FORMAT_LEGACY;
+  } else {
+    // nothing on an empty page ties it to the older layout
+    page->format = PAGE_FORMAT_VERSION;
+    page->free_space = PAGE_SIZE - PAGE_HEADER_SIZE;
+  }
+  if (page->zone_count > PAGE_ZONE_COLUMNS) page->zone_count = 0;
+
+  for (int i = 0; i < page->zone_count; i++) {
+    PageZone* zone = &page->zones[i];
+    fread(&zone->type, sizeof(zone->type), 1, file);
+    fread(&zone->has_range, sizeof(zone->has_range), 1, file);
+    fread(&zone->null_count, sizeof(zone->null_count), 1, file);
+    fread(&zone->min, sizeof(ZoneKey), 1, file);
+    fread(&zone->max, sizeof(ZoneKey), 1, file);
+  }
+
+  uint32_t header_size = page->format == PAGE_FORMAT_LEGACY ? PAGE_LEGACY_HEADER_SIZE : PAGE_HEADER_SIZE;
+  fseek(file, page_number * PAGE_SIZE + header_size, SEEK_SET);
+
+  if (page->num_rows > PAGE_ROW_CAPACITY) page->num_rows = PAGE_ROW_CAPACITY;
+  if (page->num_rows == 0) return;
+
+  // the values stay encoded until a query asks for their columns
+  PageImage* image = calloc(1, sizeof(PageImage));
+  uint8_t* bytes = image ? malloc(PAGE_SIZE - header_size) : NULL;
+  if (!bytes) {
+    LOG_ERROR("Failed to allocate memory for page image");
+    free(image);
+    page->num_rows = 0;
+    return;
+  }
+
+  image->bytes = bytes;
+  image->size = fread(bytes, 1, PAGE_SIZE - header_size, file);
+  page->image = image;
+
+  uint32_t at = 0;
   for (int i = 0; i < page->num_rows; i++) {
     Row* row = &page->rows[i];
+    uint32_t header = sizeof(row->id.page_id) + sizeof(row->id.row_id) +
+                      sizeof(row->row_length) + sizeof(row->null_bitmap_size);
 
-    fread(&row->id.page_id, sizeof(row->id.page_id), 1, file);
-    fread(&row->id.row_id, sizeof(row->id.row_id), 1, file);
+    if (image->size - at < header) {
+      LOG_ERROR("Page %lu ends inside row %d", page_number, i);
+      page->num_rows = i;
+      break;
+    }
 
-    fread(&row->row_length, sizeof(row->row_length), 1, file);
+    memcpy(&row->id.page_id, bytes + at, sizeof(row->id.page_id));
+    at += sizeof(row->id.page_id);
+    memcpy(&row->id.row_id, bytes + at, sizeof(row->id.row_id));
+    at += sizeof(row->id.row_id);
+    memcpy(&row->row_length, bytes + at, sizeof(row->row_length));
+    at += sizeof(row->row_length);
+    memcpy(&row->null_bitmap_size, bytes + at, sizeof(row->null_bitmap_size));
+    at += sizeof(row->null_bitmap_size);
 
-    fread(&row->null_bitmap_size, sizeof(row->null_bitmap_size), 1, file);
-    row->null_bitmap = malloc(row->null_bitmap_size);
-    if (row->null_bitmap && row->null_bitmap_size > 0) {
-      fread(row->null_bitmap, row->null_bitmap_size, 1, file);
-    }
+    uint8_t bitmap_size = (tc.schema->column_count + 7) / 8;
+    if (row->null_bitmap_size > bitmap_size) bitmap_size = row->null_bitmap_size;
 
+    row->null_bitmap = calloc(bitmap_size, 1);
     row->values = calloc(tc.schema->column_count, sizeof(ColumnValue));
     row->n_values = tc.schema->column_count;
-    for (int j = 0; j < tc.schema->column_count; j++) {
-      row->values[j].is_null = (row->null_bitmap[j / 8] >> (j % 8)) & 1;
+    row->owns_strings = false;
+    row->deleted = false; // write_page leaves deleted rows out
+    if (!row->null_bitmap || !row->values || image->size - at < row->null_bitmap_size) {
+      LOG_ERROR("Failed to read row %d of page %lu", i, page_number);
+      page->num_rows = i;
+      break;
     }
 
+    memcpy(row->null_bitmap, bytes + at, row->null_bitmap_size);
+    at += row->null_bitmap_size;
+
     for (int j = 0; j < tc.schema->column_count; j++) {
-      ColumnDefinition* col_def = &tc.schema->columns[j];
+      row->values[j].is_null = true;
+    }
 
-      if (!row->values[j].is_null && col_def) {
-        read_column_value(file, &row->values[j], col_def);
+    image->offsets[i] = at;
+    image->row_count = i + 1;
+
+    // walk past the stored values to find where the next row starts
+    for (int j = 0; j < tc.schema->column_count; j++) {
+      if ((row->null_bitmap[j / 8] >> (j % 8)) & 1) continue;
+
+      uint32_t length = at < image->size ?
+        read_column_value_from_buffer(bytes + at, image->size - at, NULL, &tc.schema->columns[j]) : 0;
+      if (length == 0) {
+        LOG_ERROR("Page %lu has an unreadable value in row %d", page_number, i);
+        page->num_rows = i;
+        image->row_count = i;
+        return;
       }
+      at += length;
     }
 
     LOG_DEBUG("Read rid: %d, %d", row->id.page_id, row->id.row_id);
   }
 }
 
+void read_page(FILE* file, uint64_t page_number, Page* page, TableCatalogEntry tc) {
+  read_page_rows(file, page_number, page, tc);
+  if (page->format != PAGE_FORMAT_LEGACY) return;
+
+  // the older layout stores no zones, they come from the rows' own values
+  uint8_t columns[PAGE_COLUMN_BYTES] = {0};
+  for (uint8_t j = 0; j < tc.schema->column_count && j < PAGE_ZONE_COLUMNS; j++) {
+    columns[j / 8] |= 1 << (j % 8);
+  }
+
+  page_materialize(page, tc.schema, columns);
+  page_zone_rebuild(page, tc.schema);
+}
+
+static bool stored_is_null(Row* row, uint8_t column) {
+  return (row->null_bitmap[column / 8] >> (column % 8)) & 1;
+}
+
+static bool column_in(const uint8_t* columns, uint8_t column) {
+  return !columns || ((columns[column / 8] >> (column % 8)) & 1);
+}
+
+static void page_image_free(Page* page) {
+  if (!page->image) return;
+
+  free(page->image->bytes);
+  free(page->image);
+  page->image = NULL;
+}
+
+void page_materialize_row(Page* page, uint16_t row_idx, TableSchema* schema, const uint8_t* columns) {
+  PageImage* image = page ? page->image : NULL;
+  if (!image || row_idx >= image->row_count) return;
+
+  Row* row = &page->rows[row_idx];
+  if (!row->values || !row->null_bitmap || row->deleted) return;
+
+  uint8_t column_count = schema->column_count < row->n_values ? schema->column_count : row->n_values;
+
+  // nothing to walk for when every wanted value is either stored NULL or already decoded
+  int last = -1;
+  for (uint8_t j = 0; j < column_count; j++) {
+    if (column_in(columns, j) && !column_in(image->decoded, j) &&
+        row->values[j].is_null && !stored_is_null(row, j)) {
+      last = j;
+    }
+  }
+  if (last < 0) return;
+
+  uint32_t at = image->offsets[row_idx];
+  for (int j = 0; j <= last; j++) {
+    if (stored_is_null(row, j)) continue;
+
+    ColumnValue* value = &row->values[j];
+    bool pending = value->is_null && column_in(columns, j) && !column_in(image->decoded, j);
+
+    ColumnValue decoded = {0};
+    uint32_t length = at < image->size ?
+      read_column_value_from_buffer(image->bytes + at, image->size - at, pending ? &decoded : NULL, &schema->columns[j]) : 0;
+    if (length == 0) return;
+
+    if (pending) *value = decoded;
+    at += length;
+  }
+}
+
+void page_materialize(Page* page, TableSchema* schema, const uint8_t* columns) {
+  PageImage* image = page ? page->image : NULL;
+  if (!image || !schema) return;
+
+  uint8_t wanted[PAGE_COLUMN_BYTES];
+  bool any = false;
+  for (int i = 0; i < PAGE_COLUMN_BYTES; i++) {
+    wanted[i] = (columns ? columns[i] : 0xff) & ~image->decoded[i];
+    any |= wanted[i] != 0;
+  }
+  if (!any) return;
+
+  for (uint16_t i = 0; i < image->row_count; i++) {
+    page_materialize_row(page, i, schema, wanted);
+  }
+
+  bool complete = true;
+  for (int j = 0; j < PAGE_COLUMN_BYTES; j++) {
+    image->decoded[j] |= wanted[j];
+  }
+  for (uint8_t j = 0; j < schema->column_count; j++) {
+    complete &= column_in(image->decoded, j);
+  }
+
+  if (complete) page_image_free(page);
+}
+
+void pool_materialize(BufferPool* pool, TableSchema* schema) {
+  if (!pool || !schema) return;
+
+  for (uint8_t i = 0; i < pool->num_pages; i++) {
+    page_materialize(pool->pages[i], schema, NULL);
+  }
+}
+
 void read_array_value(FILE* file, ColumnValue* col_val, ColumnDefinition* col_def) {
   if (!file || !col_val || !col_def) {
     LOG_ERROR("Invalid input to read_array_value.\n");
@@ -218,9 +399,138 @@ void read_column_value(FILE* file, ColumnValue* col_val, ColumnDefinition* col_d
   }
 }
 
+// decodes one stored value, or only measures it when col_val is NULL; 0 means it does not fit in size
+uint32_t read_column_value_from_buffer(const uint8_t* buffer, uint32_t size, ColumnValue* col_val, ColumnDefinition* col_def) {
+  if (!buffer || !col_def) return 0;
+
+  uint32_t offset = 0;
+  uint16_t str_len;
+
+  if (col_def->is_array) {
+    if (size < sizeof(uint16_t)) return 0;
+
+    uint16_t len;
+    memcpy(&len, buffer, sizeof(uint16_t));
+    offset += sizeof(uint16_t);
+
+    ColumnDefinition base_def = *col_def;
+    base_def.is_array = false;
+
+    if (col_val) {
+      col_val->is_array = true;
+      col_val->array.array_size = len;
+      col_val->array.array_value = calloc(len, sizeof(ColumnValue));
+      if (len && !col_val->array.array_value) return 0;
+    }
+
+    for (int i = 0; i < len; i++) {
+      uint32_t length = read_column_value_from_buffer(buffer + offset, size - offset,
+        col_val ? &col_val->array.array_value[i] : NULL, &base_def);
+      if (length == 0) return 0;
+      offset += length;
+    }
+
+    return offset;
+  }
+
+  uint32_t fixed = 0;
+  switch (col_def->type) {
+    case TOK_T_CHAR:         fixed = sizeof(char); break;
+    case TOK_T_INT:
+    case TOK_T_UINT:
+    case TOK_T_SERIAL:       fixed = sizeof(int64_t); break;
+    case TOK_T_BOOL:         fixed = sizeof(uint8_t); break;
+    case TOK_T_FLOAT:        fixed = sizeof(float); break;
+    case TOK_T_DOUBLE:       fixed = sizeof(double); break;
+    case TOK_T_DECIMAL:      fixed = 2 * sizeof(int) + MAX_DECIMAL_LEN; break;
+    case TOK_T_UUID:         fixed = 16; break;
+    case TOK_T_DATE:         fixed = sizeof(Date); break;
+    case TOK_T_TIME:         fixed = sizeof(TimeStored); break;
+    case TOK_T_TIME_TZ:      fixed = sizeof(Time_TZ); break;
+    case TOK_T_DATETIME:     fixed = sizeof(DateTime); break;
+    case TOK_T_DATETIME_TZ:  fixed = sizeof(DateTime_TZ); break;
+    case TOK_T_TIMESTAMP:    fixed = sizeof(Timestamp); break;
+    case TOK_T_TIMESTAMP_TZ: fixed = sizeof(Timestamp_TZ); break;
+    case TOK_T_INTERVAL:     fixed = sizeof(Interval); break;
+    default: break;
+  }
+
+  if (col_val) col_val->type = col_def->type;
+
+  if (fixed) {
+    if (size < fixed) return 0;
+    if (!col_val) return fixed;
+
+    switch (col_def->type) {
+      case TOK_T_CHAR:
+      case TOK_T_UUID:
+        col_val->str_value = calloc(17, sizeof(char));
+        if (!col_val->str_value) return 0;
+        memcpy(col_val->str_value, buffer, fixed);
+        break;
+      case TOK_T_BOOL:
+        col_val->bool_value = buffer[0] ? true : false;
+        break;
+      case TOK_T_DECIMAL:
+        memcpy(&col_val->decimal.precision, buffer, sizeof(int));
+        memcpy(&col_val->decimal.scale, buffer + sizeof(int), sizeof(int));
+        memcpy(col_val->decimal.decimal_value, buffer + 2 * sizeof(int), MAX_DECIMAL_LEN);
+        break;
+      default:
+        // the remaining fixed width types all start the value union
+        memcpy(&col_val->int_value, buffer, fixed);
+        break;
+    }
+
+    return fixed;
+  }
+
+  switch (col_def->type) {
+    case TOK_T_VARCHAR:
+      break;
+
+    case TOK_T_TEXT:
+    case TOK_T_JSON:
+    case TOK_T_BLOB: {
+      if (size < sizeof(bool)) return 0;
+
+      bool is_toast_pointer = buffer[0] != 0;
+      offset += sizeof(bool);
+      if (col_val) col_val->is_toast = is_toast_pointer;
+
+      if (is_toast_pointer) {
+        if (size - offset < sizeof(uint32_t)) return 0;
+        if (col_val) memcpy(&col_val->toast_object, buffer + offset, sizeof(uint32_t));
+        return offset + sizeof(uint32_t);
+      }
+      break;
+    }
+
+    default:
+      LOG_ERROR("Unsupported data type in read_column_value_from_buffer.\n");
+      return 0;
+  }
+
+  if (size - offset < sizeof(uint16_t)) return 0;
+  memcpy(&str_len, buffer + offset, sizeof(uint16_t));
+  offset += sizeof(uint16_t);
+  if (size - offset < str_len) return 0;
+
+  if (col_val) {
+    col_val->str_value = malloc(str_len + 1);
+    if (!col_val->str_value) return 0;
+    memcpy(col_val->str_value, buffer + offset, str_len);
+    col_val->str_value[str_len] = '\0';
+  }
+
+  return offset + str_len;
+}
+
 void write_page(FILE* file, uint64_t page_number, Page* page, TableCatalogEntry tc) {
   if (!file || !page) return;
 
+  page_materialize(page, tc.schema, NULL);
+
   fseek(file, page_number * PAGE_SIZE, SEEK_SET);
 
   fwrite(&page->page_id, sizeof(page->page_id), 1, file);
@@ -231,6 +541,29 @@ void write_page(FILE* file, uint64_t page_number, Page* page, TableCatalogEntry
 
   fwrite(&page->free_space, sizeof(page->free_space), 1, file);
 
+  // the bounds widened by updates and deletes tighten again here
+  page_zone_rebuild(page, tc.schema);
+
+  // a page read in the older layout may not have room for the zones, so it keeps that layout
+  if (page->format != PAGE_FORMAT_LEGACY) {
+    uint32_t magic = PAGE_FORMAT_MAGIC;
+    fwrite(&magic, sizeof(magic), 1, file);
+    fwrite(&page->format, sizeof(page->format), 1, file);
+    fwrite(&page->zone_count, sizeof(page->zone_count), 1, file);
+
+    for (int i = 0; i < page->zone_count; i++) {
+      PageZone* zone = &page->zones[i];
+      fwrite(&zone->type, sizeof(zone->type), 1, file);
+      fwrite(&zone->has_range, sizeof(zone->has_range), 1, file);
+      fwrite(&zone->null_count, sizeof(zone->null_count), 1, file);
+      fwrite(&zone->min, sizeof(ZoneKey), 1, file);
+      fwrite(&zone->max, sizeof(ZoneKey), 1, file);
+    }
+  }
+
+  uint32_t header_size = page->format == PAGE_FORMAT_LEGACY ? PAGE_LEGACY_HEADER_SIZE : PAGE_HEADER_SIZE;
+  fseek(file, page_number * PAGE_SIZE + header_size, SEEK_SET);
+
   uint16_t actual_row_count = 0;
 
   for (int i = 0; i < page->num_rows; i++) {
@@ -605,7 +938,7 @@ RowID serialize_insert(BufferPool* pool, Row row, TableCatalogEntry tc) {
   for (int i = 0; i < POOL_SIZE; i++) {
     if (pool->pages[i] != NULL) {
       page = pool->pages[i];
-      if (page->free_space >= row.row_length) {
+      if (page->free_space >= row.row_length && page->num_rows < PAGE_ROW_CAPACITY) {
         break; 
       }
     }
@@ -627,7 +960,7 @@ RowID serialize_insert(BufferPool* pool, Row row, TableCatalogEntry tc) {
     }
   }
 
-  if (page->free_space <= row.row_length) {
+  if (page->free_space <= row.row_length || page->num_rows >= PAGE_ROW_CAPACITY) {
     page->is_full = true; // old
     page = page_init(pool->next_pg_no);
 
@@ -647,6 +980,9 @@ RowID serialize_insert(BufferPool* pool, Row row, TableCatalogEntry tc) {
   //   LOG_DEBUG("!! %d - %s", j, str_column_value(&page->rows[page->num_rows].values[j]));
   // }
 
+  if (page->num_rows == 0) page_zone_rebuild(page, tc.schema);
+  page_zone_add(page, &page->rows[page->num_rows], tc.schema);
+
   page->num_rows++;
   page->free_space -= row.row_length;
   page->is_dirty = true;  
@@ -714,6 +1050,104 @@ bool serialize_delete(BufferPool* pool, RowID rid) {
   return true;
 }
 
+// the order a zone map keeps a column in, types without one get no zone
+bool zone_key(ColumnValue* value, uint8_t type, ZoneKey* key) {
+  if (!value || value->is_null || value->is_array || value->is_toast) return false;
+
+  switch (type) {
+    case TOK_T_INT:
+    case TOK_T_UINT:
+    case TOK_T_SERIAL:
+      key->i = value->int_value;
+      return true;
+    case TOK_T_BOOL:
+      key->i = value->bool_value ? 1 : 0;
+      return true;
+    case TOK_T_DATE:
+      key->i = value->date_value;
+      return true;
+    case TOK_T_TIME:
+      key->i = value->time_value;
+      return true;
+    case TOK_T_TIMESTAMP:
+      key->i = value->timestamp_value.timestamp;
+      return true;
+    case TOK_T_DATETIME: {
+      DateTime* dt = &value->datetime_value;
+      key->i = ((((int64_t)dt->year * 100 + dt->month) * 100 + dt->day) * 100 + dt->hour) * 10000 +
+               dt->minute * 100 + dt->second;
+      return true;
+    }
+    case TOK_T_FLOAT:
+      key->d = value->float_value;
+      return true;
+    case TOK_T_DOUBLE:
+      key->d = value->double_value;
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool zone_key_is_float(uint8_t type) {
+  return type == TOK_T_FLOAT || type == TOK_T_DOUBLE;
+}
+
+static bool zone_key_less(ZoneKey a, ZoneKey b, bool is_float) {
+  return is_float ? a.d < b.d : a.i < b.i;
+}
+
+void page_zone_add(Page* page, Row* row, TableSchema* schema) {
+  if (!page || !row || !row->values || row->deleted || !schema) return;
+
+  uint8_t count = page->zone_count < schema->column_count ? page->zone_count : schema->column_count;
+  for (uint8_t i = 0; i < count; i++) {
+    PageZone* zone = &page->zones[i];
+    ColumnValue* value = &row->values[i];
+
+    if (value->is_null) {
+      if (zone->null_count < UINT16_MAX) zone->null_count++;
+      continue;
+    }
+
+    if (zone->type != schema->columns[i].type) continue;
+
+    ZoneKey key;
+    if (!zone_key(value, zone->type, &key)) {
+      zone->type = PAGE_ZONE_UNBOUNDED;
+      continue;
+    }
+
+    bool is_float = zone_key_is_float(zone->type);
+    if (!zone->has_range) {
+      zone->min = zone->max = key;
+      zone->has_range = true;
+      continue;
+    }
+
+    if (zone_key_less(key, zone->min, is_float)) zone->min = key;
+    if (zone_key_less(zone->max, key, is_float)) zone->max = key;
+  }
+}
+
+void page_zone_rebuild(Page* page, TableSchema* schema) {
+  if (!page || !schema) return;
+
+  page->zone_count = schema->column_count < PAGE_ZONE_COLUMNS ? schema->column_count : PAGE_ZONE_COLUMNS;
+  for (uint8_t i = 0; i < page->zone_count; i++) {
+    ColumnDefinition* column = &schema->columns[i];
+    ColumnValue probe = { .type = column->type };
+    ZoneKey key;
+
+    bool is_ordered = !column->is_array && zone_key(&probe, column->type, &key);
+    page->zones[i] = (PageZone){ .type = is_ordered ? column->type : PAGE_ZONE_UNBOUNDED };
+  }
+
+  for (uint16_t i = 0; i < page->num_rows; i++) {
+    page_zone_add(page, &page->rows[i], schema);
+  }
+}
+
 void pop_lru_page(BufferPool* pool, TableCatalogEntry tc) {
   if (pool->num_pages == 0) return;
 
@@ -725,6 +1159,7 @@ void pop_lru_page(BufferPool* pool, TableCatalogEntry tc) {
   }
 
   fclose(file);
+  page_image_free(lru_page);
   free(lru_page);
 
   for (int i = 1; i < pool->num_pages; i++) {
@@ -20,6 +20,7 @@ typedef struct Row {
   size_t n_values;
 
   bool deleted;
+  bool owns_strings;
 } Row;
 
 typedef struct RowSet {
@@ -35,15 +36,74 @@ typedef struct UpdateData {
   int count;
 } UpdateData;
 
+#define PAGE_ZONE_COLUMNS 16
+#define PAGE_ZONE_UNBOUNDED UINT8_MAX // entry type once a value could not be ordered
+#define PAGE_ZONE_ENTRY_SIZE 20 // type, has_range, null_count, min, max
+
+/*
+  Page header: page id, row count and free space, then the format magic and
+  version, the zone count and the zone entries. Pages written before the
+  header was versioned have their first row where the magic now goes; they
+  are read and written back in that layout, with zones rebuilt on each read.
+*/
+#define PAGE_FORMAT_MAGIC 0x4a5a4d50u // never a row's page id, which is where older pages keep one
+#define PAGE_FORMAT_LEGACY 0          // page id, row count and free space only
+#define PAGE_FORMAT_VERSION 1         // adds the zone map
+#define PAGE_LEGACY_HEADER_SIZE (sizeof(uint32_t) + 2 * sizeof(uint16_t))
+#define PAGE_HEADER_SIZE (PAGE_LEGACY_HEADER_SIZE + sizeof(uint32_t) + 2 * sizeof(uint8_t) + \
+                          PAGE_ZONE_COLUMNS * PAGE_ZONE_ENTRY_SIZE)
+
+typedef union ZoneKey {
+  int64_t i;
+  double d;
+} ZoneKey;
+
+/*
+  Zone map entry: bounds and NULL count of one column over a page's rows,
+  kept for the first PAGE_ZONE_COLUMNS columns. Inserts and updates only
+  widen an entry and write_page recomputes it from the live rows, so the
+  bounds may be loose but never exclude a row that is on the page.
+*/
+typedef struct PageZone {
+  uint8_t type;      // column type the bounds were taken as
+  bool has_range;    // false while every value seen was NULL
+  uint16_t null_count;
+  ZoneKey min, max;
+} PageZone;
+
 typedef struct Page {
   uint32_t page_id; 
   uint16_t num_rows;
   uint16_t free_space;
   bool is_dirty, is_full;
 
+  uint8_t format; // PAGE_FORMAT_VERSION, or PAGE_FORMAT_LEGACY for a page read in the older layout
+  uint8_t zone_count;
+  PageZone zones[PAGE_ZONE_COLUMNS];
+
+  struct PageImage* image; // encoded rows read from disk, NULL once every column is decoded
+
   Row rows[PAGE_SIZE / sizeof(Row)];
 } Page;
 
+#define PAGE_ROW_CAPACITY (PAGE_SIZE / sizeof(Row))
+#define PAGE_COLUMN_BYTES (MAX_COLUMNS / 8)
+
+/*
+  Rows read from disk keep their encoded bytes and decode a column only
+  when something asks for it. Until then a stored value reads as NULL;
+  page_materialize decodes a set of columns for every row of the page,
+  page_materialize_row for one row. Rows inserted after the read are
+  never part of the image.
+*/
+typedef struct PageImage {
+  uint8_t* bytes;
+  uint32_t size;
+  uint16_t row_count;
+  uint16_t offsets[PAGE_ROW_CAPACITY];  // where each row's values start in bytes
+  uint8_t decoded[PAGE_COLUMN_BYTES];   // columns decoded in every row
+} PageImage;
+
 typedef struct BufferPool {
   Page* pages[POOL_SIZE];
   char file[MAX_PATH_LENGTH];
@@ -60,6 +120,7 @@ Page* page_init(uint32_t pg_n);
 
 void read_page(FILE* file, uint64_t page_number, Page* page, TableCatalogEntry tc);
 void read_column_value(FILE* file, ColumnValue* col_val, ColumnDefinition* col_def);
+uint32_t read_column_value_from_buffer(const uint8_t* buffer, uint32_t size, ColumnValue* col_val, ColumnDefinition* col_def);
 void write_page(FILE* file, uint64_t page_number, Page* page, TableCatalogEntry tc);
 void write_array_value(FILE* file, ColumnValue* col_val, ColumnDefinition* col_def);
 uint32_t write_array_value_to_buffer(uint8_t* buffer, ColumnValue* col_val, ColumnDefinition* col_def);
@@ -69,6 +130,15 @@ RowID serialize_insert(BufferPool* pool, Row row, TableCatalogEntry tc);
 uint32_t row_to_buffer(Row* row, BufferPool* pool, TableSchema* schema, uint8_t* buffer);
 bool serialize_delete(BufferPool* pool, RowID rid);
 
+bool zone_key(ColumnValue* value, uint8_t type, ZoneKey* key);
+bool zone_key_is_float(uint8_t type);
+void page_zone_add(Page* page, Row* row, TableSchema* schema);
+void page_zone_rebuild(Page* page, TableSchema* schema);
+
+void page_materialize(Page* page, TableSchema* schema, const uint8_t* columns);
+void page_materialize_row(Page* page, uint16_t row_idx, TableSchema* schema, const uint8_t* columns);
+void pool_materialize(BufferPool* pool, TableSchema* schema);
+
 void pop_lru_page(BufferPool* pool, TableCatalogEntry tc);
 void free_row(Row* row);
 
@@ -42,7 +42,7 @@ TableSchema* jb_sequences_schema() {
   TableSchema* schema = malloc(sizeof(TableSchema));
   strcpy(schema->table_name, "jb_sequences");
 
-  schema->column_count = 7;
+  schema->column_count = 8;
   schema->not_null_count = 0;
 
   schema->columns = calloc(schema->column_count, sizeof(ColumnDefinition));
@@ -70,6 +70,9 @@ TableSchema* jb_sequences_schema() {
   strcpy(cols[6].name, "cycle");
   cols[6].type = TOK_T_BOOL;
 
+  strcpy(cols[7].name, "cache_size");
+  cols[7].type = TOK_T_INT;
+
   return schema;
 }
 
@@ -271,6 +274,7 @@ bool load_jb_sequences_hardcoded(Database* db) {
     {TOK_T_INT, 4, true, false, false},     // min_value (type 0 -> INT, nullable)
     {TOK_T_INT, 5, true, false, false},     // max_value (type 0 -> INT, nullable)
     {TOK_T_BOOL, 6, true, false, false},    // cycle (type 4 -> BOOL, nullable)
+    {TOK_T_INT, 7, true, false, false},     // cache_size (type 0 -> INT, nullable)
   };
 
   FILE* io = db->tc_reader;
@@ -5,7 +5,7 @@
 
 #define INIT_TEST(db_var)                                                  \
   char path[MAX_PATH_LENGTH];                                                \
-  char* argv[2];                                                            \
+  char* argv[3];                                                            \
   do {                                                                      \
     *verbosity_level = 2;                                                    \
     const char* __file = __FILE__;                                           \
@@ -0,0 +1,179 @@
+#include <check.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_aggregates) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE readings (id INT PRIMKEY, grp VARCHAR(5), val INT, score DOUBLE, flag BOOL, name VARCHAR(10));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  // every tenth val is NULL; the table spans several pages and vectors
+  char query[256];
+  for (int i = 1; i <= 400; i++) {
+    char val[16];
+    if (i % 10 == 0) snprintf(val, sizeof(val), "NULL");
+    else snprintf(val, sizeof(val), "%d", i % 13);
+
+    snprintf(query, sizeof(query), "INSERT INTO readings VALUES (%d, 'g%d', %s, %d.25, %s, 'n%d');",
+      i, i % 3, val, i % 9, i % 2 ? "true" : "false", i % 5);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  for (uint32_t threads = 1; threads <= 4; threads += 3) {
+    db->scan_threads = threads;
+
+    res = process(db, "SELECT COUNT(*), COUNT(val), SUM(val), AVG(val), MIN(score), MAX(score), STDDEV(val), VARIANCE(score) FROM readings LIM 1;").exec;
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_int_eq(res.row_count, 1);
+
+    ColumnValue* v = res.rows[0].values;
+    ck_assert_int_eq(v[0].int_value, 400);
+    ck_assert_int_eq(v[1].int_value, 360);
+    ck_assert_int_eq(v[2].int_value, 2151);
+    ck_assert(fabs(v[3].double_value - 5.975) < 1e-9);
+    ck_assert(v[4].double_value == 0.25);
+    ck_assert(v[5].double_value == 8.25);
+    ck_assert(fabs(v[6].double_value - 3.725532995462334) < 1e-9);
+    ck_assert(fabs(v[7].double_value - 6.65140350877193) < 1e-9);
+
+    res = process(db, "SELECT MEDIAN(val), MODE(val), BOOL_AND(flag), BOOL_OR(flag), FIRST(name), LAST(name) FROM readings LIM 1;").exec;
+    ck_assert_int_eq(res.code, 0);
+
+    v = res.rows[0].values;
+    ck_assert(v[0].double_value == 6.0);
+    ck_assert_int_eq(v[1].int_value, 1);
+    ck_assert(!v[2].bool_value);
+    ck_assert(v[3].bool_value);
+    ck_assert_str_eq(v[4].str_value, "n1");
+    ck_assert_str_eq(v[5].str_value, "n0");
+  }
+
+  res = process(db, "SELECT STRING_AGG(name, '-'), GROUP_CONCAT(val), SUM(val * 2) FROM readings WHERE id < 6 LIM 1;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_str_eq(res.rows[0].values[0].str_value, "n1-n2-n3-n4-n0");
+  ck_assert_str_eq(res.rows[0].values[1].str_value, "1,2,3,4,5");
+  ck_assert(res.rows[0].values[2].double_value == 30.0);
+
+  res = process(db, "SELECT grp, SUM(val), STDDEV(val), MEDIAN(score), MODE(name) FROM readings GROUP BY grp ORDER BY grp;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 3);
+
+  struct {
+    char* grp;
+    int sum;
+    double stddev;
+    double median;
+    char* mode;
+  } group_cases[] = {
+    { "g0", 720, 3.7304110211281842, 3.25, "n1" },
+    { "g1", 714, 3.7435659089009925, 4.25, "n0" },
+    { "g2", 717, 3.7337040882329435, 5.25, "n0" },
+  };
+
+  for (int i = 0; i < 3; i++) {
+    ColumnValue* v = res.rows[i].values;
+    ck_assert_str_eq(v[0].str_value, group_cases[i].grp);
+    ck_assert_int_eq(v[1].int_value, group_cases[i].sum);
+    ck_assert(fabs(v[2].double_value - group_cases[i].stddev) < 1e-9);
+    ck_assert(v[3].double_value == group_cases[i].median);
+    ck_assert_str_eq(v[4].str_value, group_cases[i].mode);
+  }
+
+  res = process(db, "SELECT SUM(val), AVG(val), STDDEV(val), COUNT(val) FROM readings WHERE id = 10 LIM 1;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert(res.rows[0].values[0].is_null);
+  ck_assert(res.rows[0].values[1].is_null);
+  ck_assert(res.rows[0].values[2].is_null);
+  ck_assert_int_eq(res.rows[0].values[3].int_value, 0);
+
+  // without GROUP BY the input is folded in batches, nothing is buffered and a single row comes out
+  struct {
+    char* query;
+    int count;
+  } single_row_cases[] = {
+    { "SELECT COUNT(*), SUM(val) FROM readings;", 400 },
+    { "SELECT COUNT(*), SUM(val) FROM readings WHERE id > 100;", 300 },
+    { "SELECT COUNT(*), SUM(val) FROM readings WHERE id > 1000;", 0 },
+    { "SELECT COUNT(*), SUM(val) FROM readings WHERE grp = 'g1' ORDER BY val;", 134 },
+  };
+
+  for (int i = 0; i < sizeof(single_row_cases) / sizeof(single_row_cases[0]); i++) {
+    res = process_silent(db, single_row_cases[i].query).exec;
+    ck_assert_msg(res.code == 0, "Aggregate test case #%d failed", i + 1);
+    ck_assert_msg(res.row_count == 1, "Aggregate test case #%d: expected 1 row, got %u", i + 1, res.row_count);
+    ck_assert_int_eq(res.rows[0].values[0].int_value, single_row_cases[i].count);
+    ck_assert(res.rows[0].values[1].is_null == (single_row_cases[i].count == 0));
+  }
+
+  res = process_silent(db, "SELECT COUNT(*) FROM readings LIM 1 OFFSET 1;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 0);
+
+  Result plan = process_silent(db, "SELECT MIN(val), MAX(val) FROM readings WHERE id > 10 ORDER BY val;");
+  ck_assert_int_eq(plan.exec.code, 0);
+
+  QueryOperator* pipeline = pipeline_build(db, plan.cmd, plan.cmd->schema);
+  ck_assert_ptr_nonnull(pipeline);
+
+  bool aggregated = false;
+  for (QueryOperator* op = pipeline; op; op = op->child) {
+    ck_assert(op->type != OPERATOR_SORT);
+    aggregated = aggregated || op->type == OPERATOR_AGGREGATE;
+  }
+  ck_assert(aggregated);
+  pipeline_free(pipeline);
+
+  // Welford moments stay exact where the naive sum of squares would cancel
+  double samples[] = { 1e9 + 4, 1e9 + 7, 1e9 + 13, 1e9 + 16 };
+  ColumnValue values[4];
+  for (int i = 0; i < 4; i++) {
+    memset(&values[i], 0, sizeof(ColumnValue));
+    values[i].type = TOK_T_DOUBLE;
+    values[i].double_value = samples[i];
+  }
+
+  ExprNode arg = { .type = EXPR_COLUMN };
+  ExprNode* args[] = { &arg };
+  ExprNode variance = { .type = EXPR_FUNCTION };
+  variance.fn.type = AGG_VARIANCE;
+  variance.fn.args = args;
+  variance.fn.arg_count = 1;
+
+  AggregateState state;
+  memset(&state, 0, sizeof(AggregateState));
+  for (int i = 0; i < 4; i++) {
+    aggregate_state_update(&state, &variance.fn, &values[i]);
+  }
+  ck_assert(fabs(aggregate_state_finalize(&state, &variance.fn).double_value - 30.0) < 1e-6);
+  aggregate_state_free(&state);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* aggregates_suite(void) {
+  Suite* s = suite_create("Aggregates");
+
+  TCase* tc_aggregates = tcase_create("Aggregates");
+  tcase_add_test(tc_aggregates, test_aggregates);
+  suite_add_tcase(s, tc_aggregates);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(aggregates_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,299 @@
+#include <check.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+#define ANALYZE_TEST_ROWS 600
+
+static uint64_t scanned_count(Database* db, char* where) {
+  char query[256];
+  snprintf(query, sizeof(query), "SELECT COUNT(*) FROM readings WHERE %s LIM 1;", where);
+
+  ExecutionResult res = process_silent(db, query).exec;
+  ck_assert_int_eq(res.code, 0);
+  return res.rows[0].values[0].int_value;
+}
+
+START_TEST(test_analyze) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE readings (id INT PRIMKEY, sensor INT, reading DOUBLE, note VARCHAR(16));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  // every 5th note is NULL
+  for (int i = 1; i <= ANALYZE_TEST_ROWS; i++) {
+    char query[256];
+    if (i % 5 == 0) {
+      snprintf(query, sizeof(query), "INSERT INTO readings VALUES (%d, %d, %d.0, NULL);", i, i % 10, i);
+    } else {
+      snprintf(query, sizeof(query), "INSERT INTO readings VALUES (%d, %d, %d.0, 'n%d');", i, i % 10, i, i % 7);
+    }
+
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  TableSchema* schema = get_table_schema(db, "readings");
+  ck_assert_ptr_nonnull(schema);
+
+  // row counts come for free, column statistics wait for ANALYZE
+  TableStatistics* stats = table_statistics(db, schema);
+  ck_assert_ptr_nonnull(stats);
+  ck_assert_int_eq(stats->row_count, ANALYZE_TEST_ROWS);
+  ck_assert(stats->columns == NULL);
+
+  res = process_silent(db, "SELECT COUNT(*), COUNT(*) FROM readings;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 1);
+  ck_assert_int_eq(res.rows[0].values[0].int_value, ANALYZE_TEST_ROWS);
+  ck_assert_int_eq(res.rows[0].values[1].int_value, ANALYZE_TEST_ROWS);
+
+  res = process_silent(db, "ANALYZE readings;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 1);
+  ck_assert(table_statistics(db, schema) == stats);
+  ck_assert_int_eq(stats->column_count, 4);
+
+  ColumnStatistics* id = &stats->columns[0];
+  ColumnStatistics* sensor = &stats->columns[1];
+  ColumnStatistics* reading = &stats->columns[2];
+  ColumnStatistics* note = &stats->columns[3];
+
+  ck_assert(llabs((long long)column_distinct_count(id) - ANALYZE_TEST_ROWS) <= ANALYZE_TEST_ROWS / 20);
+  ck_assert_int_eq(column_distinct_count(sensor), 10);
+  ck_assert_int_eq(column_distinct_count(note), 7);
+  ck_assert_int_eq(note->null_count, ANALYZE_TEST_ROWS / 5);
+  ck_assert_int_eq(sensor->null_count, 0);
+
+  ck_assert(reading->has_range && reading->min.d == 1.0 && reading->max.d == ANALYZE_TEST_ROWS);
+  ck_assert(id->has_range && id->min.i == 1 && id->max.i == ANALYZE_TEST_ROWS);
+  ck_assert(!note->has_range);
+  ck_assert_int_eq(note->bucket_count, 0);
+
+  ck_assert_int_eq(reading->bucket_count, STATS_HISTOGRAM_BUCKETS);
+  ck_assert(reading->bounds[0] == 1.0 && reading->bounds[STATS_HISTOGRAM_BUCKETS] == ANALYZE_TEST_ROWS);
+  for (int b = 0; b < STATS_HISTOGRAM_BUCKETS; b++) {
+    ck_assert(reading->bounds[b] <= reading->bounds[b + 1]);
+  }
+
+  // one jb_statistics row per column, replaced rather than added to by a second ANALYZE
+  for (int round = 0; round < 2; round++) {
+    char query[256];
+    snprintf(query, sizeof(query),
+      "SELECT column_name, row_count, n_distinct, null_frac FROM jb_statistics WHERE table_id = %ld;",
+      find_table(db, "readings"));
+
+    ParserState state = parser_save_state(db->core->parser);
+    res = process_silent(db->core, query).exec;
+    parser_restore_state(db->core->parser, state);
+
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_int_eq(res.row_count, 4);
+    for (uint32_t i = 0; i < res.row_count; i++) {
+      ck_assert_int_eq(res.rows[i].values[1].int_value, ANALYZE_TEST_ROWS);
+      if (strcmp(res.rows[i].values[0].str_value, "note") == 0) {
+        ck_assert(fabs(res.rows[i].values[3].double_value - 0.2) < 1e-6);
+        ck_assert_int_eq(res.rows[i].values[2].int_value, 7);
+      }
+    }
+
+    res = process_silent(db, "ANALYZE;").exec;
+    ck_assert_int_eq(res.code, 0);
+    ck_assert(res.row_count >= 1);
+  }
+
+  // re-analyzing rebuilds the column statistics
+  sensor = &stats->columns[1];
+  reading = &stats->columns[2];
+  note = &stats->columns[3];
+
+  struct {
+    char* where;
+    double expected;
+    double tolerance;
+  } selectivity_cases[] = {
+    { "reading <= 150", 0.25, 0.02 },
+    { "reading > 450", 0.25, 0.02 },
+    { "150 >= reading", 0.25, 0.02 },
+    { "reading BETWEEN 100 AND 400", 0.5, 0.02 },
+    { "reading < 0", 0.0, 0.0 },
+    { "sensor = 3", 0.1, 0.01 },
+    { "sensor = 42", 0.0, 0.0 },
+    { "id = 17", 1.0 / ANALYZE_TEST_ROWS, 0.0001 },
+    { "note = NULL", 0.2, 1e-9 },
+    { "sensor = 3 AND reading <= 300", 0.05, 0.01 },
+    { "sensor = 1 OR sensor = 2", 0.19, 0.01 },
+    { "sensor IN (1, 2, 3)", 0.3, 0.02 },
+  };
+
+  for (int i = 0; i < sizeof(selectivity_cases) / sizeof(selectivity_cases[0]); i++) {
+    char query[256];
+    snprintf(query, sizeof(query), "SELECT id FROM readings WHERE %s;", selectivity_cases[i].where);
+
+    Result result = process_silent(db, query);
+    ck_assert_int_eq(result.exec.code, 0);
+
+    double s = estimate_selectivity(db, schema, result.cmd->where);
+    ck_assert_msg(fabs(s - selectivity_cases[i].expected) <= selectivity_cases[i].tolerance,
+      "Selectivity case #%d (%s) failed: expected %.6f, got %.6f",
+      i + 1, selectivity_cases[i].where, selectivity_cases[i].expected, s);
+  }
+
+  // writes keep the row count exact and the NULL counts with it
+  for (int i = ANALYZE_TEST_ROWS + 1; i <= ANALYZE_TEST_ROWS + 10; i++) {
+    char query[128];
+    snprintf(query, sizeof(query), "INSERT INTO readings VALUES (%d, 0, %d.0, NULL);", i, i);
+    res = process_silent(db, query).exec;
+    ck_assert_int_eq(res.code, 0);
+  }
+
+  res = process_silent(db, "DELETE FROM readings WHERE sensor = 1;").exec;
+  ck_assert_int_eq(res.code, 0);
+  res = process_silent(db, "UPDATE readings SET sensor = NULL WHERE id <= 20;").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  uint64_t live = scanned_count(db, "id > 0");
+  ck_assert_int_eq(live, ANALYZE_TEST_ROWS + 10 - ANALYZE_TEST_ROWS / 10);
+  ck_assert_int_eq(stats->row_count, live);
+
+  res = process_silent(db, "SELECT COUNT(*) FROM readings;").exec;
+  ck_assert_int_eq(res.row_count, 1);
+  ck_assert_int_eq(res.rows[0].values[0].int_value, live);
+
+  res = process_silent(db, "SELECT COUNT(note), COUNT(sensor) FROM readings LIM 1;").exec;
+  ck_assert_int_eq(note->null_count, live - res.rows[0].values[0].int_value);
+  ck_assert_int_eq(sensor->null_count, live - res.rows[0].values[1].int_value);
+  ck_assert(reading->max.d == ANALYZE_TEST_ROWS + 10);
+
+  res = process_silent(db, "SELECT COUNT(*) FROM readings LIM 0;").exec;
+  ck_assert_int_eq(res.row_count, 0);
+
+  // the row count answers with exactly the row a scan would have produced
+  res = process_silent(db, "CREATE TABLE vacant (id INT PRIMKEY, sensor INT);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  struct {
+    char* query;
+    uint64_t expected;
+  } count_test_cases[] = {
+    { "SELECT COUNT(*) FROM readings;", live },
+    { "SELECT COUNT(*) FROM readings WHERE id > 0;", live },
+    { "SELECT COUNT(*) FROM readings TABLESAMPLE SYSTEM (100);", live },
+    { "SELECT COUNT(*) FROM vacant;", 0 },
+    { "SELECT COUNT(*) FROM vacant WHERE id > 0;", 0 },
+  };
+
+  for (int i = 0; i < sizeof(count_test_cases) / sizeof(count_test_cases[0]); i++) {
+    res = process_silent(db, count_test_cases[i].query).exec;
+    ck_assert_msg(res.code == 0, "COUNT test case #%d failed", i + 1);
+    ck_assert_msg(res.row_count == 1, "COUNT test case #%d: expected 1 row, got %u", i + 1, res.row_count);
+    ck_assert_int_eq(res.rows[0].values[0].int_value, count_test_cases[i].expected);
+  }
+
+  res = process_silent(db, "ANALYZE nosuchtable;").exec;
+  ck_assert(res.code != 0);
+
+  // the access path only changes with a key btree to probe
+  res = process_silent(db,
+    "CREATE TABLE keyed (id INT PRIMKEY, sensor INT, reading DOUBLE, note VARCHAR(16));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  // the schema read back after CREATE does not carry its key flags, restore them so inserts build the btree
+  TableSchema* keyed = get_table_schema(db, "keyed");
+  ck_assert_ptr_nonnull(keyed);
+  keyed->columns[0].is_primary_key = true;
+  keyed->columns[0].is_unique = true;
+  keyed->prim_column_count = 1;
+  db->tc[hash_fnv1a("keyed", MAX_TABLES)].is_populated = false;
+
+  for (int i = 1; i <= ANALYZE_TEST_ROWS; i++) {
+    char query[256];
+    snprintf(query, sizeof(query), "INSERT INTO keyed VALUES (%d, %d, %d.0, 'n%d');", i, i % 10, i, i % 7);
+
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  res = process_silent(db, "ANALYZE keyed;").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  Result result = process_silent(db, "SELECT id FROM keyed WHERE id = 17;");
+  ck_assert(estimate_selectivity(db, keyed, result.cmd->where) == 1.0 / ANALYZE_TEST_ROWS);
+
+  struct {
+    char* query;
+    AccessMethod method;
+    int expected_rows;
+  } access_cases[] = {
+    { "SELECT * FROM keyed WHERE id = 42;", ACCESS_PK_LOOKUP, 1 },
+    { "SELECT id, note FROM keyed WHERE 42 = id;", ACCESS_PK_LOOKUP, 1 },
+    { "SELECT * FROM keyed WHERE id = 42 AND sensor = 2;", ACCESS_PK_LOOKUP, 1 },
+    { "SELECT * FROM keyed WHERE sensor = 2 AND id = 42;", ACCESS_PK_LOOKUP, 1 },
+    { "SELECT * FROM keyed WHERE id = 42 AND sensor = 3;", ACCESS_PK_LOOKUP, 0 },
+    { "SELECT * FROM keyed WHERE id = 100000;", ACCESS_PK_LOOKUP, 0 },
+    { "SELECT COUNT(*) FROM keyed WHERE id = 42 LIM 1;", ACCESS_PK_LOOKUP, 1 },
+    { "SELECT * FROM keyed WHERE id = 42.5;", ACCESS_SEQ_SCAN, 1 },
+    { "SELECT * FROM keyed WHERE id = 42 OR id = 43;", ACCESS_SEQ_SCAN, 2 },
+    { "SELECT * FROM keyed WHERE sensor = 3;", ACCESS_SEQ_SCAN, ANALYZE_TEST_ROWS / 10 },
+    { "SELECT * FROM keyed TABLESAMPLE BERNOULLI (100) WHERE id = 42;", ACCESS_SEQ_SCAN, 1 },
+  };
+
+  for (int i = 0; i < sizeof(access_cases) / sizeof(access_cases[0]); i++) {
+    result = process_silent(db, access_cases[i].query);
+    ck_assert_int_eq(result.exec.code, 0);
+    ck_assert_msg(result.exec.row_count == access_cases[i].expected_rows,
+      "Access path case #%d failed: expected %d rows, got %d",
+      i + 1, access_cases[i].expected_rows, result.exec.row_count);
+
+    AccessPlan plan = plan_table_access(db, result.cmd, keyed);
+    ck_assert_msg(plan.method == access_cases[i].method, "Access path case #%d chose method %d", i + 1, plan.method);
+  }
+
+  res = process_silent(db, "SELECT id, sensor FROM keyed WHERE id = 42;").exec;
+  ck_assert_int_eq(res.rows[0].values[0].int_value, 42);
+  ck_assert_int_eq(res.rows[0].values[1].int_value, 2);
+
+  // a table that fits on a page is cheaper to scan than to look up
+  res = process_silent(db, "CREATE TABLE tiny (id INT PRIMKEY, label VARCHAR(8));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  TableSchema* tiny = get_table_schema(db, "tiny");
+  tiny->columns[0].is_primary_key = true;
+  tiny->columns[0].is_unique = true;
+  tiny->prim_column_count = 1;
+  db->tc[hash_fnv1a("tiny", MAX_TABLES)].is_populated = false;
+
+  process_silent(db, "INSERT INTO tiny VALUES (1, 'a');");
+  process_silent(db, "INSERT INTO tiny VALUES (2, 'b');");
+
+  result = process_silent(db, "SELECT * FROM tiny WHERE id = 2;");
+  ck_assert_int_eq(result.exec.row_count, 1);
+  ck_assert(plan_table_access(db, result.cmd, tiny).method == ACCESS_SEQ_SCAN);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* analyze_suite(void) {
+  Suite* s = suite_create("Analyze");
+
+  TCase* tc_analyze = tcase_create("Analyze");
+  tcase_add_test(tc_analyze, test_analyze);
+  suite_add_tcase(s, tc_analyze);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(analyze_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
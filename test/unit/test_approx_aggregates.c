@@ -0,0 +1,207 @@
+#include <check.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "storage/cluster.h"
+#include "utils/testing.h"
+
+#define APPROX_TEST_ROWS 400
+#define APPROX_TEST_VISITORS 53
+
+START_TEST(test_hyperloglog) {
+  HyperLogLog all, low, high;
+  hll_init(&all);
+  hll_init(&low);
+  hll_init(&high);
+
+  for (uint64_t i = 0; i < 100000; i++) {
+    hll_add(&all, i);
+    if (i < 60000) hll_add(&low, i);
+    if (i >= 40000) hll_add(&high, i);
+  }
+
+  uint64_t estimate = hll_estimate(&all);
+  ck_assert_msg(fabs((double)estimate - 100000.0) < 5000.0, "HyperLogLog estimate %llu is too far off",
+    (unsigned long long)estimate);
+
+  // overlapping halves merge into exactly the sketch of the whole
+  hll_merge(&low, &high);
+  ck_assert(memcmp(low.registers, all.registers, HLL_REGISTERS) == 0);
+
+  HyperLogLog few;
+  hll_init(&few);
+  for (int round = 0; round < 3; round++) {
+    for (uint64_t i = 0; i < 10; i++) hll_add(&few, i * 7919);
+  }
+  ck_assert_int_eq(hll_estimate(&few), 10);
+}
+END_TEST
+
+START_TEST(test_tdigest) {
+  TDigest* digest = malloc(sizeof(TDigest));
+  TDigest* odd = malloc(sizeof(TDigest));
+  TDigest* even = malloc(sizeof(TDigest));
+  tdigest_init(digest);
+  tdigest_init(odd);
+  tdigest_init(even);
+
+  double out;
+  ck_assert(!tdigest_quantile(digest, 0.5, &out));
+
+  // 1..10000 in a scrambled order
+  for (int i = 0; i < 10000; i++) {
+    double value = (double)((i * 7919) % 10000 + 1);
+    tdigest_add(digest, value, 1.0);
+    tdigest_add((int)value % 2 ? odd : even, value, 1.0);
+  }
+
+  ck_assert(tdigest_total(digest) == 10000.0);
+
+  struct {
+    double q;
+    double expected;
+    double tolerance;
+  } quantile_cases[] = {
+    { 0.0, 1.0, 0.0 },
+    { 0.001, 10.0, 5.0 },
+    { 0.25, 2500.0, 50.0 },
+    { 0.5, 5000.0, 50.0 },
+    { 0.9, 9000.0, 30.0 },
+    { 0.999, 9990.0, 5.0 },
+    { 1.0, 10000.0, 0.0 },
+  };
+
+  tdigest_merge(odd, even);
+
+  for (int i = 0; i < sizeof(quantile_cases) / sizeof(quantile_cases[0]); i++) {
+    TDigest* digests[] = { digest, odd };
+
+    for (int d = 0; d < 2; d++) {
+      ck_assert(tdigest_quantile(digests[d], quantile_cases[i].q, &out));
+      ck_assert_msg(fabs(out - quantile_cases[i].expected) <= quantile_cases[i].tolerance,
+        "t-digest quantile case #%d (digest %d) failed: expected %.1f, got %.3f",
+        i + 1, d, quantile_cases[i].expected, out);
+    }
+  }
+
+  // the centroids stay bounded however many values went in
+  ck_assert(digest->merged <= 2 * TDIGEST_COMPRESSION);
+
+  free(digest);
+  free(odd);
+  free(even);
+}
+END_TEST
+
+START_TEST(test_approx_aggregates) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE events (id INT PRIMKEY, region VARCHAR(8), visitor INT, latency DOUBLE);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  // every 25th visitor is NULL
+  char query[256];
+  for (int i = 1; i <= APPROX_TEST_ROWS; i++) {
+    char visitor[16];
+    if (i % 25 == 0) snprintf(visitor, sizeof(visitor), "NULL");
+    else snprintf(visitor, sizeof(visitor), "%d", i % APPROX_TEST_VISITORS);
+
+    snprintf(query, sizeof(query), "INSERT INTO events VALUES (%d, 'r%d', %s, %d.0);", i, i % 4, visitor, i);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  for (uint32_t threads = 1; threads <= 4; threads += 3) {
+    db->scan_threads = threads;
+
+    res = process_silent(db,
+      "SELECT APPROX_COUNT_DISTINCT(visitor), COUNT(DISTINCT visitor), APPROX_PERCENTILE(latency, 0.5), "
+      "APPROX_PERCENTILE(latency, 0.99), APPROX_PERCENTILE(latency, 0), APPROX_PERCENTILE(latency, 1) FROM events LIM 1;").exec;
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_int_eq(res.row_count, 1);
+
+    ColumnValue* v = res.rows[0].values;
+    ck_assert_int_eq(v[1].int_value, APPROX_TEST_VISITORS);
+    ck_assert_msg(llabs(v[0].int_value - APPROX_TEST_VISITORS) <= 1,
+      "APPROX_COUNT_DISTINCT returned %lld", (long long)v[0].int_value);
+    ck_assert(fabs(v[2].double_value - 200.5) <= 2.0);
+    ck_assert(fabs(v[3].double_value - 396.0) <= 2.0);
+    ck_assert(v[4].double_value == 1.0);
+    ck_assert(v[5].double_value == 400.0);
+  }
+
+  res = process_silent(db,
+    "SELECT region, APPROX_COUNT_DISTINCT(visitor), COUNT(DISTINCT visitor), APPROX_PERCENTILE(latency, 0.5) "
+    "FROM events GROUP BY region ORDER BY region;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 4);
+
+  for (uint32_t i = 0; i < res.row_count; i++) {
+    ColumnValue* v = res.rows[i].values;
+    ck_assert_msg(llabs(v[1].int_value - v[2].int_value) <= 1,
+      "Group %u: APPROX_COUNT_DISTINCT %lld against %lld", i, (long long)v[1].int_value, (long long)v[2].int_value);
+    ck_assert(fabs(v[3].double_value - 200.5) <= 4.0);
+  }
+
+  // p outside 0..1 and inputs without values have no percentile
+  res = process_silent(db, "SELECT APPROX_PERCENTILE(latency, 1.5), APPROX_PERCENTILE(visitor, 0.5) FROM events WHERE id = 25 LIM 1;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert(res.rows[0].values[0].is_null);
+  ck_assert(res.rows[0].values[1].is_null);
+
+  // a cluster listing the same database twice: sketches merge as a union, counts add up
+  ClusterManager* manager = calloc(1, sizeof(ClusterManager));
+  ck_assert_ptr_nonnull(manager);
+  manager->cluster_count = 1;
+  manager->active_cluster = 0;
+  manager->clusters[0].databases[0] = db;
+  manager->clusters[0].databases[1] = db;
+  manager->clusters[0].db_count = 2;
+
+  Result result = cluster_aggregate_all(manager,
+    "SELECT APPROX_COUNT_DISTINCT(visitor), COUNT(*), SUM(latency), APPROX_PERCENTILE(latency, 0.5) FROM events WHERE id <= 200;");
+  ck_assert_int_eq(result.exec.code, 0);
+  ck_assert_int_eq(result.exec.row_count, 1);
+
+  ColumnValue* v = result.exec.rows[0].values;
+  ck_assert(llabs(v[0].int_value - APPROX_TEST_VISITORS) <= 1);
+  ck_assert_int_eq(v[1].int_value, 400);
+  ck_assert(v[2].double_value == 40200.0);
+  ck_assert(fabs(v[3].double_value - 100.5) <= 2.0);
+  ck_assert_str_eq(result.exec.aliases[0], "APPROX_COUNT_DISTINCT");
+
+  result = cluster_aggregate_all(manager, "SELECT region, COUNT(*) FROM events GROUP BY region;");
+  ck_assert(result.exec.code != 0);
+
+  result = cluster_aggregate_all(manager, "SELECT FIRST(visitor) FROM events;");
+  ck_assert(result.exec.code != 0);
+
+  free(manager);
+  db_free(db);
+}
+END_TEST
+
+Suite* approx_aggregates_suite(void) {
+  Suite* s = suite_create("ApproxAggregates");
+
+  TCase* tc_approx = tcase_create("ApproxAggregates");
+  tcase_add_test(tc_approx, test_hyperloglog);
+  tcase_add_test(tc_approx, test_tdigest);
+  tcase_add_test(tc_approx, test_approx_aggregates);
+  suite_add_tcase(s, tc_approx);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(approx_aggregates_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
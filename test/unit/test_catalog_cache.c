@@ -0,0 +1,126 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_catalog_cache) {
+  INIT_TEST(db);
+
+  char* create_queries[] = {
+    "CREATE TABLE items (id INT PRIMKEY, name VARCHAR(10) NOT NULL, qty INT DEFAULT 7);",
+    "CREATE TABLE tags (id INT PRIMKEY, label TEXT);",
+  };
+
+  for (int i = 0; i < sizeof(create_queries) / sizeof(create_queries[0]); i++) {
+    ExecutionResult res = process_silent(db, create_queries[i]).exec;
+    ck_assert_int_eq(res.code, 0);
+  }
+
+  // cached lookups agree with the rows they mirror, which live in the core database
+  char* tables[] = { "items", "tags" };
+  for (int i = 0; i < sizeof(tables) / sizeof(tables[0]); i++) {
+    char query[256];
+    snprintf(query, sizeof(query), "SELECT id FROM jb_tables WHERE name = '%s';", tables[i]);
+
+    ExecutionResult res = process(db->core, query).exec;
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_int_eq(res.row_count, 1);
+
+    int64_t table_id = find_table(db, tables[i]);
+    ck_assert_msg(table_id == res.rows[0].values[0].int_value,
+      "Catalog test case #%d failed: '%s' resolved to %lld, expected %lld",
+      i + 1, tables[i], (long long)table_id, (long long)res.rows[0].values[0].int_value);
+
+    ck_assert_str_eq(catalog_table_name(db, table_id), tables[i]);
+    ck_assert(get_table_schema_by_id(db, table_id) == get_table_schema(db, tables[i]));
+  }
+
+  ck_assert(db->core->catalog != NULL);
+  ck_assert(db->core->catalog->is_loaded);
+  ck_assert(find_table(db, "missing") == -1);
+  ck_assert(catalog_table_name(db, 999999) == NULL);
+
+  int64_t items_id = find_table(db, "items");
+
+  struct {
+    char* column;
+    int data_type;
+    int ordinal_position;
+    bool is_nullable;
+    bool has_default;
+  } attribute_test_cases[] = {
+    { "id",   TOK_T_INT,     0, false, false },
+    { "name", TOK_T_VARCHAR, 1, false, false },
+    { "qty",  TOK_T_INT,     2, true,  true  },
+  };
+
+  int n_cases = sizeof(attribute_test_cases) / sizeof(attribute_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    Attribute* attr = load_attribute(db, items_id, attribute_test_cases[i].column);
+    ck_assert_msg(attr != NULL, "Attribute test case #%d: '%s' not found", i + 1, attribute_test_cases[i].column);
+    ck_assert_int_eq(attr->data_type, attribute_test_cases[i].data_type);
+    ck_assert_int_eq(attr->ordinal_position, attribute_test_cases[i].ordinal_position);
+    ck_assert_int_eq(attr->is_nullable, attribute_test_cases[i].is_nullable);
+    ck_assert_int_eq(attr->has_default, attribute_test_cases[i].has_default);
+    free(attr);
+  }
+
+  ck_assert(load_attribute(db, items_id, "missing") == NULL);
+
+  ExprNode* qty_default = load_attr_default(db, items_id, "qty");
+  ck_assert(qty_default != NULL);
+  ck_assert_int_eq(qty_default->type, EXPR_LITERAL);
+  ck_assert_int_eq(qty_default->literal.int_value, 7);
+
+  // writers append to a loaded cache instead of dropping it
+  uint64_t version = catalog_version(db);
+  ExecutionResult res = process_silent(db, "CREATE TABLE notes (id INT PRIMKEY, body TEXT);").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert(db->core->catalog->is_loaded);
+  ck_assert(catalog_version(db) > version);
+
+  int64_t notes_id = find_table(db, "notes");
+  ck_assert(notes_id != -1);
+  ck_assert_str_eq(catalog_table_name(db, notes_id), "notes");
+  ck_assert(load_attribute(db, notes_id, "body") != NULL);
+
+  res = process_silent(db, "INSERT INTO notes VALUES (1, 'first');").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  // DDL that rewrites catalog rows drops the cache, the next lookup reads it back
+  version = catalog_version(db);
+  res = process_silent(db, "ALTER TABLE items ALTER COLUMN name DROP NOT NULL;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert(!db->core->catalog->is_loaded);
+  ck_assert(catalog_version(db) > version);
+
+  ck_assert(find_table(db, "tags") != -1);
+  ck_assert(db->core->catalog->is_loaded);
+  ck_assert(find_table(db, "notes") == notes_id);
+  ck_assert(load_attr_default(db, items_id, "qty") != NULL);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* catalog_cache_suite(void) {
+  Suite* s = suite_create("CatalogCache");
+
+  TCase* tc_catalog = tcase_create("CatalogCache");
+  tcase_add_test(tc_catalog, test_catalog_cache);
+  suite_add_tcase(s, tc_catalog);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(catalog_cache_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+#define EXPLAIN_TEST_ROWS 200
+
+static bool plan_contains(ExecutionResult* res, const char* needle) {
+  for (uint32_t i = 0; i < res->row_count; i++) {
+    if (strstr(res->rows[i].values[0].str_value, needle)) return true;
+  }
+  return false;
+}
+
+START_TEST(test_explain) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE items (id INT PRIMKEY, kind INT, qty INT, label VARCHAR(16));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  for (int i = 1; i <= EXPLAIN_TEST_ROWS; i++) {
+    char query[256];
+    snprintf(query, sizeof(query), "INSERT INTO items VALUES (%d, %d, %d, 'l%d');", i, i % 5, i % 20, i);
+
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  res = process_silent(db,
+    "CREATE TABLE orders (id INT PRIMKEY, item_id INT FRNKEY REFERENCES items(id) ON DELETE CASCADE);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  struct {
+    char* query;
+    char* expected[4];
+  } plan_test_cases[] = {
+    { "EXPLAIN SELECT id FROM items WHERE qty > 5 ORDER BY id LIM 10;",
+      { "-> Limit  (offset=0 limit=10)", "Top-N Sort", "Seq Scan on items", "Filter:" } },
+    { "EXPLAIN SELECT * FROM items ORDER BY qty;", { "Project", "-> Sort  (keys=1)", "Seq Scan on items", NULL } },
+    { "EXPLAIN SELECT kind, COUNT(*) FROM items GROUP BY kind;", { "Hash Aggregate  (keys=1)", "Seq Scan", NULL } },
+    { "EXPLAIN SELECT DISTINCT kind FROM items;", { "Hash Distinct", NULL } },
+    { "EXPLAIN SELECT id FROM items TABLESAMPLE BERNOULLI (50);", { "Sample: BERNOULLI", NULL } },
+    { "EXPLAIN UPDATE items SET qty = 1 WHERE kind = 2;", { "Update on items", "-> Seq Scan on items", NULL } },
+    { "EXPLAIN DELETE FROM items WHERE kind = 2;", { "Delete on items", "Foreign key", "from orders", NULL } },
+  };
+
+  for (int i = 0; i < sizeof(plan_test_cases) / sizeof(plan_test_cases[0]); i++) {
+    res = process_silent(db, plan_test_cases[i].query).exec;
+
+    ck_assert_msg(res.code == 0, "EXPLAIN test case #%d failed: %s", i + 1, res.message);
+    ck_assert_str_eq(res.aliases[0], "QUERY PLAN");
+    ck_assert_msg(!plan_contains(&res, "Actual:"), "EXPLAIN test case #%d ran the statement", i + 1);
+
+    for (int e = 0; e < 4 && plan_test_cases[i].expected[e]; e++) {
+      ck_assert_msg(plan_contains(&res, plan_test_cases[i].expected[e]),
+        "EXPLAIN test case #%d failed: no line contains '%s'", i + 1, plan_test_cases[i].expected[e]);
+    }
+  }
+
+  // plain EXPLAIN leaves the table alone
+  res = process_silent(db, "SELECT COUNT(*) FROM items LIM 1;").exec;
+  ck_assert_int_eq(res.rows[0].values[0].int_value, EXPLAIN_TEST_ROWS);
+
+  struct {
+    char* query;
+    char* expected[4];
+  } analyze_test_cases[] = {
+    { "EXPLAIN ANALYZE SELECT id FROM items WHERE qty < 10;",
+      { "rows in=200 out=100", "Pages:", "Execute:", "Total:" } },
+    { "EXPLAIN ANALYZE SELECT id FROM items WHERE qty < 10 ORDER BY id LIM 5 OFFSET 2;",
+      { "rows in=100 out=7", "rows in=7 out=5", "5 rows allocated", "Plan:" } },
+    { "EXPLAIN ANALYZE SELECT kind, COUNT(*) FROM items GROUP BY kind;", { "5 groups", "Bind:", NULL } },
+    { "EXPLAIN ANALYZE UPDATE items SET label = 'x' WHERE kind = 3;",
+      { "Update on items  (rows=40)", "Collect:", "Write:", "Parse:" } },
+    { "EXPLAIN ANALYZE DELETE FROM items WHERE id <= 10;", { "Delete on items  (rows=10)", "Foreign key collect:", "Foreign key actions:", "Write:" } },
+  };
+
+  for (int i = 0; i < sizeof(analyze_test_cases) / sizeof(analyze_test_cases[0]); i++) {
+    res = process_silent(db, analyze_test_cases[i].query).exec;
+    ck_assert_msg(res.code == 0, "EXPLAIN ANALYZE test case #%d failed: %s", i + 1, res.message);
+
+    for (int e = 0; e < 4 && analyze_test_cases[i].expected[e]; e++) {
+      ck_assert_msg(plan_contains(&res, analyze_test_cases[i].expected[e]),
+        "EXPLAIN ANALYZE test case #%d failed: no line contains '%s'", i + 1, analyze_test_cases[i].expected[e]);
+    }
+  }
+
+  // EXPLAIN ANALYZE runs the writes it profiles
+  res = process_silent(db, "SELECT COUNT(*) FROM items LIM 1;").exec;
+  ck_assert_int_eq(res.rows[0].values[0].int_value, EXPLAIN_TEST_ROWS - 10);
+
+  res = process_silent(db, "SELECT COUNT(*) FROM items WHERE label = 'x' LIM 1;").exec;
+  ck_assert_int_eq(res.rows[0].values[0].int_value, 38);
+
+  char* invalid_queries[] = {
+    "EXPLAIN CREATE TABLE other (id INT PRIMKEY);",
+    "EXPLAIN ANALYZE INSERT INTO items VALUES (1000, 1, 1, 'a');",
+    "EXPLAIN SELECT * FROM missing;",
+    "EXPLAIN ANALYZE SELECT nope FROM items;",
+  };
+
+  for (int i = 0; i < sizeof(invalid_queries) / sizeof(invalid_queries[0]); i++) {
+    res = process_silent(db, invalid_queries[i]).exec;
+    ck_assert_msg(res.code != 0, "Invalid EXPLAIN query #%d unexpectedly succeeded", i + 1);
+  }
+
+  db_free(db);
+}
+END_TEST
+
+Suite* explain_suite(void) {
+  Suite* s = suite_create("Explain");
+
+  TCase* tc_explain = tcase_create("Explain");
+  tcase_add_test(tc_explain, test_explain);
+  suite_add_tcase(s, tc_explain);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(explain_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
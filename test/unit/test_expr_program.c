@@ -0,0 +1,95 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_expr_program) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE items (id INT PRIMKEY, price DOUBLE, name VARCHAR(20));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  char query[256];
+  for (int i = 1; i <= 20; i++) {
+    snprintf(query, sizeof(query), "INSERT INTO items VALUES (%d, %d.0, 'item%d');", i, i, i);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  res = process(db, "SELECT price * 2 + 1, ABS(price * 2), POW(price, 2), (2 * 3) + price FROM items WHERE id = 3;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 1);
+  ck_assert(res.rows[0].values[0].double_value == 7.0);
+  ck_assert(res.rows[0].values[1].double_value == 6.0);
+  ck_assert(res.rows[0].values[2].double_value == 9.0);
+  ck_assert(res.rows[0].values[3].double_value == 9.0);
+
+  struct {
+    char* query;
+    int expected_rows;
+  } program_test_cases[] = {
+    { "SELECT * FROM items WHERE price * 2 > 30;", 5 },
+    { "SELECT * FROM items WHERE name LIKE 'item1%' AND price > 12;", 7 },
+    { "SELECT * FROM items WHERE NOT (price * 2 < 20) OR name LIKE 'item2';", 12 },
+  };
+
+  int n_cases = sizeof(program_test_cases) / sizeof(program_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    printf("Executing expression program test case #%d: %s\n", i + 1, program_test_cases[i].query);
+
+    res = process(db, program_test_cases[i].query).exec;
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_msg(res.row_count == (uint32_t)program_test_cases[i].expected_rows,
+      "Expression program test case #%d failed: expected %d rows, got %u",
+      i + 1, program_test_cases[i].expected_rows, res.row_count);
+  }
+
+  res = process_silent(db, "UPDATE items SET price = price * 2 + (3 * 0) WHERE id <= 5;").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  res = process(db, "SELECT price FROM items WHERE id = 5;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert(res.rows[0].values[0].double_value == 10.0);
+
+  Result result = process_silent(db, "SELECT (2 * 3) + price, price * 2, price * 2 + 1 FROM items WHERE id = 1;");
+  ck_assert_int_eq(result.exec.code, 0);
+
+  // the constant subtree folds away, leaving a column load and one addition
+  ExprNode* folded[] = { result.cmd->sel_columns[0].expr };
+  ExprProgram* program = expr_program_compile(folded, 1, result.cmd->schema, db);
+  ck_assert(program != NULL);
+  ck_assert_int_eq(program->length, 2);
+  expr_program_free(program);
+
+  // `price` and `price * 2` are computed once and shared by both outputs
+  ExprNode* shared[] = { result.cmd->sel_columns[1].expr, result.cmd->sel_columns[2].expr };
+  program = expr_program_compile(shared, 2, result.cmd->schema, db);
+  ck_assert(program != NULL);
+  ck_assert_int_eq(program->length, 3);
+  expr_program_free(program);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* expr_program_suite(void) {
+  Suite* s = suite_create("ExprProgram");
+
+  TCase* tc_expr_program = tcase_create("ExprProgram");
+  tcase_add_test(tc_expr_program, test_expr_program);
+  suite_add_tcase(s, tc_expr_program);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(expr_program_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
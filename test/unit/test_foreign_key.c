@@ -0,0 +1,99 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_foreign_key) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE authors (id INT PRIMKEY, name VARCHAR(50));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  res = process_silent(db,
+    "CREATE TABLE books (id INT PRIMKEY, "
+    "author_id INT FRNKEY REFERENCES authors(id) ON DELETE CASCADE ON UPDATE CASCADE, "
+    "title VARCHAR(50));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  res = process_silent(db,
+    "CREATE TABLE reviews (id INT PRIMKEY, "
+    "book_id INT FRNKEY REFERENCES books(id) ON DELETE RESTRICT);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  char query[256];
+  for (int i = 1; i <= 10; i++) {
+    snprintf(query, sizeof(query), "INSERT INTO authors VALUES (%d, 'author%d');", i, i);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Author insert #%d unexpectedly failed", i);
+  }
+
+  for (int i = 1; i <= 40; i++) {
+    snprintf(query, sizeof(query), "INSERT INTO books VALUES (%d, %d, 'book%d');", i, i % 10 + 1, i);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Book insert #%d unexpectedly failed", i);
+  }
+
+  struct {
+    char* query;
+    bool should_succeed;
+  } fk_test_cases[] = {
+    { "INSERT INTO books VALUES (41, 99, 'dangling');", false },
+    { "INSERT INTO books VALUES (41, NULL, 'orphan');", true },
+    { "INSERT INTO reviews VALUES (1, 5);", true },
+    { "INSERT INTO reviews VALUES (2, 500);", false },
+    { "DELETE FROM authors WHERE id = 6;", false },
+    { "DELETE FROM authors WHERE id = 5;", true },
+    { "DELETE FROM reviews WHERE id = 1;", true },
+    { "DELETE FROM authors WHERE id = 6;", true },
+    { "UPDATE authors SET id = 50 WHERE id = 7;", true },
+    { "INSERT INTO books VALUES (42, 50, 'renamed');", true },
+    { "INSERT INTO books VALUES (43, 7, 'stale');", false },
+  };
+
+  int n_cases = sizeof(fk_test_cases) / sizeof(fk_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    printf("Executing FOREIGN KEY test case #%d: %s\n", i + 1, fk_test_cases[i].query);
+
+    res = process_silent(db, fk_test_cases[i].query).exec;
+    ck_assert_msg((res.code == 0) == fk_test_cases[i].should_succeed,
+      "FOREIGN KEY test case #%d failed: expected %s, got code %d",
+      i + 1, fk_test_cases[i].should_succeed ? "success" : "failure", res.code);
+  }
+
+  res = process(db, "SELECT * FROM books WHERE author_id = 5;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 0);
+
+  res = process(db, "SELECT * FROM books WHERE author_id = 50;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 5);
+
+  res = process(db, "SELECT * FROM books;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 34);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* foreign_key_suite(void) {
+  Suite* s = suite_create("ForeignKey");
+
+  TCase* tc_foreign_key = tcase_create("ForeignKey");
+  tcase_add_test(tc_foreign_key, test_foreign_key);
+  suite_add_tcase(s, tc_foreign_key);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(foreign_key_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+static const ColumnValue* group_value(ExecutionResult* res, const char* region, int column) {
+  for (uint32_t i = 0; i < res->row_count; i++) {
+    if (strcmp(res->rows[i].values[0].str_value, region) == 0) return &res->rows[i].values[column];
+  }
+
+  return NULL;
+}
+
+START_TEST(test_group_by) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE sales (id INT PRIMKEY, region VARCHAR(10), amount INT, price DOUBLE);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  // region rN holds ids with id % 4 == N; every tenth amount is NULL
+  char query[256];
+  for (int i = 1; i <= 60; i++) {
+    char amount[16];
+    if (i % 10 == 0) snprintf(amount, sizeof(amount), "NULL");
+    else snprintf(amount, sizeof(amount), "%d", i);
+
+    snprintf(query, sizeof(query), "INSERT INTO sales VALUES (%d, 'r%d', %s, %d.5);", i, i % 4, amount, i % 7);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  res = process(db, "SELECT region, COUNT(*), COUNT(amount), SUM(amount), MIN(amount), MAX(price) FROM sales GROUP BY region;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 4);
+
+  struct {
+    char* region;
+    int count;
+    int non_null;
+    int sum;
+    int min;
+  } group_cases[] = {
+    { "r0", 15, 12, 360, 4 },
+    { "r1", 15, 15, 435, 1 },
+    { "r2", 15, 12, 360, 2 },
+    { "r3", 15, 15, 465, 3 },
+  };
+
+  for (int i = 0; i < 4; i++) {
+    ck_assert_msg(group_value(&res, group_cases[i].region, 0) != NULL, "Missing group %s", group_cases[i].region);
+    ck_assert_int_eq(group_value(&res, group_cases[i].region, 1)->int_value, group_cases[i].count);
+    ck_assert_int_eq(group_value(&res, group_cases[i].region, 2)->int_value, group_cases[i].non_null);
+    ck_assert_int_eq(group_value(&res, group_cases[i].region, 3)->int_value, group_cases[i].sum);
+    ck_assert_int_eq(group_value(&res, group_cases[i].region, 4)->int_value, group_cases[i].min);
+    ck_assert(group_value(&res, group_cases[i].region, 5)->double_value == 6.5);
+  }
+
+  struct {
+    char* query;
+    int expected_rows;
+  } having_test_cases[] = {
+    { "SELECT region, SUM(amount) FROM sales GROUP BY region HAVING SUM(amount) > 400;", 2 },
+    { "SELECT region FROM sales GROUP BY region HAVING MIN(amount) <= 2 AND COUNT(*) = 15;", 2 },
+    { "SELECT region, COUNT(*) FROM sales WHERE id > 20 GROUP BY region HAVING COUNT(*) >= 10;", 4 },
+    { "SELECT region, price FROM sales GROUP BY region, price;", 28 },
+    { "SELECT COUNT(*) FROM sales HAVING COUNT(*) > 100;", 0 },
+  };
+
+  int n_cases = sizeof(having_test_cases) / sizeof(having_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    printf("Executing GROUP BY test case #%d: %s\n", i + 1, having_test_cases[i].query);
+
+    res = process(db, having_test_cases[i].query).exec;
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_msg(res.row_count == (uint32_t)having_test_cases[i].expected_rows,
+      "GROUP BY test case #%d failed: expected %d rows, got %u",
+      i + 1, having_test_cases[i].expected_rows, res.row_count);
+  }
+
+  res = process(db, "SELECT region, AVG(amount) FROM sales GROUP BY region ORDER BY region DESC LIM 2;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 2);
+  ck_assert_str_eq(res.rows[0].values[0].str_value, "r3");
+  ck_assert(res.rows[0].values[1].double_value == 31.0);
+  ck_assert_str_eq(res.rows[1].values[0].str_value, "r2");
+  ck_assert(res.rows[1].values[1].double_value == 30.0);
+
+  char* invalid_queries[] = {
+    "SELECT id % 5, COUNT(*) FROM sales GROUP BY id % 5;",
+    "SELECT COUNT(*) FROM sales GROUP BY 1 + 1;",
+    "SELECT region, COUNT(*) FROM sales GROUP region;",
+  };
+
+  for (int i = 0; i < sizeof(invalid_queries) / sizeof(invalid_queries[0]); i++) {
+    res = process_silent(db, invalid_queries[i]).exec;
+    ck_assert_msg(res.code != 0, "Invalid GROUP BY query #%d unexpectedly succeeded", i + 1);
+  }
+
+  // a budget too small for every group pushes the remaining ids through partition files
+  db->sort_memory = 1;
+
+  res = process(db, "SELECT id, COUNT(*), SUM(amount) FROM sales GROUP BY id;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 60);
+
+  int64_t total = 0;
+  for (uint32_t i = 0; i < res.row_count; i++) {
+    ck_assert_int_eq(res.rows[i].values[1].int_value, 1);
+    if (!res.rows[i].values[2].is_null) total += res.rows[i].values[2].int_value;
+  }
+  ck_assert_int_eq(total, 1830 - 210);
+
+  // groups aggregated from partition rows keep their own copies of the strings they hold on to
+  res = process(db, "SELECT region, id, MIN(region), MAX(region), MODE(region), LAST(region), COUNT(DISTINCT region) "
+    "FROM sales GROUP BY region, id;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 60);
+
+  for (uint32_t i = 0; i < res.row_count; i++) {
+    ColumnValue* v = res.rows[i].values;
+    char region[8];
+    snprintf(region, sizeof(region), "r%d", (int)(v[1].int_value % 4));
+
+    for (int c = 0; c < 6; c++) {
+      if (c != 1) ck_assert_str_eq(v[c].str_value, region);
+    }
+    ck_assert_int_eq(v[6].int_value, 1);
+  }
+
+  Result result = process_silent(db, "SELECT region, COUNT(*) FROM sales GROUP BY id;");
+  ck_assert_int_eq(result.exec.code, 0);
+
+  GroupTable table;
+  ck_assert(group_table_init(&table, db, result.cmd, result.cmd->schema, 1));
+  ck_assert_int_eq(table.aggregate_count, 1);
+
+  BufferPool* pool = &db->lake[hash_fnv1a("sales", MAX_TABLES)];
+  for (uint16_t p = 0; p < pool->num_pages; p++) {
+    for (uint16_t r = 0; r < pool->pages[p]->num_rows; r++) {
+      ck_assert(group_table_add(&table, &pool->pages[p]->rows[r]));
+    }
+  }
+  ck_assert(group_table_finish(&table));
+  ck_assert_int_eq(table.group_count, table.max_groups);
+  ck_assert(table.pending_count > 0);
+
+  uint32_t groups = 0;
+  Row row;
+  while (group_table_next(&table, &row)) groups++;
+  ck_assert(table.error == NULL);
+  ck_assert_int_eq(groups, 60);
+  group_table_free(&table);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* group_by_suite(void) {
+  Suite* s = suite_create("GroupBy");
+
+  TCase* tc_group_by = tcase_create("GroupBy");
+  tcase_add_test(tc_group_by, test_group_by);
+  suite_add_tcase(s, tc_group_by);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(group_by_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
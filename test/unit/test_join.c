@@ -0,0 +1,215 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+static JoinStrategy planned_strategy(Database* db, char* query) {
+  Result result = process_silent(db, query);
+  ck_assert_int_eq(result.exec.code, 0);
+
+  QueryOperator* pipeline = pipeline_build(db, result.cmd, result.cmd->join_schema);
+  ck_assert(pipeline != NULL);
+
+  QueryOperator* op = pipeline;
+  while (op->child) op = op->child;
+  ck_assert_int_eq(op->type, OPERATOR_JOIN);
+
+  JoinStrategy strategy = op->join.strategy;
+  pipeline_free(pipeline);
+  return strategy;
+}
+
+START_TEST(test_join) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db, "CREATE TABLE users (id INT PRIMKEY, name VARCHAR(10));").exec;
+  ck_assert_int_eq(res.code, 0);
+  res = process_silent(db, "CREATE TABLE orders (id INT PRIMKEY, user_id INT, amount INT);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  res = process_silent(db, "CREATE TABLE vips (id INT PRIMKEY, tier INT);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  // orders for user ids 41..50 have no matching user
+  char query[256];
+  for (int i = 1; i <= 40; i++) {
+    snprintf(query, sizeof(query), "INSERT INTO users VALUES (%d, 'u%d');", i, i);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "User insert #%d unexpectedly failed", i);
+  }
+  for (int i = 1; i <= 200; i++) {
+    snprintf(query, sizeof(query), "INSERT INTO orders VALUES (%d, %d, %d);", i, i % 50 + 1, i);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Order insert #%d unexpectedly failed", i);
+  }
+
+  for (int i = 1; i <= 3; i++) {
+    snprintf(query, sizeof(query), "INSERT INTO vips VALUES (%d, %d);", i * 60, i);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "VIP insert #%d unexpectedly failed", i);
+  }
+
+  struct {
+    char* query;
+    int expected_rows;
+  } join_test_cases[] = {
+    { "SELECT users.name, orders.amount FROM users JOIN orders ON users.id = orders.user_id;", 160 },
+    { "SELECT name, amount FROM orders JOIN users ON orders.user_id = users.id WHERE amount < 5;", 4 },
+    { "SELECT * FROM users JOIN orders ON users.id = orders.id;", 40 },
+    { "SELECT users.id FROM users JOIN orders ON users.id = orders.user_id AND orders.amount > 150;", 40 },
+    { "SELECT users.id FROM users JOIN orders ON orders.amount < users.id WHERE orders.id <= 10;", 345 },
+    { "SELECT users.name FROM users JOIN orders ON users.id = orders.user_id LIM 7;", 7 },
+    { "SELECT orders.amount FROM vips JOIN orders ON vips.id = orders.id;", 3 },
+  };
+
+  int n_cases = sizeof(join_test_cases) / sizeof(join_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    printf("Executing JOIN test case #%d: %s\n", i + 1, join_test_cases[i].query);
+
+    res = process(db, join_test_cases[i].query).exec;
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_msg(res.row_count == (uint32_t)join_test_cases[i].expected_rows,
+      "JOIN test case #%d failed: expected %d rows, got %u",
+      i + 1, join_test_cases[i].expected_rows, res.row_count);
+  }
+
+  res = process(db, "SELECT * FROM users JOIN orders ON users.id = orders.id LIM 1;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.rows[0].values[0].int_value, res.rows[0].values[2].int_value);
+  ck_assert_str_eq(res.aliases[3], "orders.user_id");
+
+  res = process(db, "SELECT vips.tier, orders.amount FROM orders JOIN vips ON orders.id = vips.id ORDER BY vips.tier;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 3);
+  for (uint32_t i = 0; i < res.row_count; i++) {
+    ck_assert_int_eq(res.rows[i].values[1].int_value, (i + 1) * 60);
+  }
+
+  res = process(db, "SELECT users.name, COUNT(*), SUM(orders.amount) FROM users JOIN orders ON users.id = orders.user_id GROUP BY users.name ORDER BY users.name LIM 2;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 2);
+  ck_assert_str_eq(res.rows[0].values[0].str_value, "u1");
+  ck_assert_int_eq(res.rows[0].values[1].int_value, 4);
+  ck_assert_int_eq(res.rows[0].values[2].int_value, 500);
+  ck_assert_str_eq(res.rows[1].values[0].str_value, "u10");
+  ck_assert_int_eq(res.rows[1].values[2].int_value, 336);
+
+  // a bare column name present in both tables has to be qualified
+  res = process_silent(db, "SELECT id FROM users JOIN orders ON users.id = orders.user_id;").exec;
+  ck_assert(res.code != 0);
+
+  // few outer rows against an indexed inner key favour index lookups over hashing both inputs
+  ck_assert_int_eq(join_choose_strategy(5, 100000, true, false), JOIN_INDEX_NESTED_LOOP);
+  ck_assert_int_eq(join_choose_strategy(100000, 100000, true, false), JOIN_HASH);
+  ck_assert_int_eq(join_choose_strategy(5, 100000, false, false), JOIN_HASH);
+
+  ck_assert_int_eq(planned_strategy(db, "SELECT vips.tier FROM vips JOIN orders ON vips.id = orders.id;"), JOIN_HASH);
+  ck_assert_int_eq(planned_strategy(db, "SELECT users.name FROM users JOIN orders ON users.id > orders.id;"), JOIN_NESTED_LOOP);
+
+  // schemas read back from the catalog carry no key flags, so orders.id gets its B-tree by hand
+  TableSchema* orders = get_table_schema(db, "orders");
+  uint8_t orders_idx = hash_fnv1a("orders", MAX_TABLES);
+  BTree* tree = btree_create(orders->columns[0].type);
+  ck_assert(tree != NULL);
+  orders->columns[0].is_primary_key = true;
+  db->tc[orders_idx].btree[hash_fnv1a("id", MAX_COLUMNS)] = tree;
+  db->tc[orders_idx].is_populated = true;
+
+  BufferPool* pool = &db->lake[orders_idx];
+  for (uint16_t p = 0; p < pool->num_pages; p++) {
+    Page* page = pool->pages[p];
+    for (uint16_t r = 0; page && r < page->num_rows; r++) {
+      ck_assert(btree_insert(tree, &page->rows[r].values[0].int_value, page->rows[r].id));
+    }
+  }
+
+  ck_assert_int_eq(planned_strategy(db, "SELECT users.name FROM users JOIN orders ON users.id = orders.user_id;"), JOIN_HASH);
+  ck_assert_int_eq(planned_strategy(db, "SELECT users.name FROM users JOIN orders ON users.id = orders.id;"), JOIN_HASH);
+  ck_assert_int_eq(planned_strategy(db, "SELECT vips.tier FROM vips JOIN orders ON vips.id = orders.id;"), JOIN_INDEX_NESTED_LOOP);
+  ck_assert_int_eq(planned_strategy(db, "SELECT vips.tier FROM orders JOIN vips ON orders.id = vips.id;"), JOIN_INDEX_NESTED_LOOP);
+
+  res = process(db, "SELECT vips.tier, orders.amount FROM orders JOIN vips ON orders.id = vips.id ORDER BY vips.tier;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 3);
+  for (uint32_t i = 0; i < res.row_count; i++) {
+    ck_assert_int_eq(res.rows[i].values[0].int_value, i + 1);
+    ck_assert_int_eq(res.rows[i].values[1].int_value, (i + 1) * 60);
+  }
+
+  // a budget too small for the build side sends both inputs through partition files
+  db->sort_memory = 1;
+
+  res = process(db, "SELECT users.name, orders.amount FROM users JOIN orders ON users.id = orders.user_id;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 160);
+
+  int64_t total = 0;
+  for (uint32_t i = 0; i < res.row_count; i++) {
+    char expected[16];
+    int amount = (int)res.rows[i].values[1].int_value;
+    snprintf(expected, sizeof(expected), "u%d", amount % 50 + 1);
+    ck_assert_str_eq(res.rows[i].values[0].str_value, expected);
+    total += amount;
+  }
+  ck_assert_int_eq(total, 15320);
+
+  // joined partition rows are gone by the time the sorted and aggregated results are read
+  res = process(db, "SELECT orders.id, users.name FROM users JOIN orders ON users.id = orders.user_id ORDER BY orders.id;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 160);
+  for (uint32_t i = 0; i < res.row_count; i++) {
+    char expected[16];
+    snprintf(expected, sizeof(expected), "u%d", (int)(res.rows[i].values[0].int_value % 50 + 1));
+    ck_assert_str_eq(res.rows[i].values[1].str_value, expected);
+  }
+
+  res = process(db, "SELECT users.name, MIN(users.name), MAX(users.name), COUNT(*) "
+    "FROM users JOIN orders ON users.id = orders.user_id;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 1);
+  ck_assert(res.rows[0].values[0].str_value[0] == 'u');
+  ck_assert_str_eq(res.rows[0].values[1].str_value, "u1");
+  ck_assert_str_eq(res.rows[0].values[2].str_value, "u9");
+  ck_assert_int_eq(res.rows[0].values[3].int_value, 160);
+
+  Result result = process_silent(db, "SELECT users.name FROM users JOIN orders ON users.id = orders.user_id;");
+  ck_assert_int_eq(result.exec.code, 0);
+
+  JoinExecutor join;
+  ck_assert(join_init(&join, db, result.cmd, result.cmd->join_schema, db->sort_memory));
+  ck_assert_int_eq(join.strategy, JOIN_HASH);
+  ck_assert(join.build == &join.left);
+
+  uint32_t joined = 0;
+  Row row;
+  while (join_next(&join, &row)) joined++;
+  ck_assert(join.error == NULL);
+  ck_assert(join.spilled);
+  ck_assert_int_eq(joined, 160);
+  join_free(&join);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* join_suite(void) {
+  Suite* s = suite_create("Join");
+
+  TCase* tc_join = tcase_create("Join");
+  tcase_add_test(tc_join, test_join);
+  suite_add_tcase(s, tc_join);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(join_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
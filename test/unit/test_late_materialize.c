@@ -0,0 +1,140 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+#define WIDE_TEST_ROWS 40
+
+static bool column_decoded(Page* page, uint8_t column) {
+  return !page->image || ((page->image->decoded[column / 8] >> (column % 8)) & 1);
+}
+
+// puts every page of the table through disk, leaving the pool with freshly read pages
+static void reload_pages(Database* db, const char* table) {
+  uint32_t idx = hash_fnv1a((char*)table, MAX_TABLES);
+  BufferPool* pool = &db->lake[idx];
+
+  for (uint8_t i = 0; i < pool->num_pages; i++) {
+    FILE* file = tmpfile();
+    ck_assert_msg(file != NULL, "failed to open a scratch page file");
+
+    write_page(file, 0, pool->pages[i], db->tc[idx]);
+
+    Page* page = page_init(pool->pages[i]->page_id);
+    read_page(file, 0, page, db->tc[idx]);
+    fclose(file);
+
+    pool->pages[i] = page;
+  }
+}
+
+START_TEST(test_late_materialize) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE documents (id INT PRIMKEY, owner VARCHAR(32), size INT, body TEXT, tags VARCHAR(200));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  for (int i = 1; i <= WIDE_TEST_ROWS; i++) {
+    char query[512];
+    snprintf(query, sizeof(query),
+      "INSERT INTO documents VALUES (%d, 'owner-%d', %d, 'body of document %d', 'tag-a tag-b tag-%d');",
+      i, i % 5, i * 10, i, i);
+
+    res = process_silent(db, query).exec;
+    ck_assert_int_eq(res.code, 0);
+  }
+
+  // pages read back from disk keep their values encoded
+  reload_pages(db, "documents");
+
+  BufferPool* pool = &db->lake[hash_fnv1a("documents", MAX_TABLES)];
+  ck_assert_msg(pool->num_pages >= 1, "expected the table to be loaded from disk");
+
+  Page* page = pool->pages[0];
+  ck_assert_msg(page->image != NULL, "expected the loaded page to keep its encoded rows");
+  ck_assert_msg(page->rows[0].values[3].is_null, "expected the TEXT column to stay undecoded after loading");
+
+  res = process_silent(db, "SELECT id, size FROM documents WHERE size > 300;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 10);
+  ck_assert_int_eq(res.rows[0].values[0].int_value, 31);
+  ck_assert_int_eq(res.rows[0].values[1].int_value, 310);
+
+  // the filter column was decoded for the whole page, the wide columns were never touched
+  ck_assert(column_decoded(page, 2));
+  ck_assert(!column_decoded(page, 3));
+  ck_assert(!column_decoded(page, 4));
+  ck_assert(page->rows[0].values[3].is_null);
+  ck_assert(page->rows[39].values[4].is_null);
+
+  // projected columns are decoded only for the rows that passed
+  res = process_silent(db, "SELECT body FROM documents WHERE id = 7;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 1);
+  ck_assert_str_eq(res.rows[0].values[0].str_value, "body of document 7");
+  ck_assert(!page->rows[6].values[3].is_null);
+  ck_assert(page->rows[7].values[3].is_null);
+
+  struct {
+    char* query;
+    int expected_rows;
+  } late_test_cases[] = {
+    { "SELECT * FROM documents;", WIDE_TEST_ROWS },
+    { "SELECT owner FROM documents WHERE owner = 'owner-1';", 8 },
+    { "SELECT id FROM documents WHERE tags LIKE '%tag-3%';", 11 },
+    { "SELECT id FROM documents WHERE size >= 100 ORDER BY owner LIM 3;", 3 },
+    { "SELECT owner, COUNT(*) FROM documents GROUP BY owner;", 5 },
+  };
+
+  for (int i = 0; i < sizeof(late_test_cases) / sizeof(late_test_cases[0]); i++) {
+    res = process_silent(db, late_test_cases[i].query).exec;
+
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_msg(res.row_count == late_test_cases[i].expected_rows,
+      "Late materialization test case #%d failed: expected %d rows, got %d",
+      i + 1, late_test_cases[i].expected_rows, res.row_count);
+  }
+
+  // writes decode the whole table first, so nothing is lost when the page goes back to disk
+  res = process_silent(db, "UPDATE documents SET size = 1 WHERE id = 3;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_msg(page->image == NULL, "expected an update to decode the whole table");
+
+  reload_pages(db, "documents");
+  page = pool->pages[0];
+  ck_assert(page->image != NULL);
+
+  res = process_silent(db, "SELECT body, tags FROM documents WHERE size = 1;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 1);
+  ck_assert_str_eq(res.rows[0].values[0].str_value, "body of document 3");
+  ck_assert_str_eq(res.rows[0].values[1].str_value, "tag-a tag-b tag-3");
+  ck_assert(!page->rows[2].values[3].is_null);
+  ck_assert(page->rows[3].values[3].is_null);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* late_materialize_suite(void) {
+  Suite* s = suite_create("LateMaterialize");
+
+  TCase* tc_late = tcase_create("LateMaterialize");
+  tcase_add_test(tc_late, test_late_materialize);
+  suite_add_tcase(s, tc_late);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(late_materialize_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_like_matcher) {
+  struct {
+    char* pattern;
+    char* str;
+    bool expected;
+  } match_test_cases[] = {
+    { "abc",                  "abc",                          true  },  // exact
+    { "abc",                  "abcd",                         false },
+    { "abc%",                 "abcdef",                       true  },  // prefix
+    { "abc%",                 "xabc",                         false },
+    { "%@example.com",        "jane@example.com",             true  },  // suffix
+    { "%@example.com",        "jane@example.co",              false },
+    { "%timeout%",            "request timeout after 30s",    true  },  // contains
+    { "%timeout%",            "request timed out after 30s",  false },
+    { "%timeout%",            "a long line of log output that only says timeout at the very end", true },
+    { "%zz%",                 "abcdefghijklmnopqrstuvwxyabcdefghijklmnopqrstuvwxyz", false },
+    { "a%b%c",                "axxbyyc",                      true  },  // general
+    { "a%b%c",                "axxcyyb",                      false },
+    { "a%bc%bc",              "abcbc",                        true  },
+    { "a%bc%bc",              "abc",                          false },
+    { "_o%",                  "John",                         true  },
+    { "_o%",                  "Jane",                         false },
+    { "[a-c]x[^0-9]",         "bxq",                          true  },
+    { "[a-c]x[^0-9]",         "bx7",                          false },
+    { "%",                    "",                             true  },
+    { "",                     "",                             true  },
+    { "",                     "a",                            false },
+    { "100\\%",               "100%",                         true  },
+    { "100\\%",               "1000",                         false },
+    { "(?i)%TimeOut%",        "REQUEST TIMEOUT",              true  },
+    { "(?i)%@EXAMPLE.com",    "Jane@Example.COM",             true  },
+    { "(?i)[A-C]%",           "bob",                          true  },
+    { "(?i)a_c",              "ABC",                          true  },
+    { "(?i)a@",               "A`",                           false },
+    { "%a%a%a%a%a%a%a%a%a%b", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", false },
+  };
+
+  int n_cases = sizeof(match_test_cases) / sizeof(match_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    LikeMatcher* matcher = like_compile(match_test_cases[i].pattern);
+    ck_assert_msg(matcher != NULL, "LIKE matcher test case #%d: failed to compile '%s'", i + 1, match_test_cases[i].pattern);
+
+    bool result = like_matches(matcher, match_test_cases[i].str, strlen(match_test_cases[i].str));
+    ck_assert_msg(result == match_test_cases[i].expected,
+      "LIKE matcher test case #%d failed: '%s' LIKE '%s' gave %d, expected %d",
+      i + 1, match_test_cases[i].str, match_test_cases[i].pattern, result, match_test_cases[i].expected);
+
+    ck_assert_int_eq(like_match(match_test_cases[i].str, match_test_cases[i].pattern), match_test_cases[i].expected);
+    like_free(matcher);
+  }
+}
+END_TEST
+
+START_TEST(test_select_with_compiled_like) {
+  INIT_TEST(db);
+
+  char* setup_queries[] = {
+    "CREATE TABLE logs (id INT PRIMKEY, message VARCHAR(64));",
+    "INSERT INTO logs VALUES (1, 'connection timeout on node 3');",
+    "INSERT INTO logs VALUES (2, 'Read TIMEOUT while waiting for the replica');",
+    "INSERT INTO logs VALUES (3, 'request served');",
+    "INSERT INTO logs VALUES (4, 'timeout');",
+  };
+
+  for (int i = 0; i < sizeof(setup_queries) / sizeof(setup_queries[0]); i++) {
+    ExecutionResult res = process_silent(db, setup_queries[i]).exec;
+    ck_assert_int_eq(res.code, 0);
+  }
+
+  struct {
+    char* query;
+    int expected_rows;
+  } like_test_cases[] = {
+    { "SELECT * FROM logs WHERE message LIKE '%timeout%';", 2 },
+    { "SELECT * FROM logs WHERE message LIKE '(?i)%timeout%';", 3 },
+    { "SELECT * FROM logs WHERE message LIKE 'timeout';", 1 },
+    { "SELECT * FROM logs WHERE NOT message LIKE '%timeout%';", 2 },
+  };
+
+  for (int i = 0; i < sizeof(like_test_cases) / sizeof(like_test_cases[0]); i++) {
+    ExecutionResult res = process_silent(db, like_test_cases[i].query).exec;
+
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_msg(res.row_count == like_test_cases[i].expected_rows,
+      "Compiled LIKE test case #%d failed: expected %d rows, got %d",
+      i + 1, like_test_cases[i].expected_rows, res.row_count);
+  }
+
+  db_free(db);
+}
+END_TEST
+
+Suite* like_matcher_suite(void) {
+  Suite* s = suite_create("LikeMatcher");
+
+  TCase* tc_like = tcase_create("LikeMatcher");
+  tcase_add_test(tc_like, test_like_matcher);
+  tcase_add_test(tc_like, test_select_with_compiled_like);
+  suite_add_tcase(s, tc_like);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(like_matcher_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
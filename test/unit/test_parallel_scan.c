@@ -0,0 +1,110 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_parallel_scan) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE readings (id INT PRIMKEY, sensor INT, value DOUBLE, tag VARCHAR(16));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  char query[256];
+  for (int i = 1; i <= 1000; i++) {
+    char value[32];
+    if (i % 50 == 0) snprintf(value, sizeof(value), "NULL");
+    else snprintf(value, sizeof(value), "%d.5", i % 97);
+
+    snprintf(query, sizeof(query), "INSERT INTO readings VALUES (%d, %d, %s, 'tag%d');", i, i % 8, value, i % 5);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  uint8_t schema_idx = hash_fnv1a("readings", MAX_TABLES);
+  ck_assert(db->lake[schema_idx].num_pages > 4);
+
+  struct {
+    char* query;
+    int expected_rows;
+    int expected_value;
+  } parallel_test_cases[] = {
+    { "SELECT * FROM readings;", 1000, -1 },
+    { "SELECT * FROM readings WHERE sensor = 3;", 125, -1 },
+    { "SELECT * FROM readings WHERE value > 90 AND tag LIKE 'tag1%';", 14, -1 },
+    { "SELECT * FROM readings WHERE sensor < 2 ORDER BY id DESC;", 250, -1 },
+    { "SELECT COUNT(*) FROM readings WHERE sensor != 0 LIM 1;", 1, 875 },
+    { "SELECT COUNT(value) FROM readings LIM 1;", 1, 980 },
+  };
+
+  uint32_t thread_settings[] = { 1, 4 };
+  int n_cases = sizeof(parallel_test_cases) / sizeof(parallel_test_cases[0]);
+
+  for (int t = 0; t < 2; t++) {
+    db->scan_threads = thread_settings[t];
+
+    for (int i = 0; i < n_cases; i++) {
+      printf("Executing parallel scan test case #%d with %u thread(s): %s\n",
+        i + 1, thread_settings[t], parallel_test_cases[i].query);
+
+      res = process_silent(db, parallel_test_cases[i].query).exec;
+      ck_assert_int_eq(res.code, 0);
+      ck_assert_msg(res.row_count == (uint32_t)parallel_test_cases[i].expected_rows,
+        "Parallel scan test case #%d failed with %u thread(s): expected %d rows, got %u",
+        i + 1, thread_settings[t], parallel_test_cases[i].expected_rows, res.row_count);
+
+      if (parallel_test_cases[i].expected_value != -1) {
+        ck_assert_int_eq(res.rows[0].values[0].int_value, parallel_test_cases[i].expected_value);
+      }
+
+      // selections are merged back in page order, so unordered scans stay in insertion order
+      for (uint32_t r = 1; r < res.row_count && parallel_test_cases[i].expected_value == -1; r++) {
+        int64_t prev = res.rows[r - 1].values[0].int_value;
+        int64_t cur = res.rows[r].values[0].int_value;
+        ck_assert(strstr(parallel_test_cases[i].query, "DESC") ? prev > cur : prev < cur);
+      }
+    }
+  }
+
+  ck_assert(db->workers != NULL);
+
+  res = process_silent(db, "UPDATE readings SET tag = 'hot' WHERE value > 95;").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  res = process_silent(db, "DELETE FROM readings WHERE sensor = 7;").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  db->scan_threads = 1;
+
+  res = process_silent(db, "SELECT * FROM readings WHERE tag = 'hot';").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 17);
+
+  res = process_silent(db, "SELECT * FROM readings;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 875);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* parallel_scan_suite(void) {
+  Suite* s = suite_create("ParallelScan");
+
+  TCase* tc_parallel_scan = tcase_create("ParallelScan");
+  tcase_add_test(tc_parallel_scan, test_parallel_scan);
+  suite_add_tcase(s, tc_parallel_scan);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(parallel_scan_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
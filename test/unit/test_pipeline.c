@@ -0,0 +1,100 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_pipeline) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE events (id INT PRIMKEY, kind INT, label VARCHAR(20));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  char query[256];
+  for (int i = 1; i <= 400; i++) {
+    snprintf(query, sizeof(query), "INSERT INTO events VALUES (%d, %d, 'event%d');", i, i % 4, i);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  struct {
+    char* query;
+    int expected_rows;
+    int expected_first_id;
+  } pipeline_test_cases[] = {
+    { "SELECT * FROM events;", 400, 1 },
+    { "SELECT * FROM events LIM 10;", 10, 1 },
+    { "SELECT * FROM events WHERE kind = 2 LIM 5 OFFSET 3;", 5, 14 },
+    { "SELECT * FROM events WHERE kind = 1 OFFSET 95;", 5, 381 },
+    { "SELECT * FROM events OFFSET 500;", 0, -1 },
+    { "SELECT * FROM events WHERE kind = 3 ORDER BY id DESC LIM 2;", 2, 399 },
+    { "SELECT * FROM events LIM 0;", 0, -1 },
+  };
+
+  int n_cases = sizeof(pipeline_test_cases) / sizeof(pipeline_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    printf("Executing pipeline test case #%d: %s\n", i + 1, pipeline_test_cases[i].query);
+
+    res = process_silent(db, pipeline_test_cases[i].query).exec;
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_msg(res.row_count == (uint32_t)pipeline_test_cases[i].expected_rows,
+      "Pipeline test case #%d failed: expected %d rows, got %u",
+      i + 1, pipeline_test_cases[i].expected_rows, res.row_count);
+
+    if (pipeline_test_cases[i].expected_first_id != -1) {
+      ck_assert_int_eq(res.rows[0].values[0].int_value, pipeline_test_cases[i].expected_first_id);
+    }
+  }
+
+  res = process_silent(db, "SELECT COUNT(*) FROM events WHERE kind = 0 LIM 1;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 1);
+  ck_assert_int_eq(res.rows[0].values[0].int_value, 100);
+
+  Result result = process_silent(db, "SELECT * FROM events LIM 10;");
+  ck_assert_int_eq(result.exec.code, 0);
+
+  // a satisfied limit never asks the scan for the table's later pages
+  QueryOperator* pipeline = pipeline_build(db, result.cmd, result.cmd->schema);
+  ck_assert(pipeline != NULL);
+
+  Row row;
+  int pulled = 0;
+  while (pipeline_next(pipeline, &row)) {
+    free(row.values);
+    pulled++;
+  }
+  ck_assert_int_eq(pulled, 10);
+
+  QueryOperator* scan = pipeline;
+  while (scan->child) scan = scan->child;
+  ck_assert_int_eq(scan->type, OPERATOR_SCAN);
+  ck_assert_int_eq(scan->scan.page, 1);
+  ck_assert(db->lake[scan->schema_idx].num_pages > 1);
+
+  pipeline_free(pipeline);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* pipeline_suite(void) {
+  Suite* s = suite_create("Pipeline");
+
+  TCase* tc_pipeline = tcase_create("Pipeline");
+  tcase_add_test(tc_pipeline, test_pipeline);
+  suite_add_tcase(s, tc_pipeline);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(pipeline_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_prepared) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db, "CREATE TABLE items (id INT PRIMKEY, name VARCHAR(10), price INT);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  res = process_silent(db, "PREPARE add_item AS INSERT INTO items VALUES ($1, $2, $3);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  char query[256];
+  for (int i = 1; i <= 20; i++) {
+    snprintf(query, sizeof(query), "EXECUTE add_item(%d, 'n%d', %d);", i, i, i * 10);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Prepared insert #%d unexpectedly failed", i);
+  }
+
+  res = process(db, "SELECT * FROM items;").exec;
+  ck_assert_int_eq(res.row_count, 20);
+  ck_assert_str_eq(res.rows[6].values[1].str_value, "n7");
+  ck_assert_int_eq(res.rows[6].values[2].int_value, 70);
+
+  // the same parsed command answers each binding
+  PreparedStatement* above = prepare_statement(db, NULL, "SELECT name FROM items WHERE price > $1;");
+  ck_assert(above != NULL);
+  ck_assert_int_eq(above->param_count, 1);
+
+  struct {
+    ColumnValue bound;
+    int expected_rows;
+  } bind_test_cases[] = {
+    { { .type = TOK_T_INT, .int_value = 150 }, 5 },
+    { { .type = TOK_T_INT, .int_value = 100 }, 10 },
+    { { .type = TOK_T_DOUBLE, .double_value = 185.5 }, 2 },
+    { { .type = TOK_T_INT, .is_null = true }, 0 },
+  };
+
+  int n_cases = sizeof(bind_test_cases) / sizeof(bind_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    Result result = execute_prepared(db, above, &bind_test_cases[i].bound, 1, true);
+    ck_assert_int_eq(result.exec.code, 0);
+    ck_assert_msg(result.exec.row_count == (uint32_t)bind_test_cases[i].expected_rows,
+      "Bind test case #%d failed: expected %d rows, got %u",
+      i + 1, bind_test_cases[i].expected_rows, result.exec.row_count);
+    free_result(&result);
+  }
+
+  ColumnValue wrong_type = { .type = TOK_T_STRING, .str_value = "cheap" };
+  ck_assert(execute_prepared(db, above, &wrong_type, 1, false).exec.code != 0);
+  ck_assert(execute_prepared(db, above, NULL, 0, false).exec.code != 0);
+  free_prepared_statement(above);
+
+  // strings are copied on bind, the caller's buffer may change between executions
+  PreparedStatement* add_item = find_prepared_statement(db, "add_item");
+  ck_assert(add_item != NULL);
+
+  char name[16];
+  snprintf(name, sizeof(name), "late");
+  ColumnValue params[] = {
+    { .type = TOK_T_INT, .int_value = 21 },
+    { .type = TOK_T_VARCHAR, .str_value = name },
+    { .type = TOK_T_INT, .int_value = 5 },
+  };
+  ck_assert_int_eq(execute_prepared(db, add_item, params, 3, false).exec.code, 0);
+  snprintf(name, sizeof(name), "changed");
+
+  PreparedStatement* by_name = prepare_statement(db, "by_name", "SELECT id, price FROM items WHERE name = $1;");
+  ck_assert(by_name != NULL);
+
+  ColumnValue lookup = { .type = TOK_T_VARCHAR, .str_value = "late" };
+  Result result = execute_prepared(db, by_name, &lookup, 1, true);
+  ck_assert_int_eq(result.exec.row_count, 1);
+  ck_assert_int_eq(result.exec.rows[0].values[0].int_value, 21);
+  free_result(&result);
+
+  res = process_silent(db, "PREPARE set_price AS UPDATE items SET price = $1 WHERE id = $2;").exec;
+  ck_assert_int_eq(res.code, 0);
+  res = process_silent(db, "EXECUTE set_price(999, 3);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  res = process(db, "EXECUTE by_name('n3');").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 1);
+  ck_assert_int_eq(res.rows[0].values[1].int_value, 999);
+
+  struct {
+    char* query;
+  } error_test_cases[] = {
+    { "SELECT name FROM items WHERE id = $1;" },
+    { "EXECUTE by_name;" },
+    { "EXECUTE by_name('n1', 'n2');" },
+    { "EXECUTE missing(1);" },
+    { "PREPARE by_name AS SELECT id FROM items;" },
+    { "PREPARE nested AS EXECUTE by_name('n1');" },
+    { "SELECT name FROM items WHERE id = $0;" },
+  };
+
+  n_cases = sizeof(error_test_cases) / sizeof(error_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    res = process_silent(db, error_test_cases[i].query).exec;
+    ck_assert_msg(res.code != 0, "Error test case #%d unexpectedly succeeded: %s", i + 1, error_test_cases[i].query);
+  }
+
+  res = process_silent(db, "DEALLOCATE by_name;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert(find_prepared_statement(db, "by_name") == NULL);
+  ck_assert(process_silent(db, "EXECUTE by_name('n1');").exec.code != 0);
+  ck_assert(process_silent(db, "DEALLOCATE by_name;").exec.code != 0);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* prepared_suite(void) {
+  Suite* s = suite_create("Prepared");
+
+  TCase* tc_prepared = tcase_create("Prepared");
+  tcase_add_test(tc_prepared, test_prepared);
+  suite_add_tcase(s, tc_prepared);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(prepared_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
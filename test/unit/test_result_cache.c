@@ -0,0 +1,178 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+#define CACHE_TEST_ROWS 100
+
+START_TEST(test_result_cache) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE items (id INT PRIMKEY, kind INT, label VARCHAR(16));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  for (int i = 1; i <= CACHE_TEST_ROWS; i++) {
+    char query[256];
+    snprintf(query, sizeof(query), "INSERT INTO items VALUES (%d, %d, 'l%d');", i, i % 5, i);
+
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  res = process_silent(db, "CREATE TABLE other (id INT PRIMKEY, note VARCHAR(16));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  // off by default
+  res = process_silent(db, "SELECT id FROM items WHERE kind = 1;").exec;
+  ck_assert_int_eq(res.row_count, 20);
+  ck_assert(db->results == NULL);
+
+  db->result_cache_memory = 1024 * 1024;
+
+  ExecutionResult first = process_silent(db, "SELECT id, label FROM items WHERE kind = 1 ORDER BY id;").exec;
+  ck_assert_int_eq(first.code, 0);
+  ck_assert_int_eq(first.row_count, 20);
+  ck_assert_ptr_nonnull(db->results);
+  ck_assert_int_eq(db->results->misses, 1);
+  ck_assert_int_eq(db->results->count, 1);
+
+  // spacing does not change the fingerprint, the hit hands out its own copy of the rows
+  ExecutionResult second = process_silent(db, "SELECT   id,label FROM items\n WHERE kind=1 ORDER BY id ;").exec;
+  ck_assert_int_eq(second.code, 0);
+  ck_assert_int_eq(db->results->hits, 1);
+  ck_assert_int_eq(second.row_count, first.row_count);
+  ck_assert_str_eq(second.aliases[1], "label");
+
+  for (uint32_t i = 0; i < first.row_count; i++) {
+    ck_assert_int_eq(second.rows[i].values[0].int_value, first.rows[i].values[0].int_value);
+    ck_assert_str_eq(second.rows[i].values[1].str_value, first.rows[i].values[1].str_value);
+    ck_assert(second.rows[i].values[1].str_value != first.rows[i].values[1].str_value);
+  }
+
+  // a different literal is a different statement
+  res = process_silent(db, "SELECT id, label FROM items WHERE kind = 2 ORDER BY id;").exec;
+  ck_assert_int_eq(db->results->misses, 2);
+  ck_assert_int_eq(db->results->count, 2);
+
+  struct {
+    char* write;
+    bool invalidates;
+    int expected_rows; // SELECT id, label FROM items WHERE kind = 1 afterwards
+  } write_test_cases[] = {
+    { "INSERT INTO other VALUES (1, 'x');", false, 20 },
+    { "UPDATE other SET note = 'y' WHERE id = 1;", false, 20 },
+    { "INSERT INTO items VALUES (101, 1, 'new');", true, 21 },
+    { "UPDATE items SET kind = 3 WHERE id = 1;", true, 20 },
+    { "UPDATE items SET label = 'same' WHERE id = 500;", false, 20 },
+    { "DELETE FROM items WHERE id = 6;", true, 19 },
+    { "DELETE FROM other WHERE id = 1;", false, 19 },
+  };
+
+  for (int i = 0; i < sizeof(write_test_cases) / sizeof(write_test_cases[0]); i++) {
+    res = process_silent(db, "SELECT id, label FROM items WHERE kind = 1 ORDER BY id;").exec;
+    ck_assert_int_eq(res.code, 0);
+
+    res = process_silent(db, write_test_cases[i].write).exec;
+    ck_assert_msg(res.code == 0, "Write #%d unexpectedly failed", i + 1);
+
+    uint64_t hits = db->results->hits;
+    res = process_silent(db, "SELECT id, label FROM items WHERE kind = 1 ORDER BY id;").exec;
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_msg((db->results->hits == hits) == write_test_cases[i].invalidates,
+      "Write #%d: expected the cached result to be %s", i + 1, write_test_cases[i].invalidates ? "dropped" : "kept");
+    ck_assert_msg(res.row_count == write_test_cases[i].expected_rows,
+      "Write #%d: expected %d rows, got %u", i + 1, write_test_cases[i].expected_rows, res.row_count);
+  }
+
+  // prepared statements are keyed on their parameters as well
+  res = process_silent(db, "PREPARE by_kind AS SELECT id FROM items WHERE kind = $1;").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  uint64_t hits = db->results->hits;
+  res = process_silent(db, "EXECUTE by_kind(2);").exec;
+  ck_assert_int_eq(res.row_count, 20);
+  res = process_silent(db, "EXECUTE by_kind(2);").exec;
+  ck_assert_int_eq(res.row_count, 20);
+  ck_assert_int_eq(db->results->hits, hits + 1);
+
+  res = process_silent(db, "EXECUTE by_kind(3);").exec;
+  ck_assert_int_eq(res.row_count, 21);
+  ck_assert_int_eq(res.rows[0].values[0].int_value, 1);
+  ck_assert_int_eq(db->results->hits, hits + 1);
+
+  // statements that can answer differently on their own never enter the cache
+  char* uncacheable_queries[] = {
+    "SELECT id FROM items TABLESAMPLE BERNOULLI (50);",
+    "SELECT id, RAND() FROM items;",
+    "SELECT NOW() FROM items LIM 1;",
+  };
+
+  for (int i = 0; i < sizeof(uncacheable_queries) / sizeof(uncacheable_queries[0]); i++) {
+    uint32_t count = db->results->count;
+    uint64_t misses = db->results->misses;
+
+    for (int run = 0; run < 2; run++) {
+      res = process_silent(db, uncacheable_queries[i]).exec;
+      ck_assert_msg(res.code == 0, "Uncacheable query #%d unexpectedly failed", i + 1);
+    }
+
+    ck_assert_msg(db->results->count == count && db->results->misses == misses,
+      "Uncacheable query #%d was cached", i + 1);
+  }
+
+  res = process_silent(db, "SELECT id FROM items TABLESAMPLE BERNOULLI (50) REPEATABLE (4);").exec;
+  res = process_silent(db, "SELECT id FROM items TABLESAMPLE BERNOULLI (50) REPEATABLE (4);").exec;
+  ck_assert_int_eq(db->results->hits, hits + 2);
+
+  // past the memory cap the least recently used entries go first
+  result_cache_free(db);
+  res = process_silent(db, "SELECT id, label FROM items WHERE kind = 0;").exec;
+  size_t entry_bytes = db->results->bytes;
+  db->result_cache_memory = entry_bytes * 2 + entry_bytes / 2;
+
+  res = process_silent(db, "SELECT id, label FROM items WHERE kind = 2;").exec;
+  res = process_silent(db, "SELECT id, label FROM items WHERE kind = 0;").exec;
+  ck_assert_int_eq(db->results->hits, 1);
+
+  res = process_silent(db, "SELECT id, label FROM items WHERE kind = 4;").exec;
+  ck_assert_int_eq(db->results->evictions, 1);
+  ck_assert_int_eq(db->results->count, 2);
+  ck_assert(db->results->bytes <= db->result_cache_memory);
+
+  res = process_silent(db, "SELECT id, label FROM items WHERE kind = 0;").exec;
+  ck_assert_int_eq(db->results->hits, 2);
+  res = process_silent(db, "SELECT id, label FROM items WHERE kind = 2;").exec;
+  ck_assert_int_eq(db->results->hits, 2);
+
+  // turning it off releases the entries
+  db->result_cache_memory = 0;
+  res = process_silent(db, "SELECT id FROM items WHERE kind = 0;").exec;
+  ck_assert_int_eq(res.row_count, 20);
+  ck_assert(db->results == NULL);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* result_cache_suite(void) {
+  Suite* s = suite_create("ResultCache");
+
+  TCase* tc_cache = tcase_create("ResultCache");
+  tcase_add_test(tc_cache, test_result_cache);
+  suite_add_tcase(s, tc_cache);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(result_cache_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
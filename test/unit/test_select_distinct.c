@@ -0,0 +1,212 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+#define DISTINCT_TEST_ROWS 60
+
+static ColumnValue decimal_value(const char* digits) {
+  ColumnValue value = { .type = TOK_T_DECIMAL };
+  strcpy(value.decimal.decimal_value, digits);
+  return value;
+}
+
+static bool same_key(ColumnValue a, ColumnValue b, uint8_t type) {
+  uint64_t ha = 0, hb = 0;
+  ck_assert(hash_column_value(&a, type, &ha));
+  ck_assert(hash_column_value(&b, type, &hb));
+
+  bool equal = column_values_equal(&a, &b, type);
+  if (equal) ck_assert_msg(ha == hb, "equal values must hash alike");
+  return equal;
+}
+
+START_TEST(test_distinct_hashing) {
+  struct {
+    ColumnValue a;
+    ColumnValue b;
+    uint8_t type;
+    bool expected;
+  } key_test_cases[] = {
+    { decimal_value("1.50"), decimal_value("01.5"), TOK_T_DECIMAL, true },
+    { decimal_value("-0.00"), decimal_value("0"), TOK_T_DECIMAL, true },
+    { decimal_value("1.5"), decimal_value("1.05"), TOK_T_DECIMAL, false },
+    { decimal_value("-2"), decimal_value("2.0"), TOK_T_DECIMAL, false },
+    { { .type = TOK_T_DATE, .date_value = 738000 }, { .type = TOK_T_DATE, .date_value = 738000 }, TOK_T_DATE, true },
+    { { .type = TOK_T_DATE, .date_value = 738000 }, { .type = TOK_T_DATE, .date_value = 738001 }, TOK_T_DATE, false },
+    { { .type = TOK_T_DATETIME, .datetime_value = { 2025, 5, 1, 10, 30, 0 } },
+      { .type = TOK_T_DATETIME, .datetime_value = { 2025, 5, 1, 10, 30, 0 } }, TOK_T_DATETIME, true },
+    { { .type = TOK_T_DATETIME, .datetime_value = { 2025, 5, 1, 10, 30, 0 } },
+      { .type = TOK_T_DATETIME, .datetime_value = { 2025, 5, 1, 10, 30, 1 } }, TOK_T_DATETIME, false },
+    { { .type = TOK_T_TIMESTAMP, .timestamp_value = { 1746000000 } },
+      { .type = TOK_T_TIMESTAMP, .timestamp_value = { 1746000000 } }, TOK_T_TIMESTAMP, true },
+    { { .type = TOK_T_INTERVAL, .interval_value = { 1, 2, 3 } },
+      { .type = TOK_T_INTERVAL, .interval_value = { 1, 2, 4 } }, TOK_T_INTERVAL, false },
+    { { .type = TOK_T_DOUBLE, .double_value = 0.0 }, { .type = TOK_T_DOUBLE, .double_value = -0.0 }, TOK_T_DOUBLE, true },
+    { { .type = TOK_T_VARCHAR, .str_value = "a" }, { .type = TOK_T_STRING, .str_value = "a" }, TOK_T_TBEV, true },
+    { { .type = TOK_T_INT, .int_value = 1 }, { .type = TOK_T_DOUBLE, .double_value = 1.0 }, TOK_T_TBEV, false },
+    { { .type = TOK_T_INT, .is_null = true }, { .type = TOK_T_VARCHAR, .is_null = true }, TOK_T_TBEV, true },
+  };
+
+  for (int i = 0; i < sizeof(key_test_cases) / sizeof(key_test_cases[0]); i++) {
+    bool equal = same_key(key_test_cases[i].a, key_test_cases[i].b, key_test_cases[i].type);
+    ck_assert_msg(equal == key_test_cases[i].expected,
+      "Distinct key test case #%d failed: expected %d, got %d", i + 1, key_test_cases[i].expected, equal);
+  }
+}
+END_TEST
+
+START_TEST(test_select_distinct) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE visits (id INT PRIMKEY, visitor VARCHAR(16), day DATE, score DOUBLE);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  for (int i = 1; i <= DISTINCT_TEST_ROWS; i++) {
+    char query[256];
+    if (i % 10 == 0) {
+      snprintf(query, sizeof(query), "INSERT INTO visits VALUES (%d, NULL, '2025-05-%02d', %d.5);",
+        i, i % 3 + 1, i % 4);
+    } else {
+      snprintf(query, sizeof(query), "INSERT INTO visits VALUES (%d, 'v%d', '2025-05-%02d', %d.5);",
+        i, i % 7, i % 3 + 1, i % 4);
+    }
+
+    res = process_silent(db, query).exec;
+    ck_assert_int_eq(res.code, 0);
+  }
+
+  struct {
+    char* query;
+    int expected_rows;
+  } distinct_test_cases[] = {
+    { "SELECT DISTINCT visitor FROM visits;", 8 },
+    { "SELECT DISTINCT day FROM visits;", 3 },
+    { "SELECT DISTINCT day, score FROM visits;", 12 },
+    { "SELECT DISTINCT score * 2 FROM visits;", 4 },
+    { "SELECT DISTINCT * FROM visits;", DISTINCT_TEST_ROWS },
+    { "SELECT DISTINCT visitor FROM visits WHERE id <= 7;", 7 },
+    { "SELECT DISTINCT day FROM visits LIM 2;", 2 },
+    { "SELECT DISTINCT visitor FROM visits ORDER BY visitor LIM 3;", 3 },
+    { "SELECT DISTINCT COUNT(*) FROM visits GROUP BY day;", 1 },
+    { "SELECT day, COUNT(DISTINCT visitor) FROM visits GROUP BY day;", 3 },
+  };
+
+  for (int i = 0; i < sizeof(distinct_test_cases) / sizeof(distinct_test_cases[0]); i++) {
+    res = process_silent(db, distinct_test_cases[i].query).exec;
+
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_msg(res.row_count == distinct_test_cases[i].expected_rows,
+      "DISTINCT test case #%d failed: expected %d rows, got %d",
+      i + 1, distinct_test_cases[i].expected_rows, res.row_count);
+  }
+
+  // NULLs are not counted, and the sets of parallel morsels merge
+  res = process_silent(db, "SELECT COUNT(DISTINCT visitor), COUNT(DISTINCT day), COUNT(*) FROM visits LIM 1;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 1);
+  ck_assert_int_eq(res.rows[0].values[0].int_value, 7);
+  ck_assert_int_eq(res.rows[0].values[1].int_value, 3);
+  ck_assert_int_eq(res.rows[0].values[2].int_value, DISTINCT_TEST_ROWS);
+
+  res = process_silent(db, "SELECT day, COUNT(DISTINCT visitor) FROM visits GROUP BY day;").exec;
+  for (uint32_t i = 0; i < res.row_count; i++) {
+    ck_assert_int_eq(res.rows[i].values[1].int_value, 7);
+  }
+
+  res = process_silent(db, "SELECT SUM(DISTINCT score) FROM visits;").exec;
+  ck_assert(res.code != 0);
+
+  // a budget too small for every key pushes the unseen ones through partition files
+  db->sort_memory = 1;
+
+  int expected_pairs = 0;
+  for (int i = 1; i <= DISTINCT_TEST_ROWS; i++) {
+    bool seen = false;
+    for (int j = 1; j < i && !seen; j++) {
+      bool same_visitor = (i % 10 == 0 && j % 10 == 0) || (i % 10 && j % 10 && i % 7 == j % 7);
+      seen = same_visitor && i % 4 == j % 4;
+    }
+    expected_pairs += !seen;
+  }
+
+  res = process_silent(db, "SELECT DISTINCT visitor, score FROM visits;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, expected_pairs);
+
+  res = process_silent(db, "SELECT DISTINCT id, day FROM visits ORDER BY id;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, DISTINCT_TEST_ROWS);
+  for (uint32_t i = 0; i < res.row_count; i++) {
+    ck_assert_int_eq(res.rows[i].values[0].int_value, i + 1);
+  }
+
+  // strings of rows deduplicated from partition files outlive the table they were read into
+  res = process_silent(db, "SELECT DISTINCT id, visitor FROM visits ORDER BY id;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, DISTINCT_TEST_ROWS);
+  for (uint32_t i = 0; i < res.row_count; i++) {
+    int id = (int)res.rows[i].values[0].int_value;
+    ck_assert_int_eq(id, i + 1);
+
+    if (id % 10 == 0) {
+      ck_assert(res.rows[i].values[1].is_null);
+      continue;
+    }
+
+    char visitor[8];
+    snprintf(visitor, sizeof(visitor), "v%d", id % 7);
+    ck_assert_str_eq(res.rows[i].values[1].str_value, visitor);
+  }
+
+  Result result = process_silent(db, "SELECT DISTINCT id FROM visits;");
+  ck_assert_int_eq(result.exec.code, 0);
+
+  DistinctTable table;
+  ck_assert(distinct_table_init(&table, db, result.cmd, result.cmd->schema, 1));
+
+  uint32_t emitted = 0;
+  BufferPool* pool = &db->lake[hash_fnv1a("visits", MAX_TABLES)];
+  for (uint16_t p = 0; p < pool->num_pages; p++) {
+    for (uint16_t r = 0; r < pool->pages[p]->num_rows; r++) {
+      bool is_new;
+      ck_assert(distinct_table_add(&table, &pool->pages[p]->rows[r], &is_new));
+      emitted += is_new;
+    }
+  }
+  ck_assert_int_eq(emitted, table.max_keys);
+  ck_assert(table.spill_files > 0);
+
+  Row row;
+  while (distinct_table_next_spilled(&table, &row)) emitted++;
+  ck_assert(table.error == NULL);
+  ck_assert_int_eq(emitted, DISTINCT_TEST_ROWS);
+  distinct_table_free(&table);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* select_distinct_suite(void) {
+  Suite* s = suite_create("SelectDistinct");
+
+  TCase* tc_distinct = tcase_create("SelectDistinct");
+  tcase_add_test(tc_distinct, test_distinct_hashing);
+  tcase_add_test(tc_distinct, test_select_distinct);
+  suite_add_tcase(s, tc_distinct);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(select_distinct_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
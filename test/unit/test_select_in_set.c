@@ -0,0 +1,85 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_select_in_set) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE readings (id INT PRIMKEY, sensor VARCHAR(16), taken DATE, value DOUBLE, ok BOOL);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  for (int i = 1; i <= 40; i++) {
+    char query[256];
+    snprintf(query, sizeof(query),
+      "INSERT INTO readings VALUES (%d, 'sensor-%d', '2025-04-%02d', %d.5, %s);",
+      i, i % 4, (i % 28) + 1, i, i % 2 ? "true" : "false");
+
+    res = process_silent(db, query).exec;
+    ck_assert_int_eq(res.code, 0);
+  }
+
+  struct {
+    char* query;
+    int expected_rows;
+  } in_test_cases[] = {
+    { "SELECT * FROM readings WHERE id IN (1, 2, 3, 99);", 3 },
+    { "SELECT * FROM readings WHERE sensor IN ('sensor-1', 'sensor-3');", 20 },
+    { "SELECT * FROM readings WHERE taken IN ('2025-04-02', '2025-04-03');", 4 },
+    { "SELECT * FROM readings WHERE value IN (1.5, 10.5, 7);", 2 },
+    { "SELECT * FROM readings WHERE ok IN (true);", 20 },
+    { "SELECT * FROM readings WHERE id IN (4, NULL);", 1 },
+    { "SELECT * FROM readings WHERE NOT id IN (1, 2, 3);", 37 },
+    { "SELECT * FROM readings WHERE id IN (1, 2, 3) AND sensor IN ('sensor-1');", 1 },
+    { "SELECT * FROM readings WHERE id IN (id, 1);", 40 },
+  };
+
+  for (int i = 0; i < sizeof(in_test_cases) / sizeof(in_test_cases[0]); i++) {
+    res = process_silent(db, in_test_cases[i].query).exec;
+
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_msg(res.row_count == in_test_cases[i].expected_rows,
+      "IN set test case #%d failed: expected %d rows, got %d",
+      i + 1, in_test_cases[i].expected_rows, res.row_count);
+  }
+
+  // thousands of ids, only the even ones up to 40 exist
+  size_t capacity = 64 * 1024;
+  char* query = malloc(capacity);
+  size_t len = snprintf(query, capacity, "SELECT * FROM readings WHERE id IN (");
+  for (int i = 0; i < 3000; i++) {
+    len += snprintf(query + len, capacity - len, "%s%d", i ? ", " : "", i * 2);
+  }
+  snprintf(query + len, capacity - len, ");");
+
+  res = process_silent(db, query).exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 20);
+  free(query);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* in_set_suite(void) {
+  Suite* s = suite_create("SelectInSet");
+
+  TCase* tc_in = tcase_create("SelectInSet");
+  tcase_add_test(tc_in, test_select_in_set);
+  suite_add_tcase(s, tc_in);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(in_set_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
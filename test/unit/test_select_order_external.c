@@ -0,0 +1,131 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_select_order_external) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE ledger (id INT PRIMKEY, amount INT, memo VARCHAR(20), rate DOUBLE);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  char query[256];
+  for (int i = 1; i <= 300; i++) {
+    int amount = (i * 53) % 300;
+    snprintf(query, sizeof(query), "INSERT INTO ledger VALUES (%d, %d, 'memo%d', %s);",
+      i, amount, amount, i % 25 == 0 ? "NULL" : "1.5");
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  // small enough that every ORDER BY below spills several sorted runs; the memo
+  // strings count against it too, so a run holds fewer than 20 rows
+  db->sort_memory = 20 * (sizeof(Row) + 4 * sizeof(ColumnValue));
+
+  struct {
+    char* query;
+    int expected_rows;
+    int first_amount;
+    int step;
+  } external_sort_test_cases[] = {
+    { "SELECT * FROM ledger ORDER BY amount ASC;", 300, 0, 1 },
+    { "SELECT * FROM ledger ORDER BY amount DESC;", 300, 299, -1 },
+    { "SELECT * FROM ledger WHERE amount >= 100 ORDER BY amount ASC OFFSET 50;", 150, 150, 1 },
+    { "SELECT * FROM ledger ORDER BY id ASC;", 300, -1, 0 },
+  };
+
+  int n_cases = sizeof(external_sort_test_cases) / sizeof(external_sort_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    printf("Executing external sort test case #%d: %s\n", i + 1, external_sort_test_cases[i].query);
+
+    res = process_silent(db, external_sort_test_cases[i].query).exec;
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_msg(res.row_count == (uint32_t)external_sort_test_cases[i].expected_rows,
+      "External sort test case #%d failed: expected %d rows, got %u",
+      i + 1, external_sort_test_cases[i].expected_rows, res.row_count);
+
+    for (uint32_t r = 0; r < res.row_count; r++) {
+      int64_t id = res.rows[r].values[0].int_value;
+      int64_t amount = res.rows[r].values[1].int_value;
+
+      if (external_sort_test_cases[i].step == 0) {
+        ck_assert_int_eq(id, r + 1);
+      } else {
+        ck_assert_int_eq(amount, external_sort_test_cases[i].first_amount + (int)r * external_sort_test_cases[i].step);
+      }
+
+      char memo[32];
+      snprintf(memo, sizeof(memo), "memo%ld", (long)amount);
+      ck_assert_str_eq(res.rows[r].values[2].str_value, memo);
+      ck_assert(res.rows[r].values[3].is_null == (id % 25 == 0));
+    }
+  }
+
+  Result result = process_silent(db, "SELECT * FROM ledger ORDER BY amount ASC;");
+  ck_assert_int_eq(result.exec.code, 0);
+
+  QueryOperator* pipeline = pipeline_build(db, result.cmd, result.cmd->schema);
+  ck_assert(pipeline != NULL);
+
+  Row row;
+  ck_assert(pipeline_next(pipeline, &row));
+  free(row.values);
+
+  QueryOperator* sort = pipeline;
+  while (sort && sort->type != OPERATOR_SORT) sort = sort->child;
+  ck_assert(sort != NULL);
+  // rows arrive in id order and a run closes once the next row would pass the budget
+  uint32_t runs = 1, buffered = 0;
+  size_t bytes = 0;
+  for (int i = 1; i <= 300; i++) {
+    char memo[32];
+    size_t row_bytes = sizeof(Row) + 4 * sizeof(ColumnValue) + snprintf(memo, sizeof(memo), "memo%d", (i * 53) % 300) + 1;
+
+    if (buffered >= 2 && bytes + row_bytes > db->sort_memory) {
+      runs++;
+      buffered = 0;
+      bytes = 0;
+    }
+
+    buffered++;
+    bytes += row_bytes;
+  }
+
+  ck_assert(runs > 15);
+  ck_assert_int_eq(sort->sort.sorter.run_count, runs);
+  ck_assert_int_eq(sort->sort.sorter.spilled_rows, 300);
+
+  pipeline_free(pipeline);
+
+  db->sort_memory = DEFAULT_SORT_MEMORY;
+
+  res = process_silent(db, "SELECT * FROM ledger ORDER BY amount DESC LIM 3;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 3);
+  ck_assert_int_eq(res.rows[0].values[1].int_value, 299);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* select_order_external_suite(void) {
+  Suite* s = suite_create("SelectOrderExternal");
+
+  TCase* tc_external = tcase_create("SelectOrderExternal");
+  tcase_add_test(tc_external, test_select_order_external);
+  suite_add_tcase(s, tc_external);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(select_order_external_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_select_order_keys) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE players (id INT PRIMKEY, team INT, handle VARCHAR(20), rating DOUBLE);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  const char* handles[] = { "ab", "abc", "a", "b", "zeta", "Zeta", "abd" };
+
+  char query[256];
+  for (int i = 1; i <= 210; i++) {
+    char rating[32];
+    if (i % 17 == 0) snprintf(rating, sizeof(rating), "NULL");
+    else snprintf(rating, sizeof(rating), "%d.25", (i * 31) % 50);
+
+    snprintf(query, sizeof(query), "INSERT INTO players VALUES (%d, %d, '%s', %s);",
+      i, (i * 7) % 5, handles[i % 7], rating);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  char* order_test_cases[] = {
+    "SELECT * FROM players ORDER BY team ASC, rating DESC;",
+    "SELECT * FROM players ORDER BY handle ASC, id DESC;",
+    "SELECT * FROM players ORDER BY rating ASC, handle DESC, id ASC;",
+    "SELECT * FROM players WHERE team < 1 ORDER BY handle DESC, team ASC, id ASC;",
+  };
+
+  int n_cases = sizeof(order_test_cases) / sizeof(order_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    printf("Executing sort key test case #%d: %s\n", i + 1, order_test_cases[i]);
+
+    Result result = process_silent(db, order_test_cases[i]);
+    ck_assert_int_eq(result.exec.code, 0);
+    ck_assert(result.exec.row_count > 32);
+
+    for (uint32_t r = 1; r < result.exec.row_count; r++) {
+      ck_assert_msg(compare_rows(&result.exec.rows[r - 1], &result.exec.rows[r], result.cmd, result.cmd->schema) <= 0,
+        "Sort key test case #%d failed: rows %u and %u are out of order", i + 1, r, r + 1);
+    }
+  }
+
+  res = process_silent(db, "SELECT * FROM players ORDER BY rating DESC, id ASC LIM 1;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert(res.rows[0].values[3].double_value == 49.25);
+
+  res = process_silent(db, "SELECT * FROM players ORDER BY team ASC, rating ASC;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.rows[0].values[1].int_value, 0);
+  ck_assert(res.rows[0].values[3].is_null);
+
+  res = process_silent(db, "SELECT * FROM players ORDER BY handle DESC, id ASC;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_str_eq(res.rows[0].values[2].str_value, "zeta");
+  ck_assert_int_eq(res.rows[0].values[0].int_value, 4);
+
+  // signed and fractional keys, built directly since literals here are non-negative
+  int64_t ints[] = { 5, -3, 0, INT64_MIN, 7000000000LL, -7000000000LL, 1 };
+  double doubles[] = { -0.5, 2.25, -100.0, 0.0, 1e10, -1e-3, 3.5 };
+  Row rows[7];
+  ColumnValue values[7][2];
+
+  for (int i = 0; i < 7; i++) {
+    memset(&rows[i], 0, sizeof(Row));
+    memset(values[i], 0, sizeof(values[i]));
+    values[i][0].type = TOK_T_INT;
+    values[i][0].int_value = ints[i];
+    values[i][1].type = TOK_T_DOUBLE;
+    values[i][1].double_value = doubles[i];
+    rows[i].values = values[i];
+    rows[i].n_values = 2;
+  }
+
+  struct order_by order_by[] = { { .col = 0, .decend = false } };
+  JQLCommand cmd = { .order_by_count = 1, .order_by = order_by };
+
+  ck_assert(sort_rows_by_key(rows, 7, &cmd));
+  int64_t sorted_ints[] = { INT64_MIN, -7000000000LL, -3, 0, 1, 5, 7000000000LL };
+  for (int i = 0; i < 7; i++) {
+    ck_assert(rows[i].values[0].int_value == sorted_ints[i]);
+  }
+
+  order_by[0] = (struct order_by){ .col = 1, .decend = true };
+  ck_assert(sort_rows_by_key(rows, 7, &cmd));
+  double sorted_doubles[] = { 1e10, 3.5, 2.25, 0.0, -1e-3, -0.5, -100.0 };
+  for (int i = 0; i < 7; i++) {
+    ck_assert(rows[i].values[1].double_value == sorted_doubles[i]);
+  }
+
+  db_free(db);
+}
+END_TEST
+
+Suite* select_order_keys_suite(void) {
+  Suite* s = suite_create("SelectOrderKeys");
+
+  TCase* tc_order_keys = tcase_create("SelectOrderKeys");
+  tcase_add_test(tc_order_keys, test_select_order_keys);
+  suite_add_tcase(s, tc_order_keys);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(select_order_keys_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
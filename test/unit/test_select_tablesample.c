@@ -0,0 +1,124 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+#define SAMPLE_TEST_ROWS 1000
+
+START_TEST(test_select_tablesample) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE samples (id INT PRIMKEY, bucket INT, amount DOUBLE);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  for (int i = 1; i <= SAMPLE_TEST_ROWS; i++) {
+    char query[128];
+    snprintf(query, sizeof(query), "INSERT INTO samples VALUES (%d, %d, %d.5);", i, i % 4, i);
+
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  BufferPool* pool = &db->lake[hash_fnv1a("samples", MAX_TABLES)];
+  ck_assert_msg(pool->num_pages >= 4, "expected the table to span several pages, got %d", pool->num_pages);
+
+  struct {
+    char* query;
+    int min_rows;
+    int max_rows;
+  } sample_test_cases[] = {
+    { "SELECT * FROM samples TABLESAMPLE SYSTEM (0);", 0, 0 },
+    { "SELECT * FROM samples TABLESAMPLE SYSTEM (100);", SAMPLE_TEST_ROWS, SAMPLE_TEST_ROWS },
+    { "SELECT * FROM samples TABLESAMPLE BERNOULLI (0);", 0, 0 },
+    { "SELECT * FROM samples TABLESAMPLE BERNOULLI (100);", SAMPLE_TEST_ROWS, SAMPLE_TEST_ROWS },
+    { "SELECT id FROM samples TABLESAMPLE BERNOULLI (30) REPEATABLE (7);", 200, 400 },
+    { "SELECT id FROM samples TABLESAMPLE BERNOULLI (12.5);", 50, 200 },
+    { "SELECT id FROM samples TABLESAMPLE BERNOULLI (50) REPEATABLE (7) WHERE bucket = 1;", 75, 175 },
+    { "SELECT id FROM samples TABLESAMPLE BERNOULLI (50) REPEATABLE (7) LIM 10;", 10, 10 },
+    { "SELECT id FROM samples TABLESAMPLE SYSTEM (50) REPEATABLE (3) ORDER BY id;", 1, SAMPLE_TEST_ROWS - 1 },
+  };
+
+  for (int i = 0; i < sizeof(sample_test_cases) / sizeof(sample_test_cases[0]); i++) {
+    res = process_silent(db, sample_test_cases[i].query).exec;
+
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_msg(res.row_count >= sample_test_cases[i].min_rows && res.row_count <= sample_test_cases[i].max_rows,
+      "TABLESAMPLE test case #%d failed: expected %d to %d rows, got %d",
+      i + 1, sample_test_cases[i].min_rows, sample_test_cases[i].max_rows, res.row_count);
+  }
+
+  // a seeded sample is the same whether one or several workers scan it
+  uint32_t system_rows = 0;
+  for (uint32_t threads = 1; threads <= 4; threads += 3) {
+    db->scan_threads = threads;
+
+    res = process_silent(db, "SELECT id, bucket FROM samples TABLESAMPLE SYSTEM (50) REPEATABLE (3);").exec;
+    ck_assert_int_eq(res.code, 0);
+    if (threads == 1) system_rows = res.row_count;
+    ck_assert_int_eq(res.row_count, system_rows);
+
+    // SYSTEM keeps or drops whole pages
+    bool* seen = calloc(SAMPLE_TEST_ROWS + 1, sizeof(bool));
+    for (uint32_t r = 0; r < res.row_count; r++) {
+      seen[res.rows[r].values[0].int_value] = true;
+    }
+
+    for (uint16_t p = 0; p < pool->num_pages; p++) {
+      Page* page = pool->pages[p];
+      uint16_t kept = 0;
+      for (uint16_t r = 0; r < page->num_rows; r++) {
+        kept += seen[page->rows[r].values[0].int_value];
+      }
+      ck_assert_msg(kept == 0 || kept == page->num_rows, "page %u was only partly sampled (%u of %u rows)",
+        p, kept, page->num_rows);
+    }
+    free(seen);
+
+    res = process_silent(db, "SELECT COUNT(*) FROM samples TABLESAMPLE SYSTEM (50) REPEATABLE (3) LIM 1;").exec;
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_int_eq(res.rows[0].values[0].int_value, system_rows);
+  }
+
+  res = process_silent(db, "SELECT id, bucket FROM samples TABLESAMPLE BERNOULLI (50) REPEATABLE (7) WHERE bucket = 1;").exec;
+  for (uint32_t r = 0; r < res.row_count; r++) {
+    ck_assert_int_eq(res.rows[r].values[1].int_value, 1);
+  }
+
+  char* invalid_queries[] = {
+    "SELECT * FROM samples TABLESAMPLE SYSTEM (150);",
+    "SELECT * FROM samples TABLESAMPLE SYSTEM 10;",
+    "SELECT * FROM samples TABLESAMPLE RANDOM (10);",
+    "SELECT * FROM samples TABLESAMPLE BERNOULLI (10) REPEATABLE (abc);",
+  };
+
+  for (int i = 0; i < sizeof(invalid_queries) / sizeof(invalid_queries[0]); i++) {
+    res = process_silent(db, invalid_queries[i]).exec;
+    ck_assert_msg(res.code != 0, "Invalid TABLESAMPLE query #%d unexpectedly succeeded", i + 1);
+  }
+
+  db_free(db);
+}
+END_TEST
+
+Suite* select_tablesample_suite(void) {
+  Suite* s = suite_create("SelectTablesample");
+
+  TCase* tc_sample = tcase_create("SelectTablesample");
+  tcase_add_test(tc_sample, test_select_tablesample);
+  suite_add_tcase(s, tc_sample);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(select_tablesample_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
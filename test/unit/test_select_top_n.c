@@ -0,0 +1,93 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_select_top_n) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE scores (id INT PRIMKEY, points INT, player VARCHAR(20));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  char query[256];
+  for (int i = 1; i <= 300; i++) {
+    snprintf(query, sizeof(query), "INSERT INTO scores VALUES (%d, %d, 'player%d');", i, (i * 37) % 300, i);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  struct {
+    char* query;
+    int expected_rows;
+    int expected_points[5];
+  } top_n_test_cases[] = {
+    { "SELECT * FROM scores ORDER BY points DESC LIM 5;", 5, { 299, 298, 297, 296, 295 } },
+    { "SELECT * FROM scores ORDER BY points ASC LIM 3 OFFSET 2;", 3, { 2, 3, 4 } },
+    { "SELECT * FROM scores WHERE points < 100 ORDER BY points DESC LIM 4;", 4, { 99, 98, 97, 96 } },
+    { "SELECT * FROM scores WHERE points > 297 ORDER BY points ASC LIM 5;", 2, { 298, 299 } },
+    { "SELECT * FROM scores ORDER BY points DESC LIM 2 OFFSET 299;", 1, { 0 } },
+  };
+
+  int n_cases = sizeof(top_n_test_cases) / sizeof(top_n_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    printf("Executing top-N test case #%d: %s\n", i + 1, top_n_test_cases[i].query);
+
+    res = process_silent(db, top_n_test_cases[i].query).exec;
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_msg(res.row_count == (uint32_t)top_n_test_cases[i].expected_rows,
+      "Top-N test case #%d failed: expected %d rows, got %u",
+      i + 1, top_n_test_cases[i].expected_rows, res.row_count);
+
+    for (uint32_t r = 0; r < res.row_count; r++) {
+      ck_assert_msg(res.rows[r].values[1].int_value == top_n_test_cases[i].expected_points[r],
+        "Top-N test case #%d failed at row %u: expected %d points, got %ld",
+        i + 1, r + 1, top_n_test_cases[i].expected_points[r], (long)res.rows[r].values[1].int_value);
+    }
+  }
+
+  Result result = process_silent(db, "SELECT * FROM scores ORDER BY points DESC LIM 5 OFFSET 3;");
+  ck_assert_int_eq(result.exec.code, 0);
+
+  // the heap never holds more than offset + limit rows
+  QueryOperator* pipeline = pipeline_build(db, result.cmd, result.cmd->schema);
+  ck_assert(pipeline != NULL);
+
+  Row row;
+  while (pipeline_next(pipeline, &row)) {
+    free(row.values);
+  }
+
+  QueryOperator* top_n = pipeline;
+  while (top_n && top_n->type != OPERATOR_TOP_N) top_n = top_n->child;
+  ck_assert(top_n != NULL);
+  ck_assert_int_eq(top_n->sort.bound, 8);
+  ck_assert_int_eq(top_n->sort.sorter.count, 8);
+  ck_assert(top_n->sort.sorter.capacity <= 8);
+
+  pipeline_free(pipeline);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* select_top_n_suite(void) {
+  Suite* s = suite_create("SelectTopN");
+
+  TCase* tc_top_n = tcase_create("SelectTopN");
+  tcase_add_test(tc_top_n, test_select_top_n);
+  suite_add_tcase(s, tc_top_n);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(select_top_n_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_sequence_cache) {
+  INIT_TEST(db);
+
+  char* create_queries[] = {
+    "CREATE TABLE tickets (id SERIAL CACHE 5, label TEXT);",
+    "CREATE TABLE events (id SERIAL, label TEXT);",
+  };
+
+  for (int i = 0; i < sizeof(create_queries) / sizeof(create_queries[0]); i++) {
+    ExecutionResult res = process_silent(db, create_queries[i]).exec;
+    ck_assert_int_eq(res.code, 0);
+  }
+
+  for (int i = 0; i < 7; i++) {
+    ExecutionResult res = process_silent(db, "INSERT INTO tickets (label) VALUES ('t');").exec;
+    ck_assert_int_eq(res.code, 0);
+
+    res = process_silent(db, "INSERT INTO events (label) VALUES ('e');").exec;
+    ck_assert_int_eq(res.code, 0);
+  }
+
+  // values come out of the reserved blocks in order, with no gaps
+  char* tables[] = { "tickets", "events" };
+  for (int t = 0; t < sizeof(tables) / sizeof(tables[0]); t++) {
+    char query[256];
+    snprintf(query, sizeof(query), "SELECT id FROM %s ORDER BY id ASC;", tables[t]);
+
+    ExecutionResult res = process_silent(db, query).exec;
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_int_eq(res.row_count, 7);
+
+    for (uint32_t i = 0; i < res.row_count; i++) {
+      ck_assert_msg(res.rows[i].values[0].int_value == i + 1,
+        "Sequence test '%s' failed: row %u has id %lld, expected %u",
+        tables[t], i, (long long)res.rows[i].values[0].int_value, i + 1);
+    }
+  }
+
+  // only the high-water mark of the reserved blocks is persisted
+  struct {
+    char* name;
+    int64_t current_value;
+  } persisted_test_cases[] = {
+    { "ticketsid", 10 },
+    { "eventsid",  DEFAULT_SEQUENCE_CACHE },
+  };
+
+  int n_cases = sizeof(persisted_test_cases) / sizeof(persisted_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    char query[256];
+    snprintf(query, sizeof(query), "SELECT current_value FROM jb_sequences WHERE name = '%s';",
+      persisted_test_cases[i].name);
+
+    ExecutionResult res = process_silent(db->core, query).exec;
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_int_eq(res.row_count, 1);
+    ck_assert_msg(res.rows[0].values[0].int_value == persisted_test_cases[i].current_value,
+      "Persisted test case #%d failed: '%s' holds %lld, expected %lld",
+      i + 1, persisted_test_cases[i].name, (long long)res.rows[0].values[0].int_value,
+      (long long)persisted_test_cases[i].current_value);
+  }
+
+  ck_assert_int_eq(sequence_next_val(db, "ticketsid"), 8);
+  ck_assert_int_eq(sequence_next_val(db, "missing"), -1);
+
+  char* invalid_queries[] = {
+    "CREATE TABLE bad_cache (id SERIAL CACHE 0);",
+    "CREATE TABLE bad_serial (id INT CACHE 5);",
+  };
+
+  for (int i = 0; i < sizeof(invalid_queries) / sizeof(invalid_queries[0]); i++) {
+    ExecutionResult res = process_silent(db, invalid_queries[i]).exec;
+    ck_assert_msg(res.code != 0, "Invalid query #%d was accepted: %s", i + 1, invalid_queries[i]);
+  }
+
+  db_free(db);
+}
+END_TEST
+
+Suite* sequence_suite(void) {
+  Suite* s = suite_create("Sequence");
+
+  TCase* tc_sequence = tcase_create("Sequence");
+  tcase_add_test(tc_sequence, test_sequence_cache);
+  suite_add_tcase(s, tc_sequence);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(sequence_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_unique) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE accounts (id SERIAL PRIMKEY, email VARCHAR(100) UNIQUE, age INT);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  char query[256];
+  for (int i = 1; i <= 80; i++) {
+    snprintf(query, sizeof(query),
+      "INSERT INTO accounts VALUES (%d, 'user%d@example.com', %d);", i, i, 20 + i % 40);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  struct {
+    char* query;
+    bool should_succeed;
+  } unique_test_cases[] = {
+    { "INSERT INTO accounts VALUES (81, 'user7@example.com', 30);", false },
+    { "INSERT INTO accounts VALUES (81, 'fresh@example.com', 30);", true },
+    { "INSERT INTO accounts VALUES (82, 'fresh@example.com', 31);", false },
+    { "DELETE FROM accounts WHERE email = 'user7@example.com';", true },
+    { "INSERT INTO accounts VALUES (83, 'user7@example.com', 30);", true },
+    { "UPDATE accounts SET email = 'moved@example.com' WHERE id = 8;", true },
+    { "INSERT INTO accounts VALUES (84, 'user8@example.com', 30);", true },
+    { "INSERT INTO accounts VALUES (85, 'moved@example.com', 30);", false },
+  };
+
+  int n_cases = sizeof(unique_test_cases) / sizeof(unique_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    printf("Executing UNIQUE test case #%d: %s\n", i + 1, unique_test_cases[i].query);
+
+    res = process_silent(db, unique_test_cases[i].query).exec;
+    ck_assert_msg((res.code == 0) == unique_test_cases[i].should_succeed,
+      "UNIQUE test case #%d failed: expected %s, got code %d",
+      i + 1, unique_test_cases[i].should_succeed ? "success" : "failure", res.code);
+  }
+
+  res = process(db, "SELECT * FROM accounts;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 82);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* unique_suite(void) {
+  Suite* s = suite_create("Unique");
+
+  TCase* tc_unique = tcase_create("Unique");
+  tcase_add_test(tc_unique, test_unique);
+  suite_add_tcase(s, tc_unique);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(unique_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+START_TEST(test_vector_filter) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE metrics (id INT PRIMKEY, score DOUBLE, name VARCHAR(20), active BOOL, bonus INT);").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  char query[256];
+  for (int i = 1; i <= 90; i++) {
+    char bonus[16];
+    if (i % 10 == 0) snprintf(bonus, sizeof(bonus), "NULL");
+    else snprintf(bonus, sizeof(bonus), "%d", i % 7);
+
+    snprintf(query, sizeof(query), "INSERT INTO metrics VALUES (%d, %d.%d, 'name%02d', %s, %s);",
+      i, i / 2, i % 2 ? 5 : 0, i, i % 2 ? "false" : "true", bonus);
+    res = process_silent(db, query).exec;
+    ck_assert_msg(res.code == 0, "Insert #%d unexpectedly failed", i);
+  }
+
+  struct {
+    char* query;
+    int expected_rows;
+  } vector_test_cases[] = {
+    { "SELECT * FROM metrics WHERE bonus > 3;", 35 },
+    { "SELECT * FROM metrics WHERE NOT (bonus > 3);", 46 },
+    { "SELECT * FROM metrics WHERE bonus = NULL;", 9 },
+    { "SELECT * FROM metrics WHERE score BETWEEN 10 AND 20;", 21 },
+    { "SELECT * FROM metrics WHERE name < 'name10';", 9 },
+    { "SELECT * FROM metrics WHERE 5 < id AND active = true;", 43 },
+    { "SELECT * FROM metrics WHERE bonus > 3 OR id <= 10;", 41 },
+    { "SELECT * FROM metrics WHERE NOT (bonus > 3 OR id > 80);", 42 },
+    { "SELECT * FROM metrics WHERE id <= 10 AND bonus != 1;", 7 },
+    { "SELECT * FROM metrics WHERE score >= 44.5 OR name = 'name03';", 3 },
+  };
+
+  int n_cases = sizeof(vector_test_cases) / sizeof(vector_test_cases[0]);
+  for (int i = 0; i < n_cases; i++) {
+    printf("Executing vector filter test case #%d: %s\n", i + 1, vector_test_cases[i].query);
+
+    Result result = process(db, vector_test_cases[i].query);
+    ck_assert_int_eq(result.exec.code, 0);
+    ck_assert_msg(result.exec.row_count == (uint32_t)vector_test_cases[i].expected_rows,
+      "Vector filter test case #%d failed: expected %d rows, got %u",
+      i + 1, vector_test_cases[i].expected_rows, result.exec.row_count);
+
+    VectorFilter* filter = vector_filter_compile(result.cmd->where, result.cmd->schema, db);
+    ck_assert_msg(filter != NULL && filter->root != NULL,
+      "Vector filter test case #%d fell back to row-at-a-time evaluation", i + 1);
+    vector_filter_free(filter);
+  }
+
+  res = process_silent(db, "DELETE FROM metrics WHERE bonus = NULL OR score < 5;").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  res = process(db, "SELECT * FROM metrics;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 72);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* vector_filter_suite(void) {
+  Suite* s = suite_create("VectorFilter");
+
+  TCase* tc_vector_filter = tcase_create("VectorFilter");
+  tcase_add_test(tc_vector_filter, test_vector_filter);
+  suite_add_tcase(s, tc_vector_filter);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(vector_filter_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernel/kernel.h"
+#include "utils/testing.h"
+
+#define ZONE_TEST_ROWS 600
+
+START_TEST(test_zone_map) {
+  INIT_TEST(db);
+
+  ExecutionResult res = process_silent(db,
+    "CREATE TABLE events (id INT PRIMKEY, taken DATE, value DOUBLE, note VARCHAR(16));").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  for (int i = 1; i <= ZONE_TEST_ROWS; i++) {
+    char query[256];
+    if (i % 100 == 0) {
+      snprintf(query, sizeof(query), "INSERT INTO events VALUES (%d, '2025-%02d-01', %d.25, NULL);",
+        i, (i * 12 - 1) / ZONE_TEST_ROWS + 1, i);
+    } else {
+      snprintf(query, sizeof(query), "INSERT INTO events VALUES (%d, '2025-%02d-01', %d.25, 'n%d');",
+        i, (i * 12 - 1) / ZONE_TEST_ROWS + 1, i, i);
+    }
+
+    res = process_silent(db, query).exec;
+    ck_assert_int_eq(res.code, 0);
+  }
+
+  BufferPool* pool = &db->lake[hash_fnv1a("events", MAX_TABLES)];
+  ck_assert_msg(pool->num_pages > 2, "expected the table to span several pages, got %d", pool->num_pages);
+
+  // every page knows the id range of its rows
+  for (uint8_t p = 0; p < pool->num_pages; p++) {
+    Page* page = pool->pages[p];
+    ck_assert_msg(page->zone_count >= 4, "page %d has %d zones", p, page->zone_count);
+
+    int64_t min = INT64_MAX, max = INT64_MIN;
+    for (uint16_t r = 0; r < page->num_rows; r++) {
+      int64_t id = page->rows[r].values[0].int_value;
+      if (id < min) min = id;
+      if (id > max) max = id;
+    }
+
+    PageZone* zone = &page->zones[0];
+    ck_assert(zone->has_range);
+    ck_assert_int_eq(zone->type, TOK_T_INT);
+    ck_assert_int_eq(zone->min.i, min);
+    ck_assert_int_eq(zone->max.i, max);
+    ck_assert_int_eq(page->zones[3].type, PAGE_ZONE_UNBOUNDED);
+  }
+
+  ZoneFilter zf = { .count = 1 };
+  zf.preds[0] = (ZonePredicate){ .column = 0, .type = TOK_T_INT, .op = TOK_GT, .low.i = ZONE_TEST_ROWS - 10 };
+
+  int skipped = 0;
+  for (uint8_t p = 0; p < pool->num_pages; p++) {
+    skipped += !zone_filter_page_may_match(&zf, pool->pages[p]);
+  }
+  ck_assert_int_eq(skipped, pool->num_pages - 1);
+
+  struct {
+    char* query;
+    int expected_rows;
+  } zone_test_cases[] = {
+    { "SELECT * FROM events WHERE id > 590;", 10 },
+    { "SELECT * FROM events WHERE 590 < id;", 10 },
+    { "SELECT * FROM events WHERE id BETWEEN 10 AND 19;", 10 },
+    { "SELECT * FROM events WHERE id = 300 AND value > 0;", 1 },
+    { "SELECT * FROM events WHERE id <= 3;", 3 },
+    { "SELECT * FROM events WHERE value < 2.5;", 2 },
+    { "SELECT * FROM events WHERE value >= 599.25;", 2 },
+    { "SELECT * FROM events WHERE taken = '2025-01-01';", 50 },
+    { "SELECT * FROM events WHERE note = NULL;", 6 },
+    { "SELECT * FROM events WHERE id < 1;", 0 },
+    { "SELECT * FROM events WHERE id > 100 OR id < 5;", 504 },
+  };
+
+  for (int i = 0; i < sizeof(zone_test_cases) / sizeof(zone_test_cases[0]); i++) {
+    res = process_silent(db, zone_test_cases[i].query).exec;
+
+    ck_assert_int_eq(res.code, 0);
+    ck_assert_msg(res.row_count == zone_test_cases[i].expected_rows,
+      "Zone map test case #%d failed: expected %d rows, got %d",
+      i + 1, zone_test_cases[i].expected_rows, res.row_count);
+  }
+
+  // an update that leaves a page's range widens it rather than hiding the row
+  res = process_silent(db, "UPDATE events SET value = 100000 WHERE id = 5;").exec;
+  ck_assert_int_eq(res.code, 0);
+
+  res = process_silent(db, "SELECT * FROM events WHERE value > 50000;").exec;
+  ck_assert_int_eq(res.code, 0);
+  ck_assert_int_eq(res.row_count, 1);
+
+  // pages written before the header carried a format version get their zones back from their rows
+  TableCatalogEntry tc = db->tc[hash_fnv1a("events", MAX_TABLES)];
+  Page* written = pool->pages[1];
+  FILE* file = tmpfile();
+  ck_assert(file != NULL);
+
+  for (uint8_t format = PAGE_FORMAT_LEGACY; format <= PAGE_FORMAT_VERSION; format++) {
+    uint8_t kept = written->format;
+    written->format = format;
+    write_page(file, 0, written, tc);
+    written->format = kept;
+    fflush(file);
+
+    Page* page = page_init(0);
+    ck_assert(page != NULL);
+    read_page(file, 0, page, tc);
+
+    ck_assert_int_eq(page->format, format);
+    ck_assert_int_eq(page->num_rows, written->num_rows);
+    ck_assert_int_eq(page->zone_count, written->zone_count);
+    ck_assert_int_eq(page->zones[0].min.i, written->zones[0].min.i);
+    ck_assert_int_eq(page->zones[0].max.i, written->zones[0].max.i);
+    ck_assert(page->zones[2].min.d == written->zones[2].min.d);
+    ck_assert_int_eq(page->zones[3].null_count, written->zones[3].null_count);
+
+    page_materialize(page, tc.schema, NULL);
+    for (uint16_t r = 0; r < page->num_rows; r++) {
+      ck_assert_int_eq(page->rows[r].values[0].int_value, written->rows[r].values[0].int_value);
+      free(page->rows[r].null_bitmap);
+      free(page->rows[r].values);
+    }
+    free(page);
+  }
+  fclose(file);
+
+  db_free(db);
+}
+END_TEST
+
+Suite* zone_map_suite(void) {
+  Suite* s = suite_create("ZoneMap");
+
+  TCase* tc_zone = tcase_create("ZoneMap");
+  tcase_add_test(tc_zone, test_zone_map);
+  suite_add_tcase(s, tc_zone);
+
+  return s;
+}
+
+int main(void) {
+  SRunner* sr = srunner_create(zone_map_suite());
+  srunner_run_all(sr, CK_NORMAL);
+  int failures = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (failures == 0) ? 0 : 1;
+}